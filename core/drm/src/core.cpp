@@ -34,7 +34,7 @@ drm_core::File::File(std::shared_ptr<Device> device)
 	HEL_CHECK(helCreateIndirectMemory(1024, &handle));
 	_memory = helix::UniqueDescriptor{handle};
 
-	_statusPage.update(_eventSequence, 0);
+	_statusPage.update(_eventSequence, 0, 0);
 };
 
 void drm_core::File::setBlocking(bool blocking) {
@@ -129,7 +129,7 @@ void drm_core::File::postEvent(drm_core::Event event) {
 
 	if(_pendingEvents.empty()) {
 		++_eventSequence;
-		_statusPage.update(_eventSequence, EPOLLIN);
+		_statusPage.update(_eventSequence, EPOLLIN, EPOLLIN);
 	}
 	_pendingEvents.push_back(event);
 	_eventBell.raise();
@@ -162,7 +162,7 @@ drm_core::File::read(void *object, const char *,
 
 	self->_pendingEvents.pop_front();
 	if(self->_pendingEvents.empty())
-		self->_statusPage.update(self->_eventSequence, 0);
+		self->_statusPage.update(self->_eventSequence, 0, 0);
 
 	co_return sizeof(drm_event_vblank);
 }
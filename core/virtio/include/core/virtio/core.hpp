@@ -16,6 +16,7 @@
 #include <async/recurring-event.hpp>
 #include <async/oneshot-event.hpp>
 #include <helix/ipc.hpp>
+#include <helix/irq-poller.hpp>
 #include <protocols/hw/client.hpp>
 
 namespace virtio_core {
@@ -73,6 +74,9 @@ enum {
 	VIRTQ_DESC_F_NEXT = 1, // descriptor is part of a chain
 	VIRTQ_DESC_F_WRITE = 2, // buffer is written by device
 
+	// Bits of the spec::AvailableRing::flags field.
+	VIRTQ_AVAIL_F_NO_INTERRUPT = 1, // no need to interrupt the driver
+
 	// Bits of the spec::UsedRing::flags field.
 	VIRTQ_USED_F_NO_NOTIFY = 1 // no need to notify the device
 };
@@ -166,6 +170,9 @@ struct Transport {
 	virtual Queue *setupQueue(unsigned int index) = 0;
 
 	virtual void runDevice() = 0;
+
+	// Statistics about switches between IRQ-driven and polling-driven completion processing.
+	virtual helix::IrqPollerStats irqPollerStats() = 0;
 };
 
 struct DeviceSpace {
@@ -336,7 +343,16 @@ public:
 
 	// Processes interrupts for this virtq.
 	// Calls retrieveDescriptor() to complete individual requests.
-	void processInterrupt();
+	void processInterrupt() {
+		processCompletions(SIZE_MAX);
+	}
+
+	// Completes up to budget requests. Returns the number of completed requests.
+	size_t processCompletions(size_t budget);
+
+	// Asks the device to not send interrupts for this virtq.
+	// This is only a hint; the device may still send interrupts.
+	void suppressInterrupts(bool suppress);
 
 protected:
 	virtual void notifyTransport() = 0;
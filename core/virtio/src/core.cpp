@@ -10,6 +10,72 @@
 
 namespace virtio_core {
 
+namespace {
+
+// Lets helix::IrqPoller process the completions of all virtqs of a transport.
+template<typename Q>
+struct QueueSetPoller {
+	QueueSetPoller(std::vector<std::unique_ptr<Q>> *queues)
+	: _queues{queues} { }
+
+	size_t pollCompletions(size_t budget) {
+		// Start at a different queue in each round, such that a busy queue
+		// cannot consume the whole budget of every round.
+		auto numQueues = _queues->size();
+		size_t n = 0;
+		for(size_t i = 0; i < numQueues && n < budget; i++) {
+			auto &queue = (*_queues)[(_next + i) % numQueues];
+			if(!queue)
+				continue;
+			n += queue->processCompletions(budget - n);
+		}
+		if(numQueues)
+			_next = (_next + 1) % numQueues;
+		return n;
+	}
+
+	void maskCompletionIrqs() {
+		for(auto &queue : *_queues)
+			if(queue)
+				queue->suppressInterrupts(true);
+	}
+
+	void unmaskCompletionIrqs() {
+		for(auto &queue : *_queues)
+			if(queue)
+				queue->suppressInterrupts(false);
+	}
+
+private:
+	std::vector<std::unique_ptr<Q>> *_queues;
+	size_t _next = 0;
+};
+
+// Interval at which the IRQ poller statistics are checked.
+constexpr uint64_t pollerStatsInterval = 10'000'000'000;
+
+// Logs the IRQ poller statistics whenever the transport switched to polling
+// since the last report (i.e., nothing is logged on idle devices).
+template<typename P>
+async::detached reportPollerStats(P *poller) {
+	uint64_t reportedEntries = 0;
+	while(true) {
+		co_await helix::sleepFor(pollerStatsInterval);
+
+		const auto &stats = poller->stats();
+		if(stats.numPollEntries == reportedEntries)
+			continue;
+		reportedEntries = stats.numPollEntries;
+
+		std::cout << "core-virtio: " << stats.numIrqs << " IRQs, "
+				<< stats.numPollEntries << " switches to polling, "
+				<< stats.numPolls << " polls (" << stats.numEmptyPolls << " empty), "
+				<< stats.numCompletions << " completions" << std::endl;
+	}
+}
+
+} // anonymous namespace
+
 struct Mapping {
 	static constexpr size_t pageSize = 0x1000;
 
@@ -100,6 +166,8 @@ struct LegacyPciTransport : Transport {
 
 	void runDevice() override;
 
+	helix::IrqPollerStats irqPollerStats() override;
+
 private:
 	async::detached _processIrqs();
 
@@ -108,6 +176,8 @@ private:
 	helix::UniqueDescriptor _irq;
 
 	std::vector<std::unique_ptr<LegacyPciQueue>> _queues;
+	QueueSetPoller<LegacyPciQueue> _queueSet{&_queues};
+	helix::IrqPoller<QueueSetPoller<LegacyPciQueue>> _poller{&_queueSet};
 };
 
 struct LegacyPciQueue final : Queue {
@@ -214,9 +284,15 @@ void LegacyPciTransport::runDevice() {
 	// Set the DRIVER_OK bit to finish the configuration.
 	_legacySpace.store(PCI_L_DEVICE_STATUS, _legacySpace.load(PCI_L_DEVICE_STATUS) | DRIVER_OK);
 
+	_poller.run();
+	reportPollerStats(&_poller);
 	_processIrqs();
 }
 
+helix::IrqPollerStats LegacyPciTransport::irqPollerStats() {
+	return _poller.stats();
+}
+
 async::detached LegacyPciTransport::_processIrqs() {
 	co_await _hwDevice.enableBusIrq();
 
@@ -244,8 +320,7 @@ async::detached LegacyPciTransport::_processIrqs() {
 			assert(!(status & DEVICE_NEEDS_RESET));
 		}
 		if(isr & 1)
-			for(auto &queue : _queues)
-				queue->processInterrupt();
+			_poller.schedule();
 	}
 }
 
@@ -297,6 +372,8 @@ struct StandardPciTransport : Transport {
 
 	void runDevice() override;
 
+	helix::IrqPollerStats irqPollerStats() override;
+
 private:
 	arch::mem_space _commonSpace() { return arch::mem_space{_commonMapping.get()}; }
 	arch::mem_space _notifySpace() { return arch::mem_space{_notifyMapping.get()}; }
@@ -318,6 +395,8 @@ private:
 
 
 	std::vector<std::unique_ptr<StandardPciQueue>> _queues;
+	QueueSetPoller<StandardPciQueue> _queueSet{&_queues};
+	helix::IrqPoller<QueueSetPoller<StandardPciQueue>> _poller{&_queueSet};
 };
 
 struct StandardPciQueue final : Queue {
@@ -454,11 +533,17 @@ void StandardPciTransport::runDevice() {
 	// Finally set the DRIVER_OK bit to finish the configuration.
 	_commonSpace().store(PCI_DEVICE_STATUS, _commonSpace().load(PCI_DEVICE_STATUS) | DRIVER_OK);
 
+	_poller.run();
+	reportPollerStats(&_poller);
 	if(_useMsi)
 		_processQueueMsi();
 	_processIrqs();
 }
 
+helix::IrqPollerStats StandardPciTransport::irqPollerStats() {
+	return _poller.stats();
+}
+
 async::detached StandardPciTransport::_processIrqs() {
 #ifdef __x86_64__ // TODO: implement kernlet compilation for aarch64
 	co_await connectKernletCompiler();
@@ -525,8 +610,7 @@ async::detached StandardPciTransport::_processIrqs() {
 		}
 
 		if(await.bitset() & 1)
-			for(auto &queue : _queues)
-				queue->processInterrupt();
+			_poller.schedule();
 	}
 #else
 	co_await _hwDevice.enableBusIrq();
@@ -557,8 +641,7 @@ async::detached StandardPciTransport::_processIrqs() {
 		}
 
 		if(isr & 1)
-			for(auto &queue : _queues)
-				queue->processInterrupt();
+			_poller.schedule();
 	}
 #endif
 }
@@ -572,8 +655,7 @@ async::detached StandardPciTransport::_processQueueMsi() {
 
 		HEL_CHECK(helAcknowledgeIrq(_queueMsi.getHandle(), kHelAckAcknowledge, sequence));
 
-		for(auto &queue : _queues)
-			queue->processInterrupt();
+		_poller.schedule();
 	}
 }
 
@@ -853,8 +935,9 @@ void Queue::notify() {
 		notifyTransport();
 }
 
-void Queue::processInterrupt() {
-	while(true) {
+size_t Queue::processCompletions(size_t budget) {
+	size_t n = 0;
+	while(n < budget) {
 		auto used_head = _usedRing->headIndex.load();
 
 		if((_progressHead & 0xFFFF) == used_head)
@@ -885,7 +968,15 @@ void Queue::processInterrupt() {
 		request->complete(request);
 
 		_progressHead++;
+		n++;
 	}
+	return n;
+}
+
+void Queue::suppressInterrupts(bool suppress) {
+	_availableRing->flags.store(suppress ? VIRTQ_AVAIL_F_NO_INTERRUPT : 0);
+	// Make sure that the flag is visible before we check the used ring again.
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
 }
 
 } // namespace virtio_core
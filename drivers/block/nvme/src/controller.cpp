@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <iostream>
+
 #include <arch/bit.hpp>
 #include <helix/timer.hpp>
 
@@ -37,15 +40,19 @@ namespace flags {
 } // namespace flags
 
 Controller::Controller(int64_t parentId, protocols::hw::Device hwDevice, helix::Mapping hbaRegs,
-					   helix::UniqueDescriptor, helix::UniqueDescriptor irq)
+					   helix::UniqueDescriptor, std::vector<helix::UniqueDescriptor> irqs,
+					   bool useMsis)
 	: hwDevice_{std::move(hwDevice)}, regsMapping_{std::move(hbaRegs)},
-	  regs_{regsMapping_.get()}, irq_{std::move(irq)}, parentId_{parentId} {
+	  regs_{regsMapping_.get()}, irqs_{std::move(irqs)}, useMsis_{useMsis},
+	  parentId_{parentId} {
+	assert(!irqs_.empty());
 }
 
 async::detached Controller::run() {
 	co_await hwDevice_.enableBusIrq();
 
-	handleIrqs();
+	if (irqs_.size() == 1)
+		handleIrqs();
 
 	co_await reset();
 	co_await scanNamespaces();
@@ -58,7 +65,7 @@ async::detached Controller::handleIrqs() {
 	irqSequence_ = 0;
 
 	while (true) {
-		auto await = co_await helix_ng::awaitEvent(irq_, irqSequence_);
+		auto await = co_await helix_ng::awaitEvent(irqs_[0], irqSequence_);
 		HEL_CHECK(await.error());
 		irqSequence_ = await.sequence();
 
@@ -67,14 +74,28 @@ async::detached Controller::handleIrqs() {
 			found |= q->handleIrq();
 		}
 
-		if (found) {
-			HEL_CHECK(helAcknowledgeIrq(irq_.getHandle(), kHelAckAcknowledge, irqSequence_));
+		if (found || useMsis_) {
+			HEL_CHECK(helAcknowledgeIrq(irqs_[0].getHandle(), kHelAckAcknowledge, irqSequence_));
 		} else {
-			HEL_CHECK(helAcknowledgeIrq(irq_.getHandle(), kHelAckNack, irqSequence_));
+			HEL_CHECK(helAcknowledgeIrq(irqs_[0].getHandle(), kHelAckNack, irqSequence_));
 		}
 	}
 }
 
+async::detached Controller::handleQueueIrqs(Queue *q, helix::BorrowedDescriptor irq) {
+	uint64_t sequence = 0;
+
+	while (true) {
+		auto await = co_await helix_ng::awaitEvent(irq, sequence);
+		HEL_CHECK(await.error());
+		sequence = await.sequence();
+
+		// MSIs are not shared, so there is nothing to NACK.
+		q->handleIrq();
+		HEL_CHECK(helAcknowledgeIrq(irq.getHandle(), kHelAckAcknowledge, sequence));
+	}
+}
+
 async::result<void> Controller::waitStatus(bool enabled) {
 	auto readyBit = enabled ? flags::csts::ready : 0;
 
@@ -118,15 +139,44 @@ async::result<void> Controller::reset() {
 	regs_.store(regs::acq, adminQ->getCqPhysAddr());
 
 	adminQ->run();
+	if (irqs_.size() > 1)
+		handleQueueIrqs(adminQ.get(), irqs_[0]);
 	activeQueues_.push_back(std::move(adminQ));
 
 	co_await enable();
 
-	auto ioQ = std::make_unique<Queue>(1, queueDepth_, regs_.subspace(doorbellsOffset + 1 * 8 * dbStride_));
-	ioQ->init();
+	// Ask for one I/O queue per remaining vector; the controller may grant fewer.
+	unsigned int numIoQueues = 1;
+	if (irqs_.size() > 1) {
+		auto res = co_await setNumberOfQueues(irqs_.size() - 1);
+		if (res.first == 0) {
+			auto granted = arch::convert_endian<arch::endian::little>(res.second.u32);
+			numIoQueues = std::min({static_cast<unsigned int>(irqs_.size() - 1),
+					(granted & 0xFFFF) + 1, (granted >> 16) + 1});
+		}
+	}
+
+	// Route the vectors of the I/O queues to consecutive CPUs, starting after the
+	// admin queue's CPU, such that the queues complete I/O in parallel.
+	auto numCpus = helix::getCpuCount();
+	auto baseCpu = (irqs_.size() > 1) ? helix::getIrqAffinity(irqs_[0]) : -1;
+
+	for (unsigned int qid = 1; qid <= numIoQueues; qid++) {
+		auto ioQ = std::make_unique<Queue>(qid, queueDepth_,
+				regs_.subspace(doorbellsOffset + qid * 8 * dbStride_));
+		ioQ->init();
+
+		if (!(co_await setupIoQueue(ioQ.get())))
+			break;
 
-	if (co_await setupIoQueue(ioQ.get())) {
 		ioQ->run();
+		if (irqs_.size() > 1) {
+			if (baseCpu >= 0)
+				helix::setIrqAffinity(irqs_[qid], (baseCpu + qid) % numCpus);
+			std::cout << "block/nvme: I/O queue " << qid << " uses CPU "
+					<< helix::getIrqAffinity(irqs_[qid]) << std::endl;
+			handleQueueIrqs(ioQ.get(), irqs_[qid]);
+		}
 		activeQueues_.push_back(std::move(ioQ));
 	}
 
@@ -160,7 +210,9 @@ async::result<Command::Result> Controller::createCQ(Queue *q) {
 	cmdBuf.cqid = convert_endian<endian::little, endian::native>((uint16_t)q->getQueueId());
 	cmdBuf.qSize = convert_endian<endian::little, endian::native>((uint16_t)q->getQueueDepth() - 1);
 	cmdBuf.cqFlags = convert_endian<endian::little, endian::native>((uint16_t)flags);
-	cmdBuf.irqVector = 0; // TODO: set to MSI vector
+	// Vector i belongs to queue i if there is one vector per queue.
+	auto irqVector = (irqs_.size() > 1) ? q->getQueueId() : 0;
+	cmdBuf.irqVector = convert_endian<endian::little, endian::native>((uint16_t)irqVector);
 
 	return adminQ->submitCommand(std::move(cmd));
 }
@@ -185,6 +237,22 @@ async::result<Command::Result> Controller::createSQ(Queue *q) {
 	return adminQ->submitCommand(std::move(cmd));
 }
 
+async::result<Command::Result> Controller::setNumberOfQueues(unsigned int count) {
+	using arch::convert_endian;
+	using arch::endian;
+
+	auto &adminQ = activeQueues_.front();
+	auto cmd = std::make_unique<Command>();
+	auto &cmdBuf = cmd->getCommandBuffer().common;
+
+	// Both counts are zero-based; the result reports the granted counts in the same format.
+	cmdBuf.opcode = spec::kSetFeatures;
+	cmdBuf.cdw10 = convert_endian<endian::little, endian::native>((uint32_t)spec::kNumberOfQueues);
+	cmdBuf.cdw11 = convert_endian<endian::little, endian::native>(((count - 1) << 16) | (count - 1));
+
+	return adminQ->submitCommand(std::move(cmd));
+}
+
 async::result<Command::Result> Controller::identifyController(spec::IdentifyController &id) {
 	auto &adminQ = activeQueues_.front();
 	auto cmd = std::make_unique<Command>();
@@ -289,7 +357,9 @@ async::result<void> Controller::createNamespace(unsigned int nsid) {
 }
 
 async::result<Command::Result> Controller::submitIoCommand(std::unique_ptr<Command> cmd) {
-	auto &ioQ = activeQueues_.back();
+	// Distribute commands across the I/O queues (activeQueues_[0] is the admin queue).
+	auto index = 1 + nextIoQueue_++ % (activeQueues_.size() - 1);
+	auto &ioQ = activeQueues_[index];
 
 	return ioQ->submitCommand(std::move(cmd));
 }
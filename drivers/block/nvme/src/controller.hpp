@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <arch/mem_space.hpp>
 #include <async/result.hpp>
 #include <helix/memory.hpp>
@@ -9,8 +11,13 @@
 #include "namespace.hpp"
 
 struct Controller {
+	static constexpr unsigned int MAX_IO_QUEUES = 16;
+
+	// If irqs contains more than one vector, vector 0 belongs to the admin queue
+	// and vector i to I/O queue i. Otherwise, all queues share a single IRQ.
 	Controller(int64_t parentId, protocols::hw::Device hwDevice, helix::Mapping hbaRegs,
-			   helix::UniqueDescriptor ahciBar, helix::UniqueDescriptor irq);
+			   helix::UniqueDescriptor ahciBar, std::vector<helix::UniqueDescriptor> irqs,
+			   bool useMsis);
 
 	async::detached run();
 
@@ -25,7 +32,8 @@ private:
 	protocols::hw::Device hwDevice_;
 	helix::Mapping regsMapping_;
 	arch::mem_space regs_;
-	helix::UniqueDescriptor irq_;
+	std::vector<helix::UniqueDescriptor> irqs_;
+	bool useMsis_;
 
 	std::vector<std::unique_ptr<Queue>> activeQueues_;
 	std::vector<std::unique_ptr<Namespace>> activeNamespaces_;
@@ -36,6 +44,7 @@ private:
 	uint32_t version_;
 
 	uint64_t irqSequence_;
+	size_t nextIoQueue_ = 0;
 
 	async::result<void> reset();
 	async::result<void> scanNamespaces();
@@ -45,6 +54,7 @@ private:
 	async::result<void> disable();
 
 	async::result<bool> setupIoQueue(Queue *q);
+	async::result<Command::Result> setNumberOfQueues(unsigned int count);
 	async::result<Command::Result> createCQ(Queue *q);
 	async::result<Command::Result> createSQ(Queue *q);
 
@@ -55,4 +65,5 @@ private:
 	async::result<void> createNamespace(unsigned int nsid);
 
 	async::detached handleIrqs();
+	async::detached handleQueueIrqs(Queue *q, helix::BorrowedDescriptor irq);
 };
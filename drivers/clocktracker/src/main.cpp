@@ -1,8 +1,13 @@
 
 #include <iostream>
 
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
 #include <async/oneshot-event.hpp>
 #include <helix/memory.hpp>
+#include <helix/timer.hpp>
 #include <protocols/clock/defs.hpp>
 #include <protocols/mbus/client.hpp>
 #include <bragi/helpers-std.hpp>
@@ -69,6 +74,67 @@ TrackerPage *accessPage() {
 	return reinterpret_cast<TrackerPage *>(trackerPageMapping.get());
 }
 
+// ----------------------------------------------------------------------------
+// Cycle counter calibration.
+// ----------------------------------------------------------------------------
+
+// Interval at which the calibration is refreshed (such that drift stays small).
+constexpr uint64_t calibrationInterval = 1'000'000'000;
+
+// Only counters that tick at a constant rate (and do not stop in idle states) can be calibrated.
+bool haveInvariantCycleCounter() {
+#if defined(__x86_64__)
+	unsigned int eax, ebx, ecx, edx;
+	if(!__get_cpuid(0x8000'0007, &eax, &ebx, &ecx, &edx))
+		return false;
+	return edx & (1 << 8);
+#else
+	return false;
+#endif
+}
+
+// Pair of (cycle counter, reference clock).
+std::pair<uint64_t, int64_t> sampleCycleCounter() {
+	uint64_t cycles;
+	uint64_t clock;
+	protocols::clock::readCycleCounter(cycles);
+	HEL_CHECK(helGetClock(&clock));
+	return {cycles, clock};
+}
+
+// Publishes a calibration of the cycle counter in the tracker page, such that
+// readers can timestamp events without calling helGetClock().
+async::detached calibrateCycleCounter() {
+	if(!haveInvariantCycleCounter()) {
+		std::cout << "drivers/clocktracker: No invariant cycle counter,"
+				" clients need to use helGetClock()" << std::endl;
+		co_return;
+	}
+
+	auto [refCycles, refClock] = sampleCycleCounter();
+	while(true) {
+		co_await helix::sleepFor(calibrationInterval);
+
+		auto [cycles, clock] = sampleCycleCounter();
+		if(cycles <= refCycles || clock <= refClock)
+			continue;
+		auto mult = static_cast<uint64_t>(
+				(static_cast<unsigned __int128>(clock - refClock) << 32) / (cycles - refCycles));
+
+		auto page = accessPage();
+		auto seqlock = __atomic_load_n(&page->seqlock, __ATOMIC_RELAXED);
+		__atomic_store_n(&page->seqlock, seqlock + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		__atomic_store_n(&page->cycleRefCycles, cycles, __ATOMIC_RELAXED);
+		__atomic_store_n(&page->cycleRefClock, clock, __ATOMIC_RELAXED);
+		__atomic_store_n(&page->cycleMult, mult, __ATOMIC_RELAXED);
+		__atomic_store_n(&page->seqlock, seqlock + 2, __ATOMIC_RELEASE);
+
+		refCycles = cycles;
+		refClock = clock;
+	}
+}
+
 // ----------------------------------------------------------------------------
 // clocktracker mbus interface.
 // ----------------------------------------------------------------------------
@@ -156,6 +222,8 @@ async::detached initializeDriver() {
 	accessPage()->refClock = std::get<0>(result);
 	accessPage()->baseRealtime = std::get<1>(result);
 
+	calibrateCycleCounter();
+
 	// Create an mbus object for the device.
 	auto root = co_await mbus::Instance::global().getRoot();
 	
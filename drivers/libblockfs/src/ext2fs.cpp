@@ -29,7 +29,7 @@ namespace {
 // --------------------------------------------------------
 
 Inode::Inode(FileSystem &fs, uint32_t number)
-: fs(fs), number(number), isReady(false) { }
+: fs(fs), number(number), isReady(false), generation(fs.nextGeneration()) { }
 
 void Inode::setFileSize(size_t size) {
 	assert(!(size & ~uint64_t(0xFFFFFFFF)));
@@ -750,6 +750,7 @@ async::result<void> FileSystem::write(Inode *inode, uint64_t offset,
 			helix::BorrowedDescriptor(inode->frontalMemory),
 			offset, length, buffer);
 	HEL_CHECK(writeMemory.error());
+	inode->generation = nextGeneration();
 }
 
 async::detached FileSystem::initiateInode(std::shared_ptr<Inode> inode) {
@@ -1375,6 +1376,7 @@ async::result<void> FileSystem::truncate(Inode *inode, size_t size) {
 			helix::BorrowedDescriptor{kHelNullHandle},
 			inode->diskMapping.get(), inodeSize);
 	HEL_CHECK(syncInode.error());
+	inode->generation = nextGeneration();
 	co_return;
 }
 
@@ -1391,13 +1393,13 @@ async::result<void> FileSystem::writebackBgdt() {
 OpenFile::OpenFile(std::shared_ptr<Inode> inode)
 : inode(inode), offset(0) { }
 
-async::result<std::optional<std::string>>
-OpenFile::readEntries() {
+async::result<protocols::fs::ReadEntriesResult>
+OpenFile::readEntries(size_t maxSize) {
 	co_await inode->readyJump.wait();
 
 	if (inode->fileType != kTypeDirectory) {
 		std::cout << "\e[33m" "ext2fs: readEntries called on something that's not a directory\e[39m" << std::endl;
-		co_return std::nullopt; // FIXME: this does not indicate an error
+		co_return protocols::fs::ReadEntriesResult{}; // FIXME: this does not indicate an error
 	}
 
 	auto map_size = (inode->fileSize() + 0xFFF) & ~size_t(0xFFF);
@@ -1414,6 +1416,9 @@ OpenFile::readEntries() {
 			kHelMapProtRead | kHelMapDontRequireBacking};
 
 	// Read the directory structure.
+	// We return as many entries as fit into the caller's buffer, such that
+	// the directory only needs to be locked and mapped once per batch.
+	protocols::fs::EntriesBuilder builder{maxSize};
 	assert(offset <= inode->fileSize());
 	while(offset < inode->fileSize()) {
 		assert(!(offset & 3));
@@ -1422,17 +1427,31 @@ OpenFile::readEntries() {
 				reinterpret_cast<char *>(file_map.get()) + offset);
 		assert(offset + disk_entry->recordLength <= inode->fileSize());
 
-		offset += disk_entry->recordLength;
-
 		if(disk_entry->inode) {
-		//	std::cout << "libblockfs: Returning entry "
-		//			<< std::string(disk_entry->name, disk_entry->nameLength) << std::endl;
-			co_return std::string(disk_entry->name, disk_entry->nameLength);
+			std::string name{disk_entry->name, disk_entry->nameLength};
+			if(!builder.fits(name))
+				break;
+
+			uint8_t type;
+			switch(disk_entry->fileType) {
+			case EXT2_FT_REG_FILE: type = DT_REG; break;
+			case EXT2_FT_DIR: type = DT_DIR; break;
+			case EXT2_FT_CHRDEV: type = DT_CHR; break;
+			case EXT2_FT_BLKDEV: type = DT_BLK; break;
+			case EXT2_FT_FIFO: type = DT_FIFO; break;
+			case EXT2_FT_SOCK: type = DT_SOCK; break;
+			case EXT2_FT_SYMLINK: type = DT_LNK; break;
+			default: type = DT_UNKNOWN;
+			}
+
+			builder.add(std::move(name), disk_entry->inode, type);
 		}
+
+		offset += disk_entry->recordLength;
 	}
-	assert(offset == inode->fileSize());
+	assert(offset <= inode->fileSize());
 
-	co_return std::nullopt;
+	co_return builder.entries();
 }
 
 } } // namespace blockfs::ext2fs
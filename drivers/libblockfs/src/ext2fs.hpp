@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+#include <protocols/fs/common.hpp>
 #include <protocols/fs/file-locks.hpp>
 
 #include <async/oneshot-event.hpp>
@@ -153,6 +154,10 @@ struct DiskDirEntry {
 enum {
 	EXT2_FT_REG_FILE = 1,
 	EXT2_FT_DIR = 2,
+	EXT2_FT_CHRDEV = 3,
+	EXT2_FT_BLKDEV = 4,
+	EXT2_FT_FIFO = 5,
+	EXT2_FT_SOCK = 6,
 	EXT2_FT_SYMLINK = 7
 };
 
@@ -234,6 +239,10 @@ struct Inode : std::enable_shared_from_this<Inode> {
 	int uid, gid;
 	FlockManager flockManager;
 
+	// Changes whenever the file contents are written or truncated.
+	// Values are unique per FileSystem, even across evictions of the Inode.
+	uint64_t generation;
+
 	std::unordered_set<std::string> obstructedLinks;
 };
 
@@ -279,6 +288,10 @@ struct FileSystem {
 
 	async::result<void> writebackBgdt();
 
+	uint64_t nextGeneration() {
+		return ++generationCounter;
+	}
+
 	BlockDevice *device;
 	uint16_t inodeSize;
 	uint32_t blockShift;
@@ -292,6 +305,7 @@ struct FileSystem {
 	uint32_t inodesCount;
 	std::vector<std::byte> blockGroupDescriptorBuffer;
 	DiskGroupDesc *bgdt;
+	uint64_t generationCounter = 0;
 
 	helix::UniqueDescriptor blockBitmap;
 	helix::UniqueDescriptor inodeBitmap;
@@ -307,7 +321,7 @@ struct FileSystem {
 struct OpenFile {
 	OpenFile(std::shared_ptr<Inode> inode);
 
-	async::result<std::optional<std::string>> readEntries();
+	async::result<protocols::fs::ReadEntriesResult> readEntries(size_t maxSize);
 
 	std::shared_ptr<Inode> inode;
 	uint64_t offset;
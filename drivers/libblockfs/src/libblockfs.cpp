@@ -192,13 +192,12 @@ accessMemory(void *object) {
 }
 
 async::result<protocols::fs::ReadEntriesResult>
-readEntries(void *object) {
+readEntries(void *object, size_t maxSize) {
 	auto self = static_cast<ext2fs::OpenFile *>(object);
 
-	protocols::ostrace::Event oste{&ostContext, ostReaddirEvent};
-	co_await oste.emit();
+	protocols::ostrace::Span ostSpan{&ostContext, ostReaddirEvent};
 
-	co_return co_await self->readEntries();
+	co_return co_await self->readEntries(maxSize);
 }
 
 async::result<frg::expected<protocols::fs::Error>>
@@ -329,6 +328,7 @@ getStats(std::shared_ptr<void> object) {
 	stats.accessTime.tv_sec = self->diskInode()->atime;
 	stats.dataModifyTime.tv_sec = self->diskInode()->mtime;;
 	stats.anyChangeTime.tv_sec = self->diskInode()->ctime;
+	stats.generation = self->generation;
 
 	co_return stats;
 }
@@ -788,7 +788,7 @@ async::detached servePartition(helix::UniqueLane lane) {
 }
 
 async::detached runDevice(BlockDevice *device) {
-	ostContext = co_await protocols::ostrace::createContext();
+	ostContext = co_await protocols::ostrace::createContext("libblockfs");
 	ostReadEvent = co_await ostContext.announceEvent("libblockfs.read");
 	ostReaddirEvent = co_await ostContext.announceEvent("libblockfs.readdir");
 	ostByteCounter = co_await ostContext.announceItem("numBytes");
@@ -127,7 +127,7 @@ File::read(void *object, const char *, void *buffer, size_t max_size) {
 			auto evt = self->_pending.front();
 			self->_pending.pop_front();
 			if(self->_pending.empty())
-				self->_statusPage.update(self->_currentSeq, 0);
+				self->_statusPage.update(self->_currentSeq, 0, 0);
 
 			input_event uev;
 			memset(&uev, 0, sizeof(input_event));
@@ -300,7 +300,7 @@ helix::UniqueLane File::serve(smarter::shared_ptr<File> file) {
 
 File::File(EventDevice *device, bool non_block)
 : _device{device}, _currentSeq{1}, _nonBlock{non_block}, _clockId{CLOCK_MONOTONIC} {
-	_statusPage.update(_currentSeq, 0);
+	_statusPage.update(_currentSeq, 0, 0);
 }
 
 File::~File() {
@@ -459,7 +459,7 @@ void EventDevice::notify() {
 		for(StagedEvent evt : _staged)
 			file._pending.push_back(PendingEvent{evt.type, evt.code, evt.value, now});
 		file._currentSeq++;
-		file._statusPage.update(file._currentSeq, EPOLLIN);
+		file._statusPage.update(file._currentSeq, EPOLLIN, EPOLLIN);
 		file._statusBell.raise();
 	}
 	_staged.clear();
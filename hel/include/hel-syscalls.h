@@ -72,6 +72,15 @@ extern inline __attribute__ (( always_inline )) HelError helCancelAsync(HelHandl
 	return helSyscall2(kHelCallCancelAsync, (HelWord)handle, (HelWord)async_id);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helSubmitBatch(HelHandle queueHandle,
+		struct HelBatchEntry *entries, size_t count, size_t *numSubmitted) {
+	HelWord submitted;
+	HelError error = helSyscall3_1(kHelCallSubmitBatch, (HelWord)queueHandle, (HelWord)entries,
+			(HelWord)count, &submitted);
+	*numSubmitted = (size_t)submitted;
+	return error;
+};
+
 extern inline __attribute__ (( always_inline )) HelError helAllocateMemory(size_t size,
 		uint32_t flags, struct HelAllocRestrictions *restrictions, HelHandle *handle) {
 	HelWord hel_handle;
@@ -285,6 +294,17 @@ extern inline __attribute__ (( always_inline )) HelError helQueryThreadStats(Hel
 	return helSyscall2(kHelCallQueryThreadStats, (HelWord)handle, (HelWord)stats);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helQueryThreadStatsBatch(
+		const HelHandle *handles, size_t count, struct HelThreadStats *stats) {
+	return helSyscall3(kHelCallQueryThreadStatsBatch, (HelWord)handles, (HelWord)count,
+			(HelWord)stats);
+};
+
+extern inline __attribute__ (( always_inline )) HelError helQueryCpuStats(int cpu,
+		struct HelCpuStats *stats) {
+	return helSyscall2(kHelCallQueryCpuStats, (HelWord)cpu, (HelWord)stats);
+};
+
 extern inline __attribute__ (( always_inline )) HelError helYield() {
 	return helSyscall0(kHelCallYield);
 };
@@ -436,6 +456,24 @@ extern inline __attribute__ (( always_inline )) HelError helAutomateIrq(HelHandl
 			(HelWord)kernlet);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helSetIrqAffinity(HelHandle handle,
+		int cpu) {
+	return helSyscall2(kHelCallSetIrqAffinity, (HelWord)handle, (HelWord)cpu);
+};
+
+extern inline __attribute__ (( always_inline )) HelError helGetIrqAffinity(HelHandle handle,
+		int *cpu) {
+	HelWord cpu_word;
+	HelError error = helSyscall1_1(kHelCallGetIrqAffinity, (HelWord)handle, &cpu_word);
+	*cpu = (int)cpu_word;
+	return error;
+};
+
+extern inline __attribute__ (( always_inline )) HelError helQueryIrqStats(int index,
+		struct HelIrqStats *stats) {
+	return helSyscall2(kHelCallQueryIrqStats, (HelWord)index, (HelWord)stats);
+};
+
 extern inline __attribute__ (( always_inline )) HelError helAccessIo(uintptr_t *port_array,
 		size_t num_ports, HelHandle *handle) {
 	HelWord out_handle;
@@ -479,5 +517,25 @@ extern inline __attribute__ (( always_inline )) HelError helQueryRegisterInfo(in
 	return helSyscall2(kHelCallQueryRegisterInfo, (HelWord)set, (HelWord)info);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helSetSignalTable(HelHandle handle,
+		const struct HelSignalTable *table) {
+	return helSyscall2(kHelCallSetSignalTable, (HelWord)handle, (HelWord)table);
+};
+
+extern inline __attribute__ (( always_inline )) HelError helRaiseSignal(HelHandle handle,
+		int number, const void *info, size_t infoSize) {
+	return helSyscall4(kHelCallRaiseSignal, (HelWord)handle, (HelWord)number,
+			(HelWord)info, (HelWord)infoSize);
+};
+
+extern inline __attribute__ (( always_inline )) HelError helReclaimSignal(HelHandle handle,
+		int *number, void *info) {
+	HelWord number_word;
+	HelError error = helSyscall2_1(kHelCallReclaimSignal, (HelWord)handle, (HelWord)info,
+			&number_word);
+	*number = (int)number_word;
+	return error;
+};
+
 #endif // HEL_SYSCALLS_H
 
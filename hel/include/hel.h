@@ -18,7 +18,7 @@
 
 enum {
 	// largest system call number plus 1
-	kHelNumCalls = 104,
+	kHelNumCalls = 114,
 
 	kHelCallLog = 1,
 	kHelCallPanic = 10,
@@ -34,6 +34,7 @@ enum {
 
 	kHelCallCreateQueue = 89,
 	kHelCallCancelAsync = 92,
+	kHelCallSubmitBatch = 104,
 
 	kHelCallAllocateMemory = 51,
 	kHelCallResizeMemory = 83,
@@ -61,6 +62,8 @@ enum {
 
 	kHelCallCreateThread = 67,
 	kHelCallQueryThreadStats = 95,
+	kHelCallQueryThreadStatsBatch = 105,
+	kHelCallQueryCpuStats = 106,
 	kHelCallSetPriority = 85,
 	kHelCallYield = 34,
 	kHelCallSubmitObserve = 74,
@@ -70,6 +73,9 @@ enum {
 	kHelCallLoadRegisters = 75,
 	kHelCallStoreRegisters = 76,
 	kHelCallQueryRegisterInfo = 102,
+	kHelCallSetSignalTable = 111,
+	kHelCallRaiseSignal = 112,
+	kHelCallReclaimSignal = 113,
 	kHelCallWriteFsBase = 41,
 	kHelCallGetClock = 42,
 	kHelCallSubmitAwaitClock = 80,
@@ -95,6 +101,9 @@ enum {
 	kHelCallAcknowledgeIrq = 81,
 	kHelCallSubmitAwaitEvent = 82,
 	kHelCallAutomateIrq = 94,
+	kHelCallSetIrqAffinity = 108,
+	kHelCallGetIrqAffinity = 109,
+	kHelCallQueryIrqStats = 110,
 
 	kHelCallAccessIo = 11,
 	kHelCallEnableIo = 12,
@@ -223,6 +232,36 @@ struct HelAction {
 	HelHandle handle;
 };
 
+enum HelBatchOps {
+	kHelBatchAsyncNop = 1,
+	kHelBatchSubmitAsync = 2,
+	kHelBatchAwaitClock = 3,
+	kHelBatchAwaitEvent = 4,
+	kHelBatchReadMemory = 5,
+	kHelBatchWriteMemory = 6,
+	kHelBatchObserve = 7
+};
+
+//! A single asynchronous operation submitted through ::helSubmitBatch.
+//!
+//! The meaning of the fields depends on @p op:
+//! - kHelBatchSubmitAsync: @p pointer and @p length are the HelAction array and its size,
+//!   @p flags is passed to ::helSubmitAsync.
+//! - kHelBatchAwaitClock: @p argument is the deadline; @p asyncId receives the operation ID.
+//! - kHelBatchAwaitEvent, kHelBatchObserve: @p argument is the previous sequence number.
+//! - kHelBatchReadMemory, kHelBatchWriteMemory: @p argument is the address,
+//!   @p pointer and @p length describe the buffer.
+struct HelBatchEntry {
+	int op;
+	uint32_t flags;
+	HelHandle handle;
+	uintptr_t context;
+	void *pointer;
+	size_t length;
+	uint64_t argument;
+	uint64_t asyncId;
+};
+
 struct HelDescriptorInfo {
 	int type;
 };
@@ -287,6 +326,68 @@ struct HelRegisterInfo {
 	int setSize;
 };
 
+enum {
+	//! Maximal size of the signal info that is passed to ::helRaiseSignal.
+	kHelSignalInfoSize = 128,
+	//! Maximal size of a signal frame (excluding the SIMD state).
+	kHelSignalMaxFrameSize = 4096
+};
+
+enum {
+	//! Copy the signal info into the signal frame.
+	kHelSignalInfo = 1,
+	//! Run the handler on the alternate signal stack.
+	kHelSignalOnStack = 2
+};
+
+struct HelSignalAction {
+	//! Entry point of the handler.
+	uintptr_t handlerIp;
+	//! Return address of the handler.
+	uintptr_t restorerIp;
+	//! Signal mask that is stored in the signal frame.
+	uint64_t mask;
+	//! Combination of kHelSignal* flags.
+	uint32_t flags;
+};
+
+//! Layout of the signal frames that the kernel builds.
+//! All offsets are in bytes, relative to the start of the frame.
+//! The SIMD state (see ::kHelRegsSimd) directly follows the frame.
+struct HelSignalFrameLayout {
+	//! Size of the frame. At most ::kHelSignalMaxFrameSize.
+	size_t frameSize;
+	//! Size of the red zone below the interrupted stack pointer.
+	size_t redZoneSize;
+	//! The frame is aligned to 16 bytes minus this amount.
+	size_t stackMisalign;
+	//! Offset of the return address (on architectures that pass it on the stack).
+	size_t returnOffset;
+	//! Offset of the ::kHelRegsSignal image.
+	size_t regsOffset;
+	//! Offset of the signal mask.
+	size_t maskOffset;
+	//! Offset of the pointer to the SIMD state.
+	size_t simdPointerOffset;
+	//! Offset of the signal info. Its address is passed as second argument.
+	size_t infoOffset;
+	//! Offset of the context. Its address is passed as third argument.
+	size_t contextOffset;
+};
+
+struct HelSignalTable {
+	//! Signals (bit n - 1 for signal n) that the kernel may deliver on its own.
+	uint64_t deliverable;
+	//! Address of a flag in the thread's address space.
+	//! The kernel does not deliver signals while the flag is non-zero.
+	uintptr_t flagAddress;
+	//! Alternate signal stack. Disabled if altStackSize is zero.
+	uintptr_t altStackSp;
+	size_t altStackSize;
+	struct HelSignalFrameLayout layout;
+	struct HelSignalAction actions[64];
+};
+
 #if defined(__x86_64__)
 enum HelRegisterIndex {
 	kHelRegRax = 0,
@@ -508,8 +609,49 @@ union HelKernletData {
 	HelHandle handle;
 };
 
+enum {
+	//! Maximal number of CPUs that are reported in HelIrqStats.
+	kHelIrqStatsMaxCpus = 64
+};
+
+struct HelIrqStats {
+	//! Name of the IRQ (NUL-terminated, possibly truncated).
+	char name[64];
+	//! CPU that the IRQ is routed to, or -1 if the routing cannot be changed.
+	int affinity;
+	//! Number of times that the IRQ was raised on each CPU.
+	//! IRQs on CPUs beyond the last entry are accounted to the last entry.
+	uint64_t counts[kHelIrqStatsMaxCpus];
+};
+
 struct HelThreadStats {
+	//! Time (in nanoseconds) that the thread spent running.
 	uint64_t userTime;
+	//! Time (in nanoseconds) that the thread was runnable but waiting for a CPU.
+	uint64_t waitTime;
+	//! Number of times that the thread blocked.
+	uint64_t numVoluntarySwitches;
+	//! Number of times that the thread was preempted.
+	uint64_t numInvoluntarySwitches;
+	//! Index of the CPU that the thread was last scheduled on (or -1).
+	int lastCpu;
+};
+
+struct HelCpuStats {
+	//! Time (in nanoseconds) that the CPU spent idling.
+	uint64_t idleTime;
+	//! Time (in nanoseconds) that the CPU spent running threads.
+	uint64_t busyTime;
+	//! Number of TLB shootdowns that were submitted on the CPU.
+	//! The shootdown counters are zero on architectures that do not track them.
+	uint64_t numShootdowns;
+	//! Number of TLB shootdown IPIs that the CPU sent.
+	uint64_t numShootdownIpis;
+	//! Number of remote address space bindings that the CPU marked for a
+	//! lazy flush instead of sending an IPI.
+	uint64_t numLazyFlushes;
+	//! Number of times that the CPU flushed a whole address space instead of single pages.
+	uint64_t numFullFlushes;
 };
 
 enum {
@@ -607,6 +749,23 @@ HEL_C_LINKAGE HelError helCreateQueue(struct HelQueueParameters *params,
 //!    	ID identifying the operation.
 HEL_C_LINKAGE HelError helCancelAsync(HelHandle queueHandle, uint64_t asyncId);
 
+//! Submits multiple asynchronous operations at once.
+//!
+//! The kernel consumes the array of operation descriptors in order.
+//! Each operation behaves exactly as if it was submitted by the corresponding
+//! system call; results are delivered to @p queueHandle.
+//! Submission stops at the first operation that fails.
+//! @param[in] queueHandle
+//!    	Handle to the queue that all operations are submitted to.
+//! @param[in] entries
+//!    	Pointer to an array of operation descriptors.
+//! @param[in] count
+//!    	Number of elements in @p entries.
+//! @param[out] numSubmitted
+//!    	Number of operations that were submitted successfully.
+HEL_C_LINKAGE HelError helSubmitBatch(HelHandle queueHandle, struct HelBatchEntry *entries,
+		size_t count, size_t *numSubmitted);
+
 //! @}
 //! @name Memory Management
 //! @{
@@ -854,6 +1013,23 @@ HEL_C_LINKAGE HelError helCreateThread(HelHandle universe, HelHandle spaceHandle
 //!     Statistics related to the thread.
 HEL_C_LINKAGE HelError helQueryThreadStats(HelHandle handle, struct HelThreadStats *stats);
 
+//! Query run-time statistics of multiple threads at once.
+//! @param[in] handles
+//!     Array of @p count handles to threads.
+//! @param[in] count
+//!     Number of threads.
+//! @param[out] stats
+//!     Array of @p count statistics; the i-th entry corresponds to @p handles[i].
+HEL_C_LINKAGE HelError helQueryThreadStatsBatch(const HelHandle *handles, size_t count,
+		struct HelThreadStats *stats);
+
+//! Query idle and busy time of a CPU.
+//! @param[in] cpu
+//!     Index of the CPU. Returns ::kHelErrOutOfBounds if there is no such CPU.
+//! @param[out] stats
+//!     Statistics related to the CPU.
+HEL_C_LINKAGE HelError helQueryCpuStats(int cpu, struct HelCpuStats *stats);
+
 //! Set the priority of a thread.
 //!
 //! Managarm always runs the runnable thread with highest priority.
@@ -923,6 +1099,49 @@ HEL_C_LINKAGE HelError helStoreRegisters(HelHandle handle, int set, const void *
 //!     Returned information.
 HEL_C_LINKAGE HelError helQueryRegisterInfo(int set, struct HelRegisterInfo *info);
 
+//! Install the signal table of a thread.
+//!
+//! The signal table allows the kernel to deliver signals that were
+//! passed to ::helRaiseSignal without stopping the thread:
+//! when the thread returns from a syscall, the kernel builds
+//! a signal frame on the thread's stack and enters the handler.
+//! Signals that are not deliverable at that point interrupt the thread
+//! (as if ::helInterruptThread was called); they can be taken back
+//! via ::helReclaimSignal.
+//!
+//! This is only supported on x86_64.
+//! @param[in] handle
+//!     Handle to the thread.
+//! @param[in] table
+//!     New signal table. Pass a null pointer to disable delivery by the kernel.
+HEL_C_LINKAGE HelError helSetSignalTable(HelHandle handle, const struct HelSignalTable *table);
+
+//! Hand a signal to the kernel for delivery.
+//!
+//! At most one signal can be in flight per thread.
+//! Returns ::kHelErrQueueTooSmall if another signal has not been delivered yet
+//! and ::kHelErrIllegalState if the signal is not deliverable according to
+//! the thread's signal table.
+//! @param[in] handle
+//!     Handle to the thread.
+//! @param[in] number
+//!     Signal number (1 to 64).
+//! @param[in] info
+//!     Signal info. Copied into the frame if the action has ::kHelSignalInfo set.
+//! @param[in] infoSize
+//!     Size of the signal info. At most ::kHelSignalInfoSize.
+HEL_C_LINKAGE HelError helRaiseSignal(HelHandle handle, int number,
+		const void *info, size_t infoSize);
+
+//! Take back a signal that was passed to ::helRaiseSignal but not yet delivered.
+//! @param[in] handle
+//!     Handle to the thread.
+//! @param[out] number
+//!     Signal number or zero if no signal is in flight.
+//! @param[out] info
+//!     Buffer of ::kHelSignalInfoSize bytes that receives the signal info.
+HEL_C_LINKAGE HelError helReclaimSignal(HelHandle handle, int *number, void *info);
+
 HEL_C_LINKAGE HelError helWriteFsBase(void *pointer);
 
 HEL_C_LINKAGE HelError helReadFsBase(void **pointer);
@@ -1053,6 +1272,31 @@ HEL_C_LINKAGE HelError helSubmitAwaitEvent(HelHandle handle, uint64_t sequence,
 
 HEL_C_LINKAGE HelError helAutomateIrq(HelHandle handle, uint32_t flags, HelHandle kernlet);
 
+//! Route an IRQ to a specific CPU.
+//!
+//! This is only supported for IRQs whose routing can be changed (e.g., MSIs).
+//! MSIs are spread across CPUs by default.
+//! @param[in] handle
+//!     Handle to the IRQ.
+//! @param[in] cpu
+//!     Index of the CPU. Returns ::kHelErrIllegalArgs if there is no such CPU.
+//!     Returns ::kHelErrUnsupportedOperation if the IRQ cannot be routed to the CPU.
+HEL_C_LINKAGE HelError helSetIrqAffinity(HelHandle handle, int cpu);
+
+//! Query the CPU that an IRQ is routed to.
+//! @param[in] handle
+//!     Handle to the IRQ.
+//! @param[out] cpu
+//!     Index of the CPU, or -1 if the routing cannot be changed.
+HEL_C_LINKAGE HelError helGetIrqAffinity(HelHandle handle, int *cpu);
+
+//! Query per-CPU statistics of an IRQ (e.g., to implement /proc/interrupts).
+//! @param[in] index
+//!     Index of the IRQ. Returns ::kHelErrOutOfBounds if there is no such IRQ.
+//! @param[out] stats
+//!     Statistics related to the IRQ.
+HEL_C_LINKAGE HelError helQueryIrqStats(int index, struct HelIrqStats *stats);
+
 //! @}
 //! @name Input/Output
 //! @{
@@ -14,6 +14,9 @@
 
 namespace helix {
 
+// Defined in ipc.hpp (after Dispatcher).
+inline void flushDeferredSubmissionsFor(HelHandle handle);
+
 struct UniqueDescriptor {
 	friend void swap(UniqueDescriptor &a, UniqueDescriptor &b) {
 		using std::swap;
@@ -34,8 +37,11 @@ struct UniqueDescriptor {
 	: _handle(handle) { }
 
 	~UniqueDescriptor() {
-		if(_handle != kHelNullHandle)
+		if(_handle != kHelNullHandle) {
+			// Deferred submissions of this thread might still refer to this handle.
+			flushDeferredSubmissionsFor(_handle);
 			HEL_CHECK(helCloseDescriptor(kHelThisUniverse, _handle));
+		}
 	}
 
 	explicit operator bool () const {
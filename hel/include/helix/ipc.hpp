@@ -104,6 +104,31 @@ struct Irq { };
 using UniqueIrq = UniqueResource<Irq>;
 using BorrowedIrq = BorrowedResource<Irq>;
 
+// Returns the number of CPUs in the system.
+inline int getCpuCount() {
+	HelCpuStats stats;
+	int n = 0;
+	while(helQueryCpuStats(n, &stats) == kHelErrNone)
+		n++;
+	return n;
+}
+
+// Routes an IRQ to the given CPU. Returns false if the routing of the IRQ is fixed.
+inline bool setIrqAffinity(BorrowedDescriptor irq, int cpu) {
+	auto error = helSetIrqAffinity(irq.getHandle(), cpu);
+	if(error == kHelErrUnsupportedOperation)
+		return false;
+	HEL_CHECK(error);
+	return true;
+}
+
+// Returns the CPU that an IRQ is routed to, or -1 if its routing is fixed.
+inline int getIrqAffinity(BorrowedDescriptor irq) {
+	int cpu;
+	HEL_CHECK(helGetIrqAffinity(irq.getHandle(), &cpu));
+	return cpu;
+}
+
 struct OperationBase {
 	friend struct Dispatcher;
 
@@ -174,11 +199,15 @@ private:
 public:
 	static constexpr int sizeShift = 9;
 
+	// Maximal number of submissions that are deferred before they are flushed.
+	static constexpr size_t batchSize = 32;
+
 	static Dispatcher &global();
 
 	Dispatcher()
 	: _handle{kHelNullHandle}, _queue{nullptr},
-			_activeChunks{0}, _retrieveIndex{0}, _nextIndex{0}, _lastProgress{0} { }
+			_activeChunks{0}, _retrieveIndex{0}, _nextIndex{0}, _lastProgress{0},
+			_numDeferred{0} { }
 
 	Dispatcher(const Dispatcher &) = delete;
 
@@ -211,7 +240,62 @@ public:
 		return _handle;
 	}
 
+	// Like helSubmitAsync() but the submission is deferred until the next flushSubmissions().
+	// All deferred submissions are then passed to the kernel by a single helSubmitBatch().
+	// actions must stay valid until the operation completes.
+	void submitAsync(BorrowedDescriptor lane, const HelAction *actions, size_t count,
+			uintptr_t context) {
+		acquire();
+		if(_numDeferred == batchSize)
+			flushSubmissions();
+
+		auto entry = &_deferred[_numDeferred++];
+		entry->op = kHelBatchSubmitAsync;
+		entry->flags = 0;
+		entry->handle = lane.getHandle();
+		entry->context = context;
+		entry->pointer = const_cast<HelAction *>(actions);
+		entry->length = count;
+	}
+
+	void flushSubmissions() {
+		if(!_numDeferred)
+			return;
+
+		size_t numSubmitted;
+		HEL_CHECK(helSubmitBatch(_handle, _deferred.data(), _numDeferred, &numSubmitted));
+		assert(numSubmitted == _numDeferred);
+		_numDeferred = 0;
+	}
+
+	// Flushes all deferred submissions if one of them refers to the given handle,
+	// either as the lane or as a descriptor that is pushed or whose credentials are imbued.
+	// Called before the handle is used for an immediate submission (such that the kernel
+	// sees all submissions on a lane in program order) and before the handle is closed.
+	void flushSubmissionsFor(HelHandle handle) {
+		for(size_t i = 0; i < _numDeferred; ++i) {
+			if(_deferred[i].handle == handle) {
+				flushSubmissions();
+				return;
+			}
+
+			auto actions = static_cast<const HelAction *>(_deferred[i].pointer);
+			for(size_t j = 0; j < _deferred[i].length; ++j) {
+				if(actions[j].type != kHelActionPushDescriptor
+						&& actions[j].type != kHelActionImbueCredentials)
+					continue;
+				if(actions[j].handle == handle) {
+					flushSubmissions();
+					return;
+				}
+			}
+		}
+	}
+
 	void wait() {
+		// Submissions made by the previous completion must reach the kernel before we block.
+		flushSubmissions();
+
 		while(true) {
 			// TODO: Initialize all chunks when setting up the queue.
 			if(_retrieveIndex == _nextIndex) {
@@ -344,8 +428,16 @@ private:
 
 	// Per-chunk reference counts.
 	int _refCounts[16];
+
+	// Submissions that were not passed to the kernel yet.
+	std::array<HelBatchEntry, batchSize> _deferred;
+	size_t _numDeferred;
 };
 
+inline void flushDeferredSubmissionsFor(HelHandle handle) {
+	Dispatcher::global().flushSubmissionsFor(handle);
+}
+
 inline void CurrentDispatcherToken::wait() {
 	Dispatcher::global().wait();
 }
@@ -831,6 +923,9 @@ struct Transmission : private Context {
 	Transmission(BorrowedDescriptor descriptor, std::array<HelAction, sizeof...(I)> actions,
 			std::array<Operation *, sizeof...(I)> results, Dispatcher &dispatcher)
 	: _results(results) {
+		// Only exchangeMsgs() defers submissions, and only on the global dispatcher.
+		Dispatcher::global().flushSubmissionsFor(descriptor.getHandle());
+
 		auto context = static_cast<Context *>(this);
 		HEL_CHECK(helSubmitAsync(descriptor.getHandle(), actions.data(), sizeof...(I),
 				dispatcher.acquire(),
@@ -915,12 +1010,14 @@ struct ExchangeMsgsOperation : private Context {
 	: lane_{std::move(lane)}, actions_{std::move(actions)}, receiver_{std::move(receiver)} { }
 
 	void start() {
-		auto helActions = frg::apply(chainActionArrays, actions_);
+		helActions_ = frg::apply(chainActionArrays, actions_);
 
+		// The kernel only reads the actions once the dispatcher flushes its submissions,
+		// hence they are stored in the operation.
 		auto context = static_cast<Context *>(this);
-		HEL_CHECK(helSubmitAsync(lane_.getHandle(),
-				helActions.data(), helActions.size(), Dispatcher::global().acquire(),
-				reinterpret_cast<uintptr_t>(context), 0));
+		Dispatcher::global().submitAsync(lane_,
+				helActions_.data(), helActions_.size(),
+				reinterpret_cast<uintptr_t>(context));
 	}
 
 private:
@@ -937,6 +1034,7 @@ private:
 
 	BorrowedDescriptor lane_;
 	Actions actions_;
+	decltype(frg::apply(chainActionArrays, std::declval<Actions &>())) helActions_;
 	Receiver receiver_;
 };
 
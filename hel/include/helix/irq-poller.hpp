@@ -0,0 +1,139 @@
+#pragma once
+
+#include <async/basic.hpp>
+#include <async/recurring-event.hpp>
+#include <async/result.hpp>
+#include <helix/ipc.hpp>
+#include <helix/timer.hpp>
+
+namespace helix {
+
+struct IrqPollerOptions {
+	// Maximal number of completions that are processed per round.
+	size_t budget = 64;
+
+	// Switch to polling once a single IRQ yields at least this many completions.
+	size_t pollThreshold = 16;
+
+	// Switch back to IRQs after polling did not find completions for this long.
+	uint64_t idleTimeoutNs = 50'000;
+
+	// Delay between two polling rounds. If zero, rounds are only separated
+	// by a trip through the dispatcher (such that other coroutines can run).
+	uint64_t pollIntervalNs = 0;
+};
+
+struct IrqPollerStats {
+	// Number of times that schedule() was called.
+	uint64_t numIrqs = 0;
+	// Number of rounds that were run in polling mode.
+	uint64_t numPolls = 0;
+	// Number of polling rounds that did not find any completions.
+	uint64_t numEmptyPolls = 0;
+	// Total number of completions.
+	uint64_t numCompletions = 0;
+	// Number of switches from IRQ mode to polling mode.
+	uint64_t numPollEntries = 0;
+};
+
+// Adaptively switches between IRQ-driven and polling-driven completion processing
+// (similar to Linux' NAPI). Under high completion rates, the device IRQ is masked and
+// completions are polled; once the device becomes idle, the IRQ is unmasked again.
+//
+// The device type D needs to provide:
+// * size_t pollCompletions(size_t budget): processes up to budget completions
+//   and returns the number of completions that were processed.
+// * void maskCompletionIrqs() and void unmaskCompletionIrqs(): disable (or enable)
+//   the device's completion IRQs, e.g., by setting VIRTQ_AVAIL_F_NO_INTERRUPT.
+//   Masking only needs to be a hint to the device.
+//
+// Drivers keep ACKing IRQs in their IRQ loop and call schedule() instead of
+// processing completions directly.
+template<typename D>
+struct IrqPoller {
+	IrqPoller(D *device, IrqPollerOptions options = {})
+	: _device{device}, _options{options} { }
+
+	IrqPoller(const IrqPoller &) = delete;
+
+	IrqPoller &operator= (const IrqPoller &) = delete;
+
+	// Called by the driver after it received (and ACKed) a completion IRQ.
+	void schedule() {
+		_stats.numIrqs++;
+		_pending = true;
+		_doorbell.raise();
+	}
+
+	const IrqPollerStats &stats() const {
+		return _stats;
+	}
+
+	async::detached run() {
+		while(true) {
+			co_await _doorbell.async_wait_if([&] () -> bool {
+				return !_pending;
+			});
+			_pending = false;
+
+			auto n = _drain();
+			if(n < _options.pollThreshold)
+				continue;
+
+			_stats.numPollEntries++;
+			_device->maskCompletionIrqs();
+			co_await _poll();
+		}
+	}
+
+private:
+	// Processes completions until the device runs dry or the budget is exhausted.
+	size_t _drain() {
+		auto n = _device->pollCompletions(_options.budget);
+		_stats.numCompletions += n;
+		return n;
+	}
+
+	async::result<void> _poll() {
+		uint64_t lastCompletion;
+		HEL_CHECK(helGetClock(&lastCompletion));
+
+		while(true) {
+			if(_options.pollIntervalNs) {
+				co_await sleepFor(_options.pollIntervalNs);
+			}else{
+				auto result = co_await helix_ng::asyncNop();
+				HEL_CHECK(result.error());
+			}
+
+			_stats.numPolls++;
+			if(_drain()) {
+				HEL_CHECK(helGetClock(&lastCompletion));
+				continue;
+			}
+			_stats.numEmptyPolls++;
+
+			uint64_t now;
+			HEL_CHECK(helGetClock(&now));
+			if(now - lastCompletion < _options.idleTimeoutNs)
+				continue;
+
+			// Completions that arrive before the IRQ is unmasked would not raise an IRQ.
+			// Hence, we need to check once more after unmasking.
+			_device->unmaskCompletionIrqs();
+			if(!_drain())
+				co_return;
+			_device->maskCompletionIrqs();
+			HEL_CHECK(helGetClock(&lastCompletion));
+		}
+	}
+
+	D *_device;
+	IrqPollerOptions _options;
+	IrqPollerStats _stats;
+
+	bool _pending = false;
+	async::recurring_event _doorbell;
+};
+
+} // namespace helix
@@ -6,11 +6,18 @@
 #include <thor-internal/kasan.hpp>
 #include <thor-internal/main.hpp>
 #include <thor-internal/physical.hpp>
+#include <thor-internal/profile.hpp>
+#include <thor-internal/timer.hpp>
 
 namespace thor {
 
 namespace {
 	constexpr bool disableSmp = false;
+
+	// Physical address of the first AP trampoline page.
+	// Each AP that is booted concurrently uses its own page (see memory.txt).
+	constexpr uintptr_t trampolineBase = 0x10000;
+	constexpr size_t maxConcurrentAps = 64;
 }
 
 namespace {
@@ -62,6 +69,42 @@ size_t Executor::determineSize() {
 	return sizeof(General) + 0x10 + determineSimdSize();
 }
 
+void Executor::materializeSimdState() {
+	if(!getGlobalCpuFeatures()->haveXsaveopt)
+		return;
+
+	auto area = reinterpret_cast<uint8_t *>(_fxState());
+	uint64_t xstateBv;
+	memcpy(&xstateBv, area + 512, sizeof(uint64_t));
+
+	// x87 state. Note that MXCSR is not part of this component.
+	if(!(xstateBv & 1)) {
+		auto fx = _fxState();
+		fx->fcw = 0x37F;
+		fx->fsw = 0;
+		fx->ftw = 0;
+		fx->fop = 0;
+		fx->fpuIp = 0;
+		fx->fpuDp = 0;
+		memset(area + 32, 0, 128);
+	}
+	// SSE state (XMM0 - XMM15).
+	if(!(xstateBv & 2))
+		memset(area + 160, 0, 256);
+	// All other components are located using CPUID leaf 0xD.
+	auto xcr0 = common::x86::rdxcr(0);
+	for(int i = 2; i < 64; i++) {
+		if(!(xcr0 & (uint64_t(1) << i)) || (xstateBv & (uint64_t(1) << i)))
+			continue;
+		auto leaf = common::x86::cpuid(0xD, i);
+		auto size = leaf[0];
+		auto offset = leaf[1];
+		if(!size || offset + size > determineSimdSize())
+			continue;
+		memset(area + offset, 0, size);
+	}
+}
+
 Executor::Executor()
 : _pointer{nullptr}, _syscallStack{nullptr}, _tss{nullptr} { }
 
@@ -136,11 +179,7 @@ void saveExecutor(Executor *executor, FaultImageAccessor accessor) {
 	executor->general()->clientFs = common::x86::rdmsr(common::x86::kMsrIndexFsBase);
 	executor->general()->clientGs = common::x86::rdmsr(common::x86::kMsrIndexKernelGsBase);
 
-	if(getGlobalCpuFeatures()->haveXsave){
-		common::x86::xsave((uint8_t*)executor->_fxState(), ~0);
-	} else {
-		asm volatile ("fxsaveq %0" : : "m" (*executor->_fxState()));
-	}
+	saveSimdState(executor);
 }
 
 void saveExecutor(Executor *executor, IrqImageAccessor accessor) {
@@ -169,12 +208,7 @@ void saveExecutor(Executor *executor, IrqImageAccessor accessor) {
 	executor->general()->clientFs = common::x86::rdmsr(common::x86::kMsrIndexFsBase);
 	executor->general()->clientGs = common::x86::rdmsr(common::x86::kMsrIndexKernelGsBase);
 
-
-	if(getGlobalCpuFeatures()->haveXsave){
-		common::x86::xsave((uint8_t*)executor->_fxState(), ~0);
-	}else{
-		asm volatile ("fxsaveq %0" : : "m" (*executor->_fxState()));
-	}
+	saveSimdState(executor);
 }
 
 void saveExecutor(Executor *executor, SyscallImageAccessor accessor) {
@@ -203,11 +237,30 @@ void saveExecutor(Executor *executor, SyscallImageAccessor accessor) {
 	executor->general()->clientFs = common::x86::rdmsr(common::x86::kMsrIndexFsBase);
 	executor->general()->clientGs = common::x86::rdmsr(common::x86::kMsrIndexKernelGsBase);
 
-	if(getGlobalCpuFeatures()->haveXsave){
-		common::x86::xsave((uint8_t*)executor->_fxState(), ~0);
-	}else{
-		asm volatile ("fxsaveq %0" : : "m" (*executor->_fxState()));
-	}
+	saveSimdState(executor);
+}
+
+void saveSignalRegisters(uintptr_t *regs, SyscallImageAccessor accessor) {
+	// This matches the layout of kHelRegsSignal.
+	regs[0] = accessor._frame()->r8;
+	regs[1] = accessor._frame()->r9;
+	regs[2] = accessor._frame()->r10;
+	regs[3] = 0; // r11
+	regs[4] = accessor._frame()->r12;
+	regs[5] = accessor._frame()->r13;
+	regs[6] = accessor._frame()->r14;
+	regs[7] = accessor._frame()->r15;
+	regs[8] = accessor._frame()->rdi;
+	regs[9] = accessor._frame()->rsi;
+	regs[10] = accessor._frame()->rbp;
+	regs[11] = 0; // rbx
+	regs[12] = accessor._frame()->rdx;
+	regs[13] = accessor._frame()->rax;
+	regs[14] = 0; // rcx
+	regs[15] = accessor._frame()->rsp;
+	regs[16] = accessor._frame()->rip;
+	regs[17] = accessor._frame()->rflags;
+	regs[18] = kSelClientUserCode;
 }
 
 void switchExecutor(smarter::borrowed_ptr<Thread> thread) {
@@ -415,6 +468,11 @@ static initgraph::Task enumerateCpuFeaturesTask{&globalInitEngine, "x86.enumerat
 
 			auto xsaveCpuid = common::x86::cpuid(0xD);
 			globalCpuFeatures.xsaveRegionSize = xsaveCpuid[2];
+
+			if(common::x86::cpuid(0xD, 1)[0] & 1) {
+				infoLogger() << "\e[37mthor: CPUs support XSAVEOPT\e[39m" << frg::endlog;
+				globalCpuFeatures.haveXsaveopt = true;
+			}
 		}else{
 			infoLogger() << "\e[37mthor: CPUs do not support XSAVE!\e[39m" << frg::endlog;
 		}
@@ -529,6 +587,8 @@ static initgraph::Task enumerateCpuFeaturesTask{&globalInitEngine, "x86.enumerat
 
 namespace {
 	frg::manual_box<frg::vector<CpuData *, KernelAlloc>> allCpuContexts;
+	// Protects allCpuContexts while APs initialize themselves concurrently.
+	frg::ticket_spinlock allCpuContextsMutex;
 }
 
 CpuData *getCpuData(size_t k) {
@@ -593,9 +653,12 @@ static initgraph::Task initBootProcessorTask{&globalInitEngine, "x86.init-boot-p
 void initializeThisProcessor() {
 	auto cpuData = getCpuData();
 
-	// TODO: If we want to make bootSecondary() parallel, we have to lock here.
-	cpuData->cpuIndex = allCpuContexts->size();
-	allCpuContexts->push(cpuData);
+	{
+		auto lock = frg::guard(&allCpuContextsMutex);
+
+		cpuData->cpuIndex = allCpuContexts->size();
+		allCpuContexts->push(cpuData);
+	}
 
 	// Allocate per-CPU areas.
 	cpuData->irqStack = UniqueKernelStack::make();
@@ -802,6 +865,8 @@ void secondaryMain(StatusBlock *statusBlock) {
 
 	infoLogger() << "Hello world from CPU #" << getLocalApicId() << frg::endlog;
 
+	initializeProfileOnThisCpu();
+
 	Scheduler::resume(cpuContext->wqFiber);
 
 	auto scheduler = localScheduler();
@@ -810,77 +875,116 @@ void secondaryMain(StatusBlock *statusBlock) {
 	scheduler->commitReschedule();
 }
 
-void bootSecondary(unsigned int apic_id) {
-	if(disableSmp)
-		return;
+namespace {
 
-	// TODO: Allocate a page in low physical memory instead of hard-coding it.
-	uintptr_t pma = 0x10000;
+// Boots up to maxConcurrentAps APs at the same time.
+void bootSecondaryGroup(const unsigned int *apicIds, size_t count) {
+	assert(count <= maxConcurrentAps);
+	StatusBlock *statusBlocks[maxConcurrentAps];
 
-	// Copy the trampoline code into low physical memory.
 	auto image_size = (uintptr_t)_binary_kernel_thor_arch_x86_trampoline_bin_end
 			- (uintptr_t)_binary_kernel_thor_arch_x86_trampoline_bin_start;
-	assert(image_size <= kPageSize);
-	PageAccessor accessor{pma};
-	memcpy(accessor.get(), _binary_kernel_thor_arch_x86_trampoline_bin_start, image_size);
+	assert(image_size <= kPageSize - sizeof(StatusBlock));
 
-	// Allocate a stack for the initialization code.
-	constexpr size_t stack_size = 0x10000;
-	void *stack_ptr = kernelAlloc->allocate(stack_size);
+	auto setupStart = systemClockSource()->currentNanos();
 
-	auto context = frg::construct<CpuData>(*kernelAlloc);
-	context->localApicId = apic_id;
+	for(size_t i = 0; i < count; i++) {
+		// Copy the trampoline code into low physical memory.
+		// Every AP gets its own copy such that the status blocks do not collide.
+		PageAccessor accessor{trampolineBase + i * kPageSize};
+		memcpy(accessor.get(), _binary_kernel_thor_arch_x86_trampoline_bin_start, image_size);
 
-	// Participate in global TLB invalidation *before* paging is used by the target CPU.
-	{
-		auto irqLock = frg::guard(&irqMutex());
+		// Allocate a stack for the initialization code.
+		constexpr size_t stack_size = 0x10000;
+		void *stack_ptr = kernelAlloc->allocate(stack_size);
 
-		context->globalBinding.bind();
-	}
+		auto context = frg::construct<CpuData>(*kernelAlloc);
+		context->localApicId = apicIds[i];
+
+		// Participate in global TLB invalidation *before* paging is used by the target CPU.
+		{
+			auto irqLock = frg::guard(&irqMutex());
 
-	// Setup a status block to communicate information to the AP.
-	auto statusBlock = reinterpret_cast<StatusBlock *>(reinterpret_cast<char *>(accessor.get())
-			+ (kPageSize - sizeof(StatusBlock)));
-	infoLogger() << "status block accessed via: " << statusBlock << frg::endlog;
+			context->globalBinding.bind();
+		}
 
-	statusBlock->self = statusBlock;
-	statusBlock->targetStage = 0;
-	statusBlock->initiatorStage = 0;
-	statusBlock->pml4 = KernelPageSpace::global().rootTable();
-	statusBlock->stack = (uintptr_t)stack_ptr + stack_size;
-	statusBlock->main = &secondaryMain;
-	statusBlock->cpuContext = context;
+		// Setup a status block to communicate information to the AP.
+		auto statusBlock = reinterpret_cast<StatusBlock *>(reinterpret_cast<char *>(accessor.get())
+				+ (kPageSize - sizeof(StatusBlock)));
 
-	// Send the IPI sequence that starts up the AP.
+		statusBlock->self = statusBlock;
+		statusBlock->targetStage = 0;
+		statusBlock->initiatorStage = 0;
+		statusBlock->pml4 = KernelPageSpace::global().rootTable();
+		statusBlock->stack = (uintptr_t)stack_ptr + stack_size;
+		statusBlock->main = &secondaryMain;
+		statusBlock->cpuContext = context;
+		statusBlocks[i] = statusBlock;
+
+		infoLogger() << "thor: Booting AP " << apicIds[i] << "." << frg::endlog;
+	}
+
+	// Send the IPI sequence that starts up the APs.
 	// On modern processors INIT lets the processor enter the wait-for-SIPI state.
 	// The BIOS is not involved in this process at all.
-	infoLogger() << "thor: Booting AP " << apic_id << "." << frg::endlog;
-	raiseInitAssertIpi(apic_id);
+	// The delays are only paid once per group since we IPI all APs before waiting.
+	auto initStart = systemClockSource()->currentNanos();
+	for(size_t i = 0; i < count; i++)
+		raiseInitAssertIpi(apicIds[i]);
 	KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(10'000'000)); // Wait for 10ms.
 
 	// SIPI causes the processor to resume execution and resets CS:IP.
 	// Intel suggets to send two SIPIs (probably for redundancy reasons).
-	raiseStartupIpi(apic_id, pma);
+	auto sipiStart = systemClockSource()->currentNanos();
+	for(size_t i = 0; i < count; i++)
+		raiseStartupIpi(apicIds[i], trampolineBase + i * kPageSize);
 	KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(200'000)); // Wait for 200us.
-	raiseStartupIpi(apic_id, pma);
+	for(size_t i = 0; i < count; i++)
+		raiseStartupIpi(apicIds[i], trampolineBase + i * kPageSize);
 	KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(200'000)); // Wait for 200us.
 
-	// Wait until the AP wakes up.
-	while(__atomic_load_n(&statusBlock->targetStage, __ATOMIC_ACQUIRE) < 1) {
-		pause();
+	// Wait until the APs wake up.
+	auto wakeStart = systemClockSource()->currentNanos();
+	for(size_t i = 0; i < count; i++) {
+		while(__atomic_load_n(&statusBlocks[i]->targetStage, __ATOMIC_ACQUIRE) < 1) {
+			pause();
+		}
 	}
-	infoLogger() << "thor: AP did wake up." << frg::endlog;
 
-	// We only let the AP proceed after all IPIs have been sent.
-	// This ensures that the AP does not execute boot code twice (e.g. in case
+	// We only let the APs proceed after all IPIs have been sent.
+	// This ensures that no AP executes boot code twice (e.g. in case
 	// it already wakes up after a single SIPI).
-	__atomic_store_n(&statusBlock->initiatorStage, 1, __ATOMIC_RELEASE);
-
-	// Wait until the AP exits the boot code.
-	while(__atomic_load_n(&statusBlock->targetStage, __ATOMIC_ACQUIRE) < 2) {
-		pause();
+	for(size_t i = 0; i < count; i++)
+		__atomic_store_n(&statusBlocks[i]->initiatorStage, 1, __ATOMIC_RELEASE);
+
+	// Wait until the APs exit the boot code.
+	// initializeThisProcessor() (including timer calibration) runs on all APs in parallel.
+	auto initializeStart = systemClockSource()->currentNanos();
+	for(size_t i = 0; i < count; i++) {
+		while(__atomic_load_n(&statusBlocks[i]->targetStage, __ATOMIC_ACQUIRE) < 2) {
+			pause();
+		}
 	}
-	infoLogger() << "thor: AP finished booting." << frg::endlog;
+	auto groupEnd = systemClockSource()->currentNanos();
+
+	infoLogger() << "thor: Booted " << count << " APs in "
+			<< (groupEnd - setupStart) / 1000 << " us"
+			<< " (setup: " << (initStart - setupStart) / 1000 << " us"
+			<< ", INIT: " << (sipiStart - initStart) / 1000 << " us"
+			<< ", SIPI: " << (wakeStart - sipiStart) / 1000 << " us"
+			<< ", wake-up: " << (initializeStart - wakeStart) / 1000 << " us"
+			<< ", initialization: " << (groupEnd - initializeStart) / 1000 << " us)"
+			<< frg::endlog;
+}
+
+} // anonymous namespace
+
+void bootSecondaries(const unsigned int *apicIds, size_t count) {
+	if(disableSmp)
+		return;
+
+	for(size_t k = 0; k < count; k += maxConcurrentAps)
+		bootSecondaryGroup(apicIds + k, frg::min(count - k, maxConcurrentAps));
 }
 
 Error getEntropyFromCpu(void *buffer, size_t size) {
@@ -1,8 +1,10 @@
+#include <string.h>
 
 #include <thor-internal/cpu-data.hpp>
 #include <thor-internal/profile.hpp>
 #include <thor-internal/thread.hpp>
 #include <thor-internal/arch/cpu.hpp>
+#include <thor-internal/arch/paging.hpp>
 #include <thor-internal/arch/pmc-amd.hpp>
 #include <thor-internal/arch/pmc-intel.hpp>
 
@@ -500,6 +502,55 @@ extern "C" void onPlatformWork() {
 	disableInts();
 }
 
+namespace {
+
+// Walks a frame-pointer chain starting at bp.
+// All memory accesses go through peekActiveSpaceWord() such that we never fault.
+void walkProfileFrames(ProfileSample &sample, uintptr_t bp, bool user) {
+	while(sample.numFrames < maxProfileFrames && bp) {
+		uint64_t nextBp;
+		uint64_t ip;
+		if(!peekActiveSpaceWord(bp, &nextBp, user)
+				|| !peekActiveSpaceWord(bp + sizeof(uint64_t), &ip, user))
+			break;
+		if(!ip)
+			break;
+		sample.frames[sample.numFrames++] = ip;
+
+		// Stacks grow downwards; anything else indicates a broken chain.
+		if(nextBp <= bp)
+			break;
+		bp = nextBp;
+	}
+}
+
+void recordProfileSample(CpuData *cpuData, NmiImageAccessor image) {
+	ProfileSample sample;
+	sample.numFrames = 0;
+	sample.cpu = cpuData->cpuIndex;
+
+	uint64_t cr3;
+	asm volatile ("mov %%cr3, %0" : "=r"(cr3));
+	sample.space = cr3 & 0x000F'FFFF'FFFF'F000;
+
+	sample.frames[sample.numFrames++] = *image.ip();
+
+	sample.thread = 0;
+	if(*image.cs() & 3) {
+		if(auto thread = cpuData->activeExecutor; thread)
+			memcpy(&sample.thread, thread->credentials() + 8, sizeof(uint64_t));
+		walkProfileFrames(sample, *image.bp(), true);
+	}else{
+#ifdef THOR_HAS_FRAME_POINTERS
+		walkProfileFrames(sample, *image.bp(), false);
+#endif
+	}
+
+	cpuData->localProfileRing->enqueue(&sample, profileSampleSize(sample));
+}
+
+} // anonymous namespace
+
 extern "C" void onPlatformNmi(NmiImageAccessor image) {
 	// If we interrupted user space or a kernel stub, we might need to update GS.
 	auto gs = common::x86::rdmsr(common::x86::kMsrIndexGsBase);
@@ -511,13 +562,11 @@ extern "C" void onPlatformNmi(NmiImageAccessor image) {
 	bool explained = false;
 	auto pmcMechanism = cpuData->profileMechanism.load(std::memory_order_acquire);
 	if(pmcMechanism == ProfileMechanism::intelPmc && checkIntelPmcOverflow()) {
-		uintptr_t ip = *image.ip();
-		cpuData->localProfileRing->enqueue(&ip, sizeof(uintptr_t));
+		recordProfileSample(cpuData, image);
 		setIntelPmc();
 		explained = true;
 	}else if(pmcMechanism == ProfileMechanism::amdPmc && checkAmdPmcOverflow()) {
-		uintptr_t ip = *image.ip();
-		cpuData->localProfileRing->enqueue(&ip, sizeof(uintptr_t));
+		recordProfileSample(cpuData, image);
 		setAmdPmc();
 		explained = true;
 	}
@@ -81,14 +81,100 @@ enum {
 
 namespace thor {
 
+bool peekActiveSpaceWord(uintptr_t address, uint64_t *value, bool user) {
+	if(address & (sizeof(uint64_t) - 1))
+		return false;
+	if(user && inHigherHalf(address))
+		return false;
+	// Reject non-canonical addresses.
+	if(!user && !inHigherHalf(address))
+		return false;
+	if((address >> 47) != 0 && (address >> 47) != 0x1FFFF)
+		return false;
+
+	uint64_t cr3;
+	asm volatile ("mov %%cr3, %0" : "=r"(cr3));
+
+	PhysicalAddr table = cr3 & kPageAddress;
+	for(int shift = 39; ; shift -= 9) {
+		auto entries = reinterpret_cast<uint64_t *>(0xFFFF'8000'0000'0000 + table);
+		auto entry = __atomic_load_n(&entries[(address >> shift) & 0x1FF], __ATOMIC_RELAXED);
+		if(!(entry & kPagePresent))
+			return false;
+		if(user && !(entry & kPageUser))
+			return false;
+
+		auto mask = (uintptr_t{1} << shift) - 1;
+		if(shift == 12 || ((shift == 21 || shift == 30) && (entry & 0x80))) {
+			// We reached a 4 KiB, 2 MiB or 1 GiB page.
+			// Only read from write-back pages; everything else is likely MMIO.
+			// Note that the PAT bit moves to bit 12 for 2 MiB and 1 GiB pages.
+			uint64_t cachingBits = kPagePwt | kPagePcd;
+			cachingBits |= (shift == 12) ? uint64_t{kPagePat} : uint64_t{0x1000};
+			if(entry & cachingBits)
+				return false;
+
+			// The direct map only covers RAM (see eir's mapRegionsAndStructs()).
+			// Reading other addresses through it faults, e.g., for framebuffers
+			// or memory that user space obtained through HardwareMemory.
+			PhysicalAddr physical = (entry & kPageAddress & ~mask) + (address & mask);
+			if(!physicalAllocator->isRam(physical))
+				return false;
+			*value = *reinterpret_cast<uint64_t *>(0xFFFF'8000'0000'0000 + physical);
+			return true;
+		}
+		table = entry & kPageAddress;
+	}
+}
+
 // --------------------------------------------------------
 
 PageContext::PageContext()
 : _nextStamp{1}, _primaryBinding{nullptr} { }
 
 PageBinding::PageBinding()
-: _pcid{0}, _boundSpace{nullptr},
-		_primaryStamp{0}, _alreadyShotSequence{0} { }
+: _pcid{0}, _cpuIndex{-1}, _boundSpace{nullptr},
+		_primaryStamp{0}, _alreadyShotSequence{0}, _ipiSequence{0},
+		_active{false}, _lazySequence{noLazyFlush} { }
+
+template<typename F>
+void PageBinding::_forEachOwedShootdown(PageSpace *space,
+		uint64_t sinceSequence, uint64_t lazySequence, F fn) {
+	if(space->_shootQueue.empty())
+		return;
+
+	auto current = space->_shootQueue.back();
+	while(current->_sequence > sinceSequence) {
+		auto predecessor = current->_queueNode.previous;
+
+		if(current->_initiatorCpu != getCpuData() && current->_sequence < lazySequence)
+			fn(current);
+
+		if(!predecessor)
+			break;
+		current = predecessor;
+	}
+}
+
+template<typename List>
+void PageBinding::_acknowledgeShootdown(PageSpace *space, ShootNode *node, List &complete) {
+	if(node->_bindingsToShoot.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		auto it = space->_shootQueue.iterator_to(node);
+		space->_shootQueue.erase(it);
+		complete.push_front(node);
+	}
+}
+
+void PageBinding::_makePrimary() {
+	auto context = &getCpuData()->pageContext;
+
+	// Shootdowns may skip the previous primary binding from now on.
+	if(context->_primaryBinding && context->_primaryBinding != this)
+		context->_primaryBinding->_active.store(false, std::memory_order_relaxed);
+
+	_primaryStamp = context->_nextStamp++;
+	context->_primaryBinding = this;
+}
 
 bool PageBinding::isPrimary() {
 	assert(!intsAreEnabled());
@@ -102,44 +188,89 @@ void PageBinding::rebind() {
 	assert(!intsAreEnabled());
 	assert(getCpuData()->havePcids || !_pcid);
 	assert(_boundSpace);
-	auto context = &getCpuData()->pageContext;
 
-	auto cr3 = _boundSpace->rootTable() | _pcid;
-	if(getCpuData()->havePcids)
-		cr3 |= PhysicalAddr(1) << 63; // Do not invalidate the PCID.
-	asm volatile ("mov %0, %%cr3" : : "r"(cr3) : "memory");
+	frg::intrusive_list<
+		ShootNode,
+		frg::locate_member<
+			ShootNode,
+			frg::default_list_hook<ShootNode>,
+			&ShootNode::_queueNode
+		>
+	> complete;
 
-	_primaryStamp = context->_nextStamp++;
-	context->_primaryBinding = this;
+	{
+		auto lock = frg::guard(&_boundSpace->_mutex);
+
+		auto cr3 = _boundSpace->rootTable() | _pcid;
+		if(_lazySequence == noLazyFlush) {
+			if(getCpuData()->havePcids)
+				cr3 |= PhysicalAddr(1) << 63; // Do not invalidate the PCID.
+			asm volatile ("mov %0, %%cr3" : : "r"(cr3) : "memory");
+		}else{
+			// Shootdowns skipped this binding while it was inactive.
+			// Switch CR3 and invalidate the PCID, then acknowledge the remaining requests.
+			asm volatile ("mov %0, %%cr3" : : "r"(cr3) : "memory");
+
+			_forEachOwedShootdown(_boundSpace.get(), _alreadyShotSequence, _lazySequence,
+					[&] (ShootNode *node) {
+				_acknowledgeShootdown(_boundSpace.get(), node, complete);
+			});
+
+			_alreadyShotSequence = _boundSpace->_shootSequence;
+			_lazySequence = noLazyFlush;
+			_boundSpace->_countShootdown(&ShootdownStats::fullFlushes);
+		}
+
+		_active.store(true, std::memory_order_relaxed);
+	}
+
+	_makePrimary();
+
+	while(!complete.empty()) {
+		auto current = complete.pop_front();
+		current->complete();
+	}
 }
 
 void PageBinding::rebind(smarter::shared_ptr<PageSpace> space) {
 	assert(!intsAreEnabled());
 	assert(getCpuData()->havePcids || !_pcid);
 	assert(!_boundSpace || _boundSpace.get() != space.get()); // This would be unnecessary work.
-	auto context = &getCpuData()->pageContext;
 
 	auto unbound_space = _boundSpace;
 	auto unbound_sequence = _alreadyShotSequence;
+	auto unbound_lazy_sequence = _lazySequence;
+
+	// Stop receiving shootdown requests for the unbound space.
+	// Since we invalidate the PCID below, we do not need to be counted for new requests.
+	if(unbound_space) {
+		auto lock = frg::guard(&unbound_space->_mutex);
+
+		unbound_space->_bindings.erase(unbound_space->_bindings.iterator_to(this));
+		if(unbound_lazy_sequence == noLazyFlush)
+			unbound_lazy_sequence = unbound_space->_shootSequence + 1;
+	}
 
 	// Bind the new space.
-	uint64_t target_seq;
 	{
 		auto lock = frg::guard(&space->_mutex);
 
-		target_seq = space->_shootSequence;
+		_boundSpace = space;
+		_alreadyShotSequence = space->_shootSequence;
+		_ipiSequence = 0;
+		_lazySequence = noLazyFlush;
+		_cpuIndex = getCpuData()->cpuIndex;
+		_active.store(true, std::memory_order_relaxed);
+
 		space->_numBindings++;
+		space->_bindings.push_back(this);
 	}
 
-	_boundSpace = space;
-	_alreadyShotSequence = target_seq;
-
 	// Switch CR3 and invalidate the PCID.
 	auto cr3 = space->rootTable() | _pcid;
 	asm volatile ("mov %0, %%cr3" : : "r"(cr3) : "memory");
 
-	_primaryStamp = context->_nextStamp++;
-	context->_primaryBinding = this;
+	_makePrimary();
 
 	// Mark every shootdown request in the unbound space as shot-down.
 	frg::intrusive_list<
@@ -154,25 +285,10 @@ void PageBinding::rebind(smarter::shared_ptr<PageSpace> space) {
 	if(unbound_space) {
 		auto lock = frg::guard(&unbound_space->_mutex);
 
-		if(!unbound_space->_shootQueue.empty()) {
-			auto current = unbound_space->_shootQueue.back();
-			while(current->_sequence > unbound_sequence) {
-				auto predecessor = current->_queueNode.previous;
-
-				// Signal completion of the shootdown.
-				if(current->_initiatorCpu != getCpuData()) {
-					if(current->_bindingsToShoot.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-						auto it = unbound_space->_shootQueue.iterator_to(current);
-						unbound_space->_shootQueue.erase(it);
-						complete.push_front(current);
-					}
-				}
-
-				if(!predecessor)
-					break;
-				current = predecessor;
-			}
-		}
+		_forEachOwedShootdown(unbound_space.get(), unbound_sequence, unbound_lazy_sequence,
+				[&] (ShootNode *node) {
+			_acknowledgeShootdown(unbound_space.get(), node, complete);
+		});
 
 		unbound_space->_numBindings--;
 		if(!unbound_space->_numBindings && unbound_space->_retireNode) {
@@ -216,27 +332,13 @@ void PageBinding::unbind() {
 	{
 		auto lock = frg::guard(&_boundSpace->_mutex);
 
-		if(!_boundSpace->_shootQueue.empty()) {
-			auto current = _boundSpace->_shootQueue.back();
-			while(current->_sequence > _alreadyShotSequence) {
-				auto predecessor = current->_queueNode.previous;
-
-				// The actual shootdown was done above.
-				// Signal completion of the shootdown.
-				if(current->_initiatorCpu != getCpuData()) {
-					if(current->_bindingsToShoot.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-						auto it = _boundSpace->_shootQueue.iterator_to(current);
-						_boundSpace->_shootQueue.erase(it);
-						complete.push_front(current);
-					}
-				}
-
-				if(!predecessor)
-					break;
-				current = predecessor;
-			}
-		}
+		// The actual shootdown was done above.
+		_forEachOwedShootdown(_boundSpace.get(), _alreadyShotSequence, _lazySequence,
+				[&] (ShootNode *node) {
+			_acknowledgeShootdown(_boundSpace.get(), node, complete);
+		});
 
+		_boundSpace->_bindings.erase(_boundSpace->_bindings.iterator_to(this));
 		_boundSpace->_numBindings--;
 		if(!_boundSpace->_numBindings && _boundSpace->_retireNode) {
 			_boundSpace->_retireNode->complete();
@@ -246,6 +348,9 @@ void PageBinding::unbind() {
 
 	_boundSpace = nullptr;
 	_alreadyShotSequence = 0;
+	_ipiSequence = 0;
+	_lazySequence = noLazyFlush;
+	_active.store(false, std::memory_order_relaxed);
 
 	while(!complete.empty()) {
 		auto current = complete.pop_front();
@@ -274,52 +379,49 @@ void PageBinding::shootdown() {
 		>
 	> complete;
 
-	uint64_t target_seq;
 	{
 		auto lock = frg::guard(&_boundSpace->_mutex);
 
-		if(!_boundSpace->_shootQueue.empty()) {
-			auto current = _boundSpace->_shootQueue.back();
-			while(current->_sequence > _alreadyShotSequence) {
-				auto predecessor = current->_queueNode.previous;
+		// Gather all pending requests first. If they cover enough pages in total,
+		// a single flush of the PCID is cheaper than invalidating each page.
+		size_t pending_pages = 0;
+		_forEachOwedShootdown(_boundSpace.get(), _alreadyShotSequence, _lazySequence,
+				[&] (ShootNode *node) {
+			pending_pages += node->size >> kPageShift;
+		});
+
+		bool flush_all = pending_pages >= shootdownFullFlushThreshold;
+		if(flush_all) {
+			if(!getCpuData()->havePcids) {
+				assert(!_pcid);
+				invalidateFullTlb();
+			}else{
+				invalidatePcid(_pcid);
+			}
+			_boundSpace->_countShootdown(&ShootdownStats::fullFlushes);
+		}
 
-				if(current->_initiatorCpu != getCpuData()) {
-					// Perform the actual shootdown.
+		_forEachOwedShootdown(_boundSpace.get(), _alreadyShotSequence, _lazySequence,
+				[&] (ShootNode *node) {
+			// Perform the actual shootdown.
+			if(!flush_all) {
+				for(size_t pg = 0; pg < node->size; pg += kPageSize) {
+					auto address = reinterpret_cast<void *>(node->address + pg);
 					if(!getCpuData()->havePcids) {
-						assert(!_pcid);
-						if((current->size >> kPageShift) >= 64) {
-							invalidateFullTlb();
-						}else{
-							for(size_t pg = 0; pg < current->size; pg += kPageSize)
-								invalidatePage(reinterpret_cast<void *>(current->address + pg));
-						}
+						invalidatePage(address);
 					}else{
-						if((current->size >> kPageShift) >= 64) {
-							invalidatePcid(_pcid);
-						}else{
-							for(size_t pg = 0; pg < current->size; pg += kPageSize)
-								invalidatePage(_pcid,
-										reinterpret_cast<void *>(current->address + pg));
-						}
-					}
-
-					// Signal completion of the shootdown.
-					if(current->_bindingsToShoot.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-						auto it = _boundSpace->_shootQueue.iterator_to(current);
-						_boundSpace->_shootQueue.erase(it);
-						complete.push_front(current);
+						invalidatePage(_pcid, address);
 					}
 				}
-
-				if(!predecessor)
-					break;
-				current = predecessor;
 			}
-		}
-		target_seq = _boundSpace->_shootSequence;
-	}
 
-	_alreadyShotSequence = target_seq;
+			// Signal completion of the shootdown.
+			_acknowledgeShootdown(_boundSpace.get(), node, complete);
+		});
+
+		// Update the sequence before releasing the lock; see _ipiSequence.
+		_alreadyShotSequence = _boundSpace->_shootSequence;
+	}
 
 	while(!complete.empty()) {
 		auto current = complete.pop_front();
@@ -460,40 +562,69 @@ bool PageSpace::submitShootdown(ShootNode *node) {
 	assert(!(node->address & (kPageSize - 1)));
 	assert(!(node->size & (kPageSize - 1)));
 
+	// CPUs that we need to send IPIs to. If there are too many, we broadcast instead.
+	constexpr size_t maxIpiTargets = 8;
+	int ipi_targets[maxIpiTargets];
+	size_t num_ipi_targets = 0;
+	bool broadcast = false;
+
 	{
 		auto irq_lock = frg::guard(&irqMutex());
 		auto lock = frg::guard(&_mutex);
 
-		auto unshot_bindings = _numBindings;
+		_countShootdown(&ShootdownStats::requests);
 
-		// Perform synchronous shootdown.
-		auto bindings = getCpuData()->pcidBindings;
-		if(!getCpuData()->havePcids) {
-			if(bindings[0].boundSpace().get() == this) {
-				assert(unshot_bindings);
+		auto sequence = ++_shootSequence;
+		bool flush_all = (node->size >> kPageShift) >= shootdownFullFlushThreshold;
+		unsigned int unshot_bindings = 0;
+
+		for(auto it = _bindings.begin(); it != _bindings.end(); ++it) {
+			auto binding = *it;
 
-				if((node->size >> kPageShift) >= 64) {
-					invalidateFullTlb();
+			if(binding->_cpuIndex == getCpuData()->cpuIndex) {
+				// Perform synchronous shootdown.
+				if(!getCpuData()->havePcids) {
+					if(flush_all) {
+						invalidateFullTlb();
+					}else{
+						for(size_t pg = 0; pg < node->size; pg += kPageSize)
+							invalidatePage(reinterpret_cast<void *>(node->address + pg));
+					}
 				}else{
-					for(size_t pg = 0; pg < node->size; pg += kPageSize)
-						invalidatePage(reinterpret_cast<void *>(node->address + pg));
+					if(flush_all) {
+						invalidatePcid(binding->getPcid());
+					}else{
+						for(size_t pg = 0; pg < node->size; pg += kPageSize)
+							invalidatePage(binding->getPcid(),
+									reinterpret_cast<void *>(node->address + pg));
+					}
 				}
-				unshot_bindings--;
+				if(flush_all)
+					_countShootdown(&ShootdownStats::fullFlushes);
+				continue;
 			}
-		}else{
-			for(int i = 0; i < maxPcidCount; i++) {
-				if(bindings[i].boundSpace().get() != this)
-					continue;
-				assert(unshot_bindings);
 
-				if((node->size >> kPageShift) >= 64) {
-					invalidatePcid(bindings[i].getPcid());
-				}else{
-					for(size_t pg = 0; pg < node->size; pg += kPageSize)
-						invalidatePage(bindings[i].getPcid(),
-								reinterpret_cast<void *>(node->address + pg));
+			// The PCID of inactive bindings cannot be used until the binding is made primary.
+			// Instead of interrupting the remote CPU, let it flush the PCID at that point.
+			if(!binding->_active.load(std::memory_order_relaxed)) {
+				if(binding->_lazySequence == PageBinding::noLazyFlush) {
+					binding->_lazySequence = sequence;
+					_countShootdown(&ShootdownStats::lazyFlushes);
 				}
-				unshot_bindings--;
+				continue;
+			}
+
+			unshot_bindings++;
+
+			// Batch this request with the ones that are already waiting for an IPI.
+			if(binding->_ipiSequence > binding->_alreadyShotSequence)
+				continue;
+			binding->_ipiSequence = sequence;
+
+			if(num_ipi_targets < maxIpiTargets) {
+				ipi_targets[num_ipi_targets++] = binding->_cpuIndex;
+			}else{
+				broadcast = true;
 			}
 		}
 
@@ -501,15 +632,31 @@ bool PageSpace::submitShootdown(ShootNode *node) {
 			return true;
 
 		node->_initiatorCpu = getCpuData();
-		node->_sequence = ++_shootSequence;
+		node->_sequence = sequence;
 		node->_bindingsToShoot = unshot_bindings;
 		_shootQueue.push_back(node);
+
+		if(broadcast) {
+			_countShootdown(&ShootdownStats::ipis, getCpuCount() - 1);
+		}else{
+			_countShootdown(&ShootdownStats::ipis, num_ipi_targets);
+		}
 	}
 
-	sendShootdownIpi();
+	if(broadcast) {
+		sendShootdownIpi();
+	}else{
+		for(size_t i = 0; i < num_ipi_targets; i++)
+			sendShootdownIpi(ipi_targets[i]);
+	}
 	return false;
 }
 
+void PageSpace::_countShootdown(uint64_t ShootdownStats::*counter, uint64_t n) {
+	_shootStats.count(counter, n);
+	getCpuData()->pageContext._shootStats.count(counter, n);
+}
+
 // --------------------------------------------------------
 // Kernel paging management.
 // --------------------------------------------------------
@@ -468,6 +468,21 @@ void sendShootdownIpi() {
 	}
 }
 
+void sendShootdownIpi(int id) {
+	auto apic = getCpuData(id)->localApicId;
+	if(picBase.isUsingX2apic()) {
+		picBase.store(lX2ApicIcr, x2apicIcrLowVector(0xF0) | x2apicIcrLowDelivMode(0)
+				| x2apicIcrLowLevel(true) | x2apicIcrLowShorthand(0) | x2apicIcrHighDestField(apic));
+	} else {
+		picBase.store(lApicIcrHigh, apicIcrHighDestField(apic));
+		picBase.store(lApicIcrLow, apicIcrLowVector(0xF0) | apicIcrLowDelivMode(0)
+				| apicIcrLowLevel(true) | apicIcrLowShorthand(0));
+		while(picBase.load(lApicIcrLow) & apicIcrLowDelivStatus) {
+			// Wait for IPI delivery.
+		}
+	}
+}
+
 void sendPingIpi(int id) {
 	auto apic = getCpuData(id)->localApicId;
 //	infoLogger() << "thor [CPU" << getLocalApicId() << "]: Sending ping" << frg::endlog;
@@ -518,8 +533,20 @@ extern IrqSpinlock globalIrqSlotsLock;
 
 namespace {
 	struct ApicMsiPin final : MsiPin {
-		ApicMsiPin(frg::string<KernelAlloc> name, unsigned int vector)
-		: MsiPin{std::move(name)}, vector_{vector} { }
+		ApicMsiPin(frg::string<KernelAlloc> name, unsigned int vector, int cpu)
+		: MsiPin{std::move(name)}, vector_{vector}, cpu_{cpu} { }
+
+		int affinity() override {
+			return cpu_;
+		}
+
+		Error routeTo(int cpu) override {
+			// The xAPIC destination ID field only has 8 bits.
+			if(getCpuData(cpu)->localApicId > 0xFF)
+				return Error::noHardwareSupport;
+			cpu_ = cpu;
+			return Error::success;
+		}
 
 		IrqStrategy program(TriggerMode mode, Polarity) override {
 			assert(mode == TriggerMode::edge);
@@ -541,7 +568,8 @@ namespace {
 		}
 
 		uint64_t getMessageAddress() override {
-			return 0xFEE00000;
+			// Physical destination mode, targeting the CPU's local APIC.
+			return 0xFEE00000 | (uint64_t(getCpuData(cpu_)->localApicId) << 12);
 		}
 
 		uint32_t getMessageData() override {
@@ -550,10 +578,11 @@ namespace {
 
 	private:
 		unsigned int vector_;
+		int cpu_;
 	};
 }
 
-MsiPin *allocateApicMsi(frg::string<KernelAlloc> name) {
+MsiPin *allocateApicMsi(frg::string<KernelAlloc> name, int cpu) {
 	auto guard = frg::guard(&globalIrqSlotsLock);
 
 	int slotIndex = -1;
@@ -567,15 +596,17 @@ MsiPin *allocateApicMsi(frg::string<KernelAlloc> name) {
 		return nullptr;
 
 	// Create an IRQ pin for the MSI.
+	if(getCpuData(cpu)->localApicId > 0xFF)
+		cpu = 0;
 	auto pin = frg::construct<ApicMsiPin>(*kernelAlloc,
-			std::move(name), 64 + slotIndex);
+			std::move(name), 64 + slotIndex, cpu);
 	pin->configure(IrqConfiguration{
 		.trigger = TriggerMode::edge,
 		.polarity = Polarity::high
 	});
 
 	infoLogger() << "thor: Allocating IRQ slot " << slotIndex
-			<< " to " << pin->name() << frg::endlog;
+			<< " to " << pin->name() << " on CPU " << cpu << frg::endlog;
 	globalIrqSlots[slotIndex]->link(pin);
 
 	return pin;
@@ -1,16 +1,25 @@
 #include <x86/machine.hpp>
 #include <thor-internal/arch/pmc-amd.hpp>
+#include <thor-internal/profile.hpp>
 
 namespace thor {
 
 namespace counters {
 	inline constexpr unsigned int clockCycles = 0x76;
 	inline constexpr unsigned int instructionsRetired = 0xC0;
+	inline constexpr unsigned int dataCacheMisses = 0x41;
+	inline constexpr unsigned int mispredictedBranchesRetired = 0xC3;
 }
 
 void setAmdPmc() {
 	// TODO: Support counters with IDs > 0xFF.
-	unsigned int whichCounter = counters::clockCycles;
+	unsigned int whichCounter;
+	switch(profileEvent) {
+	case ProfileEvent::cycles: whichCounter = counters::clockCycles; break;
+	case ProfileEvent::instructions: whichCounter = counters::instructionsRetired; break;
+	case ProfileEvent::cacheMisses: whichCounter = counters::dataCacheMisses; break;
+	case ProfileEvent::branchMisses: whichCounter = counters::mispredictedBranchesRetired; break;
+	}
 
 	// First, disable the performance counter.
 	// The manual recommends this to avoid races during the inital value update.
@@ -22,8 +31,7 @@ void setAmdPmc() {
 	);
 
 	// Program the initial value.
-	// This is hardcoded to yield a fixed number of events per second on a 1 GHz machine for now.
-	common::x86::wrmsr(0xC001'0201, -static_cast<uint64_t>(1'000'000'000/5000));
+	common::x86::wrmsr(0xC001'0201, -static_cast<uint64_t>(profilePeriod));
 
 	// Re-enable the performance counter.
 	common::x86::wrmsr(0xC001'0200,
@@ -1,44 +1,85 @@
 #include <x86/machine.hpp>
 #include <thor-internal/arch/pmc-intel.hpp>
+#include <thor-internal/profile.hpp>
 
 namespace thor {
 
 enum class IntelCounter {
 	none,
 	fixed0, // Instructions retired.
-	fixed1 // Clock cycles.
+	fixed1, // Clock cycles.
+	general0 // Programmable via IA32_PERFEVTSEL0.
 };
 
-static IntelCounter whichCounter = IntelCounter::fixed1;
+namespace {
+	// Architectural performance events (see the Intel SDM, volume 3, chapter 19).
+	namespace events {
+		inline constexpr uint64_t llcMisses = 0x2E | (0x41 << 8);
+		inline constexpr uint64_t branchMissesRetired = 0xC5 | (0x00 << 8);
+	}
+
+	IntelCounter whichCounter = IntelCounter::fixed1;
+
+	uint64_t generalEvent() {
+		if(profileEvent == ProfileEvent::cacheMisses)
+			return events::llcMisses;
+		assert(profileEvent == ProfileEvent::branchMisses);
+		return events::branchMissesRetired;
+	}
+}
 
 void initializeIntelPmc() {
+	switch(profileEvent) {
+	case ProfileEvent::cycles: whichCounter = IntelCounter::fixed1; break;
+	case ProfileEvent::instructions: whichCounter = IntelCounter::fixed0; break;
+	case ProfileEvent::cacheMisses:
+	case ProfileEvent::branchMisses: whichCounter = IntelCounter::general0; break;
+	}
+
 	// Disable all fixed performance counters.
 	common::x86::wrmsr(0x38D, // PERF_FIXED_CTR_CTRL
 		0
 	);
+	common::x86::wrmsr(0x186, // IA32_PERFEVTSEL0
+		0
+	);
 
 	// Counters first need to be enabled in the "global control" MSR.
 	common::x86::wrmsr(0x38F, // PERF_GLOBAL_CTRL
 			common::x86::rdmsr(0x38F)
+			| (UINT64_C(1) << 0)
 			| (UINT64_C(1) << 32)
 			| (UINT64_C(1) << 33));
 }
 
 void setIntelPmc() {
+	if(whichCounter == IntelCounter::general0) {
+		auto eventSelect = generalEvent()
+				| (UINT64_C(1) << 16) // Count in user mode.
+				| (UINT64_C(1) << 17) // Count in supervisor mode.
+				| (UINT64_C(1) << 20); // Enable PMI.
+
+		// Disable the counter while we program the initial value (see below).
+		common::x86::wrmsr(0x186, eventSelect); // IA32_PERFEVTSEL0
+		// Writes to IA32_PMC0 are sign-extended from 32 bits.
+		common::x86::wrmsr(0xC1, -static_cast<uint64_t>(profilePeriod)); // IA32_PMC0
+		common::x86::wrmsr(0x186, eventSelect | (UINT64_C(1) << 22)); // Enable the counter.
+		return;
+	}
+
 	// Disable the performance counter.
 	common::x86::wrmsr(0x38D, // PERF_FIXED_CTR_CTRL
 		0
 	);
 
 	// Program the initial value.
-	// This is hardcoded to yield a fixed number of events per second on a 1 GHz machine for now.
 	if(whichCounter == IntelCounter::fixed0) {
 		common::x86::wrmsr(0x309, // PERF_FIXED_CTR0
-				(UINT64_C(1) << 48) - 1'000'000'000/5000);
+				(UINT64_C(1) << 48) - profilePeriod);
 	}else{
 		assert(whichCounter == IntelCounter::fixed1);
 		common::x86::wrmsr(0x30A, // PERF_FIXED_CTR1
-				(UINT64_C(1) << 48) - 1'000'000'000/5000);
+				(UINT64_C(1) << 48) - profilePeriod);
 	}
 
 	// TODO: Clear overflow. This is required for real hardware.
@@ -64,9 +105,12 @@ void setIntelPmc() {
 }
 
 bool checkIntelPmcOverflow() {
-	if(whichCounter == IntelCounter::fixed0) {
+	if(whichCounter == IntelCounter::general0) {
+		return common::x86::rdmsr(0x38E) // PERF_GLOBAL_STATUS
+				& (UINT64_C(1) << 0); // Overflow of IA32_PMC0
+	}else if(whichCounter == IntelCounter::fixed0) {
 		common::x86::wrmsr(0x309, // PERF_FIXED_CTR0
-				(UINT64_C(1) << 48) - 1'000'000'000/5000);
+				(UINT64_C(1) << 48) - profilePeriod);
 		return common::x86::rdmsr(0x38E) // PERF_GLOBAL_STATUS
 				& (UINT64_C(1) << 32); // Overflow of PERF_FIXED_CTR0
 	}else{
@@ -229,6 +229,7 @@ private:
 
 struct SyscallImageAccessor {
 	friend void saveExecutor(Executor *executor, SyscallImageAccessor accessor);
+	friend void saveSignalRegisters(uintptr_t *regs, SyscallImageAccessor accessor);
 
 	Word *number() { return &_frame()->rdi; }
 	Word *in0() { return &_frame()->rsi; }
@@ -245,6 +246,9 @@ struct SyscallImageAccessor {
 	Word *out0() { return &_frame()->rsi; }
 	Word *out1() { return &_frame()->rdx; }
 
+	Word *ip() { return &_frame()->rip; }
+	Word *sp() { return &_frame()->rsp; }
+
 	void *frameBase() { return _pointer + sizeof(Frame); }
 
 private:
@@ -283,6 +287,8 @@ struct NmiImageAccessor {
 	Word *ip() { return &_frame()->rip; }
 	Word *cs() { return &_frame()->cs; }
 	Word *rflags() { return &_frame()->rflags; }
+	Word *sp() { return &_frame()->rsp; }
+	Word *bp() { return &_frame()->rbp; }
 
 private:
 	// note: this struct is accessed from assembly.
@@ -488,6 +494,10 @@ public:
 		return reinterpret_cast<General *>(_pointer);
 	}
 
+	// XSAVEOPT does not write components that are in their initial configuration.
+	// This function fills in those components such that the area can be exposed as-is.
+	void materializeSimdState();
+
 	FxState *_fxState() {
 		// fxState is offset from General by 0x10 bytes to make it aligned
 		return reinterpret_cast<FxState *>(_pointer + sizeof(General) + 0x10);
@@ -518,6 +528,7 @@ struct CpuFeatures {
 	static constexpr uint32_t profileAmdSupported = 2;
 
 	bool haveXsave;
+	bool haveXsaveopt;
 	bool haveAvx;
 	bool haveZmm;
 	bool haveInvariantTsc;
@@ -633,7 +644,34 @@ void doRunOnStack(void (*function) (void *, void *), void *sp, void *argument);
 void setupBootCpuContext();
 void initializeThisProcessor();
 
-void bootSecondary(unsigned int apic_id);
+// Boots the given APs. APs are woken up concurrently (in groups).
+void bootSecondaries(const unsigned int *apicIds, size_t count);
+
+// Saves the current SIMD state into the executor.
+inline void saveSimdState(Executor *executor) {
+	if(getGlobalCpuFeatures()->haveXsaveopt) {
+		common::x86::xsaveopt((uint8_t*)executor->_fxState(), ~0);
+	} else if(getGlobalCpuFeatures()->haveXsave) {
+		common::x86::xsave((uint8_t*)executor->_fxState(), ~0);
+	} else {
+		asm volatile ("fxsaveq %0" : : "m" (*executor->_fxState()));
+	}
+}
+
+// Saves the current SIMD state into a zeroed buffer of Executor::determineSimdSize() bytes.
+// The buffer needs to be aligned to 64 bytes. Unlike saveSimdState(), this does not rely
+// on the init optimization of xsaveopt, i.e., the buffer does not need to be materialized.
+inline void dumpSimdState(void *buffer) {
+	if(getGlobalCpuFeatures()->haveXsave) {
+		common::x86::xsave(reinterpret_cast<uint8_t *>(buffer), ~0);
+	} else {
+		asm volatile ("fxsaveq %0" : "=m" (*reinterpret_cast<uint8_t (*)[512]>(buffer)));
+	}
+}
+
+// Stores the kHelRegsSignal image of the user space context of a syscall.
+// rbx, rcx and r11 are not preserved across syscalls; they are stored as zero.
+void saveSignalRegisters(uintptr_t *regs, SyscallImageAccessor accessor);
 
 template<typename F>
 void forkExecutor(F functor, Executor *executor) {
@@ -642,11 +680,7 @@ void forkExecutor(F functor, Executor *executor) {
 		(*fp)();
 	};
 
-	if(getGlobalCpuFeatures()->haveXsave) {
-		common::x86::xsave((uint8_t*)executor->_fxState(), ~0);
-	} else {
-		asm volatile ("fxsaveq %0" : : "m" (*executor->_fxState()));
-	}
+	saveSimdState(executor);
 
 	doForkExecutor(executor, delegate, &functor);
 }
@@ -111,9 +111,39 @@ struct PageBinding;
 
 static constexpr int maxPcidCount = 8;
 
+// Shootdowns of at least this many pages flush the whole PCID instead of single pages.
+static constexpr size_t shootdownFullFlushThreshold = 64;
+
+// TLB shootdown statistics. They are kept both per CPU and per PageSpace.
+// Since they are read while other CPUs update them, all accesses are (relaxed) atomics.
+struct ShootdownStats {
+	// Number of submitted shootdown requests.
+	uint64_t requests;
+	// Number of IPIs sent to other CPUs.
+	uint64_t ipis;
+	// Number of remote bindings that were marked for a lazy PCID flush instead.
+	uint64_t lazyFlushes;
+	// Number of times that a whole PCID was flushed instead of single pages.
+	uint64_t fullFlushes;
+
+	void count(uint64_t ShootdownStats::*counter, uint64_t n = 1) {
+		__atomic_fetch_add(&(this->*counter), n, __ATOMIC_RELAXED);
+	}
+
+	ShootdownStats load() {
+		ShootdownStats copy;
+		copy.requests = __atomic_load_n(&requests, __ATOMIC_RELAXED);
+		copy.ipis = __atomic_load_n(&ipis, __ATOMIC_RELAXED);
+		copy.lazyFlushes = __atomic_load_n(&lazyFlushes, __ATOMIC_RELAXED);
+		copy.fullFlushes = __atomic_load_n(&fullFlushes, __ATOMIC_RELAXED);
+		return copy;
+	}
+};
+
 // Per-CPU context for paging.
 struct PageContext {
 	friend struct PageBinding;
+	friend struct PageSpace;
 
 	PageContext();
 
@@ -121,15 +151,24 @@ struct PageContext {
 
 	PageContext &operator= (const PageContext &) = delete;
 
+	// Shootdown work that was done by this CPU.
+	ShootdownStats shootdownStats() {
+		return _shootStats.load();
+	}
+
 private:
 	// Timestamp for the LRU mechansim of PCIDs.
 	uint64_t _nextStamp;
 
 	// Current primary binding (i.e. the currently active PCID).
 	PageBinding *_primaryBinding;
+
+	ShootdownStats _shootStats{};
 };
 
 struct PageBinding {
+	friend struct PageSpace;
+
 	PageBinding();
 
 	PageBinding(const PageBinding &) = delete;
@@ -164,8 +203,29 @@ struct PageBinding {
 	void shootdown();
 
 private:
+	static constexpr uint64_t noLazyFlush = ~uint64_t(0);
+
+	// Calls fn on all requests of the space with a sequence number in
+	// (sinceSequence, lazySequence) that were not initiated by this CPU.
+	// Those are exactly the requests that still count a binding.
+	// Must be called with the space's mutex held.
+	template<typename F>
+	static void _forEachOwedShootdown(PageSpace *space,
+			uint64_t sinceSequence, uint64_t lazySequence, F fn);
+
+	// Decrements the binding count of the request and moves it to the
+	// completion list if this was the last binding.
+	template<typename List>
+	static void _acknowledgeShootdown(PageSpace *space, ShootNode *node, List &complete);
+
+	// Makes this binding the primary binding of the current CPU.
+	void _makePrimary();
+
 	int _pcid;
 
+	// Index of the CPU that owns this binding.
+	int _cpuIndex;
+
 	// TODO: Once we can use libsmarter in the kernel, we should make this a shared_ptr
 	//       to the PageSpace that does *not* prevent the PageSpace from becoming
 	//       "activatable".
@@ -173,7 +233,27 @@ private:
 
 	uint64_t _primaryStamp;
 
+	// Protected by the bound space's mutex.
 	uint64_t _alreadyShotSequence;
+
+	// Sequence number of the last request that sent an IPI to this binding.
+	// While it exceeds _alreadyShotSequence, an IPI is still pending and further requests
+	// do not need to send another one: the IPI handler processes all requests that are
+	// queued by the time it runs. Protected by the bound space's mutex.
+	uint64_t _ipiSequence;
+
+	// Whether this binding is the primary binding of its CPU.
+	// Transitions to true only happen with the bound space's mutex held;
+	// shootdowns skip remote bindings that are not active (see _lazySequence).
+	std::atomic<bool> _active;
+
+	// Set by shootdown initiators for inactive bindings instead of sending an IPI.
+	// The PCID is flushed entirely before the binding becomes active again.
+	// Requests with a sequence number >= _lazySequence do not count this binding.
+	// Protected by the bound space's mutex.
+	uint64_t _lazySequence;
+
+	frg::default_list_hook<PageBinding> _spaceNode;
 };
 
 struct GlobalPageBinding {
@@ -208,7 +288,15 @@ struct PageSpace {
 
 	bool submitShootdown(ShootNode *node);
 
+	// Shootdown work that was done for this space (on all CPUs).
+	ShootdownStats shootdownStats() {
+		return _shootStats.load();
+	}
+
 private:
+	// Counts towards both the per-space and the current CPU's statistics.
+	void _countShootdown(uint64_t ShootdownStats::*counter, uint64_t n = 1);
+
 	PhysicalAddr _rootTable;
 
 	std::atomic<bool> _wantToRetire = false;
@@ -219,6 +307,16 @@ private:
 
 	unsigned int _numBindings;
 
+	// All bindings (on all CPUs) that currently bind this space.
+	frg::intrusive_list<
+		PageBinding,
+		frg::locate_member<
+			PageBinding,
+			frg::default_list_hook<PageBinding>,
+			&PageBinding::_spaceNode
+		>
+	> _bindings;
+
 	uint64_t _shootSequence;
 
 	frg::intrusive_list<
@@ -229,6 +327,8 @@ private:
 			&ShootNode::_queueNode
 		>
 	> _shootQueue;
+
+	ShootdownStats _shootStats{};
 };
 
 namespace page_mode {
@@ -568,4 +668,9 @@ void invalidatePage(const void *address);
 
 void invalidateFullTlb();
 
+// Reads a word from the address space that is active on this CPU by walking its page tables.
+// This never faults and takes no locks; hence, it can be used from NMI context.
+// If user is true, only user-accessible pages are considered.
+bool peekActiveSpaceWord(uintptr_t address, uint64_t *value, bool user);
+
 } // namespace thor
@@ -120,13 +120,14 @@ void raiseInitDeassertIpi(uint32_t dest_apic_id);
 void raiseStartupIpi(uint32_t dest_apic_id, uint32_t page);
 
 void sendShootdownIpi();
+void sendShootdownIpi(int id);
 void sendGlobalNmi();
 
 // --------------------------------------------------------
 // MSI management
 // --------------------------------------------------------
 
-MsiPin *allocateApicMsi(frg::string<KernelAlloc> name);
+MsiPin *allocateApicMsi(frg::string<KernelAlloc> name, int cpu);
 
 // --------------------------------------------------------
 // I/O APIC management
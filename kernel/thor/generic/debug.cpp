@@ -1,5 +1,12 @@
+#include <async/algorithm.hpp>
+#include <async/recurring-event.hpp>
 #include <thor-internal/cpu-data.hpp>
 #include <thor-internal/debug.hpp>
+#include <thor-internal/fiber.hpp>
+#include <thor-internal/kernel_heap.hpp>
+#include <thor-internal/main.hpp>
+#include <thor-internal/ring-buffer.hpp>
+#include <thor-internal/timer.hpp>
 #include <thor-internal/arch/stack.hpp>
 
 namespace thor {
@@ -148,8 +155,273 @@ constinit frg::stack_buffer_logger<InfoSink, logLineLength> infoLogger;
 constinit frg::stack_buffer_logger<UrgentSink, logLineLength> urgentLogger;
 constinit frg::stack_buffer_logger<PanicSink, logLineLength> panicLogger;
 
+// --------------------------------------------------------
+// Per-CPU log rings.
+// --------------------------------------------------------
+
+// infoLogger() does not feed the sinks directly. Instead, each CPU writes its records
+// to a lock-free ring that is only written by this CPU. A drain fiber merges the rings
+// (by global sequence number) and feeds the (potentially slow) sinks.
+// urgentLogger() and panicLogger() bypass the rings but flush them before printing.
+//
+// Sequence numbers are taken before a record is published. Hence, a record can become
+// visible before records with lower sequence numbers. To merge the rings in order anyway,
+// each writer announces a lower bound of its sequence number (in localLogInFlight)
+// before it takes the number. The drain only emits records whose sequence is below
+// all announced bounds (and below the global sequence at the start of the round).
+//
+// The drain sleeps while the rings are empty. Writers wake it up through logDrainEvent,
+// unless they run with IRQs disabled: in that case, they might hold locks that the wakeup
+// needs, and the drain only picks up their records on its periodic fallback wakeup.
+
+namespace {
+	struct LogRecordHeader {
+		// Global sequence number; used to merge records from different CPUs.
+		uint64_t sequence;
+		// Per-CPU sequence number; used to detect dropped records.
+		uint64_t cpuSequence;
+	};
+
+	constinit std::atomic<uint64_t> globalLogSequence{0};
+	constinit std::atomic<uint64_t> droppedLogRecords{0};
+	constinit std::atomic<bool> logDrainRunning{false};
+
+	// Set by the drain before it goes to sleep; cleared by the writer that wakes it up.
+	constinit std::atomic<bool> logDrainIdle{false};
+	frg::manual_box<async::recurring_event> logDrainEvent;
+
+	// Interval at which the drain wakes up even if no writer raised logDrainEvent.
+	constexpr uint64_t logDrainFallbackInterval = 100'000'000;
+
+	// Returns false if the message needs to be printed synchronously.
+	// canWake must only be true if the caller does not hold any locks
+	// (i.e., if IRQs were enabled before the caller disabled them).
+	bool enqueueToLogRing(const char *msg, bool canWake) {
+		if(!logDrainRunning.load(std::memory_order_acquire))
+			return false;
+
+		auto cpuData = getCpuData();
+		auto ring = __atomic_load_n(&cpuData->localLogRing, __ATOMIC_ACQUIRE);
+		if(!ring)
+			return false;
+		// The ring only supports a single writer. Nested writers (e.g., NMIs)
+		// print synchronously.
+		if(cpuData->inLogRing)
+			return false;
+		cpuData->inLogRing = true;
+
+		struct {
+			LogRecordHeader header;
+			char text[logLineLength];
+		} record;
+		cpuData->localLogInFlight.store(globalLogSequence.load(std::memory_order_seq_cst),
+				std::memory_order_seq_cst);
+		record.header.sequence = globalLogSequence.fetch_add(1, std::memory_order_seq_cst);
+		record.header.cpuSequence = cpuData->localLogSequence++;
+		auto length = strlen(msg);
+		assert(length < logLineLength);
+		memcpy(record.text, msg, length);
+		ring->enqueue(&record, sizeof(LogRecordHeader) + length);
+		cpuData->localLogInFlight.store(UINT64_MAX, std::memory_order_release);
+
+		// Pairs with the fence in runLogDrain(): either the drain sees our record,
+		// or we see that it is idle.
+		if(canWake) {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(logDrainIdle.load(std::memory_order_relaxed)
+					&& logDrainIdle.exchange(false, std::memory_order_relaxed))
+				logDrainEvent->raise();
+		}
+
+		cpuData->inLogRing = false;
+		return true;
+	}
+
+	struct DrainState {
+		SingleContextRecordRing *ring = nullptr;
+		uint64_t deqPtr = 0;
+		uint64_t expectedCpuSequence = 0;
+		bool havePending = false;
+		size_t pendingLength = 0;
+		LogRecordHeader pendingHeader;
+		char pendingText[logLineLength];
+	};
+
+	// Consumer side of the rings. Protected by drainOwner, which stores the index
+	// of the CPU that currently drains (or -1).
+	frg::manual_box<frg::vector<DrainState *, KernelAlloc>> drainStates;
+	constinit std::atomic<int> drainOwner{-1};
+
+	bool tryLockDrain() {
+		int expected = -1;
+		return drainOwner.compare_exchange_strong(expected, getCpuData()->cpuIndex,
+				std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	void unlockDrain() {
+		drainOwner.store(-1, std::memory_order_release);
+	}
+
+	// Emits up to budget records from all rings in sequence order.
+	// Must be called with the drain locked.
+	// If force is true, records are emitted even if writers with lower sequence numbers
+	// are still in flight (such that panics print as much as possible).
+	// Returns true if any record was emitted.
+	bool drainLogRings(bool force, size_t budget = SIZE_MAX) {
+		uint64_t limit = UINT64_MAX;
+		if(!force) {
+			limit = globalLogSequence.load(std::memory_order_seq_cst);
+			for(int i = 0; i < getCpuCount(); i++)
+				limit = frg::min(limit,
+						getCpuData(i)->localLogInFlight.load(std::memory_order_seq_cst));
+		}
+
+		bool progress = false;
+		while(budget) {
+			DrainState *oldest = nullptr;
+			for(auto state : *drainStates) {
+				if(!state->havePending) {
+					struct {
+						LogRecordHeader header;
+						char text[logLineLength];
+					} record;
+					auto [success, recordPtr, newPtr, size] = state->ring->dequeueAt(
+							state->deqPtr, &record, sizeof(record));
+					state->deqPtr = newPtr;
+					if(!success)
+						continue;
+					assert(size >= sizeof(LogRecordHeader));
+
+					if(record.header.cpuSequence != state->expectedCpuSequence)
+						droppedLogRecords.fetch_add(
+								record.header.cpuSequence - state->expectedCpuSequence,
+								std::memory_order_relaxed);
+					state->expectedCpuSequence = record.header.cpuSequence + 1;
+
+					state->pendingHeader = record.header;
+					state->pendingLength = size - sizeof(LogRecordHeader);
+					memcpy(state->pendingText, record.text, state->pendingLength);
+					state->havePending = true;
+				}
+
+				if(!oldest || state->pendingHeader.sequence < oldest->pendingHeader.sequence)
+					oldest = state;
+			}
+			if(!oldest || oldest->pendingHeader.sequence >= limit)
+				break;
+
+			// Terminate the message; the ring does not store the NUL byte.
+			oldest->pendingText[oldest->pendingLength] = 0;
+			{
+				auto lock = frg::guard(&logMutex);
+
+				logProcessor.print(oldest->pendingText);
+				logProcessor.print('\n');
+			}
+			oldest->havePending = false;
+			progress = true;
+			budget--;
+		}
+		return progress;
+	}
+
+	// Called by urgentLogger() and panicLogger() before they print, such that
+	// their output does not overtake earlier infoLogger() records.
+	void flushLogRings(bool panicking) {
+		if(!logDrainRunning.load(std::memory_order_acquire))
+			return;
+
+		// If this CPU interrupted the drain (e.g., in an NMI), we cannot flush.
+		// On panic, the drain might belong to a CPU that is stuck; do not wait for it.
+		while(!tryLockDrain()) {
+			if(panicking || drainOwner.load(std::memory_order_relaxed) == getCpuData()->cpuIndex)
+				return;
+			pause();
+		}
+		drainLogRings(panicking);
+		unlockDrain();
+	}
+
+	void runLogDrain() {
+		uint64_t reportedDrops = 0;
+		while(true) {
+			// Attach rings to CPUs that came up since the last iteration.
+			for(size_t i = drainStates->size(); i < static_cast<size_t>(getCpuCount()); i++) {
+				auto state = frg::construct<DrainState>(*kernelAlloc);
+				state->ring = frg::construct<SingleContextRecordRing>(*kernelAlloc);
+
+				auto irqLock = frg::guard(&irqMutex());
+				while(!tryLockDrain())
+					pause();
+				drainStates->push(state);
+				unlockDrain();
+
+				__atomic_store_n(&getCpuData(i)->localLogRing, state->ring, __ATOMIC_RELEASE);
+			}
+
+			// Announce that we might go to sleep *before* the final check of the rings.
+			// Writers that publish records afterwards see the flag and wake us up.
+			logDrainIdle.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			// Emit one record at a time, such that IRQs are not disabled for too long.
+			bool progress = false;
+			while(true) {
+				auto irqLock = frg::guard(&irqMutex());
+				while(!tryLockDrain())
+					pause();
+				auto emitted = drainLogRings(false, 1);
+				unlockDrain();
+				if(!emitted)
+					break;
+				progress = true;
+			}
+
+			auto dropped = droppedLogRecords.load(std::memory_order_relaxed);
+			if(dropped != reportedDrops) {
+				urgentLogger() << "thor: " << (dropped - reportedDrops)
+						<< " log records were dropped" << frg::endlog;
+				reportedDrops = dropped;
+			}
+
+			if(!progress)
+				KernelFiber::asyncBlockCurrent(async::race_and_cancel(
+					[] (async::cancellation_token cancellation) {
+						return async::transform(logDrainEvent->async_wait_if([] () -> bool {
+							return logDrainIdle.load(std::memory_order_relaxed);
+						}, cancellation), [] (bool) { });
+					},
+					[] (async::cancellation_token cancellation) {
+						return generalTimerEngine()->sleepFor(logDrainFallbackInterval,
+								cancellation);
+					}
+				));
+		}
+	}
+
+	initgraph::Task initLogDrain{&globalInitEngine, "generic.init-log-drain",
+		initgraph::Requires{getTaskingAvailableStage()},
+		[] {
+			drainStates.initialize(*kernelAlloc);
+			logDrainEvent.initialize();
+			KernelFiber::run([] {
+				logDrainRunning.store(true, std::memory_order_release);
+				runLogDrain();
+			});
+		}
+	};
+} // anonymous namespace
+
+uint64_t numDroppedLogRecords() {
+	return droppedLogRecords.load(std::memory_order_relaxed);
+}
+
 void InfoSink::operator() (const char *msg) {
+	bool canWake = intsAreEnabled();
 	auto irqLock = frg::guard(&irqMutex());
+	if(enqueueToLogRing(msg, canWake))
+		return;
+
 	auto lock = frg::guard(&logMutex);
 
 	logProcessor.print(msg);
@@ -158,6 +430,8 @@ void InfoSink::operator() (const char *msg) {
 
 void UrgentSink::operator() (const char *msg) {
 	StatelessIrqLock irqLock;
+	flushLogRings(false);
+
 	auto lock = frg::guard(&logMutex);
 
 	logProcessor.print(msg);
@@ -166,6 +440,7 @@ void UrgentSink::operator() (const char *msg) {
 
 void PanicSink::operator() (const char *msg) {
 	StatelessIrqLock irqLock;
+	flushLogRings(true);
 
 	auto lock = frg::guard(&logMutex);
 
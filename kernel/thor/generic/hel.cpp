@@ -12,6 +12,7 @@
 #include <thor-internal/ipc-queue.hpp>
 #include <thor-internal/irq.hpp>
 #include <thor-internal/kernlet.hpp>
+#include <thor-internal/ostrace.hpp>
 #include <thor-internal/physical.hpp>
 #include <thor-internal/random.hpp>
 #include <thor-internal/stream.hpp>
@@ -353,6 +354,63 @@ HelError helCancelAsync(HelHandle handle, uint64_t async_id) {
 	return kHelErrNone;
 }
 
+HelError helSubmitBatch(HelHandle queueHandle, HelBatchEntry *entries,
+		size_t count, size_t *numSubmitted) {
+	*numSubmitted = 0;
+
+	for(size_t i = 0; i < count; i++) {
+		HelBatchEntry entry;
+		if(!readUserObject(entries + i, entry))
+			return kHelErrFault;
+
+		// Each operation is dispatched to the same code path as the corresponding syscall.
+		// This keeps the semantics (and the error codes) of batched submission identical.
+		HelError error;
+		switch(entry.op) {
+		case kHelBatchAsyncNop:
+			error = helSubmitAsyncNop(queueHandle, entry.context);
+			break;
+		case kHelBatchSubmitAsync:
+			error = helSubmitAsync(entry.handle, static_cast<const HelAction *>(entry.pointer),
+					entry.length, queueHandle, entry.context, entry.flags);
+			break;
+		case kHelBatchAwaitClock: {
+			uint64_t asyncId;
+			error = helSubmitAwaitClock(entry.argument, queueHandle, entry.context, &asyncId);
+			if(error == kHelErrNone && !writeUserObject(&entries[i].asyncId, asyncId)) {
+				// The operation was submitted; userspace just cannot cancel it.
+				*numSubmitted = i + 1;
+				return kHelErrFault;
+			}
+		} break;
+		case kHelBatchAwaitEvent:
+			error = helSubmitAwaitEvent(entry.handle, entry.argument,
+					queueHandle, entry.context);
+			break;
+		case kHelBatchReadMemory:
+			error = helSubmitReadMemory(entry.handle, entry.argument,
+					entry.length, entry.pointer, queueHandle, entry.context);
+			break;
+		case kHelBatchWriteMemory:
+			error = helSubmitWriteMemory(entry.handle, entry.argument,
+					entry.length, entry.pointer, queueHandle, entry.context);
+			break;
+		case kHelBatchObserve:
+			error = helSubmitObserve(entry.handle, entry.argument,
+					queueHandle, entry.context);
+			break;
+		default:
+			error = kHelErrIllegalArgs;
+		}
+
+		if(error != kHelErrNone)
+			return error;
+		*numSubmitted = i + 1;
+	}
+
+	return kHelErrNone;
+}
+
 HelError helAllocateMemory(size_t size, uint32_t flags,
 		HelAllocRestrictions *restrictions, HelHandle *handle) {
 	if(!size)
@@ -1613,6 +1671,17 @@ HelError helCreateThread(HelHandle universe_handle, HelHandle space_handle,
 	return kHelErrNone;
 }
 
+namespace {
+	void fillThreadStats(Thread *thread, HelThreadStats *stats) {
+		memset(stats, 0, sizeof(HelThreadStats));
+		stats->userTime = thread->runTime();
+		stats->waitTime = thread->waitTime();
+		stats->numVoluntarySwitches = thread->numVoluntarySwitches();
+		stats->numInvoluntarySwitches = thread->numInvoluntarySwitches();
+		stats->lastCpu = thread->lastCpu();
+	}
+}
+
 HelError helQueryThreadStats(HelHandle handle, HelThreadStats *user_stats) {
 	auto this_thread = getCurrentThread();
 	auto this_universe = this_thread->getUniverse();
@@ -1633,8 +1702,72 @@ HelError helQueryThreadStats(HelHandle handle, HelThreadStats *user_stats) {
 	}
 
 	HelThreadStats stats;
-	memset(&stats, 0, sizeof(HelThreadStats));
-	stats.userTime = thread->runTime();
+	fillThreadStats(thread.get(), &stats);
+
+	if(!writeUserObject(user_stats, stats))
+		return kHelErrFault;
+
+	return kHelErrNone;
+}
+
+HelError helQueryThreadStatsBatch(const HelHandle *handles, size_t count,
+		HelThreadStats *user_stats) {
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	// Bound the amount of kernel memory that a single call can consume.
+	if(count > 4096)
+		return kHelErrIllegalArgs;
+
+	frg::vector<HelHandle, KernelAlloc> handleBuffer{*kernelAlloc};
+	handleBuffer.resize(count);
+	if(!readUserArray(handles, handleBuffer.data(), count))
+		return kHelErrFault;
+
+	frg::vector<smarter::shared_ptr<Thread>, KernelAlloc> threads{*kernelAlloc};
+	threads.resize(count);
+	{
+		auto irq_lock = frg::guard(&irqMutex());
+		Universe::Guard universe_guard(this_universe->lock);
+
+		for(size_t i = 0; i < count; i++) {
+			auto thread_wrapper = this_universe->getDescriptor(universe_guard, handleBuffer[i]);
+			if(!thread_wrapper)
+				return kHelErrNoDescriptor;
+			if(!thread_wrapper->is<ThreadDescriptor>())
+				return kHelErrBadDescriptor;
+			threads[i] = remove_tag_cast(thread_wrapper->get<ThreadDescriptor>().thread);
+		}
+	}
+
+	for(size_t i = 0; i < count; i++) {
+		HelThreadStats stats;
+		fillThreadStats(threads[i].get(), &stats);
+
+		if(!writeUserObject(user_stats + i, stats))
+			return kHelErrFault;
+	}
+
+	return kHelErrNone;
+}
+
+HelError helQueryCpuStats(int cpu, HelCpuStats *user_stats) {
+	if(cpu < 0 || cpu >= getCpuCount())
+		return kHelErrOutOfBounds;
+
+	auto scheduler = &getCpuData(cpu)->scheduler;
+
+	HelCpuStats stats;
+	memset(&stats, 0, sizeof(HelCpuStats));
+	stats.idleTime = scheduler->idleTime();
+	stats.busyTime = scheduler->busyTime();
+#ifdef __x86_64__
+	auto shootStats = getCpuData(cpu)->pageContext.shootdownStats();
+	stats.numShootdowns = shootStats.requests;
+	stats.numShootdownIpis = shootStats.ipis;
+	stats.numLazyFlushes = shootStats.lazyFlushes;
+	stats.numFullFlushes = shootStats.fullFlushes;
+#endif
 
 	if(!writeUserObject(user_stats, stats))
 		return kHelErrFault;
@@ -1904,6 +2037,7 @@ HelError helLoadRegisters(HelHandle handle, int set, void *image) {
 #endif
 	}else if(set == kHelRegsSimd) {
 #if defined(__x86_64__)
+		thread->_executor.materializeSimdState();
 		if(!writeUserMemory(image, thread->_executor._fxState(), Executor::determineSimdSize()))
 			return kHelErrFault;
 #elif defined(__aarch64__)
@@ -2265,6 +2399,8 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 	if(!count)
 		return kHelErrIllegalArgs;
 
+	OsTraceSpan span{osTraceKernelEvents.submitAsync};
+
 	auto thisThread = getCurrentThread();
 	auto thisUniverse = thisThread->getUniverse();
 
@@ -3211,6 +3347,77 @@ HelError helAutomateIrq(HelHandle handle, uint32_t flags, HelHandle kernlet_hand
 	return kHelErrNone;
 }
 
+namespace {
+	HelError getIrqPinOfHandle(HelHandle handle, IrqPin **pin) {
+		auto this_thread = getCurrentThread();
+		auto this_universe = this_thread->getUniverse();
+
+		smarter::shared_ptr<IrqObject> irq;
+		{
+			auto irq_lock = frg::guard(&irqMutex());
+			Universe::Guard universe_guard(this_universe->lock);
+
+			auto irq_wrapper = this_universe->getDescriptor(universe_guard, handle);
+			if(!irq_wrapper)
+				return kHelErrNoDescriptor;
+			if(!irq_wrapper->is<IrqDescriptor>())
+				return kHelErrBadDescriptor;
+			irq = irq_wrapper->get<IrqDescriptor>().irq;
+		}
+
+		// IrqPins are never destructed, hence it is fine to drop the IrqObject here.
+		*pin = irq->getPin();
+		if(!*pin)
+			return kHelErrIllegalState;
+		return kHelErrNone;
+	}
+}
+
+HelError helSetIrqAffinity(HelHandle handle, int cpu) {
+	IrqPin *pin;
+	if(auto error = getIrqPinOfHandle(handle, &pin); error != kHelErrNone)
+		return error;
+
+	auto error = pin->setAffinity(cpu);
+	if(error == Error::illegalArgs)
+		return kHelErrIllegalArgs;
+	if(error == Error::noHardwareSupport)
+		return kHelErrUnsupportedOperation;
+	assert(error == Error::success);
+	return kHelErrNone;
+}
+
+HelError helGetIrqAffinity(HelHandle handle, int *cpu) {
+	IrqPin *pin;
+	if(auto error = getIrqPinOfHandle(handle, &pin); error != kHelErrNone)
+		return error;
+
+	*cpu = pin->affinity();
+	return kHelErrNone;
+}
+
+HelError helQueryIrqStats(int index, HelIrqStats *user_stats) {
+	if(index < 0)
+		return kHelErrOutOfBounds;
+	auto pin = getIrqPinByIndex(index);
+	if(!pin)
+		return kHelErrOutOfBounds;
+
+	HelIrqStats stats;
+	memset(&stats, 0, sizeof(HelIrqStats));
+	auto &name = pin->name();
+	memcpy(stats.name, name.data(), frg::min(name.size(), sizeof(stats.name) - 1));
+	stats.affinity = pin->affinity();
+	static_assert(kHelIrqStatsMaxCpus == IrqPin::maxStatCpus);
+	for(int i = 0; i < frg::min(getCpuCount(), IrqPin::maxStatCpus); i++)
+		stats.counts[i] = pin->raiseCount(i);
+
+	if(!writeUserObject(user_stats, stats))
+		return kHelErrFault;
+
+	return kHelErrNone;
+}
+
 HelError helAccessIo(uintptr_t *port_array, size_t num_ports,
 		HelHandle *handle) {
 	auto this_thread = getCurrentThread();
@@ -3320,17 +3527,15 @@ HelError helBindKernlet(HelHandle handle, const HelKernletData *data, size_t num
 				memory = wrapper->get<MemoryViewDescriptor>().memory;
 			}
 
-			auto window = reinterpret_cast<char *>(KernelVirtualMemory::global().allocate(0x10000));
-			assert(memory->getLength() <= 0x10000);
-
-			for(size_t off = 0; off < memory->getLength(); off += kPageSize) {
-				auto range = memory->peekRange(off);
-				assert(range.get<0>() != PhysicalAddr(-1));
-				KernelPageSpace::global().mapSingle4k(reinterpret_cast<uintptr_t>(window + off),
-						range.get<0>(), page_access::write, range.get<1>());
-			}
-
-			bound->setupMemoryViewBinding(i, window);
+			auto pinned = smarter::allocate_shared<PinnedMemory>(*kernelAlloc,
+					std::move(memory));
+			auto pinOutcome = Thread::asyncBlockCurrent(
+					pinned->pin(this_thread->mainWorkQueue()->take()));
+			if(!pinOutcome)
+				return translateError(pinOutcome.error());
+			if(auto error = pinned->map(); error != Error::success)
+				return translateError(error);
+			bound->setupMemoryViewBinding(i, std::move(pinned));
 		}else{
 			assert(defn.type == KernletParameterType::bitsetEvent);
 
@@ -3503,6 +3708,124 @@ HelError helQueryRegisterInfo(int set, HelRegisterInfo *info) {
 	return kHelErrNone;
 }
 
+HelError helSetSignalTable(HelHandle handle, const HelSignalTable *table) {
+#ifdef __x86_64__
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	smarter::shared_ptr<Thread> thread;
+	{
+		auto irq_lock = frg::guard(&irqMutex());
+		Universe::Guard universe_guard(this_universe->lock);
+
+		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
+		if(!thread_wrapper)
+			return kHelErrNoDescriptor;
+		if(!thread_wrapper->is<ThreadDescriptor>())
+			return kHelErrBadDescriptor;
+		thread = remove_tag_cast(thread_wrapper->get<ThreadDescriptor>().thread);
+	}
+
+	if(!table) {
+		Thread::setSignalTable(thread, nullptr);
+		return kHelErrNone;
+	}
+
+	auto copy = frg::construct<HelSignalTable>(*kernelAlloc);
+	if(!readUserObject(table, *copy)) {
+		frg::destruct(*kernelAlloc, copy);
+		return kHelErrFault;
+	}
+
+	// Make sure that all fields that the kernel writes are inside of the frame.
+	const auto &layout = copy->layout;
+	auto fits = [&] (size_t offset, size_t size) {
+		return offset <= layout.frameSize && size <= layout.frameSize - offset;
+	};
+	if(layout.frameSize > kHelSignalMaxFrameSize
+			|| !fits(layout.returnOffset, sizeof(uintptr_t))
+			|| !fits(layout.regsOffset, 19 * sizeof(uintptr_t))
+			|| !fits(layout.maskOffset, sizeof(uint64_t))
+			|| !fits(layout.simdPointerOffset, sizeof(uintptr_t))
+			|| !fits(layout.infoOffset, 0)
+			|| !fits(layout.contextOffset, 0)) {
+		frg::destruct(*kernelAlloc, copy);
+		return kHelErrIllegalArgs;
+	}
+
+	Thread::setSignalTable(thread, copy);
+	return kHelErrNone;
+#else
+	(void)handle;
+	(void)table;
+	return kHelErrUnsupportedOperation;
+#endif
+}
+
+HelError helRaiseSignal(HelHandle handle, int number, const void *info, size_t infoSize) {
+	static_assert(Thread::userSignalInfoSize == kHelSignalInfoSize);
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	if(number < 1 || number > 64 || infoSize > kHelSignalInfoSize)
+		return kHelErrIllegalArgs;
+
+	char infoBuffer[kHelSignalInfoSize];
+	if(!readUserMemory(infoBuffer, info, infoSize))
+		return kHelErrFault;
+
+	smarter::shared_ptr<Thread> thread;
+	{
+		auto irq_lock = frg::guard(&irqMutex());
+		Universe::Guard universe_guard(this_universe->lock);
+
+		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
+		if(!thread_wrapper)
+			return kHelErrNoDescriptor;
+		if(!thread_wrapper->is<ThreadDescriptor>())
+			return kHelErrBadDescriptor;
+		thread = remove_tag_cast(thread_wrapper->get<ThreadDescriptor>().thread);
+	}
+
+	auto error = Thread::raiseUserSignal(thread, number, infoBuffer, infoSize);
+	if(error == Error::illegalState)
+		return kHelErrIllegalState;
+	if(error == Error::bufferTooSmall)
+		return kHelErrQueueTooSmall;
+	assert(error == Error::success);
+	return kHelErrNone;
+}
+
+HelError helReclaimSignal(HelHandle handle, int *number, void *info) {
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	smarter::shared_ptr<Thread> thread;
+	{
+		auto irq_lock = frg::guard(&irqMutex());
+		Universe::Guard universe_guard(this_universe->lock);
+
+		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
+		if(!thread_wrapper)
+			return kHelErrNoDescriptor;
+		if(!thread_wrapper->is<ThreadDescriptor>())
+			return kHelErrBadDescriptor;
+		thread = remove_tag_cast(thread_wrapper->get<ThreadDescriptor>().thread);
+	}
+
+	// Check that the buffer is writable before taking the signal out of the thread.
+	char infoBuffer[kHelSignalInfoSize]{};
+	if(!writeUserMemory(info, infoBuffer, kHelSignalInfoSize))
+		return kHelErrFault;
+
+	auto reclaimed = Thread::reclaimUserSignal(thread, infoBuffer);
+	if(reclaimed && !writeUserMemory(info, infoBuffer, kHelSignalInfoSize))
+		return kHelErrFault;
+
+	*number = reclaimed;
+	return kHelErrNone;
+}
+
 HelError helGetCurrentCpu(int *cpu) {
 	*cpu = getCpuData()->cpuIndex;
 	return kHelErrNone;
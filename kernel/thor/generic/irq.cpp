@@ -1,3 +1,4 @@
+#include <frg/vector.hpp>
 #include <thor-internal/coroutine.hpp>
 #include <thor-internal/cpu-data.hpp>
 #include <thor-internal/debug.hpp>
@@ -119,10 +120,39 @@ Error IrqPin::kickSink(IrqSink *sink, bool wantClear) {
 // IrqPin
 // --------------------------------------------------------
 
+namespace {
+	IrqSpinlock irqPinRegistryLock;
+
+	// All IrqPins in the system. Since pins are never destructed, indices are stable.
+	frg::vector<IrqPin *, KernelAlloc> &irqPinRegistry() {
+		static frg::eternal<frg::vector<IrqPin *, KernelAlloc>> singleton{*kernelAlloc};
+		return singleton.get();
+	}
+
+	std::atomic<unsigned int> msiAffinityCounter;
+}
+
+IrqPin *getIrqPinByIndex(size_t n) {
+	auto lock = frg::guard(&irqPinRegistryLock);
+	auto &registry = irqPinRegistry();
+	if(n >= registry.size())
+		return nullptr;
+	return registry[n];
+}
+
+int nextMsiAffinity() {
+	return msiAffinityCounter.fetch_add(1, std::memory_order_relaxed) % getCpuCount();
+}
+
 IrqPin::IrqPin(frg::string<KernelAlloc> name)
 : _name{std::move(name)}, _strategy{IrqStrategy::null},
 		_inService{false}, _dueSinks{0},
 		_maskState{0} {
+	{
+		auto lock = frg::guard(&irqPinRegistryLock);
+		irqPinRegistry().push_back(this);
+	}
+
 	[] (IrqPin *self, enable_detached_coroutine = {}) -> void {
 		while(true) {
 			co_await self->_unstallEvent.async_wait_if([&] () -> bool {
@@ -185,10 +215,21 @@ void IrqPin::configure(IrqConfiguration desired) {
 	}
 }
 
+int IrqPin::affinity() {
+	return -1;
+}
+
+Error IrqPin::setAffinity(int) {
+	return Error::noHardwareSupport;
+}
+
 void IrqPin::raise() {
 	assert(!intsAreEnabled());
 	auto lock = frg::guard(&_mutex);
 
+	auto cpu = frg::min(getCpuData()->cpuIndex, maxStatCpus - 1);
+	__atomic_store_n(&_raisesPerCpu[cpu], _raisesPerCpu[cpu] + 1, __ATOMIC_RELAXED);
+
 	if(_strategy == IrqStrategy::null) {
 		infoLogger() << "\e[35mthor: Unconfigured IRQ was raised\e[39m" << frg::endlog;
 		dumpHardwareState();
@@ -444,6 +485,39 @@ void IrqPin::_updateMask() {
 	}
 }
 
+// --------------------------------------------------------
+// MsiPin
+// --------------------------------------------------------
+
+void MsiPin::attachProgrammer(MsiProgrammer *programmer, size_t index) {
+	auto irqLock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&_mutex);
+
+	_programmer = programmer;
+	_programmerIndex = index;
+	_programmer->programMsi(this, _programmerIndex);
+}
+
+Error MsiPin::setAffinity(int cpu) {
+	if(cpu < 0 || cpu >= getCpuCount())
+		return Error::illegalArgs;
+
+	// Hold the lock such that concurrent updates cannot interleave their writes
+	// to the device. The programmer masks the MSI at the device while it is updated.
+	auto irqLock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&_mutex);
+
+	if(auto error = routeTo(cpu); error != Error::success)
+		return error;
+	if(_programmer)
+		_programmer->programMsi(this, _programmerIndex);
+	return Error::success;
+}
+
+Error MsiPin::routeTo(int) {
+	return Error::noHardwareSupport;
+}
+
 // --------------------------------------------------------
 // IrqObject
 // --------------------------------------------------------
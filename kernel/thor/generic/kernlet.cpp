@@ -8,6 +8,7 @@
 #include <frg/string.hpp>
 #include <elf.h>
 #include <thor-internal/universe.hpp>
+#include <thor-internal/arch/paging.hpp>
 #include <thor-internal/coroutine.hpp>
 #include <thor-internal/fiber.hpp>
 #include <thor-internal/kernlet.hpp>
@@ -26,6 +27,81 @@ namespace {
 	constexpr bool logIo = false;
 }
 
+// ------------------------------------------------------------------------
+// PinnedMemory class.
+// ------------------------------------------------------------------------
+
+PinnedMemory::PinnedMemory(smarter::shared_ptr<MemoryView> memory)
+: _memory{std::move(memory)}, _pages{*kernelAlloc} {
+	_length = _memory->getLength();
+}
+
+PinnedMemory::~PinnedMemory() {
+	if(_window) {
+		for(size_t off = 0; off < _length; off += kPageSize)
+			KernelPageSpace::global().unmapSingle4k(reinterpret_cast<uintptr_t>(_window + off));
+
+		struct Closure final : ShootNode {
+			void complete() override {
+				KernelVirtualMemory::global().deallocate(reinterpret_cast<void *>(address), size);
+				auto physical = thisPage;
+				Closure::~Closure();
+				asm volatile ("" : : : "memory");
+				physicalAllocator->free(physical, kPageSize);
+			}
+
+			PhysicalAddr thisPage;
+		};
+		static_assert(sizeof(Closure) <= kPageSize);
+
+		// See UniqueKernelStack for the rationale of this allocation strategy.
+		auto physical = physicalAllocator->allocate(kPageSize);
+		assert(physical != PhysicalAddr(-1) && "OOM");
+		PageAccessor accessor{physical};
+		auto p = new (accessor.get()) Closure;
+		p->thisPage = physical;
+		p->address = reinterpret_cast<uintptr_t>(_window);
+		p->size = 0x10000;
+		if(KernelPageSpace::global().submitShootdown(p))
+			p->complete();
+	}
+
+	// Nobody accesses the memory anymore, even if the shootdown is still in progress.
+	if(_locked)
+		_memory->unlockRange(0, _length);
+}
+
+coroutine<frg::expected<Error>> PinnedMemory::pin(smarter::shared_ptr<WorkQueue> wq) {
+	assert(!_locked);
+	if(auto error = _memory->lockRange(0, _length); error != Error::success)
+		co_return error;
+	_locked = true;
+
+	FRG_CO_TRY(co_await _memory->touchRange(0, _length, 0, wq));
+
+	_pages.resize((_length + kPageSize - 1) >> kPageShift);
+	for(size_t i = 0; i < _pages.size(); i++) {
+		auto range = _memory->peekRange(i << kPageShift);
+		if(range.get<0>() == PhysicalAddr(-1))
+			co_return Error::fault;
+		_pages[i] = range;
+	}
+	co_return {};
+}
+
+Error PinnedMemory::map() {
+	assert(_locked && !_window);
+	if(_length > 0x10000)
+		return Error::illegalArgs;
+
+	_window = reinterpret_cast<char *>(KernelVirtualMemory::global().allocate(0x10000));
+	for(size_t i = 0; i < _pages.size(); i++)
+		KernelPageSpace::global().mapSingle4k(reinterpret_cast<uintptr_t>(_window)
+				+ (i << kPageShift), _pages[i].get<0>(), page_access::write,
+				_pages[i].get<1>());
+	return Error::success;
+}
+
 // ------------------------------------------------------------------------
 // KernletObject class.
 // ------------------------------------------------------------------------
@@ -69,7 +145,7 @@ const KernletParameterDefn &KernletObject::defnOfBindParameter(size_t index) {
 // ------------------------------------------------------------------------
 
 BoundKernlet::BoundKernlet(smarter::shared_ptr<KernletObject> object)
-: _object{std::move(object)} {
+: _object{std::move(object)}, _memories{*kernelAlloc} {
 	_instance = reinterpret_cast<char *>(kernelAlloc->allocate(_object->instanceSize()));
 }
 
@@ -82,13 +158,16 @@ void BoundKernlet::setupOffsetBinding(size_t index, uint32_t offset) {
 	memcpy(_instance + defn.offset, &offset, sizeof(uint32_t));
 }
 
-void BoundKernlet::setupMemoryViewBinding(size_t index, void *p) {
+void BoundKernlet::setupMemoryViewBinding(size_t index,
+		smarter::shared_ptr<PinnedMemory> memory) {
 	assert(index < _object->numberOfBindParameters());
 	const auto &defn = _object->defnOfBindParameter(index);
+	auto p = memory->window();
 	if(logBinding)
-		infoLogger() << "thor: Binding memory view " << p
+		infoLogger() << "thor: Binding memory view " << (void *)p
 				<< " to instance offset " << defn.offset << frg::endlog;
 	memcpy(_instance + defn.offset, &p, sizeof(void *));
+	_memories.push_back(std::move(memory));
 }
 
 void BoundKernlet::setupBitsetEventBinding(size_t index, smarter::shared_ptr<BitsetEvent> event) {
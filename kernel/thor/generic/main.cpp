@@ -257,6 +257,11 @@ extern "C" void thorMain() {
 				return v;
 			};
 
+			size_t numMappedFiles = 0;
+			size_t numCopiedFiles = 0;
+			size_t mappedBytes = 0;
+			size_t copiedBytes = 0;
+
 			auto p = base;
 			auto limit = base + modules[0].length;
 			while(true) {
@@ -272,7 +277,10 @@ extern "C" void thorMain() {
 				auto file_size = parseHex(header.fileSize, 8);
 				auto data = p + ((sizeof(Header) + name_size + 3) & ~uint32_t{3});
 
-				frg::string_view path{p + sizeof(Header), name_size - 1};
+				// gen-initrd.py pads names with NULs to page-align the file data.
+				auto namePtr = p + sizeof(Header);
+				frg::string_view path{namePtr,
+						static_cast<size_t>(std::find(namePtr, namePtr + name_size, '\0') - namePtr)};
 				if(path == "TRAILER!!!")
 					break;
 
@@ -301,16 +309,31 @@ extern "C" void thorMain() {
 							frg::construct<MfsDirectory>(*kernelAlloc));
 				}else{
 					assert((mode & type_mask) == regular_type);
-	//				if(logInitialization)
+					if(logInitialization)
 						infoLogger() << "thor: initrd file " << path << frg::endlog;
 
-					auto memory = smarter::allocate_shared<AllocatedMemory>(*kernelAlloc,
-							(file_size + (kPageSize - 1)) & ~size_t{kPageSize - 1});
-					memory->selfPtr = memory;
-					auto copyOutcome = KernelFiber::asyncBlockCurrent(memory->copyTo(0,
-							data, file_size,
-							thisFiber()->associatedWorkQueue()->take()));
-					assert(copyOutcome);
+					smarter::shared_ptr<MemoryView> memory;
+					auto dataPhysical = modules[0].physicalBase + (data - base);
+					if(file_size && !(dataPhysical % kPageSize)) {
+						// Reference the module's pages directly instead of copying them.
+						auto inPlace = smarter::allocate_shared<ModuleMemory>(*kernelAlloc,
+								dataPhysical, file_size);
+						inPlace->selfPtr = inPlace;
+						memory = std::move(inPlace);
+						numMappedFiles++;
+						mappedBytes += file_size;
+					}else{
+						auto allocated = smarter::allocate_shared<AllocatedMemory>(*kernelAlloc,
+								(file_size + (kPageSize - 1)) & ~size_t{kPageSize - 1});
+						allocated->selfPtr = allocated;
+						auto copyOutcome = KernelFiber::asyncBlockCurrent(allocated->copyTo(0,
+								data, file_size,
+								thisFiber()->associatedWorkQueue()->take()));
+						assert(copyOutcome);
+						memory = std::move(allocated);
+						numCopiedFiles++;
+						copiedBytes += file_size;
+					}
 
 					auto name = frg::string<KernelAlloc>{*kernelAlloc,
 							path.sub_string(it - path.data(), end - it)};
@@ -320,6 +343,11 @@ extern "C" void thorMain() {
 
 				p = data + ((file_size + 3) & ~uint32_t{3});
 			}
+
+			infoLogger() << "thor: initrd contains " << numMappedFiles << " page-aligned files ("
+					<< (mappedBytes / 1024) << " KiB, used in place) and "
+					<< numCopiedFiles << " unaligned files ("
+					<< (copiedBytes / 1024) << " KiB, copied)" << frg::endlog;
 		}
 
 		if(logInitialization)
@@ -615,6 +643,12 @@ void handleSyscall(SyscallImageAccessor image) {
 	case kHelCallCancelAsync: {
 		*image.error() = helCancelAsync((HelHandle)arg0, (uint64_t)arg1);
 	} break;
+	case kHelCallSubmitBatch: {
+		size_t numSubmitted;
+		*image.error() = helSubmitBatch((HelHandle)arg0, (HelBatchEntry *)arg1,
+				(size_t)arg2, &numSubmitted);
+		*image.out0() = numSubmitted;
+	} break;
 
 	case kHelCallAllocateMemory: {
 		HelHandle handle;
@@ -748,6 +782,13 @@ void handleSyscall(SyscallImageAccessor image) {
 	case kHelCallQueryThreadStats: {
 		*image.error() = helQueryThreadStats((HelHandle)arg0, (HelThreadStats *)arg1);
 	} break;
+	case kHelCallQueryThreadStatsBatch: {
+		*image.error() = helQueryThreadStatsBatch((const HelHandle *)arg0, (size_t)arg1,
+				(HelThreadStats *)arg2);
+	} break;
+	case kHelCallQueryCpuStats: {
+		*image.error() = helQueryCpuStats((int)arg0, (HelCpuStats *)arg1);
+	} break;
 	case kHelCallSetPriority: {
 		*image.error() = helSetPriority((HelHandle)arg0, (int)arg1);
 	} break;
@@ -851,6 +892,17 @@ void handleSyscall(SyscallImageAccessor image) {
 	case kHelCallAutomateIrq: {
 		*image.error() = helAutomateIrq((HelHandle)arg0, (uint32_t)arg1, (HelHandle)arg2);
 	} break;
+	case kHelCallSetIrqAffinity: {
+		*image.error() = helSetIrqAffinity((HelHandle)arg0, (int)arg1);
+	} break;
+	case kHelCallGetIrqAffinity: {
+		int cpu;
+		*image.error() = helGetIrqAffinity((HelHandle)arg0, &cpu);
+		*image.out0() = cpu;
+	} break;
+	case kHelCallQueryIrqStats: {
+		*image.error() = helQueryIrqStats((int)arg0, (HelIrqStats *)arg1);
+	} break;
 
 	case kHelCallAccessIo: {
 		HelHandle handle;
@@ -886,6 +938,18 @@ void handleSyscall(SyscallImageAccessor image) {
 	case kHelCallQueryRegisterInfo: {
 		*image.error() = helQueryRegisterInfo((int)arg0, (HelRegisterInfo *)arg1);
 	} break;
+	case kHelCallSetSignalTable: {
+		*image.error() = helSetSignalTable((HelHandle)arg0, (const HelSignalTable *)arg1);
+	} break;
+	case kHelCallRaiseSignal: {
+		*image.error() = helRaiseSignal((HelHandle)arg0, (int)arg1,
+				(const void *)arg2, (size_t)arg3);
+	} break;
+	case kHelCallReclaimSignal: {
+		int number;
+		*image.error() = helReclaimSignal((HelHandle)arg0, &number, (void *)arg1);
+		*image.out0() = (Word)number;
+	} break;
 
 	default:
 		*image.error() = kHelErrIllegalSyscall;
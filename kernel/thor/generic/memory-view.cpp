@@ -590,6 +590,85 @@ size_t HardwareMemory::getLength() {
 	return _length;
 }
 
+// --------------------------------------------------------
+// ModuleMemory
+// --------------------------------------------------------
+
+ModuleMemory::ModuleMemory(PhysicalAddr base, size_t length)
+: _base{base}, _inPlaceLength{length & ~(kPageSize - 1)} {
+	assert(!(base % kPageSize));
+
+	if(auto tailLength = length & (kPageSize - 1); tailLength) {
+		// The rest of the last page belongs to whatever follows the data in the module.
+		_tail = physicalAllocator->allocate(kPageSize);
+		assert(_tail != PhysicalAddr(-1) && "OOM");
+
+		PageAccessor srcAccessor{_base + _inPlaceLength};
+		PageAccessor destAccessor{_tail};
+		memcpy(destAccessor.get(), srcAccessor.get(), tailLength);
+		memset(reinterpret_cast<char *>(destAccessor.get()) + tailLength, 0,
+				kPageSize - tailLength);
+	}
+}
+
+ModuleMemory::~ModuleMemory() {
+	// The module's pages are not owned by the physical allocator; only free our copy.
+	if(_tail != PhysicalAddr(-1))
+		physicalAllocator->free(_tail, kPageSize);
+}
+
+frg::expected<Error, frg::tuple<smarter::shared_ptr<GlobalFutexSpace>, uintptr_t>>
+ModuleMemory::resolveGlobalFutex(uintptr_t offset) {
+	smarter::shared_ptr<GlobalFutexSpace> futexSpace{selfPtr.lock()};
+	return frg::make_tuple(std::move(futexSpace), offset);
+}
+
+Error ModuleMemory::lockRange(uintptr_t, size_t) {
+	// Module memory is never evicted.
+	return Error::success;
+}
+
+void ModuleMemory::unlockRange(uintptr_t, size_t) {
+	// Module memory is never evicted.
+}
+
+frg::tuple<PhysicalAddr, CachingMode> ModuleMemory::peekRange(uintptr_t offset) {
+	assert(offset % kPageSize == 0);
+	if(offset < _inPlaceLength)
+		return frg::tuple<PhysicalAddr, CachingMode>{_base + offset, CachingMode::null};
+	assert(offset == _inPlaceLength && _tail != PhysicalAddr(-1));
+	return frg::tuple<PhysicalAddr, CachingMode>{_tail, CachingMode::null};
+}
+
+coroutine<frg::expected<Error, PhysicalRange>>
+ModuleMemory::fetchRange(uintptr_t offset, FetchFlags, smarter::shared_ptr<WorkQueue>) {
+	if(offset < _inPlaceLength)
+		co_return PhysicalRange{_base + offset, _inPlaceLength - offset, CachingMode::null};
+	auto misalign = offset & (kPageSize - 1);
+	assert(offset - misalign == _inPlaceLength && _tail != PhysicalAddr(-1));
+	co_return PhysicalRange{_tail + misalign, kPageSize - misalign, CachingMode::null};
+}
+
+void ModuleMemory::markDirty(uintptr_t, size_t) {
+	// We never evict memory, there is no need to track dirty pages.
+}
+
+size_t ModuleMemory::getLength() {
+	if(_tail != PhysicalAddr(-1))
+		return _inPlaceLength + kPageSize;
+	return _inPlaceLength;
+}
+
+coroutine<frg::expected<Error, PhysicalAddr>> ModuleMemory::takeGlobalFutex(uintptr_t offset,
+		smarter::shared_ptr<WorkQueue> wq) {
+	auto range = FRG_CO_TRY(co_await fetchRange(offset & ~(kPageSize - 1), 0, wq));
+	co_return range.get<0>();
+}
+
+void ModuleMemory::retireGlobalFutex(uintptr_t) {
+	// Do nothing.
+}
+
 // --------------------------------------------------------
 // AllocatedMemory
 // --------------------------------------------------------
@@ -1,14 +1,19 @@
+#include <async/recurring-event.hpp>
 #include <bragi/helpers-all.hpp>
 #include <bragi/helpers-frigg.hpp>
 #include <frg/small_vector.hpp>
+#include <frg/vector.hpp>
 #include <frg/span.hpp>
+#include <thor-internal/cpu-data.hpp>
 #include <thor-internal/fiber.hpp>
 #include <thor-internal/kernel-io.hpp>
 #include <thor-internal/main.hpp>
+#include <thor-internal/memory-view.hpp>
 #include <thor-internal/ostrace.hpp>
 #include <thor-internal/stream.hpp>
 #include <thor-internal/timer.hpp>
 #include <thor-internal/mbus.hpp>
+#include <thor-internal/universe.hpp>
 
 // --------------------------------------------------------------------------------------
 // Core ostrace implementation.
@@ -20,6 +25,8 @@ bool wantOsTrace = false;
 
 constinit std::atomic<bool> osTraceInUse{false};
 
+OsTraceKernelEvents osTraceKernelEvents;
+
 initgraph::Stage *getOsTraceAvailableStage() {
 	static initgraph::Stage s{&globalInitEngine, "generic.ostrace-available"};
 	return &s;
@@ -28,7 +35,38 @@ initgraph::Stage *getOsTraceAvailableStage() {
 namespace {
 
 std::atomic<uint64_t> nextId{1};
+std::atomic<uint64_t> nextSpanId{1};
 frg::manual_box<LogRingBuffer> globalOsTraceRing;
+OsTraceItemId osTraceDroppedItem;
+
+// Must match the layout in protocols/ostrace/include/protocols/ostrace/ostrace.hpp.
+// The data area starts at osTraceRingDataOffset and its size is a power of two.
+struct OsTraceRingHeader {
+	uint64_t head;
+	uint64_t tail;
+	uint64_t dropped;
+	uint64_t wantSignal;
+};
+
+constexpr size_t osTraceRingDataOffset = 0x1000;
+constexpr size_t osTraceRingMaxSize = size_t{1} << 20;
+
+struct OsTraceRing {
+	smarter::shared_ptr<MemoryView> view;
+	size_t size;
+	Stream *owner; // Only used as an identity; the ring is dropped when the owner goes away.
+	bool orphaned = false; // Protected by osTraceRingsMutex.
+	uint64_t tail = 0; // Our own copy of the tail; we never trust the one in the header.
+	uint64_t reportedDropped = 0; // Value of the header's dropped counter that we reported.
+};
+
+frg::ticket_spinlock osTraceRingsMutex;
+frg::manual_box<frg::vector<smarter::shared_ptr<OsTraceRing>, KernelAlloc>> osTraceRings;
+
+// Incremented (and osTraceRingEvent is raised) whenever a ring is registered,
+// orphaned or signaled by its producer. The drain sleeps until this changes.
+std::atomic<uint64_t> osTraceRingSignals{0};
+frg::manual_box<async::recurring_event> osTraceRingEvent;
 
 initgraph::Task initOsTraceCore{&globalInitEngine, "generic.init-ostrace-core",
 	initgraph::Entails{getOsTraceAvailableStage()},
@@ -38,8 +76,17 @@ initgraph::Task initOsTraceCore{&globalInitEngine, "generic.init-ostrace-core",
 
 		void *osTraceMemory = kernelAlloc->allocate(1 << 20);
 		globalOsTraceRing.initialize(reinterpret_cast<uintptr_t>(osTraceMemory), 1 << 20);
+		osTraceRings.initialize(*kernelAlloc);
+		osTraceRingEvent.initialize();
 
 		osTraceInUse.store(true);
+
+		osTraceKernelEvents.run = announceOsTraceEvent("thor.run");
+		osTraceKernelEvents.submitAsync = announceOsTraceEvent("thor.submit-async");
+		osTraceKernelEvents.offerAccept = announceOsTraceEvent("thor.offer-accept");
+		osTraceKernelEvents.sendRecv = announceOsTraceEvent("thor.send-recv");
+		osTraceKernelEvents.ringDropped = announceOsTraceEvent("thor.ostrace-ring-dropped");
+		osTraceDroppedItem = announceOsTraceItem("dropped");
 	}
 };
 
@@ -61,6 +108,25 @@ void commitOsTrace(R record) {
 	globalOsTraceRing->enqueue(ser.data(), ser.size(), !intsAreEnabled());
 }
 
+// Span records are emitted on hot paths (e.g., for every helSubmitAsync()).
+// They have a bounded size, so we serialize them without going through the allocator.
+constexpr size_t osTraceSpanMaxSize = 128;
+
+void commitOsTraceSpan(managarm::ostrace::SpanRecord<KernelAlloc> &record) {
+	if(!osTraceInUse.load(std::memory_order_relaxed))
+		return;
+
+	char ser[osTraceSpanMaxSize];
+	auto ts = record.size_of_tail();
+	assert(8 + ts <= osTraceSpanMaxSize);
+	bool encodeSuccess = bragi::write_head_tail(record,
+			frg::span<char>(ser, 8),
+			frg::span<char>(ser + 8, ts));
+	assert(encodeSuccess);
+
+	globalOsTraceRing->enqueue(ser, 8 + ts, !intsAreEnabled());
+}
+
 } // anonymous namespace
 
 OsTraceEventId announceOsTraceEvent(frg::string_view name) {
@@ -74,16 +140,242 @@ OsTraceEventId announceOsTraceEvent(frg::string_view name) {
 	return static_cast<OsTraceEventId>(id);
 }
 
+OsTraceItemId announceOsTraceItem(frg::string_view name) {
+	auto id = nextId.fetch_add(1, std::memory_order_relaxed);
+
+	managarm::ostrace::AnnounceItemRecord<KernelAlloc> record{*kernelAlloc};
+	record.set_id(id);
+	record.set_name(frg::string<KernelAlloc>{*kernelAlloc, name});
+	commitOsTrace(std::move(record));
+
+	return static_cast<OsTraceItemId>(id);
+}
+
 void emitOsTrace(managarm::ostrace::EventRecord<KernelAlloc> record) {
 	record.set_ts(systemClockSource()->currentNanos());
 
 	commitOsTrace(std::move(record));
 }
 
+uint64_t allocateOsTraceSpanId() {
+	return nextSpanId.fetch_add(1, std::memory_order_relaxed);
+}
+
+void emitOsTraceSpan(OsTraceEventId id, OsTraceSpanPhase phase, uint64_t span, uint64_t flow) {
+	// Note that constructing the record does not allocate as long as ctrs stays empty.
+	managarm::ostrace::SpanRecord<KernelAlloc> record{*kernelAlloc};
+	record.set_ts(systemClockSource()->currentNanos());
+	record.set_id(static_cast<uint64_t>(id));
+	record.set_phase(static_cast<uint32_t>(phase));
+	record.set_span(span);
+	record.set_flow(flow);
+	record.set_ctx(0);
+	record.set_thread(getCpuData()->cpuIndex);
+
+	commitOsTraceSpan(record);
+}
+
 LogRingBuffer *getGlobalOsTraceRing() {
 	return globalOsTraceRing.get();
 }
 
+// --------------------------------------------------------------------------------------
+// Shared-memory rings registered by userspace.
+// --------------------------------------------------------------------------------------
+
+namespace {
+
+void signalOsTraceRingDrain() {
+	osTraceRingSignals.fetch_add(1, std::memory_order_release);
+	osTraceRingEvent->raise();
+}
+
+void registerOsTraceRing(smarter::shared_ptr<MemoryView> view, size_t size, Stream *owner) {
+	auto ring = smarter::allocate_shared<OsTraceRing>(*kernelAlloc);
+	ring->view = std::move(view);
+	ring->size = size;
+	ring->owner = owner;
+
+	{
+		auto lock = frg::guard(&osTraceRingsMutex);
+		osTraceRings->push(std::move(ring));
+	}
+	signalOsTraceRingDrain();
+}
+
+// Called when the lane that registered rings is closed.
+// The drain fiber drains the rings one last time and drops them afterwards.
+void orphanOsTraceRings(Stream *owner) {
+	{
+		auto lock = frg::guard(&osTraceRingsMutex);
+		for(auto &ring : *osTraceRings) {
+			if(ring->owner == owner)
+				ring->orphaned = true;
+		}
+	}
+	signalOsTraceRingDrain();
+}
+
+void removeOsTraceRing(OsTraceRing *ring) {
+	auto lock = frg::guard(&osTraceRingsMutex);
+	for(size_t i = 0; i < osTraceRings->size(); ++i) {
+		if((*osTraceRings)[i].get() != ring)
+			continue;
+		(*osTraceRings)[i] = std::move(osTraceRings->back());
+		osTraceRings->pop();
+		break;
+	}
+}
+
+// Asks the producer to send a SignalRingReq once it appends the next record.
+// Returns false if the ring is corrupted (in which case it should be dropped).
+bool armOsTraceRing(OsTraceRing *ring) {
+	auto wq = thisFiber()->associatedWorkQueue()->take();
+
+	uint64_t wantSignal = 1;
+	auto outcome = KernelFiber::asyncBlockCurrent(ring->view->copyTo(
+			offsetof(OsTraceRingHeader, wantSignal), &wantSignal, sizeof(uint64_t), wq));
+	if(!outcome)
+		return false;
+	// Pairs with the fence in userspace: either we see the producer's next record
+	// or the producer sees our request.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	return true;
+}
+
+// Copies all complete records from the ring into globalOsTraceRing.
+// Sets gotRecords if the ring was not empty.
+// Returns false if the ring is corrupted (in which case it should be dropped).
+bool drainOsTraceRing(OsTraceRing *ring, frg::vector<char, KernelAlloc> &buffer,
+		bool &gotRecords) {
+	auto wq = thisFiber()->associatedWorkQueue()->take();
+
+	OsTraceRingHeader header;
+	auto headerOutcome = KernelFiber::asyncBlockCurrent(ring->view->copyFrom(
+			0, &header, sizeof(OsTraceRingHeader), wq));
+	if(!headerOutcome)
+		return false;
+	// Pairs with the release store of the head in userspace.
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	auto head = header.head;
+
+	// Report events that did not fit into the ring such that gaps in the trace are visible.
+	if(header.dropped != ring->reportedDropped) {
+		managarm::ostrace::CounterItem<KernelAlloc> item{*kernelAlloc};
+		item.set_id(static_cast<uint64_t>(osTraceDroppedItem));
+		item.set_value(static_cast<int64_t>(header.dropped - ring->reportedDropped));
+
+		managarm::ostrace::EventRecord<KernelAlloc> record{*kernelAlloc};
+		record.set_id(static_cast<uint64_t>(osTraceKernelEvents.ringDropped));
+		record.add_ctrs(std::move(item));
+		emitOsTrace(std::move(record));
+		ring->reportedDropped = header.dropped;
+	}
+
+	auto pending = head - ring->tail;
+	if(!pending)
+		return true;
+	if(pending > ring->size)
+		return false;
+	gotRecords = true;
+
+	// Copy the pending bytes out of the ring, taking wrap-around into account.
+	buffer.resize(pending);
+	auto offset = ring->tail & (ring->size - 1);
+	auto firstChunk = frg::min(pending, ring->size - offset);
+	auto firstOutcome = KernelFiber::asyncBlockCurrent(ring->view->copyFrom(
+			osTraceRingDataOffset + offset, buffer.data(), firstChunk, wq));
+	if(!firstOutcome)
+		return false;
+	if(firstChunk < pending) {
+		auto secondOutcome = KernelFiber::asyncBlockCurrent(ring->view->copyFrom(
+				osTraceRingDataOffset, buffer.data() + firstChunk, pending - firstChunk, wq));
+		if(!secondOutcome)
+			return false;
+	}
+
+	// Userspace writes fully serialized records; we only validate their framing.
+	size_t progress = 0;
+	while(progress < pending) {
+		if(pending - progress < 8)
+			return false;
+		auto preamble = bragi::read_preamble(
+				frg::span<const char>{buffer.data() + progress, pending - progress});
+		if(preamble.error())
+			return false;
+		if(preamble.id() != bragi::message_id<managarm::ostrace::EventRecord>
+				&& preamble.id() != bragi::message_id<managarm::ostrace::SpanRecord>)
+			return false;
+		auto recordSize = 8 + size_t{preamble.tail_size()};
+		if(recordSize > pending - progress)
+			return false;
+
+		globalOsTraceRing->enqueue(buffer.data() + progress, recordSize);
+		progress += recordSize;
+	}
+
+	ring->tail = head;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	auto tailOutcome = KernelFiber::asyncBlockCurrent(ring->view->copyTo(
+			offsetof(OsTraceRingHeader, tail), &ring->tail, sizeof(uint64_t), wq));
+	if(!tailOutcome)
+		return false;
+	return true;
+}
+
+void runOsTraceRingDrain() {
+	KernelFiber::run([=] {
+		frg::vector<frg::tuple<smarter::shared_ptr<OsTraceRing>, bool>, KernelAlloc> rings{*kernelAlloc};
+		frg::vector<char, KernelAlloc> buffer{*kernelAlloc};
+
+		auto snapshotRings = [&] {
+			auto lock = frg::guard(&osTraceRingsMutex);
+			rings.clear();
+			for(auto &ring : *osTraceRings)
+				rings.push(frg::make_tuple(ring, ring->orphaned));
+		};
+
+		// Drains all rings in the current snapshot; returns true if any ring had records.
+		auto drainRings = [&] (bool arm) -> bool {
+			bool gotRecords = false;
+			for(auto &[ring, orphaned] : rings) {
+				if((arm && !armOsTraceRing(ring.get()))
+						|| !drainOsTraceRing(ring.get(), buffer, gotRecords)) {
+					infoLogger() << "thor: Dropping corrupted ostrace ring" << frg::endlog;
+					removeOsTraceRing(ring.get());
+				}else if(orphaned) {
+					// The owner cannot append more records; this was the final drain.
+					removeOsTraceRing(ring.get());
+				}
+			}
+			return gotRecords;
+		};
+
+		while(true) {
+			auto signals = osTraceRingSignals.load(std::memory_order_acquire);
+
+			// While producers are active, drain periodically to batch the copies.
+			snapshotRings();
+			if(drainRings(false)) {
+				KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(10'000'000));
+				continue;
+			}
+
+			// All rings are idle. Ask the producers to signal us, then check again for records
+			// that were appended before they saw the request.
+			snapshotRings();
+			if(drainRings(true))
+				continue;
+
+			KernelFiber::asyncBlockCurrent(osTraceRingEvent->async_wait_if([&] () -> bool {
+				return osTraceRingSignals.load(std::memory_order_acquire) == signals;
+			}));
+		}
+	});
+}
+
+} // anonymous namespace
+
 // --------------------------------------------------------------------------------------
 // mbus object handling.
 // --------------------------------------------------------------------------------------
@@ -102,8 +394,11 @@ struct OstraceBusObject : private KernelBusObject {
 private:
 	coroutine<frg::expected<Error>> handleRequest(LaneHandle boundLane) override {
 		auto [acceptError, lane] = co_await AcceptSender{boundLane};
-		if(acceptError == Error::endOfLane)
+		if(acceptError == Error::endOfLane) {
+			if(wantOsTrace)
+				orphanOsTraceRings(boundLane.getStream().get());
 			co_return Error::endOfLane;
+		}
 		if(acceptError != Error::success) {
 			assert(isRemoteIpcError(acceptError));
 			co_return Error::protocolViolation;
@@ -132,9 +427,19 @@ private:
 			if(!maybeReq)
 				co_return Error::protocolViolation;
 
+			auto &req = maybeReq.value();
+
 			managarm::ostrace::Response<KernelAlloc> resp(*kernelAlloc);
 			if(wantOsTrace) {
+				auto id = nextId.fetch_add(1, std::memory_order_relaxed);
+
+				managarm::ostrace::AnnounceContextRecord<KernelAlloc> record{*kernelAlloc};
+				record.set_id(id);
+				record.set_name(std::move(req.name()));
+				commitOsTrace(std::move(record));
+
 				resp.set_error(managarm::ostrace::Error::SUCCESS);
+				resp.set_id(id);
 			}else{
 				resp.set_error(managarm::ostrace::Error::OSTRACE_GLOBALLY_DISABLED);
 			}
@@ -231,6 +536,61 @@ private:
 				co_return Error::protocolViolation;
 			}
 		} break;
+		case bragi::message_id<managarm::ostrace::RegisterRingReq>: {
+			auto maybeReq = bragi::parse_head_tail<managarm::ostrace::RegisterRingReq>(
+					headSpan, tailSpan, *kernelAlloc);
+			if(!maybeReq)
+				co_return Error::protocolViolation;
+			auto &req = maybeReq.value();
+
+			auto [descError, descriptor] = co_await PullDescriptorSender{lane};
+			if(descError != Error::success) {
+				assert(isRemoteIpcError(descError));
+				co_return Error::protocolViolation;
+			}
+
+			managarm::ostrace::Response<KernelAlloc> resp(*kernelAlloc);
+			auto size = req.size();
+			if(!wantOsTrace) {
+				resp.set_error(managarm::ostrace::Error::OSTRACE_GLOBALLY_DISABLED);
+			}else if(!descriptor.is<MemoryViewDescriptor>()
+					|| size < kPageSize || size > osTraceRingMaxSize || (size & (size - 1))
+					|| descriptor.get<MemoryViewDescriptor>().memory->getLength()
+						< osTraceRingDataOffset + size) {
+				resp.set_error(managarm::ostrace::Error::ILLEGAL_ARGUMENTS);
+			}else{
+				registerOsTraceRing(descriptor.get<MemoryViewDescriptor>().memory, size,
+						boundLane.getStream().get());
+				resp.set_error(managarm::ostrace::Error::SUCCESS);
+			}
+
+			frg::string<KernelAlloc> ser(*kernelAlloc);
+			resp.SerializeToString(&ser);
+			frg::unique_memory<KernelAlloc> respBuffer{*kernelAlloc, ser.size()};
+			memcpy(respBuffer.data(), ser.data(), ser.size());
+			auto respError = co_await SendBufferSender{lane, std::move(respBuffer)};
+			if(respError != Error::success) {
+				assert(isRemoteIpcError(respError));
+				co_return Error::protocolViolation;
+			}
+		} break;
+		case bragi::message_id<managarm::ostrace::SignalRingReq>: {
+			if(wantOsTrace)
+				signalOsTraceRingDrain();
+
+			managarm::ostrace::Response<KernelAlloc> resp(*kernelAlloc);
+			resp.set_error(managarm::ostrace::Error::SUCCESS);
+
+			frg::string<KernelAlloc> ser(*kernelAlloc);
+			resp.SerializeToString(&ser);
+			frg::unique_memory<KernelAlloc> respBuffer{*kernelAlloc, ser.size()};
+			memcpy(respBuffer.data(), ser.data(), ser.size());
+			auto respError = co_await SendBufferSender{lane, std::move(respBuffer)};
+			if(respError != Error::success) {
+				assert(isRemoteIpcError(respError));
+				co_return Error::protocolViolation;
+			}
+		} break;
 		default:
 			managarm::ostrace::Response<KernelAlloc> resp(*kernelAlloc);
 			resp.set_error(managarm::ostrace::Error::ILLEGAL_REQUEST);
@@ -264,6 +624,8 @@ initgraph::Task initOsTraceMbus{&globalInitEngine, "generic.init-ostrace-sinks",
 			// Only dump to an I/O channel if ostrace is supported (otherwise, the ring buffer
 			// does not even exist).
 			if(wantOsTrace) {
+				runOsTraceRingDrain();
+
 				auto channel = solicitIoChannel("ostrace");
 				if(channel) {
 					infoLogger() << "thor: Connecting ostrace to I/O channel" << frg::endlog;
@@ -114,4 +114,16 @@ void PhysicalChunkAllocator::free(PhysicalAddr address, size_t size) {
 	assert(!"Physical page is not part of any region");
 }
 
+bool PhysicalChunkAllocator::isRam(PhysicalAddr address) {
+	// Regions are only added during boot, hence we do not need to lock here.
+	for(int i = 0; i < _numRegions; i++) {
+		if(address < _allRegions[i].physicalBase)
+			continue;
+		if(address - _allRegions[i].physicalBase >= _allRegions[i].regionSize)
+			continue;
+		return true;
+	}
+	return false;
+}
+
 } // namespace thor
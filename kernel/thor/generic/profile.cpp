@@ -2,6 +2,7 @@
 #include <thor-internal/arch/pmc-amd.hpp>
 #include <thor-internal/arch/pmc-intel.hpp>
 #endif
+#include <frg/string.hpp>
 #include <thor-internal/fiber.hpp>
 #include <thor-internal/kernel-io.hpp>
 #include <thor-internal/main.hpp>
@@ -10,10 +11,56 @@
 
 namespace thor {
 
+extern frg::manual_box<frg::string<KernelAlloc>> kernelCommandLine;
+
 bool wantKernelProfile = false;
+ProfileEvent profileEvent = ProfileEvent::cycles;
+// Yields roughly 5000 samples per second on a 1 GHz machine when counting cycles.
+uint64_t profilePeriod = 1'000'000'000 / 5000;
 
 namespace {
 	frg::manual_box<LogRingBuffer> globalProfileRing;
+	[[maybe_unused]] bool profileAvailable = false;
+
+	[[maybe_unused]] void parseProfileOptions() {
+		frg::string_view cmdline{kernelCommandLine->data(), kernelCommandLine->size()};
+
+		size_t i = 0;
+		while(i < cmdline.size()) {
+			while(i < cmdline.size() && cmdline[i] == ' ')
+				i++;
+			auto start = i;
+			while(i < cmdline.size() && cmdline[i] != ' ')
+				i++;
+			auto token = cmdline.sub_string(start, i - start);
+
+			if(token == "kernel-profile.event=cycles") {
+				profileEvent = ProfileEvent::cycles;
+			}else if(token == "kernel-profile.event=instructions") {
+				profileEvent = ProfileEvent::instructions;
+			}else if(token == "kernel-profile.event=cache-misses") {
+				profileEvent = ProfileEvent::cacheMisses;
+			}else if(token == "kernel-profile.event=branch-misses") {
+				profileEvent = ProfileEvent::branchMisses;
+			}else if(token.size() > 22 && token.sub_string(0, 22) == "kernel-profile.period=") {
+				uint64_t period = 0;
+				auto digits = token.sub_string(22, token.size() - 22);
+				for(size_t k = 0; k < digits.size(); ++k) {
+					if(digits[k] < '0' || digits[k] > '9') {
+						period = 0;
+						break;
+					}
+					period = period * 10 + (digits[k] - '0');
+				}
+				// The counters are at least 32 bits wide.
+				if(period && period < (UINT64_C(1) << 31)) {
+					profilePeriod = period;
+				}else{
+					infoLogger() << "thor: Ignoring invalid profiling period" << frg::endlog;
+				}
+			}
+		}
+	}
 
 	initgraph::Task initProfilingSinks{&globalInitEngine, "generic.init-profiling-sinks",
 		initgraph::Requires{getFibersAvailableStage(),
@@ -44,11 +91,22 @@ void initializeProfile() {
 		return;
 	}
 
+	parseProfileOptions();
+
 	void *profileMemory = kernelAlloc->allocate(1 << 20);
 	globalProfileRing.initialize(reinterpret_cast<uintptr_t>(profileMemory), 1 << 20);
+	profileAvailable = true;
+
+	initializeProfileOnThisCpu();
+#endif
+}
+
+void initializeProfileOnThisCpu() {
+#ifdef __x86_64__
+	if(!profileAvailable)
+		return;
 
 	// Dump the per-CPU profiling data to the global ring buffer.
-	// TODO: Start one such fiber per CPU.
 	KernelFiber::run([=] {
 		getCpuData()->localProfileRing = frg::construct<SingleContextRecordRing>(*kernelAlloc);
 
@@ -66,18 +124,18 @@ void initializeProfile() {
 
 		uint64_t deqPtr = 0;
 		while(true) {
-			char buffer[128];
+			ProfileSample sample;
 			auto [success, recordPtr, newPtr, size] = getCpuData()->localProfileRing->dequeueAt(
-					deqPtr, buffer, 128);
+					deqPtr, &sample, sizeof(ProfileSample));
 			deqPtr = newPtr;
 			if(!success) {
 				KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(1'000'000));
 				continue;
 			}
 			assert(size);
-			assert(size < 128);
+			assert(size == profileSampleSize(sample));
 
-			globalProfileRing->enqueue(buffer, size);
+			globalProfileRing->enqueue(&sample, size);
 		}
 	});
 #endif
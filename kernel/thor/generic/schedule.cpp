@@ -4,6 +4,7 @@
 #include <thor-internal/arch/cpu.hpp>
 #include <thor-internal/cpu-data.hpp>
 #include <thor-internal/debug.hpp>
+#include <thor-internal/ostrace.hpp>
 #include <thor-internal/schedule.hpp>
 #include <thor-internal/timer.hpp>
 
@@ -65,6 +66,7 @@ bool ScheduleEntity::scheduleBefore(const ScheduleEntity *a, const ScheduleEntit
 
 ScheduleEntity::ScheduleEntity(ScheduleType type)
 : type_{type}, state{ScheduleState::null}, priority{0}, _refClock{0}, _runTime{0},
+		_waitTime{0}, _numVoluntarySwitches{0}, _numInvoluntarySwitches{0}, _lastCpu{-1},
 		refProgress{0}, baseUnfairness{0} { }
 
 ScheduleEntity::~ScheduleEntity() {
@@ -150,7 +152,9 @@ void Scheduler::suspendCurrent() {
 	// Update the unfairness on suspend.
 	self->_updateEntityStats(entity);
 	entity->state = ScheduleState::attached;
+	entity->_numVoluntarySwitches++;
 
+	self->_endRunSpan();
 	self->_current = nullptr;
 }
 
@@ -197,6 +201,13 @@ void Scheduler::update() {
 	assert(haveTimer());
 	auto now = systemClockSource()->currentNanos();
 	auto deltaTime = now - _refClock;
+	if(_refClock) {
+		if(_current->type() == ScheduleType::idle) {
+			_idleTime += deltaTime;
+		}else{
+			_busyTime += deltaTime;
+		}
+	}
 	_refClock = now;
 	if(n)
 		_systemProgress += deltaTime * fixedInverse(n);
@@ -287,6 +298,12 @@ void Scheduler::forceReschedule() {
 	if(!preemptionIsArmed())
 		_updatePreemption();
 
+	if(osTraceInUse.load(std::memory_order_relaxed)
+			&& _current->type() == ScheduleType::regular) {
+		_runSpan = allocateOsTraceSpanId();
+		emitOsTraceSpan(osTraceKernelEvents.run, OsTraceSpanPhase::begin, _runSpan);
+	}
+
 	currentRunnable()->invoke();
 }
 
@@ -308,13 +325,22 @@ void Scheduler::_unschedule() {
 
 	if(_current->type() == ScheduleType::regular
 			|| _current->state == ScheduleState::active) {
+		_current->_numInvoluntarySwitches++;
 		_waitQueue.push(_current);
 		_numWaiting++;
 	}
 
+	_endRunSpan();
 	_current = nullptr;
 }
 
+void Scheduler::_endRunSpan() {
+	if(!_runSpan)
+		return;
+	emitOsTraceSpan(osTraceKernelEvents.run, OsTraceSpanPhase::end, _runSpan);
+	_runSpan = 0;
+}
+
 void Scheduler::_schedule() {
 	assert(!_current);
 	assert(!_scheduled);
@@ -334,6 +360,7 @@ void Scheduler::_schedule() {
 	assert(entity->state == ScheduleState::active);
 	_updateWaitingEntity(entity);
 	_updateEntityStats(entity);
+	entity->_lastCpu = _cpuContext->cpuIndex;
 
 	if(logScheduling) {
 //		infoLogger() << "System progress: " << (_systemProgress / 256) / (1000 * 1000)
@@ -412,8 +439,12 @@ void Scheduler::_updateEntityStats(ScheduleEntity *entity) {
 	assert(entity->state == ScheduleState::active
 			|| entity == _current);
 
-	if(entity == _current)
+	// Entities that are not current have been waiting since _refClock was last updated.
+	if(entity == _current) {
 		entity->_runTime += _refClock - entity->_refClock;
+	}else{
+		entity->_waitTime += _refClock - entity->_refClock;
+	}
 	entity->_refClock = _refClock;
 }
 
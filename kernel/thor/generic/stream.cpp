@@ -1,4 +1,5 @@
 
+#include <thor-internal/ostrace.hpp>
 #include <thor-internal/stream.hpp>
 
 namespace thor {
@@ -148,12 +149,21 @@ void Stream::Submitter::run() {
 		if(getStreamOrientation(u->tag()) < getStreamOrientation(v->tag()))
 			std::swap(u, v);
 
+		if(s->_osTraceFlow
+				&& (u->tag() == kTagSendKernelBuffer || u->tag() == kTagSendFlow)
+				&& (v->tag() == kTagRecvKernelBuffer || v->tag() == kTagRecvFlow))
+			emitOsTraceSpan(osTraceKernelEvents.sendRecv, OsTraceSpanPhase::instant,
+					allocateOsTraceSpanId(), s->_osTraceFlow);
+
 		// Do the main work here, after we released the lock.
 		if(u->tag() == kTagOffer && v->tag() == kTagAccept) {
 			// Initially there will be 3 references to the new stream:
 			// * One reference for the original shared pointer.
 			// * One reference for each of the two lanes.
 			auto branch = smarter::allocate_shared<Stream>(*kernelAlloc);
+			if(branch->_osTraceFlow)
+				emitOsTraceSpan(osTraceKernelEvents.offerAccept, OsTraceSpanPhase::instant,
+						allocateOsTraceSpanId(), branch->_osTraceFlow);
 			assert(branch.ctr()->check_count() == 1);
 			branch.ctr()->increment();
 			branch.ctr()->increment();
@@ -283,6 +293,9 @@ Stream::Stream()
 : _laneBroken{false, false}, _laneShutDown{false, false} {
 	_peerCount[0].store(1, std::memory_order_relaxed);
 	_peerCount[1].store(1, std::memory_order_relaxed);
+
+	if(osTraceInUse.load(std::memory_order_relaxed))
+		_osTraceFlow = allocateOsTraceSpanId();
 }
 
 Stream::~Stream() {
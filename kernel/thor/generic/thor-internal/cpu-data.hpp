@@ -43,6 +43,14 @@ struct CpuData : public PlatformCpuData {
 	std::atomic<ProfileMechanism> profileMechanism{};
 	// TODO: This should be a unique_ptr instead.
 	SingleContextRecordRing *localProfileRing = nullptr;
+
+	// Ring that infoLogger() writes to once the log drain is running (see debug.cpp).
+	SingleContextRecordRing *localLogRing = nullptr;
+	uint64_t localLogSequence = 0;
+	// Lower bound of the sequence number of the record that this CPU is writing
+	// (or UINT64_MAX if it is not writing a record).
+	std::atomic<uint64_t> localLogInFlight{UINT64_MAX};
+	bool inLogRing = false;
 };
 
 CpuData *getCpuData(size_t k);
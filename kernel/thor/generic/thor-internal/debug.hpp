@@ -32,6 +32,9 @@ void disableLogHandler(LogHandler *sink);
 size_t currentLogSequence();
 void copyLogMessage(size_t sequence, LogMessage &msg);
 
+// Number of infoLogger() records that were overwritten before they could be drained.
+uint64_t numDroppedLogRecords();
+
 // --------------------------------------------------------
 // Loggers.
 // --------------------------------------------------------
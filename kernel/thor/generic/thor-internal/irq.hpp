@@ -149,6 +149,8 @@ enum class IrqStrategy {
 // Represents a (not necessarily physical) "pin" of an interrupt controller.
 // This class handles the IRQ configuration and acknowledgement.
 struct IrqPin {
+	friend struct MsiPin;
+
 private:
 	static constexpr int maskedForService = 1;
 	static constexpr int maskedWhileBuffered = 2;
@@ -167,12 +169,29 @@ public:
 
 	IrqPin &operator= (const IrqPin &) = delete;
 
+	// Maximal number of CPUs for which raiseCount() is tracked.
+	// IRQs on CPUs beyond this limit are accounted to the last CPU.
+	static constexpr int maxStatCpus = 64;
+
 	const frg::string<KernelAlloc> &name() {
 		return _name;
 	}
 
 	void configure(IrqConfiguration cfg);
 
+	// Number of times that this IRQ was raised on the given CPU.
+	uint64_t raiseCount(int cpu) {
+		assert(cpu >= 0 && cpu < maxStatCpus);
+		return __atomic_load_n(&_raisesPerCpu[cpu], __ATOMIC_RELAXED);
+	}
+
+	// Returns the CPU that this IRQ is routed to, or -1 if the routing is fixed.
+	virtual int affinity();
+
+	// Routes this IRQ to the given CPU.
+	// Returns Error::noHardwareSupport if the routing is fixed.
+	virtual Error setAffinity(int cpu);
+
 	// This function is called from IrqSlot::raise().
 	void raise();
 
@@ -226,6 +245,8 @@ private:
 	// Relative to currentNanos().
 	uint64_t _raiseClock;
 
+	uint64_t _raisesPerCpu[maxStatCpus] = {};
+
 	bool _warnedAfterPending;
 
 	// Unstall logic to unmask an IRQ periodically after NACK.
@@ -243,6 +264,18 @@ private:
 	> _sinkList;
 };
 
+struct MsiPin;
+
+// Writes the message of an MSI to the device that raises it.
+struct MsiProgrammer {
+	// The index is the one that was passed to MsiPin::attachProgrammer()
+	// (e.g., the entry of the MSI-X table).
+	virtual void programMsi(MsiPin *msi, size_t index) = 0;
+
+protected:
+	~MsiProgrammer() = default;
+};
+
 struct MsiPin : IrqPin {
 	MsiPin(frg::string<KernelAlloc> name)
 	: IrqPin{std::move(name)} { }
@@ -250,10 +283,34 @@ struct MsiPin : IrqPin {
 	virtual uint64_t getMessageAddress() = 0;
 	virtual uint32_t getMessageData() = 0;
 
+	// Sets up the MSI at the device. The programmer is invoked again whenever
+	// the message changes (e.g., if the MSI is routed to another CPU).
+	void attachProgrammer(MsiProgrammer *programmer, size_t index);
+
+	Error setAffinity(int cpu) override;
+
 protected:
 	~MsiPin() = default;
+
+	// Changes the message such that the MSI targets the given CPU.
+	// Called with the pin's lock held; the device is reprogrammed afterwards.
+	virtual Error routeTo(int cpu);
+
+private:
+	// Protected by the pin's _mutex.
+	MsiProgrammer *_programmer = nullptr;
+	size_t _programmerIndex = 0;
 };
 
+// Returns the n-th IrqPin in the system, or nullptr if there are fewer pins.
+// Pins are numbered in order of their creation. IrqPins are never destructed,
+// so the pointer remains valid.
+IrqPin *getIrqPinByIndex(size_t n);
+
+// Returns the CPU that the first MSI of the next device is routed to.
+// Consecutive devices start at different CPUs.
+int nextMsiAffinity();
+
 // ----------------------------------------------------------------------------
 
 // This class implements the user-visible part of IRQ handling.
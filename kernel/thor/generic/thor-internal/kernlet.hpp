@@ -2,7 +2,10 @@
 
 #include <frg/vector.hpp>
 #include <frg/variant.hpp>
+#include <thor-internal/coroutine.hpp>
 #include <thor-internal/event.hpp>
+#include <thor-internal/memory-view.hpp>
+#include <thor-internal/types.hpp>
 
 namespace thor {
 
@@ -20,6 +23,35 @@ struct KernletParameterDefn {
 	size_t offset;
 };
 
+// Memory that kernlets access from IRQ context.
+// The memory is locked and its pages are resolved up front.
+struct PinnedMemory {
+	PinnedMemory(smarter::shared_ptr<MemoryView> memory);
+
+	PinnedMemory(const PinnedMemory &) = delete;
+
+	~PinnedMemory();
+
+	PinnedMemory &operator= (const PinnedMemory &) = delete;
+
+	// Locks and populates the memory.
+	coroutine<frg::expected<Error>> pin(smarter::shared_ptr<WorkQueue> wq);
+
+	// Maps the memory into kernel space. Requires pin(); at most 64 KiB can be mapped.
+	Error map();
+
+	char *window() {
+		return _window;
+	}
+
+private:
+	smarter::shared_ptr<MemoryView> _memory;
+	size_t _length;
+	bool _locked = false;
+	frg::vector<frg::tuple<PhysicalAddr, CachingMode>, KernelAlloc> _pages;
+	char *_window = nullptr;
+};
+
 struct KernletObject {
 	// This is only required so that BoundKernlet can access the _entry.
 	// TODO: Add a getIrqAutomationEntry() function instead.
@@ -49,7 +81,7 @@ struct BoundKernlet {
 	}
 
 	void setupOffsetBinding(size_t index, uint32_t offset);
-	void setupMemoryViewBinding(size_t index, void *p);
+	void setupMemoryViewBinding(size_t index, smarter::shared_ptr<PinnedMemory> memory);
 	void setupBitsetEventBinding(size_t index, smarter::shared_ptr<BitsetEvent> event);
 
 	int invokeIrqAutomation();
@@ -57,6 +89,7 @@ struct BoundKernlet {
 private:
 	smarter::shared_ptr<KernletObject> _object;
 	char *_instance;
+	frg::vector<smarter::shared_ptr<PinnedMemory>, KernelAlloc> _memories;
 };
 
 void initializeKernletCtl();
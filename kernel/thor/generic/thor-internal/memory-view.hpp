@@ -790,6 +790,42 @@ private:
 	CachingMode _cacheMode;
 };
 
+// Memory that is backed in place by pages that were loaded by the boot loader
+// (e.g., files of the initrd). If the length is not page-aligned, the last page
+// is backed by a copy that is zero-filled beyond the end of the data.
+struct ModuleMemory final : MemoryView, GlobalFutexSpace {
+	ModuleMemory(PhysicalAddr base, size_t length);
+	ModuleMemory(const ModuleMemory &) = delete;
+	~ModuleMemory();
+
+	ModuleMemory &operator= (const ModuleMemory &) = delete;
+
+	size_t getLength() override;
+	frg::expected<Error, frg::tuple<smarter::shared_ptr<GlobalFutexSpace>, uintptr_t>>
+			resolveGlobalFutex(uintptr_t offset) override;
+	Error lockRange(uintptr_t offset, size_t size) override;
+	void unlockRange(uintptr_t offset, size_t size) override;
+	frg::tuple<PhysicalAddr, CachingMode> peekRange(uintptr_t offset) override;
+	coroutine<frg::expected<Error, PhysicalRange>>
+			fetchRange(uintptr_t offset, FetchFlags flags,
+			smarter::shared_ptr<WorkQueue> wq) override;
+	void markDirty(uintptr_t offset, size_t size) override;
+
+	coroutine<frg::expected<Error, PhysicalAddr>> takeGlobalFutex(uintptr_t offset,
+			smarter::shared_ptr<WorkQueue> wq) override;
+	void retireGlobalFutex(uintptr_t offset) override;
+
+public:
+	// Contract: set by the code that constructs this object.
+	smarter::borrowed_ptr<ModuleMemory> selfPtr;
+private:
+	PhysicalAddr _base;
+	// Length of the part that is backed in place (page-aligned).
+	size_t _inPlaceLength;
+	// Copy of the last page (or PhysicalAddr(-1) if the length is page-aligned).
+	PhysicalAddr _tail = PhysicalAddr(-1);
+};
+
 struct AllocatedMemory final : MemoryView, GlobalFutexSpace {
 	AllocatedMemory(size_t length, int addressBits = 64,
 			size_t chunkSize = kPageSize, size_t chunkAlign = kPageSize);
@@ -12,12 +12,37 @@ extern bool wantOsTrace;
 extern std::atomic<bool> osTraceInUse;
 
 enum class OsTraceEventId : uint64_t { };
+enum class OsTraceItemId : uint64_t { };
+
+enum class OsTraceSpanPhase : uint32_t {
+	begin = 1,
+	end = 2,
+	instant = 3
+};
+
+// Events that are emitted by the kernel itself.
+struct OsTraceKernelEvents {
+	OsTraceEventId run; // A thread runs on a CPU.
+	OsTraceEventId submitAsync; // helSubmitAsync().
+	OsTraceEventId offerAccept; // An offer is matched with an accept.
+	OsTraceEventId sendRecv; // A send is matched with a receive.
+	OsTraceEventId ringDropped; // Userspace dropped events because its ring was full.
+};
+
+extern OsTraceKernelEvents osTraceKernelEvents;
 
 LogRingBuffer *getGlobalOsTraceRing();
 
 OsTraceEventId announceOsTraceEvent(frg::string_view name);
+OsTraceItemId announceOsTraceItem(frg::string_view name);
 void emitOsTrace(managarm::ostrace::EventRecord<KernelAlloc> record);
 
+uint64_t allocateOsTraceSpanId();
+// Emits a span record on the track of the current CPU.
+// Records with the same (non-zero) flow ID are linked by the trace viewer.
+void emitOsTraceSpan(OsTraceEventId id, OsTraceSpanPhase phase, uint64_t span,
+		uint64_t flow = 0);
+
 initgraph::Stage *getOsTraceAvailableStage();
 
 struct OsTraceEvent {
@@ -38,4 +63,30 @@ private:
 	managarm::ostrace::EventRecord<KernelAlloc> rec_{*kernelAlloc};
 };
 
+// Emits a span that lasts for the lifetime of this object.
+struct OsTraceSpan {
+	OsTraceSpan(OsTraceEventId id)
+	: id_{id} {
+		live_ = osTraceInUse.load(std::memory_order_relaxed);
+		if(live_) {
+			span_ = allocateOsTraceSpanId();
+			emitOsTraceSpan(id_, OsTraceSpanPhase::begin, span_);
+		}
+	}
+
+	OsTraceSpan(const OsTraceSpan &) = delete;
+
+	~OsTraceSpan() {
+		if(live_)
+			emitOsTraceSpan(id_, OsTraceSpanPhase::end, span_);
+	}
+
+	OsTraceSpan &operator= (const OsTraceSpan &) = delete;
+
+private:
+	OsTraceEventId id_;
+	bool live_;
+	uint64_t span_ = 0;
+};
+
 } // namespace thor
@@ -36,6 +36,10 @@ public:
 	PhysicalAddr allocate(size_t size, int addressBits = 64);
 	void free(PhysicalAddr address, size_t size);
 
+	// Returns true if the address belongs to RAM that is managed by this allocator.
+	// Does not take any locks, such that it can be called from NMI context.
+	bool isRam(PhysicalAddr address);
+
 	size_t numTotalPages() {
 		return _totalPages.load(std::memory_order_relaxed);
 	}
@@ -1,12 +1,44 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <thor-internal/ring-buffer.hpp>
 
 namespace thor {
 
 extern bool wantKernelProfile;
 
+enum class ProfileEvent {
+	cycles,
+	instructions,
+	cacheMisses,
+	branchMisses
+};
+
+// Configured via kernel-profile.event= and kernel-profile.period= on the command line.
+extern ProfileEvent profileEvent;
+extern uint64_t profilePeriod;
+
+inline constexpr size_t maxProfileFrames = 32;
+
+// Format of the records in the kernel-profile ring.
+// Only the first numFrames entries of frames are written to the ring.
+struct ProfileSample {
+	uint32_t numFrames; // The first frame is the interrupted IP.
+	uint32_t cpu;
+	uint64_t space; // Root of the page tables; identifies the address space.
+	uint64_t thread; // Credentials ID of the interrupted user thread (zero for kernel code).
+	uint64_t frames[maxProfileFrames];
+};
+
+inline size_t profileSampleSize(const ProfileSample &sample) {
+	return offsetof(ProfileSample, frames) + sample.numFrames * sizeof(uint64_t);
+}
+
 void initializeProfile();
+// Starts sampling on the current CPU. Called on each CPU after it is brought up.
+void initializeProfileOnThisCpu();
 LogRingBuffer *getGlobalProfileRing();
 
 } // namespace thor
@@ -57,6 +57,24 @@ public:
 		return _runTime;
 	}
 
+	// Time spent runnable but waiting for a CPU.
+	uint64_t waitTime() {
+		return _waitTime;
+	}
+
+	uint64_t numVoluntarySwitches() {
+		return _numVoluntarySwitches;
+	}
+
+	uint64_t numInvoluntarySwitches() {
+		return _numInvoluntarySwitches;
+	}
+
+	// Index of the CPU that this entity was last scheduled on (or -1).
+	int lastCpu() {
+		return _lastCpu;
+	}
+
 private:
 	const ScheduleType type_;
 
@@ -71,6 +89,10 @@ private:
 
 	uint64_t _refClock;
 	uint64_t _runTime;
+	uint64_t _waitTime;
+	uint64_t _numVoluntarySwitches;
+	uint64_t _numInvoluntarySwitches;
+	int _lastCpu;
 
 	// Scheduler::_systemProgress value at some slice T.
 	// Invariant: This entity's state did not change since T.
@@ -122,10 +144,21 @@ public:
 
 	ScheduleEntity *currentRunnable();
 
+	// Time that this CPU spent running the idle task and other entities, respectively.
+	uint64_t idleTime() {
+		return _idleTime;
+	}
+
+	uint64_t busyTime() {
+		return _busyTime;
+	}
+
 private:
 	void _unschedule();
 	void _schedule();
 
+	void _endRunSpan();
+
 private:
 	void _updatePreemption();
 
@@ -158,6 +191,13 @@ private:
 	// Start of the current timeslice.
 	uint64_t _sliceClock;
 
+	// Per-CPU accounting; see idleTime() and busyTime().
+	uint64_t _idleTime = 0;
+	uint64_t _busyTime = 0;
+
+	// ostrace span of the current entity (or zero).
+	uint64_t _runSpan = 0;
+
 	// This variables stores sum{t = 0, ... T} w(t)/n(t).
 	// This allows us to easily track u_p(T) for all waiting processes.
 	Progress _systemProgress = 0;
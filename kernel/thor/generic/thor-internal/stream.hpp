@@ -241,6 +241,10 @@ private:
 	// Submissions are disallowed and return lane-shutdown errors.
 	// Submissions to the paired lane return end-of-lane errors.
 	bool _laneShutDown[2];
+
+	// ostrace flow ID that links all transmissions on this stream (or zero).
+	// Immutable after construction.
+	uint64_t _osTraceFlow = 0;
 };
 
 frg::tuple<LaneHandle, LaneHandle> createStream();
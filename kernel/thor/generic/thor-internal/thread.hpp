@@ -11,6 +11,8 @@
 #include <thor-internal/universe.hpp>
 #include <thor-internal/work-queue.hpp>
 
+struct HelSignalTable;
+
 namespace thor {
 
 enum Interrupt {
@@ -186,6 +188,13 @@ public:
 	static void interruptOther(smarter::borrowed_ptr<Thread> thread);
 	static Error resumeOther(smarter::borrowed_ptr<Thread> thread);
 
+	// Signal delivery on behalf of user space (see helSetSignalTable()).
+	static constexpr size_t userSignalInfoSize = 128;
+	static void setSignalTable(smarter::borrowed_ptr<Thread> thread, HelSignalTable *table);
+	static Error raiseUserSignal(smarter::borrowed_ptr<Thread> thread, int number,
+			const void *info, size_t infoSize);
+	static int reclaimUserSignal(smarter::borrowed_ptr<Thread> thread, void *info);
+
 	// These signals let the thread change its RunState.
 	// Do not confuse them with POSIX signals!
 	// TODO: Interrupt signals should be queued.
@@ -274,6 +283,7 @@ public:
 private:
 	void _uninvoke();
 	void _kill();
+	bool _deliverUserSignal(SyscallImageAccessor image);
 
 public:
 	frg::vector<uint8_t, KernelAlloc> getAffinityMask() {
@@ -340,6 +350,14 @@ private:
 	bool _pendingKill;
 	Signal _pendingSignal;
 
+	// Signal table installed by helSetSignalTable() (or nullptr).
+	HelSignalTable *_signalTable = nullptr;
+	// Signal that was handed to us by helRaiseSignal() (or zero) and its info.
+	// _userSignal is only written under _mutex but polled without it on syscall exit.
+	std::atomic<int> _userSignal{0};
+	bool _deliveringUserSignal = false;
+	char _userSignalInfo[userSignalInfoSize];
+
 	// Number of references that keep this thread running.
 	// The thread is killed when this counter reaches zero.
 	std::atomic<int> _runCount;
@@ -7,6 +7,11 @@
 #include <thor-internal/cpu-data.hpp>
 #include <thor-internal/stream.hpp>
 #include <thor-internal/thread.hpp>
+#include <hel.h>
+
+// Defined in hel.cpp.
+bool readUserMemory(void *kernelPtr, const void *userPtr, size_t size);
+bool writeUserMemory(void *userPtr, const void *kernelPtr, size_t size);
 
 namespace thor {
 
@@ -245,9 +250,19 @@ void Thread::interruptCurrent(Interrupt interrupt, SyscallImageAccessor image) {
 
 void Thread::raiseSignals(SyscallImageAccessor image) {
 	auto this_thread = getCurrentThread();
+
+	// Signals from helRaiseSignal() are delivered before taking the lock since building
+	// the signal frame accesses user memory. If that is not possible, we interrupt the thread.
+	bool needsObserver = false;
+	if(this_thread->_userSignal.load(std::memory_order_relaxed))
+		needsObserver = !this_thread->_deliverUserSignal(image);
+
 	StatelessIrqLock irq_lock;
 	auto lock = frg::guard(&this_thread->_mutex);
 
+	if(needsObserver)
+		this_thread->_pendingSignal = kSigInterrupt;
+
 	if(logTransitions)
 		infoLogger() << "thor: raiseSignals() in " << (void *)this_thread.get()
 				<< frg::endlog;
@@ -356,6 +371,157 @@ void Thread::interruptOther(smarter::borrowed_ptr<Thread> thread) {
 	thread->_pendingSignal = kSigInterrupt;
 }
 
+void Thread::setSignalTable(smarter::borrowed_ptr<Thread> thread, HelSignalTable *table) {
+	HelSignalTable *former;
+	{
+		auto irq_lock = frg::guard(&irqMutex());
+		auto lock = frg::guard(&thread->_mutex);
+
+		former = std::exchange(thread->_signalTable, table);
+	}
+
+	if(former)
+		frg::destruct(*kernelAlloc, former);
+}
+
+Error Thread::raiseUserSignal(smarter::borrowed_ptr<Thread> thread, int number,
+		const void *info, size_t infoSize) {
+	assert(number > 0 && number <= 64);
+	assert(infoSize <= userSignalInfoSize);
+
+	auto irq_lock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&thread->_mutex);
+
+	if(!thread->_signalTable
+			|| !(thread->_signalTable->deliverable & (UINT64_C(1) << (number - 1))))
+		return Error::illegalState;
+	if(thread->_userSignal.load(std::memory_order_relaxed) || thread->_deliveringUserSignal)
+		return Error::bufferTooSmall;
+
+	memset(thread->_userSignalInfo, 0, userSignalInfoSize);
+	memcpy(thread->_userSignalInfo, info, infoSize);
+	thread->_userSignal.store(number, std::memory_order_relaxed);
+
+	// TODO: Like interruptOther(), this only takes effect on the next syscall exit.
+	return Error::success;
+}
+
+int Thread::reclaimUserSignal(smarter::borrowed_ptr<Thread> thread, void *info) {
+	auto irq_lock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&thread->_mutex);
+
+	auto number = thread->_userSignal.load(std::memory_order_relaxed);
+	if(!number)
+		return 0;
+	memcpy(info, thread->_userSignalInfo, userSignalInfoSize);
+	thread->_userSignal.store(0, std::memory_order_relaxed);
+	return number;
+}
+
+// Returns false if the signal needs to be handled by the observer of the thread.
+bool Thread::_deliverUserSignal(SyscallImageAccessor image) {
+#ifdef __x86_64__
+	int number;
+	uintptr_t flagAddress;
+	uintptr_t altStackSp;
+	size_t altStackSize;
+	HelSignalFrameLayout layout;
+	HelSignalAction action;
+	char info[userSignalInfoSize];
+	{
+		StatelessIrqLock irq_lock;
+		auto lock = frg::guard(&_mutex);
+
+		number = _userSignal.load(std::memory_order_relaxed);
+		if(!number)
+			return true;
+		if(!_signalTable || !(_signalTable->deliverable & (UINT64_C(1) << (number - 1))))
+			return false;
+
+		flagAddress = _signalTable->flagAddress;
+		altStackSp = _signalTable->altStackSp;
+		altStackSize = _signalTable->altStackSize;
+		layout = _signalTable->layout;
+		action = _signalTable->actions[number - 1];
+		memcpy(info, _userSignalInfo, userSignalInfoSize);
+
+		// raiseUserSignal() does not accept new signals until we are done.
+		_userSignal.store(0, std::memory_order_relaxed);
+		_deliveringUserSignal = true;
+	}
+
+	auto finish = [&] (bool delivered) {
+		StatelessIrqLock irq_lock;
+		auto lock = frg::guard(&_mutex);
+
+		// Hand the signal back such that helReclaimSignal() can retrieve it.
+		if(!delivered) {
+			memcpy(_userSignalInfo, info, userSignalInfoSize);
+			_userSignal.store(number, std::memory_order_relaxed);
+		}
+		_deliveringUserSignal = false;
+		return delivered;
+	};
+
+	// User space does not want to receive signals right now.
+	unsigned int flag;
+	if(!readUserMemory(&flag, reinterpret_cast<const void *>(flagAddress), sizeof(unsigned int))
+			|| flag)
+		return finish(false);
+
+	uintptr_t sp = *image.sp();
+	if((action.flags & kHelSignalOnStack) && altStackSize
+			&& !(sp >= altStackSp && sp <= altStackSp + altStackSize))
+		sp = altStackSp + altStackSize;
+
+	auto simdSize = Executor::determineSimdSize();
+	uintptr_t frame = ((sp - layout.redZoneSize - layout.frameSize - simdSize)
+			& ~uintptr_t(15)) - layout.stackMisalign;
+
+	// The SIMD state is dumped to a 64-byte aligned position and then moved
+	// behind the frame, such that both can be written in a single operation.
+	auto simdOffset = (layout.frameSize + 63) & ~size_t(63);
+	auto bufferSize = simdOffset + simdSize + 64;
+	auto buffer = reinterpret_cast<char *>(kernelAlloc->allocate(bufferSize));
+	auto base = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(buffer) + 63)
+			& ~uintptr_t(63));
+	memset(base, 0, simdOffset + simdSize);
+
+	dumpSimdState(base + simdOffset);
+	memmove(base + layout.frameSize, base + simdOffset, simdSize);
+
+	uintptr_t regs[19];
+	saveSignalRegisters(regs, image);
+	uintptr_t simdPointer = frame + layout.frameSize;
+	memcpy(base + layout.returnOffset, &action.restorerIp, sizeof(uintptr_t));
+	memcpy(base + layout.regsOffset, regs, sizeof(regs));
+	memcpy(base + layout.maskOffset, &action.mask, sizeof(uint64_t));
+	memcpy(base + layout.simdPointerOffset, &simdPointer, sizeof(uintptr_t));
+	if(action.flags & kHelSignalInfo)
+		memcpy(base + layout.infoOffset, info,
+				frg::min(userSignalInfoSize, layout.frameSize - layout.infoOffset));
+
+	bool stored = writeUserMemory(reinterpret_cast<void *>(frame), base,
+			layout.frameSize + simdSize);
+	kernelAlloc->deallocate(buffer, bufferSize);
+	// Let the observer decide what to do with an unusable stack.
+	if(!stored)
+		return finish(false);
+
+	// Enter the handler when returning from the syscall.
+	*image.error() = number;
+	*image.out0() = frame + layout.infoOffset;
+	*image.out1() = frame + layout.contextOffset;
+	*image.in2() = 0; // Number of vector arguments in rax.
+	*image.ip() = action.handlerIp;
+	*image.sp() = frame;
+	return finish(true);
+#else
+	(void)image;
+	return false;
+#endif
+}
+
 Error Thread::resumeOther(smarter::borrowed_ptr<Thread> thread) {
 	auto irq_lock = frg::guard(&irqMutex());
 	auto lock = frg::guard(&thread->_mutex);
@@ -387,6 +553,9 @@ Thread::Thread(smarter::shared_ptr<Universe> universe,
 Thread::~Thread() {
 	assert(_runState == kRunTerminated);
 	assert(_observeQueue.empty());
+
+	if(_signalTable)
+		frg::destruct(*kernelAlloc, _signalTable);
 }
 
 // This function has to initiate the thread's shutdown.
@@ -7,6 +7,7 @@
 #include <thor-internal/kernel_heap.hpp>
 #include <thor-internal/main.hpp>
 #include <thor-internal/address-space.hpp>
+#include <thor-internal/cpu-data.hpp>
 #include <thor-internal/framebuffer/boot-screen.hpp>
 #include <thor-internal/pci/pci.hpp>
 #include <thor-internal/stream.hpp>
@@ -361,7 +362,11 @@ coroutine<frg::expected<Error>> PciEntity::handleRequest(LaneHandle lane) {
 			co_return frg::success;
 		}
 
-		// Allocate the MSI.
+		// Allocate the MSI. Spread the MSIs of each device across all CPUs, such that
+		// the queues of multi-queue devices are not serviced by a single CPU.
+		if(msiAffinityBase < 0)
+			msiAffinityBase = nextMsiAffinity();
+		auto cpu = static_cast<int>((msiAffinityBase + req->index()) % getCpuCount());
 		auto interrupt = parentBus->msiController->allocateMsiPin(
 				frg::string<KernelAlloc>{*kernelAlloc, "pci-msi."}
 				+ frg::to_allocated_string(*kernelAlloc, bus)
@@ -370,7 +375,7 @@ coroutine<frg::expected<Error>> PciEntity::handleRequest(LaneHandle lane) {
 				+ frg::string<KernelAlloc>{*kernelAlloc, "-"}
 				+ frg::to_allocated_string(*kernelAlloc, function)
 				+ frg::string<KernelAlloc>{*kernelAlloc, "."}
-				+ frg::to_allocated_string(*kernelAlloc, req->index()));
+				+ frg::to_allocated_string(*kernelAlloc, req->index()), cpu);
 		if(!interrupt) {
 			infoLogger() << "thor: Could not allocate interrupt vector for MSI" << frg::endlog;
 
@@ -393,7 +398,7 @@ coroutine<frg::expected<Error>> PciEntity::handleRequest(LaneHandle lane) {
 				+ frg::to_allocated_string(*kernelAlloc, req->index()));
 		IrqPin::attachSink(interrupt, object.get());
 
-		static_cast<PciDevice *>(this)->setupMsi(interrupt, req->index());
+		interrupt->attachProgrammer(static_cast<PciDevice *>(this), req->index());
 
 		managarm::hw::SvrResponse<KernelAlloc> resp{*kernelAlloc};
 		resp.set_error(managarm::hw::Errors::SUCCESS);
@@ -735,8 +740,10 @@ void PciDevice::setupMsi(MsiPin *msi, size_t index) {
 	auto io = parentBus->io;
 
 	if (msixIndex >= 0) {
-		// Setup the MSI-X table.
+		// Setup the MSI-X table. Mask the vector while the message is inconsistent.
 		auto space = arch::mem_space{msixMapping}.subspace(index * 16);
+		space.store(msixVectorControl,
+				space.load(msixVectorControl) | uint32_t{1});
 		space.store(msixMessageAddress, msi->getMessageAddress());
 		space.store(msixMessageData, msi->getMessageData());
 		space.store(msixVectorControl,
@@ -752,6 +759,21 @@ void PciDevice::setupMsi(MsiPin *msi, size_t index) {
 				slot, function, offset + 2);
 
 		bool is64Capable = msgControl & (1 << 7);
+		bool maskCapable = msgControl & (1 << 8);
+		auto maskOffset = offset + (is64Capable ? 16 : 12);
+
+		// Keep the device from signalling a half-written message. Without per-vector
+		// masking, we have to disable MSI instead (edges in this window are lost).
+		uint32_t maskBits = 0;
+		if (maskCapable) {
+			maskBits = io->readConfigWord(parentBus,
+					slot, function, maskOffset);
+			io->writeConfigWord(parentBus,
+					slot, function, maskOffset, maskBits | 1);
+		} else if (msgControl & 0x0001) {
+			io->writeConfigHalf(parentBus,
+					slot, function, offset + 2, msgControl & ~uint16_t{1});
+		}
 
 		io->writeConfigWord(parentBus,
 				slot, function, offset + 4, msi->getMessageAddress() & 0xFFFFFFFF);
@@ -769,13 +791,16 @@ void PciDevice::setupMsi(MsiPin *msi, size_t index) {
 				slot, function, offset + 8, msi->getMessageData());
 		}
 
+		if (maskCapable)
+			io->writeConfigWord(parentBus,
+					slot, function, maskOffset, maskBits);
+
 		if (msiEnabled) {
 			// Enable MSI
 			msgControl |= 0x0001;
-
-			io->writeConfigHalf(parentBus,
-					slot, function, offset + 2, msgControl);
 		}
+		io->writeConfigHalf(parentBus,
+				slot, function, offset + 2, msgControl);
 
 		msiInstalled = true;
 	}
@@ -303,6 +303,8 @@ struct PciEntity : protected KernelBusObject {
 	int msiIndex = -1;
 	bool msiEnabled = false;
 	bool msiInstalled = false;
+	// CPU that MSI 0 is routed to; MSI n goes to the n-th CPU after it.
+	int msiAffinityBase = -1;
 
 private:
 	coroutine<frg::expected<Error>> handleRequest(LaneHandle lane) override;
@@ -338,7 +340,7 @@ struct PciBridge final : PciEntity {
 	async::oneshot_event mbusPublished;
 };
 
-struct PciDevice final : PciEntity {
+struct PciDevice final : PciEntity, MsiProgrammer {
 	PciDevice(PciBus *parentBus_, uint32_t seg, uint32_t bus, uint32_t slot, uint32_t function,
 			uint16_t vendor, uint16_t device_id, uint8_t revision,
 			uint8_t class_code, uint8_t sub_class, uint8_t interface, uint16_t subsystem_vendor, uint16_t subsystem_device)
@@ -361,6 +363,10 @@ struct PciDevice final : PciEntity {
 	void setupMsi(MsiPin *msi, size_t index);
 	void enableMsi();
 
+	void programMsi(MsiPin *msi, size_t index) override {
+		setupMsi(msi, index);
+	}
+
 	uint16_t subsystemVendor;
 	uint16_t subsystemDevice;
 
@@ -489,7 +495,8 @@ protected:
 };
 
 struct PciMsiController {
-	virtual MsiPin *allocateMsiPin(frg::string<KernelAlloc> name) = 0;
+	// Allocates an MSI that is initially routed to the given CPU.
+	virtual MsiPin *allocateMsiPin(frg::string<KernelAlloc> name, int cpu) = 0;
 
 protected:
 	~PciMsiController() = default;
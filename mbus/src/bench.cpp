@@ -0,0 +1,167 @@
+// Measures boot-time enumeration cost of the mbus filter index using synthetic
+// entities and observers that resemble the ones created by our drivers.
+// For comparison, it also runs the linear matching that mbus used before the index.
+
+#include <assert.h>
+#include <stdint.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "index.hpp"
+
+namespace {
+
+constexpr int numEntities = 4000;
+constexpr int numObservers = 128;
+
+std::string hex(unsigned int value, int digits) {
+	static const char *chars = "0123456789abcdef";
+	std::string s(digits, '0');
+	for(int i = digits - 1; i >= 0; --i) {
+		s[i] = chars[value & 0xF];
+		value >>= 4;
+	}
+	return s;
+}
+
+std::vector<Properties> makeEntities(std::mt19937 &rng) {
+	std::vector<Properties> entities;
+	for(int i = 0; i < numEntities; ++i) {
+		Properties properties;
+		switch(rng() % 4) {
+		case 0:
+			properties["unix.subsystem"] = "pci";
+			properties["pci-vendor"] = hex(rng() % 64, 4);
+			properties["pci-device"] = hex(rng() % 256, 4);
+			properties["pci-class"] = hex(rng() % 16, 2);
+			properties["pci-subclass"] = hex(rng() % 8, 2);
+			break;
+		case 1:
+			properties["unix.subsystem"] = "usb";
+			properties["usb.type"] = (rng() % 2) ? "device" : "interface";
+			properties["usb.vendor"] = hex(rng() % 64, 4);
+			break;
+		case 2:
+			properties["unix.subsystem"] = "block";
+			properties["class"] = "partition";
+			properties["drvcore.mbus-parent"] = std::to_string(rng() % numEntities);
+			break;
+		default:
+			properties["class"] = (rng() % 2) ? "framebuffer" : "pm-interface";
+			properties["unix.devname"] = "dev" + std::to_string(i);
+		}
+		entities.push_back(std::move(properties));
+	}
+	return entities;
+}
+
+std::vector<AnyFilter> makeFilters(std::mt19937 &rng) {
+	std::vector<AnyFilter> filters;
+	for(int i = 0; i < numObservers; ++i) {
+		switch(rng() % 4) {
+		case 0:
+			filters.push_back(Conjunction{{
+				EqualsFilter{"pci-vendor", hex(rng() % 64, 4)},
+				EqualsFilter{"pci-device", hex(rng() % 256, 4)}
+			}});
+			break;
+		case 1:
+			filters.push_back(Conjunction{{
+				EqualsFilter{"pci-class", hex(rng() % 16, 2)},
+				EqualsFilter{"pci-subclass", hex(rng() % 8, 2)}
+			}});
+			break;
+		case 2:
+			filters.push_back(Conjunction{{
+				EqualsFilter{"unix.subsystem", "block"},
+				EqualsFilter{"drvcore.mbus-parent", std::to_string(rng() % numEntities)}
+			}});
+			break;
+		default:
+			filters.push_back(EqualsFilter{"class", (rng() % 2) ? "framebuffer" : "pm-interface"});
+		}
+	}
+	return filters;
+}
+
+// Observers are linked first, then all entities are attached (i.e., drivers wait
+// for their devices), followed by a second wave of observers (i.e., late watchers).
+// Returns the number of (entity, observer) matches.
+uint64_t runIndexed(const std::vector<Properties> &entities,
+		const std::vector<AnyFilter> &filters) {
+	FilterIndex index;
+	uint64_t matches = 0;
+	size_t half = filters.size() / 2;
+
+	for(size_t j = 0; j < half; ++j)
+		index.addObserver(j, filters[j]);
+
+	for(size_t i = 0; i < entities.size(); ++i) {
+		index.addEntity(i, entities[i]);
+		index.forEachObserverCandidate(entities[i], [&] (int64_t j) {
+			if(matchesFilter(entities[i], filters[j]))
+				++matches;
+		});
+	}
+
+	for(size_t j = half; j < filters.size(); ++j) {
+		index.addObserver(j, filters[j]);
+		index.forEachEntityCandidate(filters[j], [&] (int64_t i) {
+			if(matchesFilter(entities[i], filters[j]))
+				++matches;
+		});
+	}
+	return matches;
+}
+
+uint64_t runLinear(const std::vector<Properties> &entities,
+		const std::vector<AnyFilter> &filters) {
+	uint64_t matches = 0;
+	size_t half = filters.size() / 2;
+
+	for(size_t i = 0; i < entities.size(); ++i) {
+		for(size_t j = 0; j < half; ++j) {
+			if(matchesFilter(entities[i], filters[j]))
+				++matches;
+		}
+	}
+
+	for(size_t j = half; j < filters.size(); ++j) {
+		for(size_t i = 0; i < entities.size(); ++i) {
+			if(matchesFilter(entities[i], filters[j]))
+				++matches;
+		}
+	}
+	return matches;
+}
+
+template<typename F>
+uint64_t measure(const char *name, F f) {
+	auto start = std::chrono::steady_clock::now();
+	auto matches = f();
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start);
+	std::cout << "mbus-bench: " << name << ": " << elapsed.count() << " us ("
+			<< matches << " matches)" << std::endl;
+	return matches;
+}
+
+} // anonymous namespace
+
+int main() {
+	std::mt19937 rng{42};
+	auto entities = makeEntities(rng);
+	auto filters = makeFilters(rng);
+
+	std::cout << "mbus-bench: " << numEntities << " entities, "
+			<< numObservers << " observers" << std::endl;
+	auto indexed = measure("indexed", [&] { return runIndexed(entities, filters); });
+	auto linear = measure("linear", [&] { return runLinear(entities, filters); });
+	if(indexed != linear) {
+		std::cout << "mbus-bench: Index reports a different number of matches" << std::endl;
+		return 1;
+	}
+}
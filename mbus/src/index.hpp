@@ -0,0 +1,206 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using Properties = std::unordered_map<std::string, std::string>;
+
+// --------------------------------------------------------
+// Filters
+// --------------------------------------------------------
+
+struct EqualsFilter;
+struct Conjunction;
+
+using AnyFilter = std::variant<
+	EqualsFilter,
+	Conjunction
+>;
+
+struct EqualsFilter {
+	explicit EqualsFilter(std::string property, std::string value)
+	: _property(std::move(property)), _value(std::move(value)) { }
+
+	const std::string &getProperty() const { return _property; }
+	const std::string &getValue() const { return _value; }
+
+private:
+	std::string _property;
+	std::string _value;
+};
+
+struct Conjunction {
+	explicit Conjunction(std::vector<AnyFilter> operands)
+	: _operands(std::move(operands)) { }
+
+	const std::vector<AnyFilter> &getOperands() const {
+		return _operands;
+	}
+
+private:
+	std::vector<AnyFilter> _operands;
+};
+
+inline bool matchesFilter(const Properties &properties, const AnyFilter &filter) {
+	if(auto real = std::get_if<EqualsFilter>(&filter); real) {
+		auto it = properties.find(real->getProperty());
+		if(it == properties.end())
+			return false;
+		return it->second == real->getValue();
+	}else if(auto real = std::get_if<Conjunction>(&filter); real) {
+		auto &operands = real->getOperands();
+		return std::all_of(operands.begin(), operands.end(), [&] (const AnyFilter &operand) {
+			return matchesFilter(properties, operand);
+		});
+	}else{
+		throw std::runtime_error("Unexpected filter");
+	}
+}
+
+// --------------------------------------------------------
+// FilterIndex
+// --------------------------------------------------------
+
+// Inverted index from (property, value) pairs to entities and observers.
+//
+// Since filters are (nested) conjunctions of EqualsFilters, every entity that matches
+// a filter carries each of its terms. Each observer is indexed by a single term;
+// only observers indexed by one of an entity's properties (and observers with empty
+// filters) can match that entity. Conversely, only the entities indexed by one term
+// of a filter can match the filter. Callers still need to check the full filter.
+//
+// Observers are keyed by their most selective term. Since observers are usually
+// linked before the entities that they are interested in exist, that choice is
+// revisited whenever the number of entities carrying a term doubles.
+struct FilterIndex {
+	using Key = std::pair<std::string, std::string>;
+
+	struct KeyHash {
+		size_t operator() (const Key &key) const {
+			auto h = std::hash<std::string>{}(key.first);
+			return h ^ (std::hash<std::string>{}(key.second) + 0x9e3779b9 + (h << 6) + (h >> 2));
+		}
+	};
+
+	void addEntity(int64_t id, const Properties &properties) {
+		_allEntities.push_back(id);
+		for(auto &kv : properties) {
+			Key key{kv.first, kv.second};
+			auto &ids = _entities[key];
+			ids.push_back(id);
+			if(ids.size() >= rekeyThreshold && !(ids.size() & (ids.size() - 1)))
+				_rekeyObservers(key);
+		}
+	}
+
+	void addObserver(int64_t id, const AnyFilter &filter) {
+		auto key = _chooseKey(filter);
+		if(key) {
+			_observers[std::move(*key)].push_back(id);
+			_observerFilters.insert({id, filter});
+		}else{
+			_unkeyedObservers.push_back(id);
+		}
+	}
+
+	// Calls f(id) for each observer that might match an entity with the given properties.
+	template<typename F>
+	void forEachObserverCandidate(const Properties &properties, F f) const {
+		for(auto id : _unkeyedObservers)
+			f(id);
+		if(_observers.empty())
+			return;
+		for(auto &kv : properties) {
+			auto it = _observers.find(Key{kv.first, kv.second});
+			if(it == _observers.end())
+				continue;
+			for(auto id : it->second)
+				f(id);
+		}
+	}
+
+	// Calls f(id) for each entity that might match the filter, in order of insertion.
+	template<typename F>
+	void forEachEntityCandidate(const AnyFilter &filter, F f) const {
+		auto key = _chooseKey(filter);
+		if(!key) {
+			for(auto id : _allEntities)
+				f(id);
+			return;
+		}
+
+		auto it = _entities.find(*key);
+		if(it == _entities.end())
+			return;
+		for(auto id : it->second)
+			f(id);
+	}
+
+private:
+	// Terms that are carried by fewer entities are not worth re-keying for.
+	static constexpr size_t rekeyThreshold = 8;
+
+	// Moves the observers that are keyed by the given term to their (now) most selective term.
+	void _rekeyObservers(const Key &key) {
+		auto it = _observers.find(key);
+		if(it == _observers.end())
+			return;
+		auto ids = std::move(it->second);
+		_observers.erase(it);
+
+		for(auto id : ids) {
+			auto newKey = _chooseKey(_observerFilters.at(id));
+			assert(newKey);
+			_observers[std::move(*newKey)].push_back(id);
+		}
+	}
+
+	static void _collectTerms(const AnyFilter &filter, std::vector<const EqualsFilter *> &terms) {
+		if(auto real = std::get_if<EqualsFilter>(&filter); real) {
+			terms.push_back(real);
+		}else if(auto real = std::get_if<Conjunction>(&filter); real) {
+			for(auto &operand : real->getOperands())
+				_collectTerms(operand, terms);
+		}else{
+			throw std::runtime_error("Unexpected filter");
+		}
+	}
+
+	// Returns the most selective term of the filter, i.e., the one that is carried
+	// by the fewest entities, or std::nullopt if the filter matches everything.
+	std::optional<Key> _chooseKey(const AnyFilter &filter) const {
+		std::vector<const EqualsFilter *> terms;
+		_collectTerms(filter, terms);
+		if(terms.empty())
+			return std::nullopt;
+
+		const EqualsFilter *best = nullptr;
+		size_t bestCount = 0;
+		for(auto term : terms) {
+			auto it = _entities.find(Key{term->getProperty(), term->getValue()});
+			size_t count = (it != _entities.end()) ? it->second.size() : 0;
+			if(!best || count < bestCount) {
+				best = term;
+				bestCount = count;
+			}
+			if(!count)
+				break;
+		}
+		return Key{best->getProperty(), best->getValue()};
+	}
+
+	std::vector<int64_t> _allEntities;
+	std::unordered_map<Key, std::vector<int64_t>, KeyHash> _entities;
+	std::unordered_map<Key, std::vector<int64_t>, KeyHash> _observers;
+	std::unordered_map<int64_t, AnyFilter> _observerFilters;
+	std::vector<int64_t> _unkeyedObservers;
+};
@@ -9,13 +9,12 @@
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
-#include <queue>
-#include <variant>
 #include <vector>
 
 #include <async/result.hpp>
 #include <helix/ipc.hpp>
 
+#include "index.hpp"
 #include "mbus.pb.h"
 
 // --------------------------------------------------------
@@ -23,7 +22,6 @@
 // --------------------------------------------------------
 
 struct Group;
-struct Observer;
 
 struct Entity {
 	explicit Entity(int64_t id, std::weak_ptr<Group> parent,
@@ -63,15 +61,8 @@ struct Group final : Entity {
 		return _children;
 	}
 
-	void linkObserver(std::shared_ptr<Observer> observer) {
-		_observers.insert(std::move(observer));
-	}
-
-	void processAttach(std::shared_ptr<Entity> entity);
-
 private:
 	std::unordered_set<std::shared_ptr<Entity>> _children;
-	std::unordered_set<std::shared_ptr<Observer>> _observers;
 };
 
 struct Object final : Entity {
@@ -116,88 +107,75 @@ async::result<helix::UniqueDescriptor> Object::bind() {
 	co_return pull_desc.descriptor();
 }
 
-struct EqualsFilter;
-struct Conjunction;
-
-using AnyFilter = std::variant<
-	EqualsFilter,
-	Conjunction
->;
-
-struct EqualsFilter {
-	explicit EqualsFilter(std::string property, std::string value)
-	: _property(std::move(property)), _value(std::move(value)) { }
-
-	std::string getProperty() const { return _property; }
-	std::string getValue() const { return _value; }
-
-private:
-	std::string _property;
-	std::string _value;
-};
-
-struct Conjunction {
-	explicit Conjunction(std::vector<AnyFilter> operands)
-	: _operands(std::move(operands)) { }
+struct Observer {
+	explicit Observer(int64_t id, std::shared_ptr<Group> group,
+			AnyFilter filter, helix::UniqueLane lane)
+	: _id(id), _group(std::move(group)), _filter(std::move(filter)),
+			_lane(std::move(lane)) { }
 
-	const std::vector<AnyFilter> &getOperands() const {
-		return _operands;
+	int64_t getId() const {
+		return _id;
 	}
 
-private:
-	std::vector<AnyFilter> _operands;
-};
+	const AnyFilter &getFilter() const {
+		return _filter;
+	}
 
-struct Observer {
-	explicit Observer(AnyFilter filter, helix::UniqueLane lane)
-	: _filter(std::move(filter)), _lane(std::move(lane)) { }
+	// Observers see all entities within the subtree of the group they are linked to.
+	bool observes(const Entity *entity) const;
 
-	async::detached traverse(std::shared_ptr<Entity> root);
+	async::detached traverse();
 
 	async::detached onAttach(std::shared_ptr<Entity> entity);
 
 private:
+	int64_t _id;
+	std::shared_ptr<Group> _group;
 	AnyFilter _filter;
 	helix::UniqueLane _lane;
 };
 
-static bool matchesFilter(const Entity *entity, const AnyFilter &filter) {
-	if(auto real = std::get_if<EqualsFilter>(&filter); real) {
-		auto &properties = entity->getProperties();
-		auto it = properties.find(real->getProperty());
-		if(it == properties.end())
-			return false;
-		return it->second == real->getValue();
-	}else if(auto real = std::get_if<Conjunction>(&filter); real) {
-		auto &operands = real->getOperands();
-		return std::all_of(operands.begin(), operands.end(), [&] (const AnyFilter &operand) {
-			return matchesFilter(entity, operand);
-		});
-	}else{
-		throw std::runtime_error("Unexpected filter");
-	}
+std::unordered_map<int64_t, std::shared_ptr<Entity>> allEntities;
+std::unordered_map<int64_t, std::shared_ptr<Observer>> allObservers;
+FilterIndex filterIndex;
+int64_t nextEntityId = 1;
+int64_t nextObserverId = 1;
+
+std::shared_ptr<Entity> getEntityById(int64_t id) {
+	auto it = allEntities.find(id);
+	if(it == allEntities.end())
+		return nullptr;
+	return it->second;
 }
-	
-void Group::processAttach(std::shared_ptr<Entity> entity) {
-	for(auto &observer_ptr : _observers)
-		observer_ptr->onAttach(entity);
+
+void registerEntity(std::shared_ptr<Entity> entity) {
+	filterIndex.addEntity(entity->getId(), entity->getProperties());
+	allEntities.insert({ entity->getId(), std::move(entity) });
 }
 
-async::detached Observer::traverse(std::shared_ptr<Entity> root) {
-	std::queue<std::shared_ptr<Entity>> entities;
-	entities.push(root);
-	while(!entities.empty()) {
-		std::shared_ptr<Entity> entity = entities.front();
-		entities.pop();
-		if(const Entity &er = *entity; typeid(er) == typeid(Group)) {
-			auto group = std::static_pointer_cast<Group>(entity);
-			for(auto child : group->getChildren())
-				entities.push(std::move(child));
-		}
+bool Observer::observes(const Entity *entity) const {
+	if(entity == _group.get())
+		return true;
+	for(auto parent = entity->getParent(); parent; parent = parent->getParent()) {
+		if(parent == _group)
+			return true;
+	}
+	return false;
+}
 
-		if(!matchesFilter(entity.get(), _filter)) 
-			continue;
-		
+async::detached Observer::traverse() {
+	// Collect all matches upfront; entities that are created while we send
+	// are reported through onAttach() instead.
+	std::vector<std::shared_ptr<Entity>> matches;
+	filterIndex.forEachEntityCandidate(_filter, [&] (int64_t id) {
+		auto entity = getEntityById(id);
+		assert(entity);
+		if(!observes(entity.get()) || !matchesFilter(entity->getProperties(), _filter))
+			return;
+		matches.push_back(std::move(entity));
+	});
+
+	for(auto &entity : matches) {
 		helix::SendBuffer send_req;
 
 		managarm::mbus::SvrRequest req;
@@ -218,7 +196,7 @@ async::detached Observer::traverse(std::shared_ptr<Entity> root) {
 }
 
 async::detached Observer::onAttach(std::shared_ptr<Entity> entity) {
-	if(!matchesFilter(entity.get(), _filter)) 
+	if(!observes(entity.get()) || !matchesFilter(entity->getProperties(), _filter))
 		co_return;
 	
 	helix::SendBuffer send_req;
@@ -239,16 +217,6 @@ async::detached Observer::onAttach(std::shared_ptr<Entity> entity) {
 	HEL_CHECK(send_req.error());
 }
 
-std::unordered_map<int64_t, std::shared_ptr<Entity>> allEntities;
-int64_t nextEntityId = 1;
-
-std::shared_ptr<Entity> getEntityById(int64_t id) {
-	auto it = allEntities.find(id);
-	if(it == allEntities.end())
-		return nullptr;
-	return it->second;
-}
-
 static AnyFilter decodeFilter(const managarm::mbus::AnyFilter &proto_filter) {
 	if(proto_filter.type_case() == managarm::mbus::AnyFilter::kEqualsFilter) {
 		return EqualsFilter(proto_filter.equals_filter().path(),
@@ -352,16 +320,17 @@ async::detached serve(helix::UniqueLane lane) {
 			std::tie(local_lane, remote_lane) = helix::createStream();
 			auto child = std::make_shared<Object>(nextEntityId++,
 					group, std::move(properties), std::move(local_lane));
-			allEntities.insert({ child->getId(), child });
+			registerEntity(child);
 
 			group->addChild(child);
 
-			// issue 'attach' events for all observers linked to parents of the entity.
-			std::shared_ptr<Group> current = group;
-			while(current) {
-				current->processAttach(child);
-				current = current->getParent();
-			}
+			// issue 'attach' events for all observers that might match the entity;
+			// onAttach() checks the observed group and the full filter.
+			filterIndex.forEachObserverCandidate(child->getProperties(), [&] (int64_t id) {
+				auto it = allObservers.find(id);
+				assert(it != allObservers.end());
+				it->second->onAttach(child);
+			});
 
 			managarm::mbus::SvrResponse resp;
 			resp.set_error(managarm::mbus::Error::SUCCESS);
@@ -397,11 +366,12 @@ async::detached serve(helix::UniqueLane lane) {
 
 			helix::UniqueLane local_lane, remote_lane;
 			std::tie(local_lane, remote_lane) = helix::createStream();
-			auto observer = std::make_shared<Observer>(decodeFilter(req.filter()),
-					std::move(local_lane));
-			group->linkObserver(observer);
+			auto observer = std::make_shared<Observer>(nextObserverId++, group,
+					decodeFilter(req.filter()), std::move(local_lane));
+			allObservers.insert({ observer->getId(), observer });
+			filterIndex.addObserver(observer->getId(), observer->getFilter());
 
-			observer->traverse(parent);
+			observer->traverse();
 
 			managarm::mbus::SvrResponse resp;
 			resp.set_error(managarm::mbus::Error::SUCCESS);
@@ -461,7 +431,7 @@ int main() {
 
 	auto root = std::make_shared<Group>(nextEntityId++, std::weak_ptr<Group>(),
 			std::unordered_map<std::string, std::string>());
-	allEntities.insert({ root->getId(), root });
+	registerEntity(root);
 
 	unsigned long xpipe;
 	if(peekauxval(AT_XPIPE, &xpipe))
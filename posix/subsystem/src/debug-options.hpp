@@ -5,6 +5,7 @@ namespace {
 	constexpr bool logPaths = false;
 	constexpr bool logSignals = false;
 	constexpr bool logCleanup = false;
+	constexpr bool logExecCache = false;
 
 	constexpr bool debugFaults = true;
 }
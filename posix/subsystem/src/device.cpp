@@ -141,51 +141,35 @@ private:
 	async::result<frg::expected<Error, PollWaitResult>> pollWait(Process *,
 			uint64_t sequence, int mask,
 			async::cancellation_token cancellation = {}) override {
+		// If the status page already reports edges after sequence, there is no need to block.
+		if(_statusPage) {
+			auto result = _statusPage.readEdges(sequence);
+			if(result && std::get<0>(*result) > sequence && (std::get<1>(*result) & mask))
+				co_return *result;
+		}
+
 		auto resultOrError = co_await _file.pollWait(sequence, mask, cancellation);
-		assert(resultOrError);
+		if(!resultOrError)
+			co_return fromFsError(resultOrError.error());
 		co_return resultOrError.value();
 	}
 
 	async::result<frg::expected<Error, PollStatusResult>> pollStatus(Process *) override {
-		auto pollOverIpc = [this] ()
-				-> async::result<frg::expected<Error, PollStatusResult>> {
-			auto resultOrError = co_await _file.pollStatus();
-			assert(resultOrError);
-			co_return resultOrError.value();
-		};
-
-		if(!_statusMapping) {
+		if(!_statusPage) {
 			std::cout << "posix: No file status page. DeviceFile::pollStatus()"
 					" falls back to slower IPC request" << std::endl;
-			co_return co_await pollOverIpc();
-		}
-
-		auto page = reinterpret_cast<protocols::fs::StatusPage *>(_statusMapping.get());
-
-		// Start the seqlock read.
-		auto seqlock = __atomic_load_n(&page->seqlock, __ATOMIC_ACQUIRE);
-		if(seqlock & 1) {
-			if(logStatusSeqlock)
-				std::cout << "posix: Status page update in progess;"
-						" falling back to IPC request." << std::endl;
-			co_return co_await pollOverIpc();
+		}else if(auto status = _statusPage.read(); status) {
+			// TODO: Return a full edge mask or edges since sequence zero.
+			co_return *status;
+		}else if(logStatusSeqlock) {
+			std::cout << "posix: Status page update in progess;"
+					" falling back to IPC request." << std::endl;
 		}
 
-		// Perform the actual loads.
-		auto sequence = __atomic_load_n(&page->sequence, __ATOMIC_RELAXED);
-		auto status = __atomic_load_n(&page->status, __ATOMIC_RELAXED);
-
-		// Finish the seqlock read.
-		__atomic_thread_fence(__ATOMIC_ACQUIRE);
-		if(__atomic_load_n(&page->seqlock, __ATOMIC_RELAXED) != seqlock) {
-			if(logStatusSeqlock)
-				std::cout << "posix: Stale data from status page;"
-						" falling back to IPC request." << std::endl;
-			co_return co_await pollOverIpc();
-		}
-
-		// TODO: Return a full edge mask or edges since sequence zero.
-		co_return PollStatusResult{sequence, status};
+		auto resultOrError = co_await _file.pollStatus();
+		if(!resultOrError)
+			co_return fromFsError(resultOrError.error());
+		co_return resultOrError.value();
 	}
 
 	FutureMaybe<helix::UniqueDescriptor> accessMemory() override {
@@ -200,10 +184,10 @@ private:
 public:
 	DeviceFile(helix::UniqueLane control, helix::UniqueLane lane,
 			std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link,
-			helix::Mapping status_mapping)
+			protocols::fs::StatusPageView status_page)
 	: File{StructName::get("devicefile"), std::move(mount), std::move(link)},
 			_control{std::move(control)}, _file{std::move(lane)},
-			_statusMapping{std::move(status_mapping)} { }
+			_statusPage{std::move(status_page)} { }
 
 	~DeviceFile() {
 		// It's not necessary to do any cleanup here.
@@ -217,7 +201,7 @@ public:
 private:
 	helix::UniqueLane _control;
 	protocols::fs::File _file;
-	helix::Mapping _statusMapping;
+	protocols::fs::StatusPageView _statusPage;
 };
 
 } // anonymous namespace
@@ -264,14 +248,14 @@ openExternalDevice(helix::BorrowedLane lane,
 	recv_resp.reset();
 	assert(resp.error() == managarm::fs::Errors::SUCCESS);
 
-	helix::Mapping status_mapping;
+	protocols::fs::StatusPageView status_page;
 	if(resp.caps() & managarm::fs::FileCaps::FC_STATUS_PAGE) {
 		assert(!pull_page.error());
-		status_mapping = helix::Mapping{pull_page.descriptor(), 0, 0x1000};
+		status_page = protocols::fs::StatusPageView{pull_page.descriptor()};
 	}
 
 	auto file = smarter::make_shared<DeviceFile>(helix::UniqueLane{},
-			pull_pt.descriptor(), std::move(mount), std::move(link), std::move(status_mapping));
+			pull_pt.descriptor(), std::move(mount), std::move(link), std::move(status_page));
 	file->setupWeakFile(file);
 	helix::UniqueDescriptor file_fd_lane;
 
@@ -339,9 +323,12 @@ async::result<void> serveServerLane(helix::UniqueDescriptor lane) {
 			auto file = File::constructHandle(std::move(dev_file));
 
 			auto fd = process->fileContext()->attachFile(file);
-
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+			if(fd) {
+				resp.set_error(managarm::posix::Errors::SUCCESS);
+				resp.set_fd(fd.value());
+			}else{
+				resp.set_error(managarm::posix::Errors::TOO_MANY_FILES);
+			}
 
 			auto ser = resp.SerializeAsString();
 			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
@@ -89,8 +89,13 @@ private:
 
 		auto resultOrError = std::move(*item->pollOutcome);
 
+		// Stop watching the item if pollWait() fails. Errors other than fileClosed
+		// are reported by files of other servers (e.g., if they reject the sequence).
 		if(!resultOrError) {
-			assert(resultOrError.error() == Error::fileClosed);
+			if(resultOrError.error() != Error::fileClosed)
+				std::cout << "posix.epoll \e[1;34m" << self->structName() << "\e[0m"
+						<< ": pollWait() of item \e[1;34m" << item->file->structName()
+						<< "\e[0m failed with " << resultOrError.error() << std::endl;
 			item->state &= ~statePolling;
 			return;
 		}
@@ -101,7 +106,7 @@ private:
 		auto result = resultOrError.value();
 		if(std::get<1>(result) & (item->eventMask | EPOLLERR | EPOLLHUP)) {
 			if(logEpoll)
-				std::cout << "posix.epoll \e[1;34m" << item->epoll->structName() << "\e[0m"
+				std::cout << "posix.epoll \e[1;34m" << self->structName() << "\e[0m"
 						<< ": Item \e[1;34m" << item->file->structName()
 						<< "\e[0m becomes pending" << std::endl;
 
@@ -120,7 +125,7 @@ private:
 			// Here, we assume that the lambda does not execute on the current stack.
 			// TODO: Use some callback queueing mechanism to ensure this.
 			if(logEpoll)
-				std::cout << "posix.epoll \e[1;34m" << item->epoll->structName() << "\e[0m"
+				std::cout << "posix.epoll \e[1;34m" << self->structName() << "\e[0m"
 						<< ": Item \e[1;34m" << item->file->structName()
 						<< "\e[0m still not pending after pollWait()."
 						<< " Mask is " << item->eventMask << ", while edges are "
@@ -253,13 +258,12 @@ public:
 							<< "\e[1;34m" << item->file->structName() << "\e[0m" << std::endl;
 				auto result_or_error = co_await item->file->pollStatus(item->process);
 
-				// Discard closed items.
+				// Discard closed items and items whose pollStatus() fails.
 				if(!result_or_error) {
-					assert(result_or_error.error() == Error::fileClosed);
-					if(logEpoll)
+					if(logEpoll || result_or_error.error() != Error::fileClosed)
 						std::cout << "posix.epoll \e[1;34m" << structName() << "\e[0m: Discarding"
-								" closed item \e[1;34m" << item->file->structName() << "\e[0m"
-								<< std::endl;
+								" item \e[1;34m" << item->file->structName() << "\e[0m: "
+								<< result_or_error.error() << std::endl;
 					item->state &= ~statePending;
 					continue;
 				}
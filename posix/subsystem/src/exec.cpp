@@ -4,24 +4,57 @@
 #include <string.h>
 #include <sys/auxv.h>
 #include <iostream>
+#include <list>
+#include <unordered_map>
 
 #include "common.hpp"
 #include "vfs.hpp"
 #include "exec.hpp"
+#include "debug-options.hpp"
 #include <fs.bragi.hpp>
 
 constexpr size_t kPageSize = 0x1000;
 
-// This struct is parsed before knowing the type of executable (PIE vs. non-PIE)
-// and also before knowing the ELF's base address.
-struct ImagePreamble {
+// A PT_LOAD segment of a cached image. Addresses are relative to the image base.
+struct CachedSegment {
+	uintptr_t mapOffset;
+	uintptr_t fileOffset;
+	size_t mapLength;
+	uint32_t nativeFlags;
+
+	// For writable segments, this is a pre-initialized memory object
+	// (file contents + zeroed remainder) that is mapped copy-on-write.
+	// Read-only segments are mapped from the file's memory instead.
+	helix::UniqueDescriptor initialImage;
+};
+
+// Parsed ELF image, independent of the base address.
+// Images are cached such that exec() does not need to re-read and re-parse the file.
+struct CachedImage {
+	// Used to validate cache entries. The key is only compared, never dereferenced.
+	FsNode *cacheKey = nullptr;
+	std::weak_ptr<FsNode> node;
+	uint64_t generation = 0;
+
+	// Right now we treat every ET_DYN object as PIE and unconditionally apply
+	// a non-zero base address.
 	bool isPie = false;
+
+	helix::UniqueDescriptor fileMemory;
+
+	uintptr_t entry = 0;
+	bool hasPhdr = false;
+	uintptr_t phdrOffset = 0;
+	size_t phdrEntrySize = 0;
+	size_t phdrCount = 0;
+
+	std::vector<CachedSegment> segments;
 };
 
 // This struct contains the image meta data with correct base address applied.
 struct ImageInfo {
 	ImageInfo()
-	: entryIp(nullptr) { }
+	: entryIp(nullptr), phdrPtr(nullptr) { }
 
 	void *entryIp;
 	void *phdrPtr;
@@ -29,46 +62,28 @@ struct ImageInfo {
 	size_t phdrCount;
 };
 
-async::result<frg::expected<Error, ImagePreamble>>
-parseElfPreamble(SharedFilePtr file) {
-	ImagePreamble preamble;
+namespace {
 
-	// Read the elf file header and verify the signature.
-	Elf64_Ehdr ehdr;
-	FRG_CO_TRY(co_await file->seek(0, VfsSeek::absolute));
-	FRG_CO_TRY(co_await file->readExactly(nullptr, &ehdr, sizeof(Elf64_Ehdr)));
-
-	if(!(ehdr.e_ident[0] == 0x7F
-			&& ehdr.e_ident[1] == 'E'
-			&& ehdr.e_ident[2] == 'L'
-			&& ehdr.e_ident[3] == 'F'))
-		co_return Error::badExecutable;
-	if(ehdr.e_type != ET_EXEC && ehdr.e_type != ET_DYN)
-		co_return Error::badExecutable;
+constexpr size_t imageCacheCapacity = 32;
 
-	// Right now we treat every ET_DYN object as PIE and unconditionally apply
-	// a non-zero base address.
-	if(ehdr.e_type == ET_DYN)
-		preamble.isPie = true;
+// Least recently used images are at the back.
+std::list<std::shared_ptr<CachedImage>> imageCacheLru;
+std::unordered_map<FsNode *, std::list<std::shared_ptr<CachedImage>>::iterator> imageCacheMap;
 
-	co_return preamble;
-}
+} // anonymous namespace
 
-async::result<frg::expected<Error, ImageInfo>>
-loadElfImage(SharedFilePtr file, VmContext *vmContext, uintptr_t base) {
-	assert(!(base & (kPageSize - 1))); // Callers need to ensure this.
-	ImageInfo info;
+async::result<frg::expected<Error, std::shared_ptr<CachedImage>>>
+parseElfImage(SharedFilePtr file) {
+	auto image = std::make_shared<CachedImage>();
 
 	// Get a handle to the file's memory.
-	auto fileMemory = co_await file->accessMemory();
+	image->fileMemory = co_await file->accessMemory();
 
 	// Read the elf file header and verify the signature.
 	Elf64_Ehdr ehdr;
 	FRG_CO_TRY(co_await file->seek(0, VfsSeek::absolute));
 	FRG_CO_TRY(co_await file->readExactly(nullptr, &ehdr, sizeof(Elf64_Ehdr)));
 
-	// Verify the ELF file again, since loadElfPreamble() is not necessarily called
-	// on every object that we load.
 	if(!(ehdr.e_ident[0] == 0x7F
 			&& ehdr.e_ident[1] == 'E'
 			&& ehdr.e_ident[2] == 'L'
@@ -77,11 +92,14 @@ loadElfImage(SharedFilePtr file, VmContext *vmContext, uintptr_t base) {
 	if(ehdr.e_type != ET_EXEC && ehdr.e_type != ET_DYN)
 		co_return Error::badExecutable;
 
-	info.entryIp = (char *)base + ehdr.e_entry;
-	info.phdrEntrySize = ehdr.e_phentsize;
-	info.phdrCount = ehdr.e_phnum;
+	if(ehdr.e_type == ET_DYN)
+		image->isPie = true;
+
+	image->entry = ehdr.e_entry;
+	image->phdrEntrySize = ehdr.e_phentsize;
+	image->phdrCount = ehdr.e_phnum;
 
-	// Read the elf program headers and load them into the address space.
+	// Read the elf program headers.
 	std::vector<char> phdrBuffer;
 	phdrBuffer.resize(ehdr.e_phnum * ehdr.e_phentsize);
 	FRG_CO_TRY(co_await file->seek(ehdr.e_phoff, VfsSeek::absolute));
@@ -98,9 +116,10 @@ loadElfImage(SharedFilePtr file, VmContext *vmContext, uintptr_t base) {
 			bool properlyAligned = phdr->p_offset % phdr->p_align == phdr->p_vaddr % phdr->p_align;
 
 			size_t misalign = phdr->p_vaddr & (kPageSize - 1);
-			uintptr_t mapAddress = base + phdr->p_vaddr - misalign;
-			uintptr_t fileOffset = phdr->p_offset - misalign;
-			size_t mapLength = (phdr->p_memsz + misalign + kPageSize - 1) & ~(kPageSize - 1);
+			CachedSegment segment;
+			segment.mapOffset = phdr->p_vaddr - misalign;
+			segment.fileOffset = phdr->p_offset - misalign;
+			segment.mapLength = (phdr->p_memsz + misalign + kPageSize - 1) & ~(kPageSize - 1);
 
 			if(!properlyAligned) {
 				std::cout << "posix: ELF file with differently misaligned p_offset and p_vaddr."
@@ -110,55 +129,51 @@ loadElfImage(SharedFilePtr file, VmContext *vmContext, uintptr_t base) {
 
 			// Check if we can share the segment.
 			if(!(phdr->p_flags & PF_W)) {
-				// Map the segment with correct permissions into the process.
 				if((phdr->p_flags & (PF_R | PF_W | PF_X)) == (PF_R | PF_X)) {
-					HEL_CHECK(helLoadahead(fileMemory.getHandle(), fileOffset, mapLength));
-
-					FRG_CO_TRY(co_await vmContext->mapFile(mapAddress,
-							fileMemory.dup(), file,
-							fileOffset, mapLength, true,
-							kHelMapProtRead | kHelMapProtExecute));
+					segment.nativeFlags = kHelMapProtRead | kHelMapProtExecute;
 				// Allow read only mappings too, ICU loves those.
 				}else if((phdr->p_flags & (PF_R | PF_W | PF_X)) == (PF_R)) {
-					HEL_CHECK(helLoadahead(fileMemory.getHandle(), fileOffset, mapLength));
-
-					FRG_CO_TRY(co_await vmContext->mapFile(mapAddress,
-							fileMemory.dup(), file,
-							fileOffset, mapLength, true,
-							kHelMapProtRead));
+					segment.nativeFlags = kHelMapProtRead;
 				}else{
 					std::cout << "posix: Illegal combination of segment permissions" << std::endl;
 					co_return Error::badExecutable;
 				}
-			}else{
-				// Map the segment with write permission into this address space.
-				HelHandle segmentHandle;
-				HEL_CHECK(helAllocateMemory(mapLength, 0, nullptr, &segmentHandle));
-
-				void *window;
-				HEL_CHECK(helMapMemory(segmentHandle, kHelNullHandle, nullptr,
-						0, mapLength, kHelMapProtRead | kHelMapProtWrite, &window));
 
-				// Map the segment with correct permissions into the process.
+				HEL_CHECK(helLoadahead(image->fileMemory.getHandle(),
+						segment.fileOffset, segment.mapLength));
+			}else{
 				if((phdr->p_flags & (PF_R | PF_W | PF_X)) == (PF_R | PF_W)) {
-					FRG_CO_TRY(co_await vmContext->mapFile(mapAddress,
-							helix::UniqueDescriptor{segmentHandle}, file,
-							0, mapLength, true,
-							kHelMapProtRead | kHelMapProtWrite));
+					segment.nativeFlags = kHelMapProtRead | kHelMapProtWrite;
 				}else{
 					std::cout << "posix: Illegal combination of segment permissions" << std::endl;
 					co_return Error::badExecutable;
 				}
 
+				// Build the initial contents of the segment once; processes map it copy-on-write.
+				HelHandle segmentHandle;
+				HEL_CHECK(helAllocateMemory(segment.mapLength, 0, nullptr, &segmentHandle));
+				segment.initialImage = helix::UniqueDescriptor{segmentHandle};
+
+				void *window;
+				HEL_CHECK(helMapMemory(segmentHandle, kHelNullHandle, nullptr,
+						0, segment.mapLength, kHelMapProtRead | kHelMapProtWrite, &window));
+
 				// Read the segment contents from the file.
-				memset(window, 0, mapLength);
-				FRG_CO_TRY(co_await file->seek(phdr->p_offset, VfsSeek::absolute));
-				FRG_CO_TRY(co_await file->readExactly(nullptr,
-						(char *)window + misalign, phdr->p_filesz));
-				HEL_CHECK(helUnmapMemory(kHelNullHandle, window, mapLength));
+				memset(window, 0, segment.mapLength);
+				auto readOutcome = co_await [&] () -> async::result<frg::expected<Error>> {
+					FRG_CO_TRY(co_await file->seek(phdr->p_offset, VfsSeek::absolute));
+					FRG_CO_TRY(co_await file->readExactly(nullptr,
+							(char *)window + misalign, phdr->p_filesz));
+					co_return {};
+				}();
+				HEL_CHECK(helUnmapMemory(kHelNullHandle, window, segment.mapLength));
+				FRG_CO_TRY(readOutcome);
 			}
+
+			image->segments.push_back(std::move(segment));
 		}else if(phdr->p_type == PT_PHDR) {
-			info.phdrPtr = (char *)base + phdr->p_vaddr;
+			image->hasPhdr = true;
+			image->phdrOffset = phdr->p_vaddr;
 		}else if(phdr->p_type == PT_DYNAMIC || phdr->p_type == PT_INTERP
 				|| phdr->p_type == PT_TLS
 				|| phdr->p_type == PT_GNU_EH_FRAME || phdr->p_type == PT_GNU_STACK
@@ -170,6 +185,88 @@ loadElfImage(SharedFilePtr file, VmContext *vmContext, uintptr_t base) {
 		}
 	}
 
+	co_return image;
+}
+
+// Returns the parsed image of a file, either from the cache or by parsing it.
+// Cache entries are keyed by FsNode and invalidated if the file's contents change.
+// Files whose server does not track content generations are not cached.
+async::result<frg::expected<Error, std::shared_ptr<CachedImage>>>
+getImage(SharedFilePtr file) {
+	std::shared_ptr<FsNode> node;
+	if(auto link = file->associatedLink(); link)
+		node = link->getTarget();
+	if(!node)
+		co_return co_await parseElfImage(file);
+
+	auto statsOrError = co_await node->getStats();
+	if(!statsOrError || !statsOrError.value().generation)
+		co_return co_await parseElfImage(file);
+	auto stats = statsOrError.value();
+
+	if(auto it = imageCacheMap.find(node.get()); it != imageCacheMap.end()) {
+		auto image = *it->second;
+		if(image->node.lock() == node && image->generation == stats.generation) {
+			if(logExecCache)
+				std::cout << "posix: Exec image cache hit" << std::endl;
+			imageCacheLru.splice(imageCacheLru.begin(), imageCacheLru, it->second);
+			co_return image;
+		}
+
+		// The entry is stale (or refers to a node that was since destroyed).
+		imageCacheLru.erase(it->second);
+		imageCacheMap.erase(it);
+	}
+
+	if(logExecCache)
+		std::cout << "posix: Exec image cache miss" << std::endl;
+	auto image = FRG_CO_TRY(co_await parseElfImage(file));
+	image->cacheKey = node.get();
+	image->node = node;
+	image->generation = stats.generation;
+
+	// Another exec() might have populated the entry while we were parsing the file.
+	if(auto it = imageCacheMap.find(node.get()); it != imageCacheMap.end()) {
+		imageCacheLru.erase(it->second);
+		imageCacheMap.erase(it);
+	}
+
+	if(imageCacheLru.size() >= imageCacheCapacity) {
+		imageCacheMap.erase(imageCacheLru.back()->cacheKey);
+		imageCacheLru.pop_back();
+	}
+	imageCacheLru.push_front(image);
+	imageCacheMap[node.get()] = imageCacheLru.begin();
+
+	co_return image;
+}
+
+async::result<frg::expected<Error, ImageInfo>>
+loadElfImage(SharedFilePtr file, std::shared_ptr<CachedImage> image,
+		VmContext *vmContext, uintptr_t base) {
+	assert(!(base & (kPageSize - 1))); // Callers need to ensure this.
+	ImageInfo info;
+
+	info.entryIp = (char *)base + image->entry;
+	if(image->hasPhdr)
+		info.phdrPtr = (char *)base + image->phdrOffset;
+	info.phdrEntrySize = image->phdrEntrySize;
+	info.phdrCount = image->phdrCount;
+
+	for(const auto &segment : image->segments) {
+		if(segment.initialImage) {
+			FRG_CO_TRY(co_await vmContext->mapFile(base + segment.mapOffset,
+					segment.initialImage.dup(), file,
+					0, segment.mapLength, true,
+					segment.nativeFlags));
+		}else{
+			FRG_CO_TRY(co_await vmContext->mapFile(base + segment.mapOffset,
+					image->fileMemory.dup(), file,
+					segment.fileOffset, segment.mapLength, true,
+					segment.nativeFlags));
+		}
+	}
+
 	co_return info;
 }
 
@@ -254,19 +351,23 @@ execute(ViewPath root, ViewPath workdir,
 		nRecursions++;
 	}
 
-	auto execPreamble = FRG_CO_TRY(co_await parseElfPreamble(execFile));
+	auto execImage = FRG_CO_TRY(co_await getImage(execFile));
 	ImageInfo execInfo;
-	if(execPreamble.isPie) {
+	if(execImage->isPie) {
 		// Unconditionally apply a non-zero base address to PIE objects.
-		execInfo = FRG_CO_TRY(co_await loadElfImage(execFile, vmContext.get(), 0x200000));
+		execInfo = FRG_CO_TRY(co_await loadElfImage(execFile, execImage,
+				vmContext.get(), 0x200000));
 	}else{
-		execInfo = FRG_CO_TRY(co_await loadElfImage(execFile, vmContext.get(), 0));
+		execInfo = FRG_CO_TRY(co_await loadElfImage(execFile, execImage,
+				vmContext.get(), 0));
 	}
 
 	// TODO: Should we really look up the dynamic linker in the current working dir?
 	auto ldsoFile = FRG_CO_TRY(co_await open(root, workdir, "/lib/ld-init.so", self));
 	assert(ldsoFile); // If open() succeeds, it must return a non-null file.
-	auto ldsoInfo = FRG_CO_TRY(co_await loadElfImage(ldsoFile, vmContext.get(), 0x40000000));
+	auto ldsoImage = FRG_CO_TRY(co_await getImage(ldsoFile));
+	auto ldsoInfo = FRG_CO_TRY(co_await loadElfImage(ldsoFile, ldsoImage,
+			vmContext.get(), 0x40000000));
 
 	constexpr size_t stackSize = 0x200000;
 
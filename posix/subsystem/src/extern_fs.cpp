@@ -75,6 +75,7 @@ struct Node : FsNode {
 		stats.mtimeNanos = resp.mtime_nanos();
 		stats.ctimeSecs = resp.ctime_secs();
 		stats.ctimeNanos = resp.ctime_nanos();
+		stats.generation = resp.generation();
 
 		co_return stats;
 	}
@@ -166,6 +167,8 @@ private:
 struct OpenFile final : File {
 private:
 	async::result<frg::expected<Error, off_t>> seek(off_t offset, VfsSeek whence) override {
+		if(whence == VfsSeek::relative)
+			co_return co_await _file.seekRelative(offset);
 		assert(whence == VfsSeek::absolute);
 		co_await _file.seekAbsolute(offset);
 		co_return offset;
@@ -201,6 +204,10 @@ private:
 		co_return std::move(memory);
 	}
 
+	bool isMemoryBacked() override {
+		return true;
+	}
+
 	helix::BorrowedDescriptor getPassthroughLane() override {
 		return _file.getLane();
 	}
@@ -5,22 +5,36 @@
 
 namespace {
 struct Socket : File {
-	Socket(helix::UniqueLane sockLane)
+	Socket(protocols::fs::File file, protocols::fs::StatusPageView statusPage)
 	: File{StructName::get("extern-socket")},
-		_file{std::move(sockLane)} { }
+		_file{std::move(file)}, _statusPage{std::move(statusPage)} { }
 
 	async::result<frg::expected<Error, PollWaitResult>>
 	pollWait(Process *, uint64_t sequence, int mask,
 			async::cancellation_token cancellation) override {
+		// See DeviceFile::pollWait(): only block if the status page has no new edges.
+		if(_statusPage) {
+			auto result = _statusPage.readEdges(sequence);
+			if(result && std::get<0>(*result) > sequence && (std::get<1>(*result) & mask))
+				co_return *result;
+		}
+
 		auto resultOrError = co_await _file.pollWait(sequence, mask, cancellation);
-		assert(resultOrError);
+		if(!resultOrError)
+			co_return fromFsError(resultOrError.error());
 		co_return resultOrError.value();
 	}
 
 	async::result<frg::expected<Error, PollStatusResult>>
 	pollStatus(Process *) override {
+		if(_statusPage) {
+			if(auto status = _statusPage.read(); status)
+				co_return *status;
+		}
+
 		auto resultOrError = co_await _file.pollStatus();
-		assert(resultOrError);
+		if(!resultOrError)
+			co_return fromFsError(resultOrError.error());
 		co_return resultOrError.value();
 	}
 
@@ -30,6 +44,7 @@ struct Socket : File {
 
 private:
 	protocols::fs::File _file;
+	protocols::fs::StatusPageView _statusPage;
 };
 }
 
@@ -64,7 +79,13 @@ async::result<smarter::shared_ptr<File, FileHandle>> createSocket(helix::Borrowe
 	resp.ParseFromArray(buffer, recv_resp.actualLength());
 	assert(resp.error() == managarm::fs::Errors::SUCCESS);
 
-	auto file = smarter::make_shared<Socket>(recv_lane.descriptor());
+	// Not all sockets publish a status page; we fall back to IPC for those.
+	protocols::fs::File socketFile{recv_lane.descriptor()};
+	protocols::fs::StatusPageView statusPage;
+	if(auto page = co_await socketFile.accessStatusPage(); page)
+		statusPage = protocols::fs::StatusPageView{page.value()};
+
+	auto file = smarter::make_shared<Socket>(std::move(socketFile), std::move(statusPage));
 	file->setupWeakFile(file);
 	co_return File::constructHandle(file);
 }
@@ -143,9 +143,9 @@ async::result<frg::expected<protocols::fs::Error, size_t>> File::ptPwrite(void *
 	co_return result.value();
 }
 
-async::result<ReadEntriesResult> File::ptReadEntries(void *object) {
+async::result<ReadEntriesResult> File::ptReadEntries(void *object, size_t max_size) {
 	auto self = static_cast<File *>(object);
-	return self->readEntries();
+	return self->readEntries(max_size);
 }
 
 async::result<frg::expected<protocols::fs::Error>> File::ptTruncate(void *object, size_t size) {
@@ -340,7 +340,7 @@ async::result<frg::expected<Error, size_t>> File::pwrite(Process *, int64_t, con
 	co_return Error::seekOnPipe;
 }
 
-async::result<ReadEntriesResult> File::readEntries() {
+async::result<ReadEntriesResult> File::readEntries(size_t) {
 	throw std::runtime_error("posix: Object has no File::readEntries()");
 }
 
@@ -461,6 +461,10 @@ FutureMaybe<helix::UniqueDescriptor> File::accessMemory() {
 	throw std::runtime_error("posix: Object has no File::accessMemory()");
 }
 
+bool File::isMemoryBacked() {
+	return false;
+}
+
 async::result<void> File::ioctl(Process *, uint32_t id, helix_ng::RecvInlineResult msg,
 		helix::UniqueLane conversation) {
 	std::cout << "posix \e[1;34m" << structName()
@@ -64,11 +64,17 @@ enum class Error {
 	// Corresponds with EISDIR
 	isDirectory,
 
-	noMemory
+	noMemory,
+
+	// Corresponds with EMFILE
+	tooManyFiles
 };
 
 std::ostream& operator<<(std::ostream& os, const Error& err);
 
+// Translates errors that other servers report through protocols::fs.
+Error fromFsError(protocols::fs::Error err);
+
 // TODO: Rename this enum as is not part of the VFS.
 enum class VfsSeek {
 	null, absolute, relative, eof
@@ -84,7 +90,7 @@ using expected = async::result<std::variant<Error, T>>;
 // File class.
 // ----------------------------------------------------------------------------
 
-using ReadEntriesResult = std::optional<std::string>;
+using ReadEntriesResult = protocols::fs::ReadEntriesResult;
 
 using PollResult = std::tuple<uint64_t, int, int>;
 using PollWaitResult = std::tuple<uint64_t, int>;
@@ -130,7 +136,7 @@ public:
 	ptPwrite(void *object, int64_t offset, const char *credentials, const void *buffer, size_t length);
 
 	static async::result<protocols::fs::ReadEntriesResult>
-	ptReadEntries(void *object);
+	ptReadEntries(void *object, size_t max_size);
 
 	static async::result<frg::expected<protocols::fs::Error>>
 	ptTruncate(void *object, size_t size);
@@ -281,6 +287,21 @@ public:
 
 	bool isTerminal();
 
+	// Access mode of the open file description. It is set by open(); files that are
+	// created otherwise (e.g., pipes and sockets) can be read and written.
+	void setAccessMode(bool readable, bool writable) {
+		_readable = readable;
+		_writable = writable;
+	}
+
+	bool isReadable() {
+		return _readable;
+	}
+
+	bool isWritable() {
+		return _writable;
+	}
+
 	async::result<frg::expected<Error>> readExactly(Process *process, void *data, size_t length);
 
 	virtual async::result<frg::expected<Error, off_t>>
@@ -301,7 +322,8 @@ public:
 	virtual async::result<frg::expected<Error, size_t>>
 	pwrite(Process *process, int64_t offset, const void *data, size_t length);
 
-	virtual FutureMaybe<ReadEntriesResult> readEntries();
+	// Returns as many entries as fit into a getdents64() buffer of max_size bytes.
+	virtual FutureMaybe<ReadEntriesResult> readEntries(size_t max_size);
 
 	virtual async::result<protocols::fs::RecvResult>
 		recvMsg(Process *process, uint32_t flags,
@@ -353,6 +375,10 @@ public:
 
 	virtual FutureMaybe<helix::UniqueDescriptor> accessMemory();
 
+	// Returns true if accessMemory() returns the memory object that holds
+	// the file's contents (e.g., the page cache of a regular file).
+	virtual bool isMemoryBacked();
+
 	virtual async::result<void> ioctl(Process *process, uint32_t id, helix_ng::RecvInlineResult msg,
 			helix::UniqueLane conversation);
 
@@ -377,6 +403,8 @@ private:
 
 	bool _isOpen;
 	bool _append;
+	bool _readable = true;
+	bool _writable = true;
 };
 
 struct DummyFile final : File {
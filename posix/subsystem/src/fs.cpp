@@ -16,6 +16,21 @@ async::result<frg::expected<Error>> FsLink::obstruct() {
 	co_return Error::illegalOperationTarget;
 }
 
+// --------------------------------------------------------
+// PseudoInode implementation.
+// --------------------------------------------------------
+
+PseudoInode::PseudoInode() {
+	static int64_t inodeCounter = 1;
+	_inodeNumber = inodeCounter++;
+}
+
+int64_t PseudoInode::of(FsNode *node) {
+	auto inode = dynamic_cast<PseudoInode *>(node);
+	assert(inode);
+	return inode->inodeNumber();
+}
+
 // --------------------------------------------------------
 // FsNode implementation.
 // --------------------------------------------------------
@@ -10,6 +10,7 @@
 #include <frg/container_of.hpp>
 #include <hel.h>
 
+#include <dirent.h>
 #include <fcntl.h>
 
 #include "file.hpp"
@@ -22,6 +23,20 @@ enum class VfsType {
 	null, directory, regular, symlink, charDevice, blockDevice, socket, fifo
 };
 
+// Returns the DT_* constant that getdents64() reports for a VfsType.
+inline uint8_t direntType(VfsType type) {
+	switch(type) {
+	case VfsType::directory: return DT_DIR;
+	case VfsType::regular: return DT_REG;
+	case VfsType::symlink: return DT_LNK;
+	case VfsType::charDevice: return DT_CHR;
+	case VfsType::blockDevice: return DT_BLK;
+	case VfsType::socket: return DT_SOCK;
+	case VfsType::fifo: return DT_FIFO;
+	default: return DT_UNKNOWN;
+	}
+}
+
 struct FileStats {
 	uint64_t inodeNumber;
 	int numLinks;
@@ -31,6 +46,8 @@ struct FileStats {
 	uint64_t atimeSecs, atimeNanos;
 	uint64_t mtimeSecs, mtimeNanos;
 	uint64_t ctimeSecs, ctimeNanos;
+	// Changes whenever the file contents change; zero if this is not tracked.
+	uint64_t generation = 0;
 };
 
 
@@ -186,6 +203,22 @@ private:
 	std::unordered_map<FsObserver *, std::shared_ptr<FsObserver>> _observers;
 };
 
+// Inode number of a node in a file system that does not persist its inodes (e.g., procfs, sysfs).
+// The number is allocated once when the node is created and shared by all such file systems.
+struct PseudoInode {
+	// Returns the inode number of a node that derives from PseudoInode.
+	static int64_t of(FsNode *node);
+
+	PseudoInode();
+
+	int64_t inodeNumber() {
+		return _inodeNumber;
+	}
+
+private:
+	int64_t _inodeNumber;
+};
+
 // ----------------------------------------------------------------------------
 // SpecialLink class.
 // ----------------------------------------------------------------------------
@@ -51,6 +51,20 @@ async::result<void> serveSignals(std::shared_ptr<Process> self,
 		auto result = co_await self->signalContext()->pollSignal(sequence,
 				UINT64_C(-1), cancellation);
 		sequence = std::get<0>(result);
+
+		// Only stop the thread if it has to act on a signal: blocked signals stay
+		// pending (unblocking them delivers them) and ignored signals can be dropped here.
+		if(!self->signalContext()->discardIgnored(~self->signalMask()))
+			continue;
+
+		// Handled signals are delivered by the kernel without stopping the thread.
+		// Default actions, SA_RESETHAND and critical sections (see checkSignalRaise())
+		// still go through the observer.
+		if(self->checkSignalRaise() && self->signalContext()->handOffSignals(self.get()))
+			continue;
+
+		// TODO: Interrupts (and signals handed to the kernel) only take effect on syscall exit.
+		//       Threads that do not enter the kernel need an IPI to reach them.
 		//std::cout << "Calling helInterruptThread on " << self->pid() << std::endl;
 		HEL_CHECK(helInterruptThread(thread.getHandle()));
 	}
@@ -83,6 +97,10 @@ namespace {
 };
 
 struct CmdlineNode final : public procfs::RegularNode {
+	bool immutable() override {
+		return true;
+	}
+
 	async::result<std::string> show() override {
 
 		managarm::kerncfg::GetCmdlineRequest req;
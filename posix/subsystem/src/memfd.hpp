@@ -32,6 +32,10 @@ public:
 
 	FutureMaybe<helix::UniqueDescriptor> accessMemory() override;
 
+	bool isMemoryBacked() override {
+		return true;
+	}
+
 	helix::BorrowedDescriptor getPassthroughLane() override {
 		return _passthrough;
 	}
@@ -123,9 +123,7 @@ async::result<void> observeThread(std::shared_ptr<Process> self,
 			HEL_CHECK(helLoadRegisters(thread.getHandle(), kHelRegsGeneral, &gprs));
 			size_t size = gprs[kHelRegArg0];
 
-			void *address = (co_await self->vmContext()->mapFile(0,
-					{}, nullptr,
-					0, size, true, kHelMapProtRead | kHelMapProtWrite)).unwrap();
+			void *address = (co_await self->vmContext()->allocateAnonymous(size)).unwrap();
 
 			gprs[kHelRegError] = kHelErrNone;
 			gprs[kHelRegOut0] = reinterpret_cast<uintptr_t>(address);
@@ -141,6 +139,14 @@ async::result<void> observeThread(std::shared_ptr<Process> self,
 			gprs[kHelRegOut0] = 0;
 			HEL_CHECK(helStoreRegisters(thread.getHandle(), kHelRegsGeneral, &gprs));
 			HEL_CHECK(helResume(thread.getHandle()));
+		}else if(observe.observation() == kHelObserveSuperCall + posix::superGetAnonArena) {
+			uintptr_t gprs[kHelNumGprs];
+			HEL_CHECK(helLoadRegisters(thread.getHandle(), kHelRegsGeneral, &gprs));
+
+			gprs[kHelRegError] = kHelErrNone;
+			gprs[kHelRegOut0] = reinterpret_cast<uintptr_t>(self->vmContext()->enableArena());
+			HEL_CHECK(helStoreRegisters(thread.getHandle(), kHelRegsGeneral, &gprs));
+			HEL_CHECK(helResume(thread.getHandle()));
 		}else if(observe.observation() == kHelObserveSuperCall + posix::superGetProcessData) {
 			posix::ManagarmProcessData data = {
 				self->clientPosixLane(),
@@ -448,6 +454,7 @@ async::result<void> observeThread(std::shared_ptr<Process> self,
 				} else {
 					self->setAltStackSp(reinterpret_cast<uint64_t>(st.ss_sp), st.ss_size);
 					self->setAltStackEnabled(!(st.ss_flags & SS_DISABLE));
+					self->signalContext()->updateKernelTable(self.get());
 				}
 			}
 
@@ -498,6 +505,10 @@ async::result<void> observeThread(std::shared_ptr<Process> self,
 			HEL_CHECK(helResume(thread.getHandle()));
 		}else if(observe.observation() == kHelObserveInterrupt) {
 			//printf("posix: Process %s was interrupted\n", self->path().c_str());
+			// The kernel also interrupts the thread if it cannot deliver a signal
+			// that we handed to it; process that signal like any other one.
+			self->signalContext()->reclaimSignal(self.get());
+
 			bool killed = false;
 			if(self->checkOrRequestSignalRaise()) {
 				auto active = co_await self->signalContext()->fetchSignal(
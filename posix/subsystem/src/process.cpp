@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <signal.h>
 #include <string.h>
 
@@ -15,6 +16,11 @@
 static bool logFileAttach = false;
 static bool logCleanup_ = false;
 
+// Size of each arena of pre-reserved anonymous memory.
+constexpr size_t anonArenaSize = size_t(32) << 20;
+// Larger allocations are always mapped as separate areas.
+constexpr size_t anonArenaMaxAllocation = size_t(1) << 20;
+
 async::result<void> serve(std::shared_ptr<Process> self, std::shared_ptr<Generation> generation);
 
 // ----------------------------------------------------------------------------
@@ -27,6 +33,7 @@ std::shared_ptr<VmContext> VmContext::create() {
 	HelHandle space;
 	HEL_CHECK(helCreateSpace(&space));
 	context->_space = helix::UniqueDescriptor(space);
+	context->setupArenaPage_();
 
 	return context;
 }
@@ -38,9 +45,21 @@ std::shared_ptr<VmContext> VmContext::clone(std::shared_ptr<VmContext> original)
 	HEL_CHECK(helCreateSpace(&space));
 	context->_space = helix::UniqueDescriptor(space);
 
+	// Process pending releases such that they are not inherited.
+	original->reconcileArena();
+	context->setupArenaPage_();
+
 	for(const auto &entry : original->_areaTree) {
 		const auto &[address, area] = entry;
 
+		// The child gets its own arena page. It is mapped at the same address
+		// since the process caches its address.
+		if(area.arenaPage) {
+			context->mapArenaPage_(reinterpret_cast<void *>(address),
+					area.nativeFlags | kHelMapFixedNoReplace);
+			continue;
+		}
+
 		helix::UniqueDescriptor copyView;
 		if(area.copyOnWrite) {
 			HelHandle copyHandle;
@@ -72,6 +91,18 @@ std::shared_ptr<VmContext> VmContext::clone(std::shared_ptr<VmContext> original)
 		context->_areaTree.emplace(address, std::move(copy));
 	}
 
+	// Inherit the current arena. Since we read the cursor after copying the areas,
+	// all memory beyond the cursor is still untouched in the copy.
+	context->_arenaEnabled = original->_arenaEnabled;
+	context->_arenaBase = original->_arenaBase;
+	context->_arenaLimit = original->_arenaLimit;
+	auto originalPage = reinterpret_cast<posix::AnonArenaPage *>(original->_arenaPageMapping.get());
+	auto page = reinterpret_cast<posix::AnonArenaPage *>(context->_arenaPageMapping.get());
+	auto limit = __atomic_load_n(&originalPage->limit, __ATOMIC_ACQUIRE);
+	auto cursor = __atomic_load_n(&originalPage->cursor, __ATOMIC_ACQUIRE);
+	__atomic_store_n(&page->cursor, cursor, __ATOMIC_RELAXED);
+	__atomic_store_n(&page->limit, limit, __ATOMIC_RELEASE);
+
 	return context;
 }
 
@@ -80,6 +111,39 @@ VmContext::~VmContext() {
 		std::cout << "\e[33mposix: VmContext is destructed\e[39m" << std::endl;
 }
 
+void *VmContext::enableArena() {
+	_arenaEnabled = true;
+
+	// Map the page again if the process unmapped it (or mapped something else over it).
+	auto it = _areaTree.find(reinterpret_cast<uintptr_t>(_clientArenaPage));
+	if(it == _areaTree.end() || !it->second.arenaPage)
+		mapArenaPage_(nullptr, kHelMapProtRead | kHelMapProtWrite);
+	return _clientArenaPage;
+}
+
+void VmContext::setupArenaPage_() {
+	HelHandle memory;
+	HEL_CHECK(helAllocateMemory(0x1000, 0, nullptr, &memory));
+	_arenaPageMemory = helix::UniqueDescriptor{memory};
+	_arenaPageMapping = helix::Mapping{_arenaPageMemory, 0, 0x1000};
+}
+
+void VmContext::mapArenaPage_(void *clientHint, uint32_t nativeFlags) {
+	HEL_CHECK(helMapMemory(_arenaPageMemory.getHandle(), _space.getHandle(),
+			clientHint, 0, 0x1000, nativeFlags, &_clientArenaPage));
+
+	// Track the page like any other shared mapping, such that it shows up in
+	// /proc/pid/maps and such that munmap() and MAP_FIXED see it.
+	Area area;
+	area.copyOnWrite = false;
+	area.areaSize = 0x1000;
+	area.nativeFlags = nativeFlags & ~kHelMapFixedNoReplace;
+	area.fileView = _arenaPageMemory.dup();
+	area.offset = 0;
+	area.arenaPage = true;
+	_areaTree.emplace(reinterpret_cast<uintptr_t>(_clientArenaPage), std::move(area));
+}
+
 auto VmContext::splitAreaOn_(uintptr_t addr, size_t size) ->
 		std::pair<
 			std::map<uintptr_t, Area>::iterator,
@@ -105,6 +169,7 @@ auto VmContext::splitAreaOn_(uintptr_t addr, size_t size) ->
 			right.copyView = area.copyView.dup();
 			right.file = area.file;
 			right.offset = area.offset + (addr - base);
+			right.arenaPage = area.arenaPage;
 
 			_areaTree.emplace(addr, std::move(right));
 
@@ -126,6 +191,9 @@ VmContext::mapFile(uintptr_t hint, helix::UniqueDescriptor memory,
 		intptr_t offset, size_t size, bool copyOnWrite, uint32_t nativeFlags) {
 	size_t alignedSize = (size + 0xFFF) & ~size_t(0xFFF);
 
+	// Released ranges might overlap fixed mappings that the process requests afterwards.
+	reconcileArena();
+
 	// Perform the actual mapping.
 	// POSIX specifies that non-page-size mappings are rounded up and filled with zeros.
 	helix::UniqueDescriptor copyView;
@@ -189,6 +257,8 @@ async::result<void *> VmContext::remapFile(void *oldPointer,
 	size_t alignedOldSize = (oldSize + 0xFFF) & ~size_t(0xFFF);
 	size_t alignedNewSize = (newSize + 0xFFF) & ~size_t(0xFFF);
 
+	reconcileArena();
+
 //	std::cout << "posix: Remapping " << oldPointer << std::endl;
 	auto it = _areaTree.find(reinterpret_cast<uintptr_t>(oldPointer));
 	assert(it != _areaTree.end());
@@ -237,6 +307,8 @@ async::result<void> VmContext::protectFile(void *pointer, size_t size, uint32_t
 	size_t alignedSize = (size + 0xFFF) & ~size_t(0xFFF);
 	auto address = reinterpret_cast<uintptr_t>(pointer);
 
+	reconcileArena();
+
 	helix::ProtectMemory protect;
 	auto &&submit = helix::submitProtectMemory(_space, &protect,
 			pointer, alignedSize, protectionFlags, helix::Dispatcher::global());
@@ -256,9 +328,105 @@ async::result<void> VmContext::protectFile(void *pointer, size_t size, uint32_t
 
 void VmContext::unmapFile(void *pointer, size_t size) {
 	size_t alignedSize = (size + 0xFFF) & ~size_t(0xFFF);
-	auto address = reinterpret_cast<uintptr_t>(pointer);
 
-	HEL_CHECK(helUnmapMemory(_space.getHandle(), pointer, alignedSize));
+	reconcileArena();
+	unmapArea_(reinterpret_cast<uintptr_t>(pointer), alignedSize);
+}
+
+async::result<frg::expected<Error, void *>> VmContext::allocateAnonymous(size_t size) {
+	size_t alignedSize = (size + 0xFFF) & ~size_t(0xFFF);
+	if(!_arenaEnabled || alignedSize > anonArenaMaxAllocation)
+		co_return co_await mapFile(0, {}, nullptr,
+				0, size, true, kHelMapProtRead | kHelMapProtWrite);
+
+	retireArena_();
+
+	auto arena = FRG_CO_TRY(co_await mapFile(0, {}, nullptr,
+			0, anonArenaSize, true, kHelMapProtRead | kHelMapProtWrite));
+	auto base = reinterpret_cast<uintptr_t>(arena);
+	_arenaBase = base;
+	_arenaLimit = base + anonArenaSize;
+
+	// The current request is served from the start of the new arena.
+	auto page = reinterpret_cast<posix::AnonArenaPage *>(_arenaPageMapping.get());
+	__atomic_store_n(&page->cursor, base + alignedSize, __ATOMIC_RELAXED);
+	__atomic_store_n(&page->limit, base + anonArenaSize, __ATOMIC_RELEASE);
+	co_return arena;
+}
+
+void VmContext::retireArena_() {
+	// Close the current arena. Clients that race with us fail their CAS on the cursor
+	// (since the new cursor is beyond any limit) and fall back to the supercall.
+	auto page = reinterpret_cast<posix::AnonArenaPage *>(_arenaPageMapping.get());
+	auto cursor = __atomic_exchange_n(&page->cursor, ~uintptr_t{0}, __ATOMIC_ACQ_REL);
+	__atomic_store_n(&page->limit, 0, __ATOMIC_RELEASE);
+
+	if(!_arenaLimit)
+		return;
+
+	// Nothing was allocated from [cursor, limit); unmap it such that it neither stays
+	// reserved nor needs to be copied on fork. If the process tampered with the cursor
+	// (or unmapped parts of the tail), we keep the arena as it is.
+	if(cursor >= _arenaBase && cursor < _arenaLimit && !(cursor & 0xFFF)
+			&& isMapped_(cursor, _arenaLimit - cursor))
+		unmapArea_(cursor, _arenaLimit - cursor);
+
+	_arenaBase = 0;
+	_arenaLimit = 0;
+}
+
+void VmContext::reconcileArena() {
+	auto page = reinterpret_cast<posix::AnonArenaPage *>(_arenaPageMapping.get());
+
+	// The process controls the ring; validate everything that we read from it.
+	auto tail = __atomic_load_n(&page->tail, __ATOMIC_ACQUIRE);
+	if(tail == _arenaHead)
+		return;
+	if(tail - _arenaHead > posix::AnonArenaPage::ringSize)
+		tail = _arenaHead + posix::AnonArenaPage::ringSize;
+
+	while(_arenaHead != tail) {
+		auto &entry = page->ring[_arenaHead % posix::AnonArenaPage::ringSize];
+		auto address = __atomic_load_n(&entry.address, __ATOMIC_RELAXED);
+		auto size = __atomic_load_n(&entry.size, __ATOMIC_RELAXED);
+
+		if(!(address & 0xFFF) && size && !(size & 0xFFF) && isMapped_(address, size)) {
+			unmapArea_(address, size);
+		}else{
+			std::cout << "\e[31m" "posix: Ignoring invalid anonymous arena release "
+					<< (void *)address << " (size: " << (void *)size << ")"
+					"\e[39m" << std::endl;
+		}
+		_arenaHead++;
+	}
+
+	__atomic_store_n(&page->head, _arenaHead, __ATOMIC_RELEASE);
+}
+
+bool VmContext::isMapped_(uintptr_t address, size_t size) {
+	if(address + size < address)
+		return false;
+
+	auto it = _areaTree.upper_bound(address);
+	if(it == _areaTree.begin())
+		return false;
+	it = std::prev(it);
+
+	uintptr_t covered = address;
+	while(covered < address + size) {
+		if(it == _areaTree.end())
+			return false;
+		const auto &[base, area] = *it;
+		if(base > covered || base + area.areaSize <= covered)
+			return false;
+		covered = base + area.areaSize;
+		++it;
+	}
+	return true;
+}
+
+void VmContext::unmapArea_(uintptr_t address, size_t alignedSize) {
+	HEL_CHECK(helUnmapMemory(_space.getHandle(), reinterpret_cast<void *>(address), alignedSize));
 
 	auto [startIt, endIt] = splitAreaOn_(address, alignedSize);
 
@@ -322,6 +490,16 @@ static HelHandle posixMbusClient = [] {
 	return data.mbusLane;
 }();
 
+void FileContext::setupFileTable_() {
+	HelHandle memory;
+	void *window;
+	HEL_CHECK(helAllocateMemory(fileTableWindowSize, 0, nullptr, &memory));
+	HEL_CHECK(helMapMemory(memory, kHelNullHandle, nullptr,
+			0, fileTableWindowSize, kHelMapProtRead | kHelMapProtWrite, &window));
+	_fileTableMemory = helix::UniqueDescriptor(memory);
+	_fileTableWindow = reinterpret_cast<HelHandle *>(window);
+}
+
 std::shared_ptr<FileContext> FileContext::create() {
 	auto context = std::make_shared<FileContext>();
 
@@ -329,13 +507,7 @@ std::shared_ptr<FileContext> FileContext::create() {
 	HEL_CHECK(helCreateUniverse(&universe));
 	context->_universe = helix::UniqueDescriptor(universe);
 
-	HelHandle memory;
-	void *window;
-	HEL_CHECK(helAllocateMemory(0x1000, 0, nullptr, &memory));
-	HEL_CHECK(helMapMemory(memory, kHelNullHandle, nullptr,
-			0, 0x1000, kHelMapProtRead | kHelMapProtWrite, &window));
-	context->_fileTableMemory = helix::UniqueDescriptor(memory);
-	context->_fileTableWindow = reinterpret_cast<HelHandle *>(window);
+	context->setupFileTable_();
 
 	HEL_CHECK(helTransferDescriptor(posixMbusClient,
 			context->_universe.getHandle(), &context->_clientMbusLane));
@@ -350,17 +522,25 @@ std::shared_ptr<FileContext> FileContext::clone(std::shared_ptr<FileContext> ori
 	HEL_CHECK(helCreateUniverse(&universe));
 	context->_universe = helix::UniqueDescriptor(universe);
 
-	HelHandle memory;
-	void *window;
-	HEL_CHECK(helAllocateMemory(0x1000, 0, nullptr, &memory));
-	HEL_CHECK(helMapMemory(memory, kHelNullHandle, nullptr,
-			0, 0x1000, kHelMapProtRead | kHelMapProtWrite, &window));
-	context->_fileTableMemory = helix::UniqueDescriptor(memory);
-	context->_fileTableWindow = reinterpret_cast<HelHandle *>(window);
+	context->setupFileTable_();
+
+	// Copy the table and bitmap wholesale; only the handles need to be
+	// transferred into the new universe individually.
+	context->_fileTable = original->_fileTable;
+	context->_usedFds = original->_usedFds;
+	context->_freeHint = original->_freeHint;
+
+	for(size_t w = 0; w < context->_usedFds.size(); w++) {
+		auto word = context->_usedFds[w];
+		while(word) {
+			auto fd = w * 64 + __builtin_ctzll(word);
+			word &= word - 1;
 
-	for(auto entry : original->_fileTable) {
-		//std::cout << "Clone FD " << entry.first << std::endl;
-		context->attachFile(entry.first, entry.second.file, entry.second.closeOnExec);
+			auto &entry = context->_fileTable[fd];
+			assert(entry);
+			HEL_CHECK(helTransferDescriptor(entry->file->getPassthroughLane().getHandle(),
+					context->_universe.getHandle(), &context->_fileTableWindow[fd]));
+		}
 	}
 
 	HEL_CHECK(helTransferDescriptor(posixMbusClient,
@@ -372,29 +552,53 @@ std::shared_ptr<FileContext> FileContext::clone(std::shared_ptr<FileContext> ori
 FileContext::~FileContext() {
 	if(logCleanup_)
 		std::cout << "\e[33mposix: FileContext is destructed\e[39m" << std::endl;
+	HEL_CHECK(helUnmapMemory(kHelNullHandle, _fileTableWindow, fileTableWindowSize));
+}
+
+void FileContext::growFileTable_(int fd) {
+	if(static_cast<size_t>(fd) < _fileTable.size())
+		return;
+
+	// Grow geometrically (in units of bitmap words) to keep attachFile() amortized O(1).
+	size_t words = std::max(_usedFds.size() * 2, static_cast<size_t>(fd / 64 + 1));
+	words = std::min(words, static_cast<size_t>(maxFileDescriptors / 64));
+	_usedFds.resize(words, 0);
+	_fileTable.resize(words * 64);
 }
 
-int FileContext::attachFile(smarter::shared_ptr<File, FileHandle> file,
+frg::expected<Error, int> FileContext::attachFile(smarter::shared_ptr<File, FileHandle> file,
 		bool close_on_exec) {
+	while(_freeHint < _usedFds.size() && _usedFds[_freeHint] == ~uint64_t(0))
+		_freeHint++;
+
+	int fd;
+	if(_freeHint < _usedFds.size()) {
+		fd = _freeHint * 64 + __builtin_ctzll(~_usedFds[_freeHint]);
+	}else{
+		fd = _usedFds.size() * 64;
+		if(fd >= maxFileDescriptors)
+			return Error::tooManyFiles;
+		growFileTable_(fd);
+	}
+
 	HelHandle handle;
 	HEL_CHECK(helTransferDescriptor(file->getPassthroughLane().getHandle(),
 			_universe.getHandle(), &handle));
 
-	for(int fd = 0; ; fd++) {
-		if(_fileTable.find(fd) != _fileTable.end())
-			continue;
-
-		if(logFileAttach)
-			std::cout << "posix: Attaching FD " << fd << std::endl;
+	if(logFileAttach)
+		std::cout << "posix: Attaching FD " << fd << std::endl;
 
-		_fileTable.insert({fd, {std::move(file), close_on_exec}});
-		_fileTableWindow[fd] = handle;
-		return fd;
-	}
+	_fileTable[fd] = FileDescriptor{std::move(file), close_on_exec};
+	markUsed_(fd);
+	_fileTableWindow[fd] = handle;
+	return fd;
 }
 
-void FileContext::attachFile(int fd, smarter::shared_ptr<File, FileHandle> file,
+Error FileContext::attachFile(int fd, smarter::shared_ptr<File, FileHandle> file,
 		bool close_on_exec) {
+	if(fd < 0 || fd >= maxFileDescriptors)
+		return Error::illegalArguments;
+
 	HelHandle handle;
 	HEL_CHECK(helTransferDescriptor(file->getPassthroughLane().getHandle(),
 			_universe.getHandle(), &handle));
@@ -402,63 +606,64 @@ void FileContext::attachFile(int fd, smarter::shared_ptr<File, FileHandle> file,
 	if(logFileAttach)
 		std::cout << "posix: Attaching fixed FD " << fd << std::endl;
 
-	auto it = _fileTable.find(fd);
-	if(it != _fileTable.end()) {
-		it->second = {std::move(file), close_on_exec};
-	}else{
-		_fileTable.insert({fd, {std::move(file), close_on_exec}});
-	}
+	growFileTable_(fd);
+	if(_fileTable[fd])
+		HEL_CHECK(helCloseDescriptor(_universe.getHandle(), _fileTableWindow[fd]));
+
+	_fileTable[fd] = FileDescriptor{std::move(file), close_on_exec};
+	markUsed_(fd);
 	_fileTableWindow[fd] = handle;
+	return Error::success;
 }
 
 std::optional<FileDescriptor> FileContext::getDescriptor(int fd) {
-	auto file = _fileTable.find(fd);
-	if(file == _fileTable.end())
+	if(fd < 0 || static_cast<size_t>(fd) >= _fileTable.size())
 		return std::nullopt;
-	return file->second;
+	return _fileTable[fd];
 }
 
 Error FileContext::setDescriptor(int fd, bool close_on_exec) {
-	auto it = _fileTable.find(fd);
-	if(it == _fileTable.end()) {
+	if(fd < 0 || static_cast<size_t>(fd) >= _fileTable.size() || !_fileTable[fd])
 		return Error::noSuchFile;
-	}
-	it->second.closeOnExec = close_on_exec;
+	_fileTable[fd]->closeOnExec = close_on_exec;
 	return Error::success;
 }
 
 smarter::shared_ptr<File, FileHandle> FileContext::getFile(int fd) {
-	auto file = _fileTable.find(fd);
-	if(file == _fileTable.end())
+	if(fd < 0 || static_cast<size_t>(fd) >= _fileTable.size() || !_fileTable[fd])
 		return smarter::shared_ptr<File, FileHandle>{};
-	return file->second.file;
+	return _fileTable[fd]->file;
 }
 
 Error FileContext::closeFile(int fd) {
 	if(logFileAttach)
 		std::cout << "posix: Closing FD " << fd << std::endl;
-	auto it = _fileTable.find(fd);
-	if(it == _fileTable.end()) {
+	if(fd < 0 || static_cast<size_t>(fd) >= _fileTable.size() || !_fileTable[fd])
 		return Error::noSuchFile;
-	}
 
 	HEL_CHECK(helCloseDescriptor(_universe.getHandle(), _fileTableWindow[fd]));
 
 	_fileTableWindow[fd] = 0;
-	_fileTable.erase(it);
+	_fileTable[fd].reset();
+	markFree_(fd);
 	return Error::success;
 }
 
 void FileContext::closeOnExec() {
-	auto it = _fileTable.begin();
-	while(it != _fileTable.end()) {
-		if(it->second.closeOnExec) {
-			HEL_CHECK(helCloseDescriptor(_universe.getHandle(), _fileTableWindow[it->first]));
+	for(size_t w = 0; w < _usedFds.size(); w++) {
+		auto word = _usedFds[w];
+		while(word) {
+			int fd = w * 64 + __builtin_ctzll(word);
+			word &= word - 1;
 
-			_fileTableWindow[it->first] = 0;
-			it = _fileTable.erase(it);
-		}else{
-			it++;
+			if(!_fileTable[fd]->closeOnExec)
+				continue;
+
+			HEL_CHECK(helCloseDescriptor(_universe.getHandle(), _fileTableWindow[fd]));
+
+			_fileTableWindow[fd] = 0;
+			_fileTable[fd].reset();
+			markFree_(fd);
 		}
 	}
 }
@@ -508,6 +713,7 @@ void SignalContext::resetHandlers() {
 	for(int sn = 1; sn <= 64; sn++)
 		if(_handlers[sn - 1].disposition == SignalDisposition::handle)
 			_handlers[sn - 1].disposition = SignalDisposition::none;
+	_handlerSeq++;
 }
 
 SignalHandler SignalContext::getHandler(int sn) {
@@ -516,6 +722,7 @@ SignalHandler SignalContext::getHandler(int sn) {
 
 SignalHandler SignalContext::changeHandler(int sn, SignalHandler handler) {
 	assert(sn - 1 < 64);
+	_handlerSeq++;
 	return std::exchange(_handlers[sn - 1], handler);
 }
 
@@ -581,6 +788,31 @@ async::result<SignalItem *> SignalContext::fetchSignal(uint64_t mask, bool nonBl
 	co_return item;
 }
 
+uint64_t SignalContext::discardIgnored(uint64_t mask) {
+	for(int sn = 1; sn <= 64; sn++) {
+		auto bit = UINT64_C(1) << (sn - 1);
+		if(!(_activeSet & mask & bit))
+			continue;
+
+		// This needs to match the dispositions that raiseContext() ignores.
+		auto disposition = _handlers[sn - 1].disposition;
+		bool ignored = disposition == SignalDisposition::ignore
+				|| (disposition == SignalDisposition::none
+					&& (sn == SIGCHLD || sn == SIGURG || sn == SIGWINCH));
+		if(!ignored)
+			continue;
+
+		while(!_slots[sn - 1].asyncQueue.empty()) {
+			auto item = &_slots[sn - 1].asyncQueue.front();
+			_slots[sn - 1].asyncQueue.pop_front();
+			delete item;
+		}
+		_activeSet &= ~bit;
+	}
+
+	return _activeSet & mask;
+}
+
 // We follow a similar model as Linux. The linux layout is a follows:
 // struct rt_sigframe. Placed at the top of the stack.
 //     struct ucontext. Part of struct rt_sigframe.
@@ -632,8 +864,10 @@ async::result<void> SignalContext::raiseContext(SignalItem *item, Process *proce
 	process->enterSignal();
 
 	// Implement SA_RESETHAND by resetting the signal disposition to default.
-	if(handler.flags & signalOnce)
+	if(handler.flags & signalOnce) {
 		_handlers[item->signalNumber - 1].disposition = SignalDisposition::none;
+		_handlerSeq++;
+	}
 
 	// Handle default dispositions properly
 	if(handler.disposition == SignalDisposition::none) {
@@ -681,8 +915,11 @@ async::result<void> SignalContext::raiseContext(SignalItem *item, Process *proce
 
 	sf.ucontext.uc_sigmask = handler.mask;
 
-	std::vector<std::byte> simdState(simdStateSize);
-	HEL_CHECK(helLoadRegisters(thread.getHandle(), kHelRegsSimd, simdState.data()));
+	// The SIMD state is stored right after the frame, such that both can be
+	// written to the thread's stack in a single operation.
+	std::vector<std::byte> frameBuffer(sizeof(SignalFrame) + simdStateSize);
+	HEL_CHECK(helLoadRegisters(thread.getHandle(), kHelRegsSimd,
+			frameBuffer.data() + sizeof(SignalFrame)));
 
 	// Once compile siginfo_t if that is neccessary (matches Linux behavior).
 	if(handler.flags & signalInfo) {
@@ -723,12 +960,10 @@ async::result<void> SignalContext::raiseContext(SignalItem *item, Process *proce
 #endif
 	// TODO: aarch64
 
+	memcpy(frameBuffer.data(), &sf, sizeof(SignalFrame));
 	auto storeFrame = co_await helix_ng::writeMemory(thread, frame,
-			sizeof(SignalFrame), &sf);
-	auto storeSimd = co_await helix_ng::writeMemory(thread, frame + sizeof(SignalFrame),
-			simdStateSize, simdState.data());
+			frameBuffer.size(), frameBuffer.data());
 	HEL_CHECK(storeFrame.error());
-	HEL_CHECK(storeSimd.error());
 
 	if(logSignals) {
 		std::cout << "posix: Saving pre-signal stack to " << (void *)frame << std::endl;
@@ -772,15 +1007,14 @@ async::result<void> SignalContext::restoreContext(helix::BorrowedDescriptor thre
 	if(logSignals)
 		std::cout << "posix: Restoring post-signal stack from " << (void *)frame << std::endl;
 
-	std::vector<std::byte> simdState(simdStateSize);
-
-	SignalFrame sf;
+	// See raiseContext() for the layout.
+	std::vector<std::byte> frameBuffer(sizeof(SignalFrame) + simdStateSize);
 	auto loadFrame = co_await helix_ng::readMemory(thread, frame,
-			sizeof(SignalFrame), &sf);
-	auto loadSimd = co_await helix_ng::readMemory(thread, frame + sizeof(SignalFrame),
-			simdStateSize, simdState.data());
+			frameBuffer.size(), frameBuffer.data());
 	HEL_CHECK(loadFrame.error());
-	HEL_CHECK(loadSimd.error());
+
+	SignalFrame sf;
+	memcpy(&sf, frameBuffer.data(), sizeof(SignalFrame));
 
 #if defined(__x86_64__)
 	HEL_CHECK(helStoreRegisters(thread.getHandle(), kHelRegsSignal, &sf.ucontext.uc_mcontext.gregs));
@@ -790,7 +1024,112 @@ async::result<void> SignalContext::restoreContext(helix::BorrowedDescriptor thre
 #error Signal register storing code is missing for architecture
 #endif
 
-	HEL_CHECK(helStoreRegisters(thread.getHandle(), kHelRegsSimd, simdState.data()));
+	HEL_CHECK(helStoreRegisters(thread.getHandle(), kHelRegsSimd,
+			frameBuffer.data() + sizeof(SignalFrame)));
+}
+
+void SignalContext::updateKernelTable(Process *process) {
+#if defined(__x86_64__)
+	HelSignalTable table;
+	memset(&table, 0, sizeof(HelSignalTable));
+
+	for(int sn = 1; sn <= 64; sn++) {
+		auto &handler = _handlers[sn - 1];
+		// Default dispositions and SA_RESETHAND are left to raiseContext().
+		if(handler.disposition != SignalDisposition::handle || (handler.flags & signalOnce))
+			continue;
+
+		auto &action = table.actions[sn - 1];
+		action.handlerIp = handler.handlerIp;
+		action.restorerIp = handler.restorerIp;
+		action.mask = handler.mask;
+		if(handler.flags & signalInfo)
+			action.flags |= kHelSignalInfo;
+		if(handler.flags & signalOnStack)
+			action.flags |= kHelSignalOnStack;
+		table.deliverable |= UINT64_C(1) << (sn - 1);
+	}
+	table.deliverable &= ~process->signalMask();
+
+	// The kernel respects the global signal flag, see checkSignalRaise().
+	table.flagAddress = reinterpret_cast<uintptr_t>(process->clientThreadPage());
+	if(process->isAltStackEnabled()) {
+		table.altStackSp = process->altStackSp();
+		table.altStackSize = process->altStackSize();
+	}
+
+	// The kernel builds the same frame as raiseContext().
+	table.layout.frameSize = sizeof(SignalFrame);
+	table.layout.redZoneSize = redZoneSize;
+	table.layout.stackMisalign = stackCallMisalign;
+	table.layout.returnOffset = offsetof(SignalFrame, returnAddress);
+	table.layout.regsOffset = offsetof(SignalFrame, ucontext.uc_mcontext.gregs);
+	table.layout.maskOffset = offsetof(SignalFrame, ucontext.uc_sigmask);
+	table.layout.simdPointerOffset = offsetof(SignalFrame, ucontext.uc_mcontext.fpregs);
+	table.layout.infoOffset = offsetof(SignalFrame, info);
+	table.layout.contextOffset = offsetof(SignalFrame, ucontext);
+
+	HEL_CHECK(helSetSignalTable(process->threadDescriptor().getHandle(), &table));
+#endif
+	// On other architectures, helRaiseSignal() always fails and we take the slow path.
+	process->setSignalTableSeq(_handlerSeq);
+}
+
+bool SignalContext::handOffSignals(Process *process) {
+	if(process->signalTableSeq() != _handlerSeq)
+		updateKernelTable(process);
+
+	auto pending = _activeSet & ~process->signalMask();
+	if(!pending)
+		return true;
+	int sn = __builtin_ctzll(pending) + 1;
+	assert(!_slots[sn - 1].asyncQueue.empty());
+	auto item = &_slots[sn - 1].asyncQueue.front();
+
+	static_assert(sizeof(siginfo_t) <= kHelSignalInfoSize);
+	siginfo_t info;
+	memset(&info, 0, sizeof(siginfo_t));
+	info.si_signo = sn;
+	std::visit(CompileSignalInfo{&info}, item->info);
+
+	auto error = helRaiseSignal(process->threadDescriptor().getHandle(), sn,
+			&info, sizeof(siginfo_t));
+	// Either the signal is not handled or another signal is still in flight.
+	if(error == kHelErrIllegalState || error == kHelErrQueueTooSmall)
+		return false;
+	HEL_CHECK(error);
+
+	if(logSignals)
+		std::cout << "posix: Handing signal " << sn << " to the kernel" << std::endl;
+
+	_slots[sn - 1].asyncQueue.pop_front();
+	if(_slots[sn - 1].asyncQueue.empty())
+		_activeSet &= ~(UINT64_C(1) << (sn - 1));
+	delete item;
+
+	process->enterSignal();
+	return !(_activeSet & ~process->signalMask());
+}
+
+void SignalContext::reclaimSignal(Process *process) {
+	int sn;
+	alignas(siginfo_t) char buffer[kHelSignalInfoSize];
+	HEL_CHECK(helReclaimSignal(process->threadDescriptor().getHandle(), &sn, buffer));
+	if(!sn)
+		return;
+
+	if(logSignals)
+		std::cout << "posix: Reclaiming signal " << sn << " from the kernel" << std::endl;
+
+	siginfo_t info;
+	memcpy(&info, buffer, sizeof(siginfo_t));
+
+	// The signal was the first one in its slot.
+	auto item = new SignalItem;
+	item->signalNumber = sn;
+	item->info = UserSignal{.pid = info.si_pid, .uid = static_cast<int>(info.si_uid)};
+	_slots[sn - 1].asyncQueue.push_front(*item);
+	_activeSet |= UINT64_C(1) << (sn - 1);
 }
 
 // ----------------------------------------------------------------------------
@@ -849,6 +1188,35 @@ std::shared_ptr<TerminalSession> PidHull::getTerminalSession() {
 	return terminalSession_.lock();
 }
 
+std::optional<HelThreadStats> Process::threadStats() {
+	if(!_threadDescriptor)
+		return std::nullopt;
+
+	HelThreadStats stats;
+	HEL_CHECK(helQueryThreadStats(_threadDescriptor.getHandle(), &stats));
+	return stats;
+}
+
+std::vector<HelThreadStats> Process::queryAllThreadStats() {
+	std::vector<HelHandle> handles;
+	for(auto [pid, hull] : globalPidMap) {
+		auto process = hull->getProcess();
+		if(!process || !process->_threadDescriptor)
+			continue;
+		handles.push_back(process->_threadDescriptor.getHandle());
+	}
+
+	std::vector<HelThreadStats> stats;
+	// The kernel bounds the number of threads per call.
+	constexpr size_t batchSize = 4096;
+	for(size_t i = 0; i < handles.size(); i += batchSize) {
+		auto n = std::min(batchSize, handles.size() - i);
+		stats.resize(i + n);
+		HEL_CHECK(helQueryThreadStatsBatch(handles.data() + i, n, stats.data() + i));
+	}
+	return stats;
+}
+
 std::shared_ptr<Process> Process::findProcess(ProcessId pid) {
 	auto it = globalPidMap.find(pid);
 	if(it == globalPidMap.end())
@@ -921,7 +1289,7 @@ async::result<std::shared_ptr<Process>> Process::init(std::string path) {
 			&process->_clientThreadPage));
 	HEL_CHECK(helMapMemory(process->_fileContext->fileTableMemory().getHandle(),
 			process->_vmContext->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead,
+			nullptr, 0, FileContext::fileTableWindowSize, kHelMapProtRead,
 			&process->_clientFileTable));
 	HEL_CHECK(helMapMemory(clk::trackerPageMemory().getHandle(),
 			process->_vmContext->getSpace().getHandle(),
@@ -993,7 +1361,7 @@ std::shared_ptr<Process> Process::fork(std::shared_ptr<Process> original) {
 			&process->_clientThreadPage));
 	HEL_CHECK(helMapMemory(process->_fileContext->fileTableMemory().getHandle(),
 			process->_vmContext->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead,
+			nullptr, 0, FileContext::fileTableWindowSize, kHelMapProtRead,
 			&process->_clientFileTable));
 	HEL_CHECK(helMapMemory(clk::trackerPageMemory().getHandle(),
 			process->_vmContext->getSpace().getHandle(),
@@ -1120,7 +1488,7 @@ async::result<Error> Process::exec(std::shared_ptr<Process> process,
 			&exec_clk_tracker_page));
 	HEL_CHECK(helMapMemory(process->_fileContext->fileTableMemory().getHandle(),
 			exec_vm_context->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead,
+			nullptr, 0, FileContext::fileTableWindowSize, kHelMapProtRead,
 			&exec_client_table));
 
 	// Kill the old thread.
@@ -1145,6 +1513,7 @@ async::result<Error> Process::exec(std::shared_ptr<Process> process,
 	process->_threadDescriptor = std::move(execResult.thread);
 	process->_vmContext = std::move(exec_vm_context);
 	process->_signalContext->resetHandlers();
+	process->_signalTableSeq = 0;
 	process->_clientThreadPage = exec_thread_page;
 	process->_clientPosixLane = exec_posix_lane;
 	process->_clientFileTable = exec_client_table;
@@ -3,6 +3,7 @@
 #include <map>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <async/result.hpp>
 #include <async/oneshot-event.hpp>
@@ -44,6 +45,18 @@ struct VmContext {
 
 	void unmapFile(void *pointer, size_t size);
 
+	// Enables arenas for this address space (i.e., the process knows how to use them)
+	// and returns the client address of the posix::AnonArenaPage.
+	// The page is mapped into the process on the first call.
+	void *enableArena();
+
+	// Slow path of anonymous allocations (i.e., when the arena is exhausted).
+	// If arenas are enabled, small allocations are taken from a freshly installed arena.
+	async::result<frg::expected<Error, void *>> allocateAnonymous(size_t size);
+
+	// Unmaps the ranges that the process released through its arena page.
+	void reconcileArena();
+
 private:
 	struct Area {
 		bool copyOnWrite;
@@ -53,6 +66,8 @@ private:
 		helix::UniqueDescriptor copyView;
 		smarter::shared_ptr<File, FileHandle> file;
 		intptr_t offset;
+		// Whether this is the process' mapping of the arena page.
+		bool arenaPage = false;
 	};
 
 	std::pair<
@@ -60,10 +75,37 @@ private:
 		std::map<uintptr_t, Area>::iterator
 	> splitAreaOn_(uintptr_t addr, size_t size);
 
+	bool isMapped_(uintptr_t address, size_t size);
+
+	void unmapArea_(uintptr_t address, size_t alignedSize);
+
+	// Allocates the arena page and maps it into the server.
+	void setupArenaPage_();
+
+	// Maps the arena page into the process and registers it as an area.
+	void mapArenaPage_(void *clientHint, uint32_t nativeFlags);
+
+	// Closes the current arena and unmaps its unused tail.
+	void retireArena_();
+
 	helix::UniqueDescriptor _space;
 
 	std::map<uintptr_t, Area> _areaTree;
 
+	helix::UniqueDescriptor _arenaPageMemory;
+	helix::Mapping _arenaPageMapping;
+	void *_clientArenaPage = nullptr;
+
+	// Arenas are only installed once the process asked for the arena page.
+	bool _arenaEnabled = false;
+	// Bounds of the current arena (or zero if there is none). These are tracked here
+	// since the process can write arbitrary values to the arena page.
+	uintptr_t _arenaBase = 0;
+	uintptr_t _arenaLimit = 0;
+
+	// Next entry of the arena page's ring that we need to unmap.
+	uint32_t _arenaHead = 0;
+
 public:
 	struct AreaAccessor {
 		AreaAccessor(std::map<uintptr_t, Area>::iterator iter)
@@ -93,7 +135,7 @@ public:
 			return _it->second.nativeFlags & kHelMapProtExecute;
 		}
 
-		smarter::borrowed_ptr<File, FileHandle> backingFile() {
+		smarter::shared_ptr<File, FileHandle> backingFile() {
 			return _it->second.file;
 		}
 
@@ -132,6 +174,11 @@ public:
 	AreaIterator end() {
 		return AreaIterator{_areaTree.end()};
 	}
+
+	// Returns the first area that starts at or after the given address.
+	AreaIterator areaFrom(uintptr_t address) {
+		return AreaIterator{_areaTree.lower_bound(address)};
+	}
 };
 
 struct FsContext {
@@ -156,6 +203,13 @@ struct FileDescriptor {
 
 struct FileContext {
 public:
+	// Upper bound on the number of file descriptors per process.
+	// The handle window is reserved for this many slots up front; since allocated
+	// memory is populated lazily by the kernel, only pages that contain open FDs
+	// are actually backed by physical memory.
+	static constexpr int maxFileDescriptors = 1 << 18;
+	static constexpr size_t fileTableWindowSize = maxFileDescriptors * sizeof(HelHandle);
+
 	static std::shared_ptr<FileContext> create();
 	static std::shared_ptr<FileContext> clone(std::shared_ptr<FileContext> original);
 
@@ -169,9 +223,14 @@ public:
 		return _fileTableMemory;
 	}
 
-	int attachFile(smarter::shared_ptr<File, FileHandle> file, bool close_on_exec = false);
+	// Attaches the file to the lowest free FD.
+	// Fails with Error::tooManyFiles if all FDs are in use.
+	frg::expected<Error, int> attachFile(smarter::shared_ptr<File, FileHandle> file,
+			bool close_on_exec = false);
 
-	void attachFile(int fd, smarter::shared_ptr<File, FileHandle> file, bool close_on_exec = false);
+	// Attaches the file to the given FD, closing the file that was previously attached.
+	// Fails with Error::illegalArguments if the FD is out of range.
+	Error attachFile(int fd, smarter::shared_ptr<File, FileHandle> file, bool close_on_exec = false);
 
 	std::optional<FileDescriptor> getDescriptor(int fd);
 
@@ -188,10 +247,30 @@ public:
 	}
 
 private:
+	void setupFileTable_();
+
+	// Grows _fileTable and _usedFds such that fd (which must be in range) is a valid index.
+	void growFileTable_(int fd);
+
+	void markUsed_(int fd) {
+		_usedFds[fd / 64] |= uint64_t(1) << (fd % 64);
+	}
+
+	void markFree_(int fd) {
+		_usedFds[fd / 64] &= ~(uint64_t(1) << (fd % 64));
+		if(static_cast<size_t>(fd / 64) < _freeHint)
+			_freeHint = fd / 64;
+	}
+
 	helix::UniqueDescriptor _universe;
 
-	// TODO: replace this by a tree that remembers gaps between keys.
-	std::unordered_map<int, FileDescriptor> _fileTable;
+	// Dense table indexed by FD; unused slots are empty.
+	std::vector<std::optional<FileDescriptor>> _fileTable;
+
+	// Bitmap of used FDs. Words below _freeHint are known to be full,
+	// such that the lowest free FD can be found without scanning from zero.
+	std::vector<uint64_t> _usedFds;
+	size_t _freeHint = 0;
 
 	helix::UniqueDescriptor _fileTableMemory;
 
@@ -275,6 +354,10 @@ public:
 	//       take a cancellation token instead of nonBlock.
 	async::result<SignalItem *> fetchSignal(uint64_t mask, bool nonBlock);
 
+	// Drops pending signals in mask whose disposition is to ignore them.
+	// Returns the set of signals in mask that remain pending.
+	uint64_t discardIgnored(uint64_t mask);
+
 	// ------------------------------------------------------------------------
 	// Signal context manipulation.
 	// ------------------------------------------------------------------------
@@ -284,6 +367,22 @@ public:
 
 	async::result<void> restoreContext(helix::BorrowedDescriptor thread);
 
+	// ------------------------------------------------------------------------
+	// Signal delivery by the kernel.
+	// ------------------------------------------------------------------------
+
+	// Installs the kernel's signal table for the process' thread.
+	// This needs to be called whenever the handlers, the signal mask or the
+	// alternate signal stack change.
+	void updateKernelTable(Process *process);
+
+	// Hands the first pending signal to the kernel if the kernel can deliver it
+	// without stopping the thread. Returns true if no unblocked signal remains pending.
+	bool handOffSignals(Process *process);
+
+	// Takes back a signal that the kernel could not deliver.
+	void reclaimSignal(Process *process);
+
 private:
 	SignalHandler _handlers[64];
 	SignalSlot _slots[64];
@@ -291,6 +390,10 @@ private:
 	async::recurring_event _signalBell;
 	uint64_t _currentSeq;
 	uint64_t _activeSet;
+
+	// Incremented whenever _handlers changes, such that the kernel tables
+	// of all threads that share this context can be refreshed.
+	uint64_t _handlerSeq = 1;
 };
 
 enum class NotifyType {
@@ -499,6 +602,13 @@ public:
 		return _threadDescriptor;
 	}
 
+	// Queries the kernel's scheduling statistics of this process' thread.
+	// Returns std::nullopt if the thread has already terminated.
+	std::optional<HelThreadStats> threadStats();
+
+	// Like threadStats(), but for all live threads at once, using a single kernel call.
+	static std::vector<HelThreadStats> queryAllThreadStats();
+
 	// As the contexts associated with a process can change (e.g. when unshare() is implemented),
 	// those functions return refcounted pointers.
 	std::shared_ptr<VmContext> vmContext() { return _vmContext; }
@@ -509,6 +619,7 @@ public:
 
 	void setSignalMask(uint64_t mask) {
 		_signalMask = mask;
+		_signalContext->updateKernelTable(this);
 	}
 
 	uint64_t signalMask() {
@@ -575,6 +686,15 @@ public:
 		_enteredSignalSeq++;
 	}
 
+	// Value of SignalContext::_handlerSeq when the kernel's signal table was installed.
+	uint64_t signalTableSeq() {
+		return _signalTableSeq;
+	}
+
+	void setSignalTableSeq(uint64_t seq) {
+		_signalTableSeq = seq;
+	}
+
 private:
 	Process *_parent;
 
@@ -641,6 +761,8 @@ private:
 	// Used for tracking signals that happened between sigprocmask and
 	// a call that resumes on a signal.
 	uint64_t _enteredSignalSeq = 0;
+
+	uint64_t _signalTableSeq = 0;
 };
 
 std::shared_ptr<Process> findProcessWithCredentials(const char *credentials);
@@ -30,6 +30,17 @@ bool LinkCompare::operator() (const std::string &name, const std::shared_ptr<Lin
 	return name < link->getName();
 }
 
+namespace {
+
+// Linux reports times in /proc in units of USER_HZ.
+constexpr uint64_t clockTicksPerSecond = 100;
+
+uint64_t toClockTicks(uint64_t nanos) {
+	return nanos / (1'000'000'000 / clockTicksPerSecond);
+}
+
+} // anonymous namespace
+
 // ----------------------------------------------------------------------------
 // RegularFile implementation.
 // ----------------------------------------------------------------------------
@@ -45,7 +56,7 @@ void RegularFile::serve(smarter::shared_ptr<RegularFile> file) {
 
 RegularFile::RegularFile(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link)
 : File{StructName::get("procfs.attr"), std::move(mount), std::move(link)},
-		_cached{false}, _offset{0} { }
+		_cached{false}, _bufferOffset{0}, _nextRecord{0}, _exhausted{false}, _offset{0} { }
 
 void RegularFile::handleClose() {
 	_cancelServe.cancel();
@@ -66,16 +77,39 @@ async::result<frg::expected<Error, size_t>>
 RegularFile::readSome(Process *, void *data, size_t max_length) {
 	assert(max_length > 0);
 
-	if(!_cached) {
-		assert(!_offset);
-		auto node = static_cast<RegularNode *>(associatedLink()->getTarget().get());
-		_buffer = co_await node->show();
+	auto node = static_cast<RegularNode *>(associatedLink()->getTarget().get());
+
+	// Restart generation on the first read and on backwards seeks.
+	if(!_cached || _offset < _bufferOffset) {
+		_buffer.clear();
+		_bufferOffset = 0;
+		_nextRecord = 0;
+		_exhausted = false;
+		if(!node->streaming()) {
+			_buffer = co_await node->showCached_();
+			_exhausted = true;
+		}
 		_cached = true;
 	}
 
-	assert(_offset <= _buffer.size());
-	size_t chunk = std::min(_buffer.size() - _offset, max_length);
-	memcpy(data, _buffer.data() + _offset, chunk);
+	// Generate records until the requested range is covered.
+	// Content that precedes the current offset is dropped on the way.
+	while(node->streaming()) {
+		size_t consumed = std::min(_offset - _bufferOffset, _buffer.size());
+		_buffer.erase(0, consumed);
+		_bufferOffset += consumed;
+
+		if(_exhausted || _bufferOffset + _buffer.size() >= _offset + max_length)
+			break;
+		if(!(co_await node->showRecord(_nextRecord, _buffer)))
+			_exhausted = true;
+	}
+
+	if(_offset >= _bufferOffset + _buffer.size())
+		co_return 0;
+	size_t disp = _offset - _bufferOffset;
+	size_t chunk = std::min(_buffer.size() - disp, max_length);
+	memcpy(data, _buffer.data() + disp, chunk);
 	_offset += chunk;
 	co_return chunk;
 }
@@ -116,14 +150,18 @@ void DirectoryFile::handleClose() {
 }
 
 // TODO: This iteration mechanism only works as long as _iter is not concurrently deleted.
-async::result<ReadEntriesResult> DirectoryFile::readEntries() {
-	if(_iter != _node->_entries.end()) {
+async::result<ReadEntriesResult> DirectoryFile::readEntries(size_t max_size) {
+	protocols::fs::EntriesBuilder builder{max_size};
+	while(_iter != _node->_entries.end()) {
 		auto name = (*_iter)->getName();
+		if(!builder.fits(name))
+			break;
+
+		builder.add(std::move(name), (*_iter)->inodeNumber(),
+				direntType((*_iter)->getTarget()->getType()));
 		_iter++;
-		co_return name;
-	}else{
-		co_return std::nullopt;
 	}
+	co_return builder.entries();
 }
 
 helix::BorrowedDescriptor DirectoryFile::getPassthroughLane() {
@@ -135,10 +173,11 @@ helix::BorrowedDescriptor DirectoryFile::getPassthroughLane() {
 // ----------------------------------------------------------------------------
 
 Link::Link(std::shared_ptr<FsNode> target)
-: _target{std::move(target)} { }
+: _target{std::move(target)}, _inodeNumber{PseudoInode::of(_target.get())} { }
 
 Link::Link(std::shared_ptr<FsNode> owner, std::string name, std::shared_ptr<FsNode> target)
-: _owner{std::move(owner)}, _name{std::move(name)}, _target{std::move(target)} {
+: _owner{std::move(owner)}, _name{std::move(name)}, _target{std::move(target)},
+		_inodeNumber{PseudoInode::of(_target.get())} {
 	assert(_owner);
 	assert(!_name.empty());
 }
@@ -172,7 +211,7 @@ async::result<frg::expected<Error, FileStats>> RegularNode::getStats() {
 	auto now = clk::getRealtime();
 
 	FileStats stats;
-	stats.inodeNumber = 0; // FIXME
+	stats.inodeNumber = inodeNumber();
 	stats.numLinks = 1;
 	stats.fileSize = 4096; // Same as in Linux.
 	stats.mode = 0666; // TODO: Some files can be written.
@@ -204,6 +243,20 @@ RegularNode::open(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link
 	co_return File::constructHandle(std::move(file));
 }
 
+async::result<bool> RegularNode::showRecord(uint64_t &, std::string &) {
+	assert(!"showRecord() must be implemented by streaming nodes");
+	__builtin_unreachable();
+}
+
+async::result<std::string> RegularNode::showCached_() {
+	if(!immutable())
+		co_return co_await show();
+
+	if(!_cachedContent)
+		_cachedContent = co_await show();
+	co_return *_cachedContent;
+}
+
 FutureMaybe<std::shared_ptr<FsNode>> SuperBlock::createRegular() {
 	co_return nullptr;
 }
@@ -234,6 +287,8 @@ std::shared_ptr<Link> DirectoryNode::createRootDirectory() {
 	the_node->_entries.insert(std::move(self_thread_link));
 
 	the_node->directMkregular("uptime", std::make_shared<UptimeNode>());
+	the_node->directMkregular("stat", std::make_shared<SystemStatNode>());
+	the_node->directMkregular("interrupts", std::make_shared<InterruptsNode>());
 
 	auto sysLink = the_node->directMkdir("sys");
 	auto sys = std::static_pointer_cast<DirectoryNode>(sysLink->getTarget());
@@ -288,6 +343,7 @@ std::shared_ptr<Link> DirectoryNode::createProcDirectory(std::string name,
 	proc_dir->directMkregular("stat", std::make_shared<StatNode>(process));
 	proc_dir->directMkregular("statm", std::make_shared<StatmNode>(process));
 	proc_dir->directMkregular("status", std::make_shared<StatusNode>(process));
+	proc_dir->directMkregular("schedstat", std::make_shared<SchedstatNode>(process));
 
 	auto task_link = proc_dir->directMkdir("task");
 	auto task_dir = static_cast<DirectoryNode*>(task_link->getTarget().get());
@@ -296,6 +352,9 @@ std::shared_ptr<Link> DirectoryNode::createProcDirectory(std::string name,
 	auto tid_dir = static_cast<DirectoryNode*>(tid_link->getTarget().get());
 
 	tid_dir->directMkregular("comm", std::make_shared<CommNode>(process));
+	tid_dir->directMkregular("stat", std::make_shared<StatNode>(process));
+	tid_dir->directMkregular("status", std::make_shared<StatusNode>(process));
+	tid_dir->directMkregular("schedstat", std::make_shared<SchedstatNode>(process));
 
 	return link;
 }
@@ -311,7 +370,9 @@ async::result<frg::expected<Error, std::shared_ptr<FsLink>>> DirectoryNode::link
 
 async::result<frg::expected<Error, FileStats>> DirectoryNode::getStats() {
 	std::cout << "\e[31mposix: Fix procfs Directory::getStats()\e[39m" << std::endl;
-	co_return FileStats{};
+	FileStats stats{};
+	stats.inodeNumber = inodeNumber();
+	co_return stats;
 }
 
 std::shared_ptr<FsLink> DirectoryNode::treeLink() {
@@ -428,7 +489,9 @@ expected<std::string> SelfLink::readSymlink(FsLink *link, Process *process) {
 
 async::result<frg::expected<Error, FileStats>> SelfLink::getStats() {
 	std::cout << "\e[31mposix: Fix procfs SelfLink::getStats()\e[39m" << std::endl;
-	co_return FileStats{};
+	FileStats stats{};
+	stats.inodeNumber = inodeNumber();
+	co_return stats;
 }
 
 VfsType SelfThreadLink::getType() {
@@ -441,7 +504,9 @@ expected<std::string> SelfThreadLink::readSymlink(FsLink *link, Process *process
 
 async::result<frg::expected<Error, FileStats>> SelfThreadLink::getStats() {
 	std::cout << "\e[31mposix: Fix procfs SelfThreadLink::getStats()\e[39m" << std::endl;
-	co_return FileStats{};
+	FileStats stats{};
+	stats.inodeNumber = inodeNumber();
+	co_return stats;
 }
 
 VfsType ExeLink::getType() {
@@ -454,46 +519,66 @@ expected<std::string> ExeLink::readSymlink(FsLink *link, Process *process) {
 
 async::result<frg::expected<Error, FileStats>> ExeLink::getStats() {
 	std::cout << "\e[31mposix: Fix procfs ExeLink::getStats()\e[39m" << std::endl;
-	co_return FileStats{};
+	FileStats stats{};
+	stats.inodeNumber = inodeNumber();
+	co_return stats;
 }
 
 async::result<std::string> MapNode::show() {
+	std::string content;
+	uint64_t pos = 0;
+	while(co_await showRecord(pos, content))
+		;
+	co_return content;
+}
+
+async::result<bool> MapNode::showRecord(uint64_t &pos, std::string &out) {
 	auto vmContext = _process->vmContext();
+	auto it = vmContext->areaFrom(pos);
+	if(!(it != vmContext->end()))
+		co_return false;
+
+	// Copy everything that we need out of the area, as it may change while we are suspended.
+	auto area = *it;
+	auto baseAddress = area.baseAddress();
+	auto size = area.size();
+	auto backingFile = area.backingFile();
+	auto backingFileOffset = area.backingFileOffset();
+	pos = baseAddress + size;
+
 	std::stringstream stream;
-	for (auto area : *vmContext) {
-		stream << std::hex << area.baseAddress();
-		stream << "-";
-		stream << std::hex << area.baseAddress() + area.size();
+	stream << std::hex << baseAddress;
+	stream << "-";
+	stream << std::hex << baseAddress + size;
+	stream << " ";
+	stream << (area.isReadable() ? "r" : "-");
+	stream << (area.isWritable() ? "w" : "-");
+	stream << (area.isExecutable() ? "x" : "-");
+	stream << (area.isPrivate() ? "p" : "-");
+	stream << " ";
+	if(backingFile && backingFile->associatedLink() && backingFile->associatedMount()) {
+		stream << std::setfill('0') << std::setw(8) << backingFileOffset;
 		stream << " ";
-		stream << (area.isReadable() ? "r" : "-");
-		stream << (area.isWritable() ? "w" : "-");
-		stream << (area.isExecutable() ? "x" : "-");
-		stream << (area.isPrivate() ? "p" : "-");
+		auto fsNode = backingFile->associatedLink()->getTarget();
+		ViewPath viewPath = {backingFile->associatedMount(), backingFile->associatedLink()};
+		auto fileStats = co_await fsNode->getStats();
+		DeviceId deviceId{};
+		if (fsNode->getType() == VfsType::charDevice || fsNode->getType() == VfsType::blockDevice)
+			deviceId = fsNode->readDevice();
+		assert(fileStats);
+
+		stream << std::dec << std::setfill('0') << std::setw(2) << deviceId.first << ":" << deviceId.second;
 		stream << " ";
-		auto backingFile = area.backingFile();
-		if(backingFile && backingFile->associatedLink() && backingFile->associatedMount()) {
-			stream << std::setfill('0') << std::setw(8) << area.backingFileOffset();
-			stream << " ";
-			auto fsNode = backingFile->associatedLink()->getTarget();
-			ViewPath viewPath = {backingFile->associatedMount(), backingFile->associatedLink()};
-			auto fileStats = co_await fsNode->getStats();
-			DeviceId deviceId{};
-			if (fsNode->getType() == VfsType::charDevice || fsNode->getType() == VfsType::blockDevice)
-				deviceId = fsNode->readDevice();
-			assert(fileStats);
-
-			stream << std::dec << std::setfill('0') << std::setw(2) << deviceId.first << ":" << deviceId.second;
-			stream << " ";
-			stream << std::setw(0) << fileStats.value().inodeNumber;
-			stream << "    ";
-			stream << viewPath.getPath(_process->fsContext()->getRoot());
-		} else {
-			// TODO: In the case of memfd files, show the name here.
-			stream << "00000000 00:00 0";
-		}
-		stream << "\n";
+		stream << std::setw(0) << fileStats.value().inodeNumber;
+		stream << "    ";
+		stream << viewPath.getPath(_process->fsContext()->getRoot());
+	} else {
+		// TODO: In the case of memfd files, show the name here.
+		stream << "00000000 00:00 0";
 	}
-	co_return stream.str();
+	stream << "\n";
+	out += stream.str();
+	co_return true;
 }
 
 async::result<void> MapNode::store(std::string) {
@@ -526,7 +611,9 @@ expected<std::string> RootLink::readSymlink(FsLink *link, Process *process) {
 
 async::result<frg::expected<Error, FileStats>> RootLink::getStats() {
 	std::cout << "\e[31mposix: Fix procfs RootLink::getStats()\e[39m" << std::endl;
-	co_return FileStats{};
+	FileStats stats{};
+	stats.inodeNumber = inodeNumber();
+	co_return stats;
 }
 
 async::result<std::string> StatNode::show() {
@@ -552,9 +639,10 @@ async::result<std::string> StatNode::show() {
 	stream << "0 "; // cminflt
 	stream << "0 "; // majflt
 	stream << "0 "; // cmajflt
-	stream << _process->accumulatedUsage().userTime << " "; // utime
+	auto stats = _process->threadStats();
+	stream << (stats ? toClockTicks(stats->userTime) : 0) << " "; // utime
 	stream << "0 "; // stime
-	stream << "0 "; // cutime
+	stream << toClockTicks(_process->accumulatedUsage().userTime) << " "; // cutime
 	stream << "0 "; // cstime
 	stream << "0 "; // priority
 	stream << "0 "; // nice
@@ -577,7 +665,7 @@ async::result<std::string> StatNode::show() {
 	stream << "0 "; // nswap
 	stream << "0 "; // cnswap
 	stream << "0 "; // exit_signal
-	stream << "0 "; // processor
+	stream << (stats ? std::max(stats->lastCpu, 0) : 0) << " "; // processor
 	stream << "0 "; // rt_priority
 	stream << "0 "; // policy
 	stream << "0 "; // delayacct_blkio_ticks
@@ -599,6 +687,117 @@ async::result<void> StatNode::store(std::string) {
 	throw std::runtime_error("Can't store to a /proc/stat file!");
 }
 
+async::result<std::string> SchedstatNode::show() {
+	// Format: time spent on the CPU (ns), time spent waiting for a CPU (ns), number of timeslices.
+	std::stringstream stream;
+	if(auto stats = _process->threadStats(); stats) {
+		stream << stats->userTime << " " << stats->waitTime << " "
+				<< (stats->numVoluntarySwitches + stats->numInvoluntarySwitches) << "\n";
+	}else{
+		stream << "0 0 0\n";
+	}
+	co_return stream.str();
+}
+
+async::result<void> SchedstatNode::store(std::string) {
+	// TODO: proper error reporting.
+	throw std::runtime_error("Can't store to a /proc/schedstat file!");
+}
+
+async::result<std::string> SystemStatNode::show() {
+	// See man 5 proc for more details.
+	// We only distinguish between idle and busy time; busy time is reported as user time.
+	std::vector<HelCpuStats> cpus;
+	while(true) {
+		HelCpuStats stats;
+		auto error = helQueryCpuStats(cpus.size(), &stats);
+		if(error == kHelErrOutOfBounds)
+			break;
+		HEL_CHECK(error);
+		cpus.push_back(stats);
+	}
+
+	auto printCpu = [] (std::stringstream &stream, uint64_t busy, uint64_t idle) {
+		stream << toClockTicks(busy) << " 0 0 " << toClockTicks(idle) << " 0 0 0 0 0 0\n";
+	};
+
+	uint64_t totalBusy = 0, totalIdle = 0;
+	for(auto &cpu : cpus) {
+		totalBusy += cpu.busyTime;
+		totalIdle += cpu.idleTime;
+	}
+
+	std::stringstream stream;
+	stream << "cpu  ";
+	printCpu(stream, totalBusy, totalIdle);
+	for(size_t i = 0; i < cpus.size(); i++) {
+		stream << "cpu" << i << " ";
+		printCpu(stream, cpus[i].busyTime, cpus[i].idleTime);
+	}
+
+	// Context switches of all live threads.
+	uint64_t ctxt = 0;
+	for(auto &stats : Process::queryAllThreadStats())
+		ctxt += stats.numVoluntarySwitches + stats.numInvoluntarySwitches;
+	stream << "ctxt " << ctxt << "\n";
+	co_return stream.str();
+}
+
+async::result<void> SystemStatNode::store(std::string) {
+	// TODO: proper error reporting.
+	throw std::runtime_error("Can't store to a /proc/stat file!");
+}
+
+async::result<std::string> InterruptsNode::show() {
+	// Same layout as on Linux: one column per CPU, followed by the target CPU and the name.
+	std::vector<HelCpuStats> cpus;
+	while(true) {
+		HelCpuStats stats;
+		auto error = helQueryCpuStats(cpus.size(), &stats);
+		if(error == kHelErrOutOfBounds)
+			break;
+		HEL_CHECK(error);
+		cpus.push_back(stats);
+	}
+	int numCpus = std::min(int(cpus.size()), int{kHelIrqStatsMaxCpus});
+
+	std::stringstream stream;
+	stream << "    ";
+	for(int i = 0; i < numCpus; i++)
+		stream << std::setw(11) << ("CPU" + std::to_string(i));
+	stream << "\n";
+
+	for(int n = 0; ; n++) {
+		HelIrqStats stats;
+		auto error = helQueryIrqStats(n, &stats);
+		if(error == kHelErrOutOfBounds)
+			break;
+		HEL_CHECK(error);
+
+		stream << std::setw(3) << n << ":";
+		for(int i = 0; i < numCpus; i++)
+			stream << std::setw(11) << stats.counts[i];
+		if(stats.affinity >= 0) {
+			stream << "  CPU" << std::left << std::setw(4) << stats.affinity << std::right;
+		}else{
+			stream << "  -      ";
+		}
+		stream << stats.name << "\n";
+	}
+
+	// Linux reports received shootdowns; we only count the IPIs on the sending CPU.
+	stream << "TLB:";
+	for(int i = 0; i < numCpus; i++)
+		stream << std::setw(11) << cpus[i].numShootdownIpis;
+	stream << "  TLB shootdown IPIs\n";
+	co_return stream.str();
+}
+
+async::result<void> InterruptsNode::store(std::string) {
+	// TODO: proper error reporting.
+	throw std::runtime_error("Can't store to a /proc/interrupts file!");
+}
+
 async::result<std::string> StatmNode::show() {
 	(void)_process;
 	// All hardcoded to 0.
@@ -696,8 +895,13 @@ async::result<std::string> StatusNode::show() {
 	stream << "Cpus_allowed_list: N/A\n";
 	stream << "Mems_allowed: N/A\n";
 	stream << "Mems_allowed_list: N/A\n";
-	stream << "voluntary_ctxt_switches: N/A\n";
-	stream << "nonvoluntary_ctxt_switches: N/A\n";
+	if(auto stats = _process->threadStats(); stats) {
+		stream << "voluntary_ctxt_switches: " << stats->numVoluntarySwitches << "\n";
+		stream << "nonvoluntary_ctxt_switches: " << stats->numInvoluntarySwitches << "\n";
+	}else{
+		stream << "voluntary_ctxt_switches: 0\n";
+		stream << "nonvoluntary_ctxt_switches: 0\n";
+	}
 	co_return stream.str();
 }
 
@@ -716,7 +920,9 @@ expected<std::string> CwdLink::readSymlink(FsLink *link, Process *process) {
 
 async::result<frg::expected<Error, FileStats>> CwdLink::getStats() {
 	std::cout << "\e[31mposix: Fix procfs CwdLink::getStats()\e[39m" << std::endl;
-	co_return FileStats{};
+	FileStats stats{};
+	stats.inodeNumber = inodeNumber();
+	co_return stats;
 }
 
 } // namespace procfs
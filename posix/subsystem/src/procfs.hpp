@@ -48,7 +48,13 @@ private:
 	async::cancellation_event _cancelServe;
 
 	bool _cached;
+	// Generated content starting at file offset _bufferOffset.
+	// For streaming nodes, this only holds the records around the current offset.
 	std::string _buffer;
+	size_t _bufferOffset;
+	// Position of the next record to generate (see RegularNode::showRecord()).
+	uint64_t _nextRecord;
+	bool _exhausted;
 	size_t _offset;
 };
 
@@ -60,7 +66,7 @@ public:
 
 	void handleClose() override;
 
-	FutureMaybe<ReadEntriesResult> readEntries() override;
+	FutureMaybe<ReadEntriesResult> readEntries(size_t max_size) override;
 	helix::BorrowedDescriptor getPassthroughLane() override;
 
 private:
@@ -83,13 +89,19 @@ struct Link final : FsLink, std::enable_shared_from_this<Link> {
 	std::string getName() override;
 	std::shared_ptr<FsNode> getTarget() override;
 
+	// Inode number of the target; cached so that readEntries() does not need to stat.
+	int64_t inodeNumber() {
+		return _inodeNumber;
+	}
+
 private:
 	std::shared_ptr<FsNode> _owner;
 	std::string _name;
 	std::shared_ptr<FsNode> _target;
+	int64_t _inodeNumber;
 };
 
-struct RegularNode : FsNode, std::enable_shared_from_this<RegularNode> {
+struct RegularNode : FsNode, PseudoInode, std::enable_shared_from_this<RegularNode> {
 	friend struct RegularFile;
 
 	RegularNode();
@@ -104,6 +116,29 @@ struct RegularNode : FsNode, std::enable_shared_from_this<RegularNode> {
 protected:
 	virtual async::result<std::string> show() = 0;
 	virtual async::result<void> store(std::string buffer) = 0;
+
+	// Nodes whose content never changes can return true here;
+	// show() is then only called once and its result is shared by all readers.
+	virtual bool immutable() {
+		return false;
+	}
+
+	// Streaming interface (similar to Linux' seq_file).
+	// Nodes that return true from streaming() generate their content record by record,
+	// such that reads only generate the records that they actually consume.
+	virtual bool streaming() {
+		return false;
+	}
+
+	// Appends the first record at or after position pos to out and advances pos
+	// past that record. The interpretation of pos is up to the node.
+	// Returns false if there are no more records.
+	virtual async::result<bool> showRecord(uint64_t &pos, std::string &out);
+
+private:
+	async::result<std::string> showCached_();
+
+	std::optional<std::string> _cachedContent;
 };
 
 struct SuperBlock final : FsSuperblock {
@@ -117,7 +152,7 @@ public:
 			rename(FsLink *source, FsNode *directory, std::string name) override;
 };
 
-struct DirectoryNode final : FsNode, std::enable_shared_from_this<DirectoryNode> {
+struct DirectoryNode final : FsNode, PseudoInode, std::enable_shared_from_this<DirectoryNode> {
 	friend struct DirectoryFile;
 
 	static std::shared_ptr<Link> createRootDirectory();
@@ -149,7 +184,7 @@ private:
 	std::set<std::shared_ptr<Link>, LinkCompare> _entries;
 };
 
-struct SelfLink final : FsNode, std::enable_shared_from_this<SelfLink> {
+struct SelfLink final : FsNode, PseudoInode, std::enable_shared_from_this<SelfLink> {
 	SelfLink() = default;
 
 	async::result<frg::expected<Error, FileStats>> getStats() override;
@@ -157,7 +192,7 @@ struct SelfLink final : FsNode, std::enable_shared_from_this<SelfLink> {
 	expected<std::string> readSymlink(FsLink *link, Process *process) override;
 };
 
-struct SelfThreadLink final : FsNode, std::enable_shared_from_this<SelfThreadLink> {
+struct SelfThreadLink final : FsNode, PseudoInode, std::enable_shared_from_this<SelfThreadLink> {
 	SelfThreadLink() = default;
 
 	async::result<frg::expected<Error, FileStats>> getStats() override;
@@ -165,7 +200,7 @@ struct SelfThreadLink final : FsNode, std::enable_shared_from_this<SelfThreadLin
 	expected<std::string> readSymlink(FsLink *link, Process *process) override;
 };
 
-struct ExeLink final : FsNode, std::enable_shared_from_this<ExeLink> {
+struct ExeLink final : FsNode, PseudoInode, std::enable_shared_from_this<ExeLink> {
 	ExeLink(Process *process)
 	: _process(process)
 	{ }
@@ -177,7 +212,7 @@ private:
 	Process *_process;
 };
 
-struct RootLink final : FsNode, std::enable_shared_from_this<RootLink> {
+struct RootLink final : FsNode, PseudoInode, std::enable_shared_from_this<RootLink> {
 	RootLink(Process *process)
 	: _process(process)
 	{ }
@@ -189,7 +224,7 @@ private:
 	Process *_process;
 };
 
-struct CwdLink final : FsNode, std::enable_shared_from_this<CwdLink> {
+struct CwdLink final : FsNode, PseudoInode, std::enable_shared_from_this<CwdLink> {
 	CwdLink(Process *process)
 	: _process(process)
 	{ }
@@ -208,6 +243,12 @@ struct MapNode final : RegularNode {
 
 	async::result<std::string> show() override;
 	async::result<void> store(std::string) override;
+
+	bool streaming() override {
+		return true;
+	}
+
+	async::result<bool> showRecord(uint64_t &pos, std::string &out) override;
 private:
 	Process *_process;
 };
@@ -224,6 +265,10 @@ struct OstypeNode final : RegularNode {
 
 	async::result<std::string> show() override;
 	async::result<void> store(std::string) override;
+
+	bool immutable() override {
+		return true;
+	}
 };
 
 struct OsreleaseNode final : RegularNode {
@@ -231,6 +276,10 @@ struct OsreleaseNode final : RegularNode {
 
 	async::result<std::string> show() override;
 	async::result<void> store(std::string) override;
+
+	bool immutable() override {
+		return true;
+	}
 };
 
 struct ArchNode final : RegularNode {
@@ -238,6 +287,10 @@ struct ArchNode final : RegularNode {
 
 	async::result<std::string> show() override;
 	async::result<void> store(std::string) override;
+
+	bool immutable() override {
+		return true;
+	}
 };
 
 struct CommNode final : RegularNode {
@@ -273,6 +326,32 @@ private:
         Process *_process;
 };
 
+struct SchedstatNode final : RegularNode {
+	SchedstatNode(Process *process)
+	: _process(process)
+	{ }
+
+	async::result<std::string> show() override;
+	async::result<void> store(std::string) override;
+private:
+	Process *_process;
+};
+
+// System-wide /proc/stat.
+struct SystemStatNode final : RegularNode {
+	SystemStatNode() {}
+
+	async::result<std::string> show() override;
+	async::result<void> store(std::string) override;
+};
+
+struct InterruptsNode final : RegularNode {
+	InterruptsNode() {}
+
+	async::result<std::string> show() override;
+	async::result<void> store(std::string) override;
+};
+
 struct StatusNode final : RegularNode {
 	StatusNode(Process *process)
 	: _process(process)
@@ -1690,6 +1690,12 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				continue;
 			}
 
+			if(req->flags() & managarm::posix::OpenFlags::OF_PATH) {
+				file->setAccessMode(false, false);
+			}else if(semantic_flags & (semanticRead | semanticWrite)) {
+				file->setAccessMode(semantic_flags & semanticRead, semantic_flags & semanticWrite);
+			}
+
 			if(file->isTerminal() &&
 				!(req->flags() & managarm::posix::OpenFlags::OF_NOCTTY) &&
 				self->pgPointer()->getSession()->getSessionId() == (pid_t)self->pid() &&
@@ -1707,12 +1713,16 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				auto result = co_await file->truncate(0);
 				assert(result || result.error() == protocols::fs::Error::illegalOperationTarget);
 			}
-			int fd = self->fileContext()->attachFile(file,
+			auto fd = self->fileContext()->attachFile(file,
 					req->flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+			if(!fd) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+			resp.set_fd(fd.value());
 
 			auto [sendResp] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -1782,14 +1792,18 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				continue;
 			}
 
-			int newfd = self->fileContext()->attachFile(file,
+			auto newfd = self->fileContext()->attachFile(file,
 					req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+			if(!newfd) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
 			helix::SendBuffer send_resp;
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(newfd);
+			resp.set_fd(newfd.value());
 
 			auto ser = resp.SerializeAsString();
 			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
@@ -1802,7 +1816,8 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			auto file = self->fileContext()->getFile(req.fd());
 
-			if (!file || req.newfd() < 0) {
+			if (!file || req.newfd() < 0
+					|| req.newfd() >= FileContext::maxFileDescriptors) {
 				helix::SendBuffer send_resp;
 
 				managarm::posix::SvrResponse resp;
@@ -1830,7 +1845,11 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				continue;
 			}
 
-			self->fileContext()->attachFile(req.newfd(), file);
+			// Like on Linux, FDs beyond the limit are invalid.
+			if(self->fileContext()->attachFile(req.newfd(), file) != Error::success) {
+				co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
+				continue;
+			}
 
 			helix::SendBuffer send_resp;
 
@@ -2185,6 +2204,8 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					std::cout << "\e[31mposix: Ignoring SA_NOCLDSTOP\e[39m" << std::endl;
 
 				saved_handler = self->signalContext()->changeHandler(req.sig_number(), handler);
+				// Other threads that share the handlers refresh their tables lazily.
+				self->signalContext()->updateKernelTable(self.get());
 			}else{
 				saved_handler = self->signalContext()->getHandler(req.sig_number());
 			}
@@ -2233,13 +2254,22 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			auto pair = fifo::createPair(nonBlock);
 			auto r_fd = self->fileContext()->attachFile(std::get<0>(pair),
 					req.flags() & O_CLOEXEC);
+			if(!r_fd) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 			auto w_fd = self->fileContext()->attachFile(std::get<1>(pair),
 					req.flags() & O_CLOEXEC);
+			if(!w_fd) {
+				self->fileContext()->closeFile(r_fd.value());
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.add_fds(r_fd);
-			resp.add_fds(w_fd);
+			resp.add_fds(r_fd.value());
+			resp.add_fds(w_fd.value());
 
 			auto ser = resp.SerializeAsString();
 			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
@@ -2315,8 +2345,12 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			auto fd = self->fileContext()->attachFile(file,
 					req->flags() & SOCK_CLOEXEC);
+			if(!fd) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
-			resp.set_fd(fd);
+			resp.set_fd(fd.value());
 
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -2364,13 +2398,22 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			auto pair = un_socket::createSocketPair(self.get());
 			auto fd0 = self->fileContext()->attachFile(std::get<0>(pair),
 					req->flags() & SOCK_CLOEXEC);
+			if(!fd0) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 			auto fd1 = self->fileContext()->attachFile(std::get<1>(pair),
 					req->flags() & SOCK_CLOEXEC);
+			if(!fd1) {
+				self->fileContext()->closeFile(fd0.value());
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.add_fds(fd0);
-			resp.add_fds(fd1);
+			resp.add_fds(fd0.value());
+			resp.add_fds(fd1.value());
 
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -2403,10 +2446,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			}
 			auto newfile = newfileResult.value();
 			auto fd = self->fileContext()->attachFile(std::move(newfile));
+			if(!fd) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+			resp.set_fd(fd.value());
 
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -2526,10 +2573,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			auto file = epoll::createFile();
 			auto fd = self->fileContext()->attachFile(file,
 					req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+			if(!fd) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+			resp.set_fd(fd.value());
 
 			auto ser = resp.SerializeAsString();
 			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
@@ -2681,10 +2732,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			auto file = timerfd::createFile(req.flags() & TFD_NONBLOCK);
 			auto fd = self->fileContext()->attachFile(file, req.flags() & TFD_CLOEXEC);
+			if(!fd) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+			resp.set_fd(fd.value());
 
 			auto ser = resp.SerializeAsString();
 			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
@@ -2727,10 +2782,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					req.flags() & managarm::posix::OpenFlags::OF_NONBLOCK);
 			auto fd = self->fileContext()->attachFile(file,
 					req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+			if(!fd) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+			resp.set_fd(fd.value());
 
 			auto ser = resp.SerializeAsString();
 			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
@@ -2753,10 +2812,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			auto file = inotify::createFile();
 			auto fd = self->fileContext()->attachFile(file,
 					req->flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+			if(!fd) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+			resp.set_fd(fd.value());
 
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -2841,9 +2904,12 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				auto file = eventfd::createFile(req->initval(), req->flags() & managarm::posix::OpenFlags::OF_NONBLOCK);
 				auto fd = self->fileContext()->attachFile(file,
 						req->flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
-
-				resp.set_error(managarm::posix::Errors::SUCCESS);
-				resp.set_fd(fd);
+				if(fd) {
+					resp.set_error(managarm::posix::Errors::SUCCESS);
+					resp.set_fd(fd.value());
+				}else{
+					resp.set_error(managarm::posix::Errors::TOO_MANY_FILES);
+				}
 			}
 
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(
@@ -3160,10 +3226,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				flags |= managarm::posix::OpenFlags::OF_CLOEXEC;
 			}
 
-			int fd = self->fileContext()->attachFile(file, flags);
+			auto fd = self->fileContext()->attachFile(file, flags);
+			if(!fd) {
+				co_await sendErrorResponse(managarm::posix::Errors::TOO_MANY_FILES);
+				continue;
+			}
 
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+			resp.set_fd(fd.value());
 
 			auto [sendResp] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -3271,6 +3341,103 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				helix_ng::sendBuffer(affinity.data(), affinity.size())
 			);
 			HEL_CHECK(sendResp.error());
+		}else if(preamble.id() == managarm::posix::CopyFileRangeRequest::message_id) {
+			auto req = bragi::parse_head_only<managarm::posix::CopyFileRangeRequest>(recv_head);
+
+			if (!req) {
+				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				break;
+			}
+
+			if(logRequests)
+				std::cout << "posix: COPY_FILE_RANGE " << req->in_fd() << " -> " << req->out_fd()
+						<< " (size: " << req->size() << ")" << std::endl;
+
+			auto inFile = self->fileContext()->getFile(req->in_fd());
+			auto outFile = self->fileContext()->getFile(req->out_fd());
+			if(!inFile || !outFile) {
+				co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
+				continue;
+			}
+
+			// Like on Linux, the descriptors must be open for reading and writing, respectively.
+			if(!inFile->isReadable() || !outFile->isWritable()) {
+				co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
+				continue;
+			}
+
+			// We copy from the memory object of the input file; this requires a regular file
+			// whose contents live in memory (unlike, e.g., files in procfs or sysfs).
+			auto inLink = inFile->associatedLink();
+			if(!inLink || inLink->getTarget()->getType() != VfsType::regular
+					|| !inFile->isMemoryBacked()) {
+				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+				continue;
+			}
+
+			auto statsResult = co_await inLink->getTarget()->getStats();
+			if(!statsResult) {
+				co_await sendErrorResponse(managarm::posix::Errors::INTERNAL_ERROR);
+				continue;
+			}
+
+			int64_t inOffset = req->in_offset();
+			if(inOffset < 0) {
+				auto seekResult = co_await inFile->seek(0, VfsSeek::relative);
+				if(!seekResult) {
+					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+					continue;
+				}
+				inOffset = seekResult.value();
+			}
+
+			// Copies stop at the end of the input file.
+			size_t fileSize = statsResult.value().fileSize;
+			size_t size = 0;
+			if(static_cast<uint64_t>(inOffset) < fileSize)
+				size = std::min(static_cast<uint64_t>(req->size()), fileSize - inOffset);
+
+			size_t copied = 0;
+			if(size) {
+				// The server of the output file maps the memory (i.e., the page cache of the
+				// input file) directly; this includes the case that both files are on the same server.
+				// The write is performed on behalf of the calling process; this matters
+				// for permission checks and for files that are served by posix itself.
+				auto memory = co_await inFile->accessMemory();
+				auto copyResult = co_await protocols::fs::writeFromMemory(
+						outFile->getPassthroughLane(), memory, inOffset, size, req->out_offset(),
+						self->threadDescriptor());
+				if(!copyResult) {
+					auto error = copyResult.error();
+					if(error == protocols::fs::Error::wouldBlock) {
+						co_await sendErrorResponse(managarm::posix::Errors::WOULD_BLOCK);
+					}else if(error == protocols::fs::Error::brokenPipe) {
+						co_await sendErrorResponse(managarm::posix::Errors::BROKEN_PIPE);
+					}else if(error == protocols::fs::Error::illegalOperationTarget) {
+						co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_OPERATION_TARGET);
+					}else if(error == protocols::fs::Error::illegalArguments) {
+						co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+					}else{
+						std::cout << "posix: Unexpected error from writeFromMemory()" << std::endl;
+						co_await sendErrorResponse(managarm::posix::Errors::INTERNAL_ERROR);
+					}
+					continue;
+				}
+				copied = copyResult.value();
+			}
+
+			if(req->in_offset() < 0 && copied)
+				co_await inFile->seek(inOffset + copied, VfsSeek::absolute);
+
+			managarm::posix::SvrResponse resp;
+			resp.set_error(managarm::posix::Errors::SUCCESS);
+			resp.set_size(copied);
+
+			auto [sendResp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+			);
+			HEL_CHECK(sendResp.error());
 		}else{
 			std::cout << "posix: Illegal request" << std::endl;
 			helix::SendBuffer send_resp;
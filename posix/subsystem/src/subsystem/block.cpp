@@ -80,7 +80,9 @@ struct ReadOnlyAttribute : sysfs::Attribute {
 
 struct DevAttribute : sysfs::Attribute {
 	DevAttribute(std::string name)
-	: sysfs::Attribute{std::move(name), false} { }
+	: sysfs::Attribute{std::move(name), false} {
+		_immutable = true;
+	}
 
 	async::result<frg::expected<Error, std::string>> show(sysfs::Object *object) override;
 };
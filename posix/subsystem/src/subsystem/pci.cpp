@@ -23,14 +23,18 @@ async::recurring_event mbusMapAddition;
 
 struct VendorAttribute : sysfs::Attribute {
 	VendorAttribute(std::string name)
-	: sysfs::Attribute{std::move(name), false} { }
+	: sysfs::Attribute{std::move(name), false} {
+		_immutable = true;
+	}
 
 	async::result<frg::expected<Error, std::string>> show(sysfs::Object *object) override;
 };
 
 struct DeviceAttribute : sysfs::Attribute {
 	DeviceAttribute(std::string name)
-	: sysfs::Attribute{std::move(name), false} { }
+	: sysfs::Attribute{std::move(name), false} {
+		_immutable = true;
+	}
 
 	async::result<frg::expected<Error, std::string>> show(sysfs::Object *object) override;
 };
@@ -44,14 +48,18 @@ struct PlainfbAttribute : sysfs::Attribute {
 
 struct SubsystemVendorAttribute : sysfs::Attribute {
 	SubsystemVendorAttribute(std::string name)
-	: sysfs::Attribute{std::move(name), false} { }
+	: sysfs::Attribute{std::move(name), false} {
+		_immutable = true;
+	}
 
 	async::result<frg::expected<Error, std::string>> show(sysfs::Object *object) override;
 };
 
 struct SubsystemDeviceAttribute : sysfs::Attribute {
 	SubsystemDeviceAttribute(std::string name)
-	: sysfs::Attribute{std::move(name), false} { }
+	: sysfs::Attribute{std::move(name), false} {
+		_immutable = true;
+	}
 
 	async::result<frg::expected<Error, std::string>> show(sysfs::Object *object) override;
 };
@@ -83,7 +91,9 @@ struct ResourceNAttribute : sysfs::Attribute {
 
 struct ClassAttribute : sysfs::Attribute {
 	ClassAttribute(std::string name)
-	: sysfs::Attribute{std::move(name), false} { }
+	: sysfs::Attribute{std::move(name), false} {
+		_immutable = true;
+	}
 
 	async::result<frg::expected<Error, std::string>> show(sysfs::Object *object) override;
 };
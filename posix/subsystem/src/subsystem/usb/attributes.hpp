@@ -6,14 +6,18 @@ namespace usb_subsystem {
 
 struct VendorAttribute : sysfs::Attribute {
 	VendorAttribute(std::string name)
-	: sysfs::Attribute{std::move(name), false} { }
+	: sysfs::Attribute{std::move(name), false} {
+		_immutable = true;
+	}
 
 	async::result<frg::expected<Error, std::string>> show(sysfs::Object *object) override;
 };
 
 struct DeviceAttribute : sysfs::Attribute {
 	DeviceAttribute(std::string name)
-	: sysfs::Attribute{std::move(name), false} { }
+	: sysfs::Attribute{std::move(name), false} {
+		_immutable = true;
+	}
 
 	async::result<frg::expected<Error, std::string>> show(sysfs::Object *object) override;
 };
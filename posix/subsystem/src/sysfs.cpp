@@ -61,7 +61,6 @@ void AttributeFile::handleClose() {
 
 async::result<frg::expected<Error, off_t>> AttributeFile::seek(off_t offset, VfsSeek whence) {
 	// TODO: it's unclear whether we should allow seeks past the end.
-	// TODO: re-cache the file for seeks to zero.
 	if(whence == VfsSeek::relative)
 		_offset = _offset + offset;
 	else if(whence == VfsSeek::absolute)
@@ -86,9 +85,10 @@ async::result<frg::expected<Error, size_t>>
 AttributeFile::pread(Process *, int64_t offset, void *buffer, size_t length) {
 	assert(length > 0);
 
-	if(!_cached) {
+	// Like Linux, regenerate the content whenever a read starts at offset zero.
+	if(!_cached || !offset) {
 		auto node = static_cast<AttributeNode *>(associatedLink()->getTarget().get());
-		if(auto res = co_await node->_attr->show(node->_object); res) {
+		if(auto res = co_await node->show_(); res) {
 			_buffer = res.value();
 			_cached = true;
 		} else
@@ -157,14 +157,18 @@ async::result<frg::expected<Error, off_t>> DirectoryFile::seek(off_t, VfsSeek) {
 }
 
 // TODO: This iteration mechanism only works as long as _iter is not concurrently deleted.
-async::result<ReadEntriesResult> DirectoryFile::readEntries() {
-	if(_iter != _node->_entries.end()) {
+async::result<ReadEntriesResult> DirectoryFile::readEntries(size_t max_size) {
+	protocols::fs::EntriesBuilder builder{max_size};
+	while(_iter != _node->_entries.end()) {
 		auto name = (*_iter)->getName();
+		if(!builder.fits(name))
+			break;
+
+		builder.add(std::move(name), (*_iter)->inodeNumber(),
+				direntType((*_iter)->getTarget()->getType()));
 		_iter++;
-		co_return name;
-	}else{
-		co_return std::nullopt;
 	}
+	co_return builder.entries();
 }
 
 helix::BorrowedDescriptor DirectoryFile::getPassthroughLane() {
@@ -176,10 +180,11 @@ helix::BorrowedDescriptor DirectoryFile::getPassthroughLane() {
 // ----------------------------------------------------------------------------
 
 Link::Link(std::shared_ptr<FsNode> target)
-: _target{std::move(target)} { }
+: _target{std::move(target)}, _inodeNumber{PseudoInode::of(_target.get())} { }
 
 Link::Link(std::shared_ptr<FsNode> owner, std::string name, std::shared_ptr<FsNode> target)
-: _owner{std::move(owner)}, _name{std::move(name)}, _target{std::move(target)} {
+: _owner{std::move(owner)}, _name{std::move(name)}, _target{std::move(target)},
+		_inodeNumber{PseudoInode::of(_target.get())} {
 	assert(_owner);
 	assert(!_name.empty());
 }
@@ -214,7 +219,7 @@ async::result<frg::expected<Error, FileStats>> AttributeNode::getStats() {
 	auto now = clk::getRealtime();
 
 	FileStats stats;
-	stats.inodeNumber = 0; // FIXME
+	stats.inodeNumber = inodeNumber();
 	stats.numLinks = 1;
 	stats.fileSize = _attr->size();
 	stats.mode = _attr->writable() ? 0666 : 0444; // TODO: Some files can be written.
@@ -229,6 +234,15 @@ async::result<frg::expected<Error, FileStats>> AttributeNode::getStats() {
 	co_return stats;
 }
 
+async::result<frg::expected<Error, std::string>> AttributeNode::show_() {
+	if(!_attr->immutable())
+		co_return co_await _attr->show(_object);
+
+	if(!_cachedContent)
+		_cachedContent = FRG_CO_TRY(co_await _attr->show(_object));
+	co_return *_cachedContent;
+}
+
 async::result<frg::expected<Error, smarter::shared_ptr<File, FileHandle>>>
 AttributeNode::open(std::shared_ptr<MountView> mount,
 		std::shared_ptr<FsLink> link, SemanticFlags semantic_flags) {
@@ -259,7 +273,9 @@ VfsType SymlinkNode::getType() {
 
 async::result<frg::expected<Error, FileStats>> SymlinkNode::getStats() {
 	std::cout << "\e[31mposix: Fix sysfs SymlinkNode::getStats()\e[39m" << std::endl;
-	co_return FileStats{};
+	FileStats stats{};
+	stats.inodeNumber = inodeNumber();
+	co_return stats;
 }
 
 expected<std::string> SymlinkNode::readSymlink(FsLink *link, Process *process) {
@@ -341,7 +357,9 @@ VfsType DirectoryNode::getType() {
 
 async::result<frg::expected<Error, FileStats>> DirectoryNode::getStats() {
 	std::cout << "\e[31mposix: Fix sysfs Directory::getStats()\e[39m" << std::endl;
-	co_return FileStats{};
+	FileStats stats{};
+	stats.inodeNumber = inodeNumber();
+	co_return stats;
 }
 
 std::shared_ptr<FsLink> DirectoryNode::treeLink() {
@@ -69,7 +69,7 @@ public:
 
 	void handleClose() override;
 
-	FutureMaybe<ReadEntriesResult> readEntries() override;
+	FutureMaybe<ReadEntriesResult> readEntries(size_t max_size) override;
 	helix::BorrowedDescriptor getPassthroughLane() override;
 	async::result<frg::expected<Error, off_t>> seek(off_t offset, VfsSeek whence) override;
 
@@ -93,13 +93,19 @@ struct Link final : FsLink, std::enable_shared_from_this<Link> {
 	std::string getName() override;
 	std::shared_ptr<FsNode> getTarget() override;
 
+	// Inode number of the target; cached so that readEntries() does not need to stat.
+	int64_t inodeNumber() {
+		return _inodeNumber;
+	}
+
 private:
 	std::shared_ptr<FsNode> _owner;
 	std::string _name;
 	std::shared_ptr<FsNode> _target;
+	int64_t _inodeNumber;
 };
 
-struct AttributeNode final : FsNode, std::enable_shared_from_this<AttributeNode> {
+struct AttributeNode final : FsNode, PseudoInode, std::enable_shared_from_this<AttributeNode> {
 	friend struct AttributeFile;
 
 	AttributeNode(Object *object, Attribute *attr);
@@ -111,11 +117,16 @@ struct AttributeNode final : FsNode, std::enable_shared_from_this<AttributeNode>
 			SemanticFlags semantic_flags) override;
 
 private:
+	async::result<frg::expected<Error, std::string>> show_();
+
 	Object *_object;
 	Attribute *_attr;
+
+	// See Attribute::immutable().
+	std::optional<std::string> _cachedContent;
 };
 
-struct SymlinkNode final : FsNode, std::enable_shared_from_this<SymlinkNode> {
+struct SymlinkNode final : FsNode, PseudoInode, std::enable_shared_from_this<SymlinkNode> {
 	SymlinkNode(std::weak_ptr<Object> target);
 
 	VfsType getType() override;
@@ -126,7 +137,7 @@ private:
 	std::weak_ptr<Object> _target;
 };
 
-struct DirectoryNode final : FsNode, std::enable_shared_from_this<DirectoryNode> {
+struct DirectoryNode final : FsNode, PseudoInode, std::enable_shared_from_this<DirectoryNode> {
 	friend struct DirectoryFile;
 
 	static std::shared_ptr<Link> createRootDirectory();
@@ -175,12 +186,19 @@ public:
 		return _size;
 	}
 
+	// Immutable attributes are only shown once per object;
+	// the result is cached and shared by all readers.
+	bool immutable() {
+		return _immutable;
+	}
+
 	virtual async::result<frg::expected<Error, std::string>> show(Object *object) = 0;
 	virtual async::result<Error> store(Object *object, std::string data);
 	virtual async::result<frg::expected<Error, helix::UniqueDescriptor>> accessMemory(Object *object);
 
 protected:
 	size_t _size = 4096;
+	bool _immutable = false;
 private:
 	const std::string _name;
 	bool _writable;
@@ -25,6 +25,9 @@ namespace {
 
 struct Superblock;
 
+// Source of MemoryNode generations; values are never reused.
+uint64_t generationCounter = 0;
+
 struct Node : FsNode {
 	Node(Superblock *superblock, FsNode::DefaultOps default_ops = 0);
 
@@ -244,7 +247,7 @@ public:
 
 	void handleClose() override;
 
-	FutureMaybe<ReadEntriesResult> readEntries() override;
+	FutureMaybe<ReadEntriesResult> readEntries(size_t max_size) override;
 	helix::BorrowedDescriptor getPassthroughLane() override;
 
 private:
@@ -414,6 +417,10 @@ public:
 
 	FutureMaybe<helix::UniqueDescriptor> accessMemory() override;
 
+	bool isMemoryBacked() override {
+		return true;
+	}
+
 	helix::BorrowedDescriptor getPassthroughLane() override {
 		return _passthrough;
 	}
@@ -465,10 +472,16 @@ struct MemoryNode final : Node {
 		stats.mtimeNanos = mtime().tv_nsec;
 		stats.ctimeSecs = ctime().tv_sec;
 		stats.ctimeNanos = ctime().tv_nsec;
+		stats.generation = _generation;
 		co_return stats;
 	}
 
 private:
+	// Called whenever the contents are written or truncated.
+	void _bumpGeneration() {
+		_generation = ++generationCounter;
+	}
+
 	void _resizeFile(size_t new_size) {
 		_fileSize = new_size;
 
@@ -492,6 +505,7 @@ private:
 	helix::Mapping _mapping;
 	size_t _areaSize;
 	size_t _fileSize;
+	uint64_t _generation = ++generationCounter;
 };
 
 struct Superblock final : FsSuperblock {
@@ -582,6 +596,7 @@ MemoryFile::writeAll(Process *, const void *buffer, size_t length) {
 		node->_resizeFile(_offset + length);
 
 	memcpy(reinterpret_cast<char *>(node->_mapping.get()) + _offset, buffer, length);
+	node->_bumpGeneration();
 	_offset += length;
 	co_return length;
 }
@@ -607,6 +622,7 @@ MemoryFile::pwrite(Process *, int64_t offset, const void *buffer, size_t length)
 		node->_resizeFile(offset + length);
 
 	memcpy(reinterpret_cast<char *>(node->_mapping.get()) + offset, buffer, length);
+	node->_bumpGeneration();
 	co_return length;
 }
 
@@ -615,6 +631,7 @@ MemoryFile::truncate(size_t size) {
 	auto node = static_cast<MemoryNode *>(associatedLink()->getTarget().get());
 
 	node->_resizeFile(size);
+	node->_bumpGeneration();
 	co_return {};
 }
 
@@ -628,6 +645,7 @@ MemoryFile::allocate(int64_t offset, size_t size) {
 	if(offset + size <= node->_fileSize)
 		co_return {};
 	node->_resizeFile(offset + size);
+	node->_bumpGeneration();
 	co_return {};
 }
 
@@ -666,14 +684,20 @@ DirectoryFile::DirectoryFile(std::shared_ptr<MountView> mount, std::shared_ptr<F
 
 // TODO: This iteration mechanism only works as long as _iter is not concurrently deleted.
 async::result<ReadEntriesResult>
-DirectoryFile::readEntries() {
-	if(_iter != _node->_entries.end()) {
+DirectoryFile::readEntries(size_t max_size) {
+	protocols::fs::EntriesBuilder builder{max_size};
+	while(_iter != _node->_entries.end()) {
 		auto name = (*_iter)->getName();
+		if(!builder.fits(name))
+			break;
+
+		auto target = (*_iter)->getTarget();
+		auto node = dynamic_cast<Node *>(target.get());
+		builder.add(std::move(name), node ? node->inodeNumber() : 0,
+				direntType(target->getType()));
 		_iter++;
-		co_return name;
-	}else{
-		co_return std::nullopt;
 	}
+	co_return builder.entries();
 }
 
 helix::BorrowedDescriptor DirectoryFile::getPassthroughLane() {
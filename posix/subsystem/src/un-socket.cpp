@@ -190,13 +190,27 @@ public:
 			ctrl.write<struct ucred>(creds);
 		}
 
+		uint32_t replyFlags = 0;
 		if(!packet->files.empty()) {
-			if(ctrl.message(SOL_SOCKET, SCM_RIGHTS, sizeof(int) * packet->files.size())) {
-				for(auto &file : packet->files)
-					ctrl.write<int>(process->fileContext()->attachFile(std::move(file),
-							flags & MSG_CMSG_CLOEXEC));
-			}else{
-				throw std::runtime_error("posix: CMSG truncation is not implemented");
+			// Like Linux, pass as many files as there are free FDs and drop the rest.
+			std::vector<int> fds;
+			for(auto &file : packet->files) {
+				auto fd = process->fileContext()->attachFile(std::move(file),
+						flags & MSG_CMSG_CLOEXEC);
+				if(!fd) {
+					replyFlags |= MSG_CTRUNC;
+					break;
+				}
+				fds.push_back(fd.value());
+			}
+
+			if(!fds.empty()) {
+				if(ctrl.message(SOL_SOCKET, SCM_RIGHTS, sizeof(int) * fds.size())) {
+					for(auto fd : fds)
+						ctrl.write<int>(fd);
+				}else{
+					throw std::runtime_error("posix: CMSG truncation is not implemented");
+				}
 			}
 
 			packet->files.clear();
@@ -209,7 +223,7 @@ public:
 
 		if(packet->offset == packet->buffer.size())
 			_recvQueue.pop_front();
-		co_return protocols::fs::RecvData{ctrl.buffer(), chunk, 0, 0};
+		co_return protocols::fs::RecvData{ctrl.buffer(), chunk, 0, replyFlags};
 	}
 
 	async::result<frg::expected<protocols::fs::Error, size_t>>
@@ -24,7 +24,28 @@ std::ostream& operator<<(std::ostream& os, const Error& err) {
 		case Error::noSpaceLeft: err_string = "noSpaceLeft"; break;
 		case Error::isDirectory: err_string = "isDirectory"; break;
 		case Error::noMemory: err_string = "noMemory"; break;
+		case Error::tooManyFiles: err_string = "tooManyFiles"; break;
 	}
 
 	return os << err_string;
 }
+
+Error fromFsError(protocols::fs::Error err) {
+	switch(err) {
+		case protocols::fs::Error::fileNotFound: return Error::noSuchFile;
+		case protocols::fs::Error::endOfFile: return Error::eof;
+		case protocols::fs::Error::wouldBlock: return Error::wouldBlock;
+		case protocols::fs::Error::seekOnPipe: return Error::seekOnPipe;
+		case protocols::fs::Error::brokenPipe: return Error::brokenPipe;
+		case protocols::fs::Error::accessDenied: return Error::accessDenied;
+		case protocols::fs::Error::notDirectory: return Error::notDirectory;
+		case protocols::fs::Error::insufficientPermissions: return Error::insufficientPermissions;
+		case protocols::fs::Error::notConnected: return Error::notConnected;
+		case protocols::fs::Error::alreadyExists: return Error::alreadyExists;
+		case protocols::fs::Error::illegalOperationTarget: return Error::illegalOperationTarget;
+		case protocols::fs::Error::noSpaceLeft: return Error::noSpaceLeft;
+		case protocols::fs::Error::noBackingDevice: return Error::noBackingDevice;
+		case protocols::fs::Error::isDirectory: return Error::isDirectory;
+		default: return Error::illegalArguments;
+	}
+}
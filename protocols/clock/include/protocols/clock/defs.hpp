@@ -8,4 +8,62 @@ struct TrackerPage {
 	int32_t padding;
 	int64_t refClock;
 	int64_t baseRealtime;
+
+	// Calibration of the CPU's cycle counter against the system clock (see helGetClock()).
+	// At cycle counter value c, the clock is cycleRefClock + ((c - cycleRefCycles) * cycleMult) >> 32.
+	// If cycleMult is zero, the cycle counter cannot be used.
+	uint64_t cycleRefCycles;
+	int64_t cycleRefClock;
+	uint64_t cycleMult;
 };
+
+namespace protocols::clock {
+
+// Reads the CPU's cycle counter. Returns false if it cannot be read from userspace.
+inline bool readCycleCounter(uint64_t &cycles) {
+#if defined(__x86_64__)
+	cycles = __builtin_ia32_rdtsc();
+	return true;
+#else
+	(void)cycles;
+	return false;
+#endif
+}
+
+// Reads the system clock through the tracker page, without entering the kernel.
+// Returns false if the page does not provide a calibration of the cycle counter;
+// callers should fall back to helGetClock() in that case.
+inline bool readClock(TrackerPage *page, uint64_t &now) {
+	uint64_t refCycles, mult;
+	int64_t refClock;
+	while(true) {
+		// Start the seqlock read.
+		auto seqlock = __atomic_load_n(&page->seqlock, __ATOMIC_ACQUIRE);
+		if(seqlock & 1)
+			continue;
+
+		// Perform the actual loads.
+		refCycles = __atomic_load_n(&page->cycleRefCycles, __ATOMIC_RELAXED);
+		refClock = __atomic_load_n(&page->cycleRefClock, __ATOMIC_RELAXED);
+		mult = __atomic_load_n(&page->cycleMult, __ATOMIC_RELAXED);
+
+		// Finish the seqlock read.
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(__atomic_load_n(&page->seqlock, __ATOMIC_RELAXED) == seqlock)
+			break;
+	}
+
+	uint64_t cycles;
+	if(!mult || !readCycleCounter(cycles))
+		return false;
+
+	// Counters of different CPUs can be slightly out of sync; never go below the reference.
+	auto delta = static_cast<int64_t>(cycles - refCycles);
+	if(delta < 0)
+		delta = 0;
+	now = refClock + static_cast<uint64_t>(
+			(static_cast<unsigned __int128>(delta) * mult) >> 32);
+	return true;
+}
+
+} // namespace protocols::clock
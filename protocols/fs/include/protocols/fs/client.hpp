@@ -3,6 +3,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <unordered_map>
 
 #include <async/result.hpp>
@@ -10,7 +11,9 @@
 #include <boost/variant.hpp>
 #include <frg/expected.hpp>
 #include <helix/ipc.hpp>
+#include <helix/memory.hpp>
 #include <protocols/fs/common.hpp>
+#include <protocols/fs/defs.hpp>
 
 // EVENTUALLY: use std::variant instead of boost::variant!
 
@@ -27,10 +30,18 @@ struct File {
 	}
 
 	async::result<void> seekAbsolute(int64_t offset);
+	// Returns the new file position.
+	async::result<int64_t> seekRelative(int64_t offset);
 
 	async::result<size_t> readSome(void *data, size_t max_length);
 	async::result<size_t> writeSome(const void *data, size_t max_length);
 
+	// Vectored I/O in a single request. Negative offsets use the file position.
+	async::result<frg::expected<Error, size_t>> readVector(const struct iovec *iov, int iovcnt,
+			int64_t offset = -1);
+	async::result<frg::expected<Error, size_t>> writeVector(const struct iovec *iov, int iovcnt,
+			int64_t offset = -1);
+
 	async::result<frg::expected<Error, PollWaitResult>>
 	pollWait(uint64_t sequence, int mask, async::cancellation_token cancellation = {});
 
@@ -39,12 +50,54 @@ struct File {
 
 	async::result<helix::UniqueDescriptor> accessMemory();
 
+	// Returns the memory of the file's status page (see StatusPageView).
+	async::result<frg::expected<Error, helix::UniqueDescriptor>> accessStatusPage();
+
+	// Returns as many entries as fit into a getdents64() buffer of max_size bytes.
+	// An empty vector indicates the end of the directory.
+	async::result<frg::expected<Error, ReadEntriesResult>> readEntries(size_t max_size);
+
 private:
 	helix::UniqueDescriptor _lane;
 };
 
+// Reader side of a StatusPageProvider.
+struct StatusPageView {
+	StatusPageView() = default;
+
+	StatusPageView(helix::BorrowedDescriptor memory)
+	: _mapping{memory, 0, 0x1000, kHelMapProtRead} { }
+
+	explicit operator bool () {
+		return static_cast<bool>(_mapping);
+	}
+
+	// Returns the same result as a FILE_POLL_STATUS request, without any IPC.
+	// Returns std::nullopt if the page is updated concurrently;
+	// callers should fall back to IPC in this case.
+	std::optional<PollStatusResult> read();
+
+	// Returns the current sequence and the bits that had edges after the given sequence,
+	// i.e., the result of a FILE_POLL_WAIT request that does not need to block.
+	// Returns std::nullopt if the page is updated concurrently.
+	std::optional<PollWaitResult> readEdges(uint64_t sequence);
+
+private:
+	helix::Mapping _mapping;
+};
+
+// Writes size bytes starting at memoryOffset of the given memory object to the file
+// that is served on lane. If offset is negative, the data is written at the file position.
+// Used to copy data between files without mapping it into the caller.
+// The write is performed with the credentials of the given thread.
+async::result<frg::expected<Error, size_t>> writeFromMemory(helix::BorrowedDescriptor lane,
+		helix::BorrowedDescriptor memory, uint64_t memoryOffset, size_t size, int64_t offset,
+		helix::BorrowedDescriptor credentials = helix::BorrowedDescriptor{kHelThisThread});
+
 } // namespace _detail
 
 using _detail::File;
+using _detail::StatusPageView;
+using _detail::writeFromMemory;
 
 } } // namespace protocols::fs
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <dirent.h>
 #include <optional>
+#include <stddef.h>
 #include <string.h>
 #include <string>
 #include <sys/socket.h>
@@ -67,9 +69,79 @@ inline managarm::fs::Errors mapFsError(Error e) {
 	}
 }
 
+inline Error toFsError(managarm::fs::Errors e) {
+	switch(e) {
+		case managarm::fs::Errors::SUCCESS: return Error::none;
+		case managarm::fs::Errors::FILE_NOT_FOUND: return Error::fileNotFound;
+		case managarm::fs::Errors::END_OF_FILE: return Error::endOfFile;
+		case managarm::fs::Errors::ILLEGAL_ARGUMENT: return Error::illegalArguments;
+		case managarm::fs::Errors::WOULD_BLOCK: return Error::wouldBlock;
+		case managarm::fs::Errors::SEEK_ON_PIPE: return Error::seekOnPipe;
+		case managarm::fs::Errors::BROKEN_PIPE: return Error::brokenPipe;
+		case managarm::fs::Errors::ACCESS_DENIED: return Error::accessDenied;
+		case managarm::fs::Errors::NOT_DIRECTORY: return Error::notDirectory;
+		case managarm::fs::Errors::AF_NOT_SUPPORTED: return Error::afNotSupported;
+		case managarm::fs::Errors::DESTINATION_ADDRESS_REQUIRED: return Error::destAddrRequired;
+		case managarm::fs::Errors::NETWORK_UNREACHABLE: return Error::netUnreachable;
+		case managarm::fs::Errors::MESSAGE_TOO_LARGE: return Error::messageSize;
+		case managarm::fs::Errors::HOST_UNREACHABLE: return Error::hostUnreachable;
+		case managarm::fs::Errors::INSUFFICIENT_PERMISSIONS: return Error::insufficientPermissions;
+		case managarm::fs::Errors::ADDRESS_IN_USE: return Error::addressInUse;
+		case managarm::fs::Errors::ADDRESS_NOT_AVAILABLE: return Error::addressNotAvailable;
+		case managarm::fs::Errors::NOT_CONNECTED: return Error::notConnected;
+		case managarm::fs::Errors::ALREADY_EXISTS: return Error::alreadyExists;
+		case managarm::fs::Errors::ILLEGAL_OPERATION_TARGET: return Error::illegalOperationTarget;
+		case managarm::fs::Errors::NO_SPACE_LEFT: return Error::noSpaceLeft;
+		// There is no Error that corresponds to NOT_A_TERMINAL.
+		case managarm::fs::Errors::NOT_A_TERMINAL: return Error::illegalOperationTarget;
+		case managarm::fs::Errors::NO_BACKING_DEVICE: return Error::noBackingDevice;
+		case managarm::fs::Errors::IS_DIRECTORY: return Error::isDirectory;
+	}
+	return Error::illegalArguments;
+}
+
 using ReadResult = std::variant<Error, size_t>;
 
-using ReadEntriesResult = std::optional<std::string>;
+struct DirEntry {
+	std::string name;
+	uint64_t inode;
+	// One of the DT_* constants from <dirent.h>.
+	uint8_t type;
+};
+
+// An empty vector indicates the end of the directory.
+using ReadEntriesResult = std::vector<DirEntry>;
+
+// Number of bytes that an entry occupies in a getdents64() buffer.
+inline size_t direntSize(size_t name_length) {
+	return (offsetof(struct dirent, d_name) + name_length + 1 + 7) & ~size_t(7);
+}
+
+// Helper to implement readEntries(): accepts entries as long as they fit into
+// a getdents64() buffer of the given size. The first entry is always accepted
+// such that callers can make progress.
+struct EntriesBuilder {
+	EntriesBuilder(size_t max_size)
+	: _maxSize{max_size}, _size{0} { }
+
+	bool fits(const std::string &name) {
+		return _entries.empty() || _size + direntSize(name.size()) <= _maxSize;
+	}
+
+	void add(std::string name, uint64_t inode, uint8_t type) {
+		_size += direntSize(name.size());
+		_entries.push_back({std::move(name), inode, type});
+	}
+
+	ReadEntriesResult entries() {
+		return std::move(_entries);
+	}
+
+private:
+	ReadEntriesResult _entries;
+	size_t _maxSize;
+	size_t _size;
+};
 
 using PollResult = std::tuple<uint64_t, int, int>;
 using PollWaitResult = std::tuple<uint64_t, int>;
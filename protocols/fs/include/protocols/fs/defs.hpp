@@ -9,6 +9,8 @@ struct StatusPage {
 	uint64_t sequence;
 	int flags;
 	int status;
+	// For each bit of status, the sequence of the last edge of that bit.
+	uint64_t edgeSequences[32];
 };
 
 } // namespace protocols::fs
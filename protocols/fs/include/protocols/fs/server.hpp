@@ -38,6 +38,8 @@ struct FileStats {
 	struct timespec accessTime;
 	struct timespec dataModifyTime;
 	struct timespec anyChangeTime;
+	// Changes whenever the file contents change; zero if the server does not track this.
+	uint64_t generation = 0;
 };
 
 using SeekResult = std::variant<Error, int64_t>;
@@ -82,7 +84,8 @@ struct FileOperations {
 		pwrite = f;
 		return *this;
 	}
-	constexpr FileOperations &withReadEntries(async::result<ReadEntriesResult> (*f)(void *object)) {
+	constexpr FileOperations &withReadEntries(async::result<ReadEntriesResult> (*f)(void *object,
+			size_t max_size)) {
 		readEntries = f;
 		return *this;
 	}
@@ -145,6 +148,10 @@ struct FileOperations {
 		peername = f;
 		return *this;
 	}
+	constexpr FileOperations &withAccessStatusPage(helix::BorrowedDescriptor (*f)(void *object)) {
+		accessStatusPage = f;
+		return *this;
+	}
 
 	async::result<SeekResult> (*seekAbs)(void *object, int64_t offset);
 	async::result<SeekResult> (*seekRel)(void *object, int64_t offset);
@@ -157,7 +164,9 @@ struct FileOperations {
 			const void *buffer, size_t length);
 	async::result<frg::expected<protocols::fs::Error, size_t>> (*pwrite)(void *object, int64_t offset, const char *credentials,
 			const void *buffer, size_t length);
-	async::result<ReadEntriesResult> (*readEntries)(void *object);
+	// Returns as many entries as fit into a getdents64() buffer of max_size bytes.
+	// Use EntriesBuilder to implement this.
+	async::result<ReadEntriesResult> (*readEntries)(void *object, size_t max_size);
 	async::result<helix::BorrowedDescriptor>(*accessMemory)(void *object);
 	async::result<frg::expected<protocols::fs::Error>> (*truncate)(void *object, size_t size);
 	async::result<frg::expected<protocols::fs::Error>> (*fallocate)(void *object, int64_t offset, size_t size);
@@ -189,6 +198,9 @@ struct FileOperations {
 	async::result<frg::expected<Error, size_t>> (*peername)(void *object, void *addr_ptr, size_t max_addr_length);
 	async::result<frg::expected<Error, int>> (*getSeals)(void *object);
 	async::result<frg::expected<Error, int>> (*addSeals)(void *object, int seals);
+	// Returns the memory of a StatusPageProvider that mirrors pollStatus().
+	// This allows clients to check the poll status without IPC.
+	helix::BorrowedDescriptor (*accessStatusPage)(void *object);
 
 	bool logRequests = false;
 };
@@ -200,7 +212,8 @@ struct StatusPageProvider {
 		return _memory;
 	}
 
-	void update(uint64_t sequence, int status);
+	// edges are the bits that had an edge (in the sense of pollWait()) at sequence.
+	void update(uint64_t sequence, int status, int edges);
 
 private:
 	helix::UniqueDescriptor _memory;
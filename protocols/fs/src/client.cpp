@@ -1,6 +1,8 @@
 
+#include <algorithm>
 #include <iostream>
 
+#include <bragi/helpers-std.hpp>
 #include "fs.bragi.hpp"
 #include "protocols/fs/client.hpp"
 
@@ -36,6 +38,33 @@ async::result<void> File::seekAbsolute(int64_t offset) {
 	assert(resp.error() == managarm::fs::Errors::SUCCESS);
 }
 
+async::result<int64_t> File::seekRelative(int64_t offset) {
+	managarm::fs::CntRequest req;
+	req.set_req_type(managarm::fs::CntReqType::SEEK_REL);
+	req.set_rel_offset(offset);
+
+	auto ser = req.SerializeAsString();
+	uint8_t buffer[128];
+
+	auto [offer, send_req, recv_resp] =
+		co_await helix_ng::exchangeMsgs(
+			_lane,
+			helix_ng::offer(
+				helix_ng::sendBuffer(ser.data(), ser.size()),
+				helix_ng::recvBuffer(buffer, 128)
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_req.error());
+	HEL_CHECK(recv_resp.error());
+
+	managarm::fs::SvrResponse resp;
+	resp.ParseFromArray(buffer, recv_resp.actualLength());
+	assert(resp.error() == managarm::fs::Errors::SUCCESS);
+	co_return resp.offset();
+}
+
 async::result<size_t> File::readSome(void *data, size_t max_length) {
 	managarm::fs::CntRequest req;
 	req.set_req_type(managarm::fs::CntReqType::READ);
@@ -103,6 +132,90 @@ async::result<size_t> File::writeSome(const void *data, size_t maxLength) {
 	co_return resp.size();
 }
 
+async::result<frg::expected<Error, size_t>> File::readVector(const struct iovec *iov, int iovcnt,
+		int64_t offset) {
+	managarm::fs::ReadVectorRequest req;
+	req.set_offset(offset);
+	for(int i = 0; i < iovcnt; i++)
+		req.add_sizes(iov[i].iov_len);
+
+	auto [offer, send_head, send_tail, imbue_creds, recv_resp] =
+		co_await helix_ng::exchangeMsgs(
+			_lane,
+			helix_ng::offer(
+				helix_ng::sendBragiHeadTail(req, frg::stl_allocator{}),
+				helix_ng::imbueCredentials(),
+				helix_ng::recvInline()
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_head.error());
+	HEL_CHECK(send_tail.error());
+	HEL_CHECK(imbue_creds.error());
+	HEL_CHECK(recv_resp.error());
+
+	managarm::fs::SvrResponse resp;
+	resp.ParseFromArray(recv_resp.data(), recv_resp.length());
+	recv_resp.reset();
+	if(resp.error() == managarm::fs::Errors::END_OF_FILE)
+		co_return 0;
+	if(resp.error() != managarm::fs::Errors::SUCCESS)
+		co_return toFsError(resp.error());
+
+	// The server sends one message per buffer that receives data.
+	size_t total = resp.size();
+	size_t progress = 0;
+	for(int i = 0; i < iovcnt && progress < total; i++) {
+		auto chunk = std::min(iov[i].iov_len, total - progress);
+		if(!chunk)
+			continue;
+		auto [recv_data] = co_await helix_ng::exchangeMsgs(
+			offer.descriptor(),
+			helix_ng::recvBuffer(iov[i].iov_base, chunk)
+		);
+		HEL_CHECK(recv_data.error());
+		progress += chunk;
+	}
+	co_return progress;
+}
+
+async::result<frg::expected<Error, size_t>> File::writeVector(const struct iovec *iov, int iovcnt,
+		int64_t offset) {
+	managarm::fs::WriteVectorRequest req;
+	req.set_offset(offset);
+	std::vector<HelSgItem> sglist;
+	for(int i = 0; i < iovcnt; i++) {
+		req.add_sizes(iov[i].iov_len);
+		sglist.push_back({iov[i].iov_base, iov[i].iov_len});
+	}
+
+	auto [offer, send_head, send_tail, imbue_creds, send_data, recv_resp] =
+		co_await helix_ng::exchangeMsgs(
+			_lane,
+			helix_ng::offer(
+				helix_ng::sendBragiHeadTail(req, frg::stl_allocator{}),
+				helix_ng::imbueCredentials(),
+				helix_ng::sendBufferSg(sglist.data(), sglist.size()),
+				helix_ng::recvInline()
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_head.error());
+	HEL_CHECK(send_tail.error());
+	HEL_CHECK(imbue_creds.error());
+	HEL_CHECK(send_data.error());
+	HEL_CHECK(recv_resp.error());
+
+	managarm::fs::SvrResponse resp;
+	resp.ParseFromArray(recv_resp.data(), recv_resp.length());
+	recv_resp.reset();
+	if(resp.error() != managarm::fs::Errors::SUCCESS)
+		co_return toFsError(resp.error());
+	co_return resp.size();
+}
+
 async::result<frg::expected<Error, PollWaitResult>> File::pollWait(uint64_t sequence, int mask,
 		async::cancellation_token cancellation) {
 	HelHandle cancel_handle;
@@ -201,5 +314,156 @@ async::result<helix::UniqueDescriptor> File::accessMemory() {
 	co_return recv_memory.descriptor();
 }
 
+async::result<frg::expected<Error, ReadEntriesResult>> File::readEntries(size_t max_size) {
+	managarm::fs::ReadEntriesRequest req;
+	req.set_size(max_size);
+
+	auto [offer, send_req, recv_head] =
+		co_await helix_ng::exchangeMsgs(
+			_lane,
+			helix_ng::offer(
+				helix_ng::sendBragiHeadOnly(req, frg::stl_allocator{}),
+				helix_ng::recvInline()
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_req.error());
+	HEL_CHECK(recv_head.error());
+
+	auto preamble = bragi::read_preamble(recv_head);
+	assert(!preamble.error());
+
+	std::vector<std::byte> tail(preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			offer.descriptor(),
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
+
+	auto resp = bragi::parse_head_tail<managarm::fs::ReadEntriesReply>(recv_head, tail);
+	recv_head.reset();
+	assert(resp);
+
+	if(resp->error() == managarm::fs::Errors::END_OF_FILE)
+		co_return ReadEntriesResult{};
+	if(resp->error() == managarm::fs::Errors::ILLEGAL_OPERATION_TARGET)
+		co_return Error::illegalOperationTarget;
+	assert(resp->error() == managarm::fs::Errors::SUCCESS);
+
+	ReadEntriesResult entries;
+	for(size_t i = 0; i < resp->names_size(); i++)
+		entries.push_back({resp->names(i), resp->inodes(i),
+				static_cast<uint8_t>(resp->types(i))});
+	co_return entries;
+}
+
+async::result<frg::expected<Error, helix::UniqueDescriptor>> File::accessStatusPage() {
+	managarm::fs::AccessStatusPageRequest req;
+
+	auto [offer, send_req, recv_resp] =
+		co_await helix_ng::exchangeMsgs(
+			_lane,
+			helix_ng::offer(
+				helix_ng::sendBragiHeadOnly(req, frg::stl_allocator{}),
+				helix_ng::recvInline()
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_req.error());
+	HEL_CHECK(recv_resp.error());
+
+	managarm::fs::SvrResponse resp;
+	resp.ParseFromArray(recv_resp.data(), recv_resp.length());
+	recv_resp.reset();
+	if(resp.error() != managarm::fs::Errors::SUCCESS)
+		co_return toFsError(resp.error());
+
+	auto [pull_page] = co_await helix_ng::exchangeMsgs(
+		offer.descriptor(),
+		helix_ng::pullDescriptor()
+	);
+	HEL_CHECK(pull_page.error());
+	co_return pull_page.descriptor();
+}
+
+std::optional<PollStatusResult> StatusPageView::read() {
+	auto page = reinterpret_cast<StatusPage *>(_mapping.get());
+
+	// Start the seqlock read.
+	auto seqlock = __atomic_load_n(&page->seqlock, __ATOMIC_ACQUIRE);
+	if(seqlock & 1)
+		return std::nullopt;
+
+	// Perform the actual loads.
+	auto sequence = __atomic_load_n(&page->sequence, __ATOMIC_RELAXED);
+	auto status = __atomic_load_n(&page->status, __ATOMIC_RELAXED);
+
+	// Finish the seqlock read.
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if(__atomic_load_n(&page->seqlock, __ATOMIC_RELAXED) != seqlock)
+		return std::nullopt;
+
+	return PollStatusResult{sequence, status};
+}
+
+std::optional<PollWaitResult> StatusPageView::readEdges(uint64_t pastSequence) {
+	auto page = reinterpret_cast<StatusPage *>(_mapping.get());
+
+	// Start the seqlock read.
+	auto seqlock = __atomic_load_n(&page->seqlock, __ATOMIC_ACQUIRE);
+	if(seqlock & 1)
+		return std::nullopt;
+
+	// Perform the actual loads.
+	auto sequence = __atomic_load_n(&page->sequence, __ATOMIC_RELAXED);
+	int edges = 0;
+	for(int i = 0; i < 32; i++) {
+		if(__atomic_load_n(&page->edgeSequences[i], __ATOMIC_RELAXED) > pastSequence)
+			edges |= 1 << i;
+	}
+
+	// Finish the seqlock read.
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if(__atomic_load_n(&page->seqlock, __ATOMIC_RELAXED) != seqlock)
+		return std::nullopt;
+
+	return PollWaitResult{sequence, edges};
+}
+
+async::result<frg::expected<Error, size_t>> writeFromMemory(helix::BorrowedDescriptor lane,
+		helix::BorrowedDescriptor memory, uint64_t memoryOffset, size_t size, int64_t offset,
+		helix::BorrowedDescriptor credentials) {
+	managarm::fs::WriteFromMemoryRequest req;
+	req.set_memory_offset(memoryOffset);
+	req.set_size(size);
+	req.set_offset(offset);
+
+	auto [offer, send_req, imbue_creds, push_memory, recv_resp] =
+		co_await helix_ng::exchangeMsgs(
+			lane,
+			helix_ng::offer(
+				helix_ng::sendBragiHeadOnly(req, frg::stl_allocator{}),
+				helix_ng::imbueCredentials(credentials),
+				helix_ng::pushDescriptor(memory),
+				helix_ng::recvInline()
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_req.error());
+	HEL_CHECK(imbue_creds.error());
+	HEL_CHECK(push_memory.error());
+	HEL_CHECK(recv_resp.error());
+
+	managarm::fs::SvrResponse resp;
+	resp.ParseFromArray(recv_resp.data(), recv_resp.length());
+	recv_resp.reset();
+	if(resp.error() != managarm::fs::Errors::SUCCESS)
+		co_return toFsError(resp.error());
+	co_return resp.size();
+}
+
 } } // namespace protocol::fs
 
@@ -1,7 +1,9 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include <unistd.h>
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -17,6 +19,215 @@ namespace fs {
 
 namespace {
 
+// Total size of the buffers of a vectored request.
+// Returns std::nullopt for requests that exceed IOV_MAX buffers or SSIZE_MAX bytes.
+template<typename Sizes>
+std::optional<size_t> vectorSize(const Sizes &sizes) {
+	constexpr size_t maxBuffers = IOV_MAX;
+	constexpr size_t maxTotal = SSIZE_MAX;
+
+	if(sizes.size() > maxBuffers)
+		return std::nullopt;
+	size_t total = 0;
+	for(size_t size : sizes) {
+		if(size > maxTotal - total)
+			return std::nullopt;
+		total += size;
+	}
+	return total;
+}
+
+async::detached handleReadVector(smarter::shared_ptr<void> file,
+		const FileOperations *file_ops,
+		managarm::fs::ReadVectorRequest req, helix::UniqueLane conversation) {
+	auto [extract_creds] = co_await helix_ng::exchangeMsgs(
+		conversation,
+		helix_ng::extractCredentials()
+	);
+	HEL_CHECK(extract_creds.error());
+
+	managarm::fs::SvrResponse resp;
+	auto total = vectorSize(req.sizes());
+	std::vector<char> buffer;
+	if(!total) {
+		resp.set_error(managarm::fs::Errors::ILLEGAL_ARGUMENT);
+	}else if((req.offset() < 0 && !file_ops->read) || (req.offset() >= 0 && !file_ops->pread)) {
+		resp.set_error(managarm::fs::Errors::ILLEGAL_OPERATION_TARGET);
+	}else if(!*total) {
+		// Like readv(), empty vectors do not touch the file.
+		resp.set_error(managarm::fs::Errors::SUCCESS);
+		resp.set_size(0);
+	}else{
+		// Perform a single read such that the semantics match read() (e.g., for pipes).
+		buffer.resize(*total);
+		ReadResult result;
+		if(req.offset() < 0) {
+			result = co_await file_ops->read(file.get(), extract_creds.credentials(),
+					buffer.data(), buffer.size());
+		}else{
+			result = co_await file_ops->pread(file.get(), req.offset(),
+					extract_creds.credentials(), buffer.data(), buffer.size());
+		}
+
+		if(auto error = std::get_if<Error>(&result); error) {
+			resp.set_error(mapFsError(*error));
+			buffer.clear();
+		}else{
+			resp.set_error(managarm::fs::Errors::SUCCESS);
+			resp.set_size(std::get<size_t>(result));
+			buffer.resize(std::get<size_t>(result));
+		}
+	}
+
+	auto ser = resp.SerializeAsString();
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+		conversation,
+		helix_ng::sendBuffer(ser.data(), ser.size())
+	);
+	HEL_CHECK(send_resp.error());
+
+	// Send one message per buffer that receives data; empty buffers are skipped.
+	size_t progress = 0;
+	for(size_t i = 0; i < req.sizes_size() && progress < buffer.size(); i++) {
+		auto chunk = std::min(static_cast<size_t>(req.sizes(i)), buffer.size() - progress);
+		if(!chunk)
+			continue;
+		auto [send_data] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::sendBuffer(buffer.data() + progress, chunk)
+		);
+		HEL_CHECK(send_data.error());
+		progress += chunk;
+	}
+}
+
+async::detached handleWriteVector(smarter::shared_ptr<void> file,
+		const FileOperations *file_ops,
+		managarm::fs::WriteVectorRequest req, helix::UniqueLane conversation) {
+	// The client gathers all buffers into a single message.
+	auto total = vectorSize(req.sizes());
+	std::vector<char> buffer(total.value_or(0));
+	auto [extract_creds, recv_data] = co_await helix_ng::exchangeMsgs(
+		conversation,
+		helix_ng::extractCredentials(),
+		helix_ng::recvBuffer(buffer.data(), buffer.size())
+	);
+	HEL_CHECK(extract_creds.error());
+
+	// Malformed requests are rejected, even if the client sent more data than announced.
+	if(recv_data.error() != kHelErrBufferTooSmall)
+		HEL_CHECK(recv_data.error());
+
+	managarm::fs::SvrResponse resp;
+	if(!total || recv_data.error()) {
+		resp.set_error(managarm::fs::Errors::ILLEGAL_ARGUMENT);
+	}else if((req.offset() < 0 && !file_ops->write) || (req.offset() >= 0 && !file_ops->pwrite)) {
+		resp.set_error(managarm::fs::Errors::ILLEGAL_OPERATION_TARGET);
+	}else if(!*total) {
+		resp.set_error(managarm::fs::Errors::SUCCESS);
+		resp.set_size(0);
+	}else{
+		// Perform a single write such that writev() is atomic wherever write() is.
+		frg::expected<Error, size_t> result;
+		if(req.offset() < 0) {
+			result = co_await file_ops->write(file.get(), extract_creds.credentials(),
+					buffer.data(), recv_data.actualLength());
+		}else{
+			result = co_await file_ops->pwrite(file.get(), req.offset(),
+					extract_creds.credentials(), buffer.data(), recv_data.actualLength());
+		}
+
+		if(!result) {
+			resp.set_error(mapFsError(result.error()));
+		}else{
+			resp.set_error(managarm::fs::Errors::SUCCESS);
+			resp.set_size(result.value());
+		}
+	}
+
+	auto ser = resp.SerializeAsString();
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+		conversation,
+		helix_ng::sendBuffer(ser.data(), ser.size())
+	);
+	HEL_CHECK(send_resp.error());
+}
+
+async::detached handleWriteFromMemory(smarter::shared_ptr<void> file,
+		const FileOperations *file_ops,
+		managarm::fs::WriteFromMemoryRequest req, helix::UniqueLane conversation) {
+	auto [extract_creds, pull_memory] = co_await helix_ng::exchangeMsgs(
+		conversation,
+		helix_ng::extractCredentials(),
+		helix_ng::pullDescriptor()
+	);
+	HEL_CHECK(extract_creds.error());
+	HEL_CHECK(pull_memory.error());
+	auto memory = pull_memory.descriptor();
+
+	managarm::fs::SvrResponse resp;
+	if((req.offset() < 0 && !file_ops->write) || (req.offset() >= 0 && !file_ops->pwrite)) {
+		resp.set_error(managarm::fs::Errors::ILLEGAL_OPERATION_TARGET);
+	}else{
+		// Map the memory in windows such that large copies do not exhaust our address space.
+		constexpr size_t windowSize = size_t(1) << 20;
+
+		size_t progress = 0;
+		Error error = Error::none;
+		while(progress < req.size()) {
+			size_t memoryOffset = req.memory_offset() + progress;
+			size_t misalign = memoryOffset & 0xFFF;
+			size_t chunk = std::min(req.size() - progress, windowSize - misalign);
+
+			// Make sure that the pages are present before we touch them.
+			helix::LockMemoryView lockMemory;
+			auto &&submit = helix::submitLockMemoryView(memory,
+					&lockMemory, memoryOffset - misalign,
+					(misalign + chunk + 0xFFF) & ~size_t(0xFFF),
+					helix::Dispatcher::global());
+			co_await submit.async_wait();
+			if(lockMemory.error()) {
+				error = Error::illegalArguments;
+				break;
+			}
+			helix::Mapping window{memory, static_cast<ptrdiff_t>(memoryOffset - misalign),
+					misalign + chunk, kHelMapProtRead};
+			auto data = reinterpret_cast<const char *>(window.get()) + misalign;
+
+			frg::expected<Error, size_t> result;
+			if(req.offset() < 0) {
+				result = co_await file_ops->write(file.get(), extract_creds.credentials(),
+						data, chunk);
+			}else{
+				result = co_await file_ops->pwrite(file.get(), req.offset() + progress,
+						extract_creds.credentials(), data, chunk);
+			}
+			if(!result) {
+				error = result.error();
+				break;
+			}
+			progress += result.value();
+			if(result.value() < chunk)
+				break;
+		}
+
+		// Report partial writes as success, similar to write().
+		if(error != Error::none && !progress) {
+			resp.set_error(mapFsError(error));
+		}else{
+			resp.set_error(managarm::fs::Errors::SUCCESS);
+			resp.set_size(progress);
+		}
+	}
+
+	auto ser = resp.SerializeAsString();
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+		conversation,
+		helix_ng::sendBuffer(ser.data(), ser.size())
+	);
+	HEL_CHECK(send_resp.error());
+}
+
 async::detached handlePassthrough(smarter::shared_ptr<void> file,
 		const FileOperations *file_ops,
 		managarm::fs::CntRequest req, helix::UniqueLane conversation) {
@@ -398,12 +609,25 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 			HEL_CHECK(send_resp.error());
 			co_return;
 		}
-		auto result = co_await file_ops->readEntries(file.get());
+		// This request only returns a single entry.
+		auto result = co_await file_ops->readEntries(file.get(), 0);
+		assert(result.size() <= 1);
 
 		managarm::fs::SvrResponse resp;
-		if(result) {
+		if(!result.empty()) {
+			auto &entry = result.front();
 			resp.set_error(managarm::fs::Errors::SUCCESS);
-			resp.set_path(std::move(*result));
+			resp.set_path(std::move(entry.name));
+			resp.set_inode_num(entry.inode);
+			if(entry.type == DT_DIR) {
+				resp.set_file_type(managarm::fs::FileType::DIRECTORY);
+			}else if(entry.type == DT_REG) {
+				resp.set_file_type(managarm::fs::FileType::REGULAR);
+			}else if(entry.type == DT_LNK) {
+				resp.set_file_type(managarm::fs::FileType::SYMLINK);
+			}else if(entry.type == DT_SOCK) {
+				resp.set_file_type(managarm::fs::FileType::SOCKET);
+			}
 		}else{
 			resp.set_error(managarm::fs::Errors::END_OF_FILE);
 		}
@@ -1129,6 +1353,108 @@ async::result<void> servePassthrough(helix::UniqueLane lane,
 				helix_ng::sendBuffer(ser.data(), ser.size())
 			);
 			HEL_CHECK(send_resp.error());
+		} else if(preamble.id() == managarm::fs::ReadEntriesRequest::message_id) {
+			auto req = bragi::parse_head_only<managarm::fs::ReadEntriesRequest>(recv_req);
+			recv_req.reset();
+
+			if(!req) {
+				std::cout << "protocols/fs: Rejecting request due to decoding failure" << std::endl;
+				continue;
+			}
+
+			managarm::fs::ReadEntriesReply resp;
+			if(!file_ops->readEntries) {
+				resp.set_error(managarm::fs::Errors::ILLEGAL_OPERATION_TARGET);
+			}else{
+				auto result = co_await file_ops->readEntries(file.get(), req->size());
+				if(result.empty()) {
+					resp.set_error(managarm::fs::Errors::END_OF_FILE);
+				}else{
+					resp.set_error(managarm::fs::Errors::SUCCESS);
+					for(auto &entry : result) {
+						resp.add_names(std::move(entry.name));
+						resp.add_inodes(entry.inode);
+						resp.add_types(entry.type);
+					}
+				}
+			}
+
+			auto [send_head, send_tail] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBragiHeadTail(resp, frg::stl_allocator{})
+			);
+			HEL_CHECK(send_head.error());
+			HEL_CHECK(send_tail.error());
+		} else if(preamble.id() == managarm::fs::AccessStatusPageRequest::message_id) {
+			managarm::fs::SvrResponse resp;
+			if(!file_ops->accessStatusPage) {
+				resp.set_error(managarm::fs::Errors::ILLEGAL_OPERATION_TARGET);
+
+				auto ser = resp.SerializeAsString();
+				auto [send_resp] = co_await helix_ng::exchangeMsgs(
+					conversation,
+					helix_ng::sendBuffer(ser.data(), ser.size())
+				);
+				HEL_CHECK(send_resp.error());
+				continue;
+			}
+
+			resp.set_error(managarm::fs::Errors::SUCCESS);
+
+			auto ser = resp.SerializeAsString();
+			auto [send_resp, push_page] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size()),
+				helix_ng::pushDescriptor(file_ops->accessStatusPage(file.get()))
+			);
+			HEL_CHECK(send_resp.error());
+			HEL_CHECK(push_page.error());
+		} else if(preamble.id() == managarm::fs::ReadVectorRequest::message_id) {
+			std::vector<std::byte> tail(preamble.tail_size());
+			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::recvBuffer(tail.data(), tail.size())
+			);
+			HEL_CHECK(recv_tail.error());
+
+			auto req = bragi::parse_head_tail<managarm::fs::ReadVectorRequest>(recv_req, tail);
+			recv_req.reset();
+
+			if(!req) {
+				std::cout << "protocols/fs: Rejecting request due to decoding failure" << std::endl;
+				continue;
+			}
+
+			// Vectored I/O can block (e.g., on pipes); do not stall other requests on this lane.
+			handleReadVector(file, file_ops, std::move(*req), std::move(conversation));
+		} else if(preamble.id() == managarm::fs::WriteVectorRequest::message_id) {
+			std::vector<std::byte> tail(preamble.tail_size());
+			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::recvBuffer(tail.data(), tail.size())
+			);
+			HEL_CHECK(recv_tail.error());
+
+			auto req = bragi::parse_head_tail<managarm::fs::WriteVectorRequest>(recv_req, tail);
+			recv_req.reset();
+
+			if(!req) {
+				std::cout << "protocols/fs: Rejecting request due to decoding failure" << std::endl;
+				continue;
+			}
+
+			handleWriteVector(file, file_ops, std::move(*req), std::move(conversation));
+		} else if(preamble.id() == managarm::fs::WriteFromMemoryRequest::message_id) {
+			auto req = bragi::parse_head_only<managarm::fs::WriteFromMemoryRequest>(recv_req);
+			recv_req.reset();
+
+			if(!req) {
+				std::cout << "protocols/fs: Rejecting request due to decoding failure" << std::endl;
+				continue;
+			}
+
+			// Large copies take a while; do not stall other requests on this lane.
+			handleWriteFromMemory(file, file_ops, std::move(*req), std::move(conversation));
 		} else if(preamble.id() == managarm::fs::IoctlRequest::message_id) {
 			auto req = bragi::parse_head_only<managarm::fs::IoctlRequest>(recv_req);
 			recv_req.reset();
@@ -1172,7 +1498,7 @@ StatusPageProvider::StatusPageProvider() {
 	_mapping = helix::Mapping{_memory, 0, page_size};
 }
 
-void StatusPageProvider::update(uint64_t sequence, int status) {
+void StatusPageProvider::update(uint64_t sequence, int status, int edges) {
 	auto page = reinterpret_cast<protocols::fs::StatusPage *>(_mapping.get());
 
 	// State the seqlock write.
@@ -1184,6 +1510,10 @@ void StatusPageProvider::update(uint64_t sequence, int status) {
 	// Perform the actual update.
 	__atomic_store_n(&page->sequence, sequence, __ATOMIC_RELAXED);
 	__atomic_store_n(&page->status, status, __ATOMIC_RELAXED);
+	for(int i = 0; i < 32; i++) {
+		if(edges & (1 << i))
+			__atomic_store_n(&page->edgeSequences[i], sequence, __ATOMIC_RELAXED);
+	}
 
 	// Complete the seqlock write.
 	__atomic_store_n(&page->seqlock, seqlock + 2, __ATOMIC_RELEASE);
@@ -1241,6 +1571,7 @@ async::detached serveNode(helix::UniqueLane lane, std::shared_ptr<void> node,
 			resp.set_mtime_nanos(result.dataModifyTime.tv_nsec);
 			resp.set_ctime_secs(result.anyChangeTime.tv_sec);
 			resp.set_ctime_nanos(result.anyChangeTime.tv_nsec);
+			resp.set_generation(result.generation);
 
 			auto ser = resp.SerializeAsString();
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(
@@ -1,19 +1,38 @@
 #pragma once
 
+#include <span>
 #include <string>
+#include <vector>
 
 #include <async/result.hpp>
+#include <bragi/helpers-std.hpp>
 #include <helix/ipc.hpp>
+#include <helix/memory.hpp>
 #include <ostrace.bragi.hpp>
 
 namespace protocols::ostrace {
 
+// Layout of the shared-memory rings that are registered with RegisterRingReq.
+// The producer appends serialized EventRecords to the data area (which starts
+// at ringDataOffset) and advances head; the kernel drains records and advances tail.
+// Both indices count bytes and are never wrapped; records may wrap around the data area.
+// The kernel does not poll idle rings: before it goes to sleep, it sets wantSignal.
+// The producer clears it when it appends the next record and sends a SignalRingReq.
+struct RingHeader {
+	uint64_t head;
+	uint64_t tail;
+	uint64_t dropped; // Number of events that did not fit into the ring.
+	uint64_t wantSignal;
+};
+
+inline constexpr size_t ringDataOffset = 0x1000;
+
 enum class EventId : uint64_t { };
 enum class ItemId : uint64_t { };
 
 struct Context {
 	Context();
-	Context(helix::UniqueLane lane, bool enabled);
+	Context(helix::UniqueLane lane, bool enabled, uint64_t id = 0);
 
 	inline helix::BorrowedLane getLane() {
 		return lane_;
@@ -27,9 +46,48 @@ struct Context {
 	async::result<EventId> announceEvent(std::string_view name);
 	async::result<ItemId> announceItem(std::string_view name);
 
+	// Allocates a shared-memory ring and registers it with the kernel.
+	// Afterwards, events are written to the ring instead of being sent via IPC.
+	// Returns false if the kernel does not accept the ring.
+	async::result<bool> registerRing(size_t size);
+
+	// Appends a record to the ring. Returns false if the record does not fit.
+	template<typename Record>
+	bool writeRing(Record &record) {
+		ringScratch_.resize(Record::head_size + record.size_of_tail());
+		bragi::write_head_tail(record,
+				std::span<char>{ringScratch_.data(), Record::head_size},
+				std::span<char>{ringScratch_.data() + Record::head_size,
+						record.size_of_tail()});
+		return writeRing_(ringScratch_.data(), ringScratch_.size());
+	}
+
+	inline bool hasRing() {
+		return ringSize_;
+	}
+
+	// ID that the kernel assigned to this context.
+	inline uint64_t id() {
+		return id_;
+	}
+
+	// Returns an ID that is unique across all contexts.
+	// Such IDs are used both for spans and for flows.
+	inline uint64_t allocateId() {
+		return (id_ << 32) | nextId_++;
+	}
+
 private:
+	bool writeRing_(const char *data, size_t size);
+
 	helix::UniqueLane lane_;
 	bool enabled_;
+	uint64_t id_;
+	uint64_t nextId_ = 1;
+
+	helix::Mapping ringMapping_;
+	size_t ringSize_ = 0;
+	std::vector<char> ringScratch_;
 };
 
 struct Event {
@@ -45,6 +103,35 @@ private:
 	managarm::ostrace::EmitEventReq req_;
 };
 
-async::result<Context> createContext();
+// A span that lasts from construction until end() is called (or the span is destructed).
+// Spans are only recorded if the context has a ring.
+struct Span {
+	Span(Context *ctx, EventId id, uint64_t parent = 0, uint64_t flow = 0);
+
+	Span(const Span &) = delete;
+
+	~Span();
+
+	Span &operator= (const Span &) = delete;
+
+	uint64_t id() {
+		return span_;
+	}
+
+	// Counters are attached to the end of the span.
+	void withCounter(ItemId id, int64_t value);
+
+	void end();
+
+private:
+	void write_(managarm::ostrace::SpanPhase phase);
+
+	Context *ctx_;
+	bool live_;
+	uint64_t span_ = 0;
+	managarm::ostrace::SpanRecord rec_;
+};
+
+async::result<Context> createContext(std::string_view name = {});
 
 } // namespace protocols::ostrace
@@ -1,17 +1,105 @@
+#include <string.h>
+#include <algorithm>
+#include <span>
+
 #include <async/oneshot-event.hpp>
 #include <bragi/helpers-std.hpp>
 #include <frg/std_compat.hpp>
+#include <protocols/clock/defs.hpp>
 #include <protocols/mbus/client.hpp>
 #include <protocols/ostrace/ostrace.hpp>
+#include <clock.bragi.hpp>
 #include <ostrace.bragi.hpp>
 
 namespace protocols::ostrace {
 
+namespace {
+
+// The clock tracker's page; used to timestamp ring records without a syscall.
+// Until we found the clock tracker (or if it cannot calibrate the cycle counter),
+// timestamps come from helGetClock().
+bool trackerPageRequested = false;
+helix::UniqueDescriptor trackerPageMemory;
+helix::Mapping trackerPageMapping;
+
+async::detached fetchTrackerPage(mbus::Entity entity) {
+	helix::UniqueLane lane{co_await entity.bind()};
+
+	managarm::clock::AccessPageRequest req;
+	auto [offer, sendReq, recvResp, pullMemory] = co_await helix_ng::exchangeMsgs(
+		lane,
+		helix_ng::offer(
+			helix_ng::sendBragiHeadOnly(req, frg::stl_allocator{}),
+			helix_ng::recvInline(),
+			helix_ng::pullDescriptor()
+		)
+	);
+	HEL_CHECK(offer.error());
+	HEL_CHECK(sendReq.error());
+	HEL_CHECK(recvResp.error());
+
+	auto resp = bragi::parse_head_only<managarm::clock::SvrResponse>(recvResp);
+	recvResp.reset();
+	if(!resp || resp->error() != managarm::clock::Error::SUCCESS)
+		co_return;
+	HEL_CHECK(pullMemory.error());
+
+	trackerPageMemory = pullMemory.descriptor();
+	trackerPageMapping = helix::Mapping{trackerPageMemory, 0, 0x1000, kHelMapProtRead};
+}
+
+async::detached findTrackerPage() {
+	auto root = co_await mbus::Instance::global().getRoot();
+
+	auto filter = mbus::Conjunction({
+		mbus::EqualsFilter("class", "clocktracker")
+	});
+
+	auto handler = mbus::ObserverHandler{}
+	.withAttach([] (mbus::Entity entity, mbus::Properties) {
+		if(!trackerPageMemory)
+			fetchTrackerPage(std::move(entity));
+	});
+
+	co_await root.linkObserver(std::move(filter), std::move(handler));
+}
+
+// Uses the same clock as the kernel's own events such that timestamps are comparable.
+uint64_t currentTimestamp() {
+	uint64_t ts;
+	auto page = reinterpret_cast<TrackerPage *>(trackerPageMapping.get());
+	if(page && protocols::clock::readClock(page, ts))
+		return ts;
+	HEL_CHECK(helGetClock(&ts));
+	return ts;
+}
+
+// Wakes up the kernel's drain after we appended a record to an idle ring.
+async::detached signalRing(helix::UniqueLane lane) {
+	managarm::ostrace::SignalRingReq req;
+
+	auto [offer, sendReq, recvResp] =
+		co_await helix_ng::exchangeMsgs(
+			lane,
+			helix_ng::offer(
+				helix_ng::sendBragiHeadOnly(req, frg::stl_allocator{}),
+				helix_ng::recvInline()
+			)
+		);
+
+	// The kernel only loses the signal if the lane is gone, in which case
+	// the ring is drained one last time anyway.
+	if(offer.error() || sendReq.error() || recvResp.error())
+		co_return;
+}
+
+} // anonymous namespace
+
 Context::Context()
-: enabled_{false} { }
+: enabled_{false}, id_{0} { }
 
-Context::Context(helix::UniqueLane lane, bool enabled)
-: lane_{std::move(lane)}, enabled_{enabled} { }
+Context::Context(helix::UniqueLane lane, bool enabled, uint64_t id)
+: lane_{std::move(lane)}, enabled_{enabled}, id_{id} { }
 
 async::result<EventId> Context::announceEvent(std::string_view name) {
 	managarm::ostrace::AnnounceEventReq req;
@@ -65,6 +153,72 @@ async::result<ItemId> Context::announceItem(std::string_view name) {
 	co_return ItemId{resp.id()};
 }
 
+async::result<bool> Context::registerRing(size_t size) {
+	assert(size && !(size & (size - 1)));
+
+	HelHandle handle;
+	HEL_CHECK(helAllocateMemory(ringDataOffset + size, 0, nullptr, &handle));
+	helix::UniqueDescriptor memory{handle};
+
+	managarm::ostrace::RegisterRingReq req;
+	req.set_size(size);
+
+	auto [offer, sendReq, pushMemory, recvResp] =
+		co_await helix_ng::exchangeMsgs(
+			lane_,
+			helix_ng::offer(
+				helix_ng::sendBragiHeadOnly(req, frg::stl_allocator{}),
+				helix_ng::pushDescriptor(memory),
+				helix_ng::recvInline()
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(sendReq.error());
+	HEL_CHECK(pushMemory.error());
+	HEL_CHECK(recvResp.error());
+
+	auto maybeResp = bragi::parse_head_only<managarm::ostrace::Response>(recvResp);
+	recvResp.reset();
+	assert(maybeResp);
+	auto &resp = maybeResp.value();
+	if(resp.error() != managarm::ostrace::Error::SUCCESS)
+		co_return false;
+
+	ringMapping_ = helix::Mapping{memory, 0, ringDataOffset + size};
+	ringSize_ = size;
+	co_return true;
+}
+
+bool Context::writeRing_(const char *record, size_t recordSize) {
+	auto header = reinterpret_cast<RingHeader *>(ringMapping_.get());
+	auto data = reinterpret_cast<char *>(ringMapping_.get()) + ringDataOffset;
+
+	// We are the only producer, hence we can read head without synchronization.
+	auto head = header->head;
+	auto tail = __atomic_load_n(&header->tail, __ATOMIC_ACQUIRE);
+	if(recordSize > ringSize_ - (head - tail)) {
+		__atomic_store_n(&header->dropped, header->dropped + 1, __ATOMIC_RELAXED);
+		return false;
+	}
+
+	auto offset = head & (ringSize_ - 1);
+	auto firstChunk = std::min(recordSize, ringSize_ - offset);
+	memcpy(data + offset, record, firstChunk);
+	memcpy(data, record + firstChunk, recordSize - firstChunk);
+
+	// Publish the record to the kernel.
+	__atomic_store_n(&header->head, head + recordSize, __ATOMIC_RELEASE);
+
+	// Pairs with the fence in the kernel's drain: either the kernel sees our record
+	// before it goes to sleep, or we see that it wants a signal.
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&header->wantSignal, __ATOMIC_RELAXED)
+			&& __atomic_exchange_n(&header->wantSignal, 0, __ATOMIC_RELAXED))
+		signalRing(lane_.dup());
+	return true;
+}
+
 Event::Event(Context *ctx, EventId id)
 : ctx_{ctx} {
 	live_ = ctx->isActive();
@@ -85,6 +239,16 @@ async::result<void> Event::emit() {
 	if(!live_)
 		co_return;
 
+	if(ctx_->hasRing()) {
+		managarm::ostrace::EventRecord record;
+		record.set_ts(currentTimestamp());
+		record.set_id(req_.id());
+		for(size_t i = 0; i < req_.ctrs_size(); ++i)
+			record.add_ctrs(std::move(req_.ctrs(i)));
+		ctx_->writeRing(record);
+		co_return;
+	}
+
 	auto [offer, sendReq, recvResp] =
 		co_await helix_ng::exchangeMsgs(
 			ctx_->getLane(),
@@ -105,7 +269,53 @@ async::result<void> Event::emit() {
 	assert(resp.error() == managarm::ostrace::Error::SUCCESS);
 }
 
-async::result<Context> createContext() {
+Span::Span(Context *ctx, EventId id, uint64_t parent, uint64_t flow)
+: ctx_{ctx} {
+	live_ = ctx->isActive() && ctx->hasRing();
+	if(!live_)
+		return;
+
+	span_ = ctx->allocateId();
+	rec_.set_id(static_cast<uint64_t>(id));
+	rec_.set_span(span_);
+	rec_.set_parent(parent);
+	rec_.set_flow(flow);
+	rec_.set_ctx(ctx->id());
+	write_(managarm::ostrace::SpanPhase::BEGIN);
+
+	// Only the begin record carries the links.
+	rec_.set_parent(0);
+	rec_.set_flow(0);
+}
+
+Span::~Span() {
+	end();
+}
+
+void Span::withCounter(ItemId id, int64_t value) {
+	if(!live_)
+		return;
+
+	managarm::ostrace::CounterItem item;
+	item.set_id(static_cast<uint64_t>(id));
+	item.set_value(value);
+	rec_.add_ctrs(std::move(item));
+}
+
+void Span::end() {
+	if(!live_)
+		return;
+	write_(managarm::ostrace::SpanPhase::END);
+	live_ = false;
+}
+
+void Span::write_(managarm::ostrace::SpanPhase phase) {
+	rec_.set_ts(currentTimestamp());
+	rec_.set_phase(static_cast<uint32_t>(phase));
+	ctx_->writeRing(rec_);
+}
+
+async::result<Context> createContext(std::string_view name) {
 	auto root = co_await mbus::Instance::global().getRoot();
 
 	// Find ostrace in mbus.
@@ -131,7 +341,8 @@ async::result<Context> createContext() {
 
 	// Perform the negotiation request.
 
-	managarm::ostrace::AnnounceItemReq req;
+	managarm::ostrace::NegotiateReq req;
+	req.set_name(std::string{name});
 
 	auto [offer, sendReq, recvResp] =
 		co_await helix_ng::exchangeMsgs(
@@ -155,7 +366,15 @@ async::result<Context> createContext() {
 		co_return Context{std::move(lane), false};
 
 	assert(resp.error() == managarm::ostrace::Error::SUCCESS);
-	co_return Context{std::move(lane), true};
+
+	Context ctx{std::move(lane), true, resp.id()};
+	if(!co_await ctx.registerRing(1 << 16)) {
+		std::cout << "ostrace: Kernel rejected trace ring, falling back to IPC" << std::endl;
+	}else if(!trackerPageRequested) {
+		trackerPageRequested = true;
+		findTrackerPage();
+	}
+	co_return std::move(ctx);
 }
 
 } // namespace protocols::ostrace
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <protocols/posix/data.hpp>
+
+namespace posix {
+
+// Client side of the anonymous memory fast path.
+// Both functions fail (and the caller has to fall back to superAnonAllocate
+// or superAnonDeallocate) instead of blocking on posix.
+
+inline void *anonArenaAllocate(AnonArenaPage *page, size_t size) {
+	size_t alignedSize = (size + 0xFFF) & ~size_t(0xFFF);
+	if(!alignedSize)
+		return nullptr;
+
+	auto cursor = __atomic_load_n(&page->cursor, __ATOMIC_RELAXED);
+	while(true) {
+		auto limit = __atomic_load_n(&page->limit, __ATOMIC_ACQUIRE);
+		if(cursor > limit || limit - cursor < alignedSize)
+			return nullptr;
+		if(__atomic_compare_exchange_n(&page->cursor, &cursor, cursor + alignedSize,
+				false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+			return reinterpret_cast<void *>(cursor);
+	}
+}
+
+inline bool anonArenaFree(AnonArenaPage *page, void *pointer, size_t size) {
+	size_t alignedSize = (size + 0xFFF) & ~size_t(0xFFF);
+
+	uint32_t expected = 0;
+	if(!__atomic_compare_exchange_n(&page->producerLock, &expected, 1,
+			false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return false;
+
+	bool success = false;
+	auto head = __atomic_load_n(&page->head, __ATOMIC_ACQUIRE);
+	auto tail = __atomic_load_n(&page->tail, __ATOMIC_RELAXED);
+	if(tail - head < AnonArenaPage::ringSize) {
+		auto &entry = page->ring[tail % AnonArenaPage::ringSize];
+		__atomic_store_n(&entry.address, reinterpret_cast<uintptr_t>(pointer), __ATOMIC_RELAXED);
+		__atomic_store_n(&entry.size, alignedSize, __ATOMIC_RELAXED);
+		__atomic_store_n(&page->tail, tail + 1, __ATOMIC_RELEASE);
+		success = true;
+	}
+
+	__atomic_store_n(&page->producerLock, 0, __ATOMIC_RELEASE);
+	return success;
+}
+
+} // namespace posix
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
 #include <hel.h>
 
 namespace posix {
@@ -12,6 +14,33 @@ struct ManagarmProcessData {
 	void *clockTrackerPage;
 };
 
+// Page that is shared between posix and a process (see superGetAnonArena).
+// posix keeps a pre-reserved arena of anonymous memory mapped into the process;
+// the process carves allocations out of it without entering posix.
+// All fields are accessed through atomic operations.
+struct AnonArenaPage {
+	static constexpr size_t ringSize = 64;
+
+	struct FreedRange {
+		uintptr_t address;
+		size_t size;
+	};
+
+	// Allocations are taken from [cursor, limit). posix closes an arena by setting
+	// cursor to ~0 and limit to zero; it then unmaps the unused tail of the arena.
+	// Cursor never moves backwards within an arena.
+	uintptr_t cursor;
+	uintptr_t limit;
+
+	// Ranges that the process released but that are still mapped.
+	// The process appends entries at tail (protected by producerLock);
+	// posix unmaps entries up to tail and publishes its progress in head.
+	uint32_t producerLock;
+	uint32_t head;
+	uint32_t tail;
+	FreedRange ring[ringSize];
+};
+
 struct ManagarmServerData {
 	HelHandle controlLane;
 };
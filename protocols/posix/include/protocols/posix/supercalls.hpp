@@ -19,6 +19,7 @@ inline constexpr uint32_t superSigAltStack = 12;
 inline constexpr uint32_t superSigSuspend = 13;
 inline constexpr uint32_t superGetTid = 14;
 inline constexpr uint32_t superSigGetPending = 15;
+inline constexpr uint32_t superGetAnonArena = 16;
 inline constexpr uint32_t superGetServerData = 64;
 
 } // namespace posix
@@ -195,6 +195,7 @@ struct Tcp4Socket {
 	static auto makeSocket(Tcp4 *parent, bool nonBlock) {
 		auto s = smarter::make_shared<Tcp4Socket>(parent, nonBlock);
 		s->holder_ = s;
+		s->updateStatusPage_();
 		async::detach(s->flushOutPackets_());
 		return s;
 	}
@@ -379,6 +380,7 @@ struct Tcp4Socket {
 			self->recvRing_.dequeueAdvance(chunk);
 			self->flushEvent_.raise();
 		}
+		self->updateStatusPage_();
 
 		struct sockaddr_in sa;
 		memset(&sa, 0, sizeof(struct sockaddr_in));
@@ -413,6 +415,7 @@ struct Tcp4Socket {
 			self->sendRing_.enqueue(p + progress, chunk);
 			self->flushEvent_.raise();
 			progress += chunk;
+			self->updateStatusPage_();
 		}
 
 		co_return progress;
@@ -420,42 +423,33 @@ struct Tcp4Socket {
 
 	static async::result<frg::expected<protocols::fs::Error, protocols::fs::PollWaitResult>>
 	pollWait(void *object, uint64_t pastSeq, int mask, async::cancellation_token cancellation) {
-		(void)mask; // TODO: utilize mask.
 		auto self = static_cast<Tcp4Socket *>(object);
 
-		// TODO: Return an error in this case.
-		if(pastSeq > self->currentSeq_) {
-			std::cout << "netserver: Illegal pastSeq in TCP poll()" << std::endl;
-			pastSeq = self->currentSeq_;
-		}
+		if(pastSeq > self->currentSeq_)
+			co_return protocols::fs::Error::illegalArguments;
 
-		while(pastSeq == self->currentSeq_ && !cancellation.is_cancellation_requested())
-			co_await self->pollEvent_.async_wait(cancellation);
+		while(true) {
+			while(pastSeq == self->currentSeq_ && !cancellation.is_cancellation_requested())
+				co_await self->pollEvent_.async_wait(cancellation);
 
-		int edges = 0;
-		if(self->inSeq_ > pastSeq)
-			edges |= EPOLLIN;
-		if(self->outSeq_ > pastSeq)
-			edges |= EPOLLOUT;
-		if(self->hupSeq_ > pastSeq)
-			edges |= EPOLLHUP;
+			auto edges = self->edgesSince_(pastSeq);
+			if((edges & mask) || cancellation.is_cancellation_requested())
+				co_return protocols::fs::PollWaitResult{self->currentSeq_, edges};
 
-		co_return protocols::fs::PollWaitResult{self->currentSeq_, edges};
+			// Mask was not satisfied.
+			pastSeq = self->currentSeq_;
+		}
 	}
 
 	static async::result<frg::expected<protocols::fs::Error, protocols::fs::PollStatusResult>>
 	pollStatus(void *object) {
 		auto self = static_cast<Tcp4Socket *>(object);
+		co_return protocols::fs::PollStatusResult{self->currentSeq_, self->activeEvents_()};
+	}
 
-		int active = 0;
-		if(self->recvRing_.availableToDequeue())
-			active |= EPOLLIN;
-		if(self->sendRing_.spaceForEnqueue())
-			active |= EPOLLOUT;
-		if(self->remoteClosed_)
-			active |= EPOLLHUP;
-
-		co_return protocols::fs::PollStatusResult{self->currentSeq_, active};
+	static helix::BorrowedDescriptor accessStatusPage(void *object) {
+		auto self = static_cast<Tcp4Socket *>(object);
+		return self->statusPage_.getMemory();
 	}
 
 	static async::result<void> setFileFlags(void *object, int flags) {
@@ -493,6 +487,7 @@ struct Tcp4Socket {
 		.recvMsg = &recvMsg,
 		.sendMsg = &sendMsg,
 		.peername = &peername,
+		.accessStatusPage = &accessStatusPage,
 	};
 
 	bool bindAvailable(uint32_t ipAddress = INADDR_ANY) {
@@ -511,6 +506,35 @@ struct Tcp4Socket {
 	}
 
 private:
+	int activeEvents_() {
+		int active = 0;
+		if(recvRing_.availableToDequeue())
+			active |= EPOLLIN;
+		if(sendRing_.spaceForEnqueue())
+			active |= EPOLLOUT;
+		if(remoteClosed_)
+			active |= EPOLLHUP;
+		return active;
+	}
+
+	int edgesSince_(uint64_t pastSeq) {
+		int edges = 0;
+		if(inSeq_ > pastSeq)
+			edges |= EPOLLIN;
+		if(outSeq_ > pastSeq)
+			edges |= EPOLLOUT;
+		if(hupSeq_ > pastSeq)
+			edges |= EPOLLHUP;
+		return edges;
+	}
+
+	// Mirrors pollStatus() and the edges of pollWait() to the status page;
+	// call this after each change of the rings.
+	void updateStatusPage_() {
+		statusPage_.update(currentSeq_, activeEvents_(), edgesSince_(publishedSeq_));
+		publishedSeq_ = currentSeq_;
+	}
+
 	async::result<void> flushOutPackets_();
 
 	void handleInPacket_(TcpPacket packet);
@@ -560,7 +584,10 @@ private:
 	uint64_t inSeq_ = 1;
 	uint64_t outSeq_ = 0;
 	uint64_t hupSeq_ = 1;
+	// Sequence that was last written to the status page.
+	uint64_t publishedSeq_ = 0;
 	async::recurring_event pollEvent_;
+	protocols::fs::StatusPageProvider statusPage_;
 };
 
 async::result<void> Tcp4Socket::flushOutPackets_() {
@@ -764,6 +791,7 @@ void Tcp4Socket::handleInPacket_(TcpPacket packet) {
 			}
 
 			if(gotUpdate) {
+				updateStatusPage_();
 				inEvent_.raise();
 				flushEvent_.raise();
 				pollEvent_.raise();
@@ -778,6 +806,7 @@ void Tcp4Socket::handleInPacket_(TcpPacket packet) {
 				localWindowSn_ = localSettledSn_ + packet.header.window.load();
 				sendRing_.dequeueAdvance(ackPointer);
 				outSeq_ = ++currentSeq_;
+				updateStatusPage_();
 				settleEvent_.raise();
 				pollEvent_.raise();
 			}else{
@@ -6,11 +6,13 @@
 #include <async/basic.hpp>
 #include <async/result.hpp>
 #include <async/queue.hpp>
+#include <async/recurring-event.hpp>
 #include <arch/bit.hpp>
 #include <protocols/fs/server.hpp>
 #include <cstring>
 #include <iomanip>
 #include <random>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/ip.h>
@@ -147,6 +149,7 @@ struct Udp4Socket {
 	static auto make_socket(Udp4 *parent) {
 		auto s = smarter::make_shared<Udp4Socket>(parent);
 		s->holder_ = s;
+		s->updateStatusPage_();
 		return s;
 	}
 
@@ -223,6 +226,8 @@ struct Udp4Socket {
 		using arch::endian;
 		auto self = static_cast<Udp4Socket *>(obj);
 		auto element = co_await self->queue_.async_get();
+		self->queuedDatagrams_--;
+		self->updateStatusPage_();
 		auto packet = element->payload();
 		auto copy_size = std::min(packet.size(), len);
 		std::memcpy(data, packet.data(), copy_size);
@@ -332,12 +337,46 @@ struct Udp4Socket {
 		co_return len;
 	}
 
+	static async::result<frg::expected<protocols::fs::Error, PollWaitResult>>
+	pollWait(void *obj, uint64_t pastSeq, int mask, async::cancellation_token cancellation) {
+		auto self = static_cast<Udp4Socket *>(obj);
+
+		if(pastSeq > self->currentSeq_)
+			co_return protocols::fs::Error::illegalArguments;
+
+		while(true) {
+			while(pastSeq == self->currentSeq_ && !cancellation.is_cancellation_requested())
+				co_await self->pollEvent_.async_wait(cancellation);
+
+			auto edges = self->edgesSince_(pastSeq);
+			if((edges & mask) || cancellation.is_cancellation_requested())
+				co_return PollWaitResult{self->currentSeq_, edges};
+
+			// Mask was not satisfied.
+			pastSeq = self->currentSeq_;
+		}
+	}
+
+	static async::result<frg::expected<protocols::fs::Error, PollStatusResult>>
+	pollStatus(void *obj) {
+		auto self = static_cast<Udp4Socket *>(obj);
+		co_return PollStatusResult{self->currentSeq_, self->activeEvents_()};
+	}
+
+	static helix::BorrowedDescriptor accessStatusPage(void *obj) {
+		auto self = static_cast<Udp4Socket *>(obj);
+		return self->statusPage_.getMemory();
+	}
+
 
 	constexpr static FileOperations ops {
+		.pollWait = &pollWait,
+		.pollStatus = &pollStatus,
 		.bind = &bind,
 		.connect = &connect,
 		.recvMsg = &recvmsg,
 		.sendMsg = &sendmsg,
+		.accessStatusPage = &accessStatusPage,
 	};
 
 	bool bindAvailable(uint32_t addr = INADDR_ANY) {
@@ -368,7 +407,48 @@ struct Udp4Socket {
 private:
 	friend struct Udp4;
 
+	// Datagrams are always sent immediately, hence the socket is always writable.
+	int activeEvents_() {
+		int active = EPOLLOUT;
+		if(queuedDatagrams_)
+			active |= EPOLLIN;
+		return active;
+	}
+
+	int edgesSince_(uint64_t pastSeq) {
+		int edges = 0;
+		if(inSeq_ > pastSeq)
+			edges |= EPOLLIN;
+		if(outSeq_ > pastSeq)
+			edges |= EPOLLOUT;
+		return edges;
+	}
+
+	void updateStatusPage_() {
+		statusPage_.update(currentSeq_, activeEvents_(), edgesSince_(publishedSeq_));
+		publishedSeq_ = currentSeq_;
+	}
+
+	void enqueueDatagram_(Udp udp) {
+		queue_.emplace(std::move(udp));
+		queuedDatagrams_++;
+		inSeq_ = ++currentSeq_;
+		updateStatusPage_();
+		pollEvent_.raise();
+	}
+
 	async::queue<Udp, stl_allocator> queue_;
+	size_t queuedDatagrams_ = 0;
+
+	// Sequence numbers that implement the poll() function.
+	uint64_t currentSeq_ = 1;
+	uint64_t inSeq_ = 0;
+	uint64_t outSeq_ = 1;
+	// Sequence that was last written to the status page.
+	uint64_t publishedSeq_ = 0;
+	async::recurring_event pollEvent_;
+	protocols::fs::StatusPageProvider statusPage_;
+
 	Endpoint remote_;
 	Endpoint local_;
 	Udp4 *parent_;
@@ -389,7 +469,7 @@ void Udp4::feedDatagram(smarter::shared_ptr<const Ip4Packet> packet) {
 		auto ep = i->first;
 		if (ep.addr == udp.packet->header.destination
 			|| ep.addr == INADDR_ANY) {
-			i->second->queue_.emplace(std::move(udp));
+			i->second->enqueueDatagram_(std::move(udp));
 			break;
 		}
 	}
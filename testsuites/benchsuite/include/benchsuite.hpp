@@ -0,0 +1,207 @@
+#pragma once
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The optional trailing arguments initialize a benchmark_options,
+// e.g. DEFINE_BENCHMARK(nop, f, .batch = 100).
+#define DEFINE_BENCHMARK(s, f, ...) \
+	static benchmark_case bench_ ## s{#s, f, benchmark_options{__VA_ARGS__}};
+
+struct benchmark_options {
+	// Number of threads that run the benchmark concurrently.
+	// Zero means one thread per CPU.
+	int threads = 1;
+
+	// Number of iterations that are timed together and yield a single sample.
+	// Benchmarks of operations that take only a few hundred cycles should
+	// use batch > 1 so that the cost of reading the clock does not dominate.
+	size_t batch = 1;
+
+	// Number of payload bytes that each iteration transfers (zero if not applicable).
+	size_t bytes = 0;
+};
+
+// Passed to each benchmark; the benchmark calls keep_running() before each iteration.
+// Each batch of iterations produces one sample (in nanoseconds per iteration).
+// Time between pause_timing() and resume_timing() is not attributed to any iteration.
+struct benchmark_state {
+	using clock = std::chrono::steady_clock;
+
+	benchmark_state(int thread_index, int cpu, size_t batch,
+			clock::duration duration, size_t max_samples)
+	: thread_index_{thread_index}, cpu_{cpu}, batch_{batch},
+			duration_{duration}, max_samples_{max_samples} {
+		samples_.reserve(max_samples);
+	}
+
+	benchmark_state(const benchmark_state &) = delete;
+
+	benchmark_state &operator= (const benchmark_state &) = delete;
+
+	// Index of the calling thread among all threads that run the benchmark.
+	int thread_index() {
+		return thread_index_;
+	}
+
+	// CPU that the calling thread is pinned to or -1 if it is not pinned.
+	int cpu() {
+		return cpu_;
+	}
+
+	bool keep_running() {
+		if(done_)
+			return false;
+		if(!started_) {
+			started_ = true;
+			start_ = clock::now();
+			ref_ = start_;
+			return true;
+		}
+
+		++iterations_;
+		if(++in_batch_ < batch_)
+			return true;
+
+		auto now = clock::now();
+		active_ += now - ref_;
+		samples_.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				active_).count() / batch_);
+		active_ = {};
+		in_batch_ = 0;
+
+		if(now - start_ >= duration_ || samples_.size() >= max_samples_) {
+			end_ = now;
+			done_ = true;
+			return false;
+		}
+		ref_ = clock::now();
+		return true;
+	}
+
+	void pause_timing() {
+		active_ += clock::now() - ref_;
+	}
+
+	void resume_timing() {
+		ref_ = clock::now();
+	}
+
+	// The following are only used by the runner.
+
+	std::vector<uint64_t> &samples() {
+		return samples_;
+	}
+
+	uint64_t iterations() {
+		return iterations_;
+	}
+
+	clock::duration elapsed() {
+		return end_ - start_;
+	}
+
+private:
+	int thread_index_;
+	int cpu_;
+	size_t batch_;
+	clock::duration duration_;
+	size_t max_samples_;
+
+	bool started_ = false;
+	bool done_ = false;
+	clock::time_point start_;
+	clock::time_point end_;
+	clock::time_point ref_;
+	clock::duration active_{};
+	size_t in_batch_ = 0;
+	uint64_t iterations_ = 0;
+	std::vector<uint64_t> samples_;
+};
+
+struct abstract_benchmark {
+private:
+	static void register_benchmark(abstract_benchmark *bp);
+
+public:
+	abstract_benchmark(const char *name, benchmark_options options)
+	: name_{name}, options_{options} {
+		register_benchmark(this);
+	}
+
+	abstract_benchmark(const abstract_benchmark &) = delete;
+
+	virtual ~abstract_benchmark() = default;
+
+	abstract_benchmark &operator= (const abstract_benchmark &) = delete;
+
+	const char *name() {
+		return name_;
+	}
+
+	const benchmark_options &options() {
+		return options_;
+	}
+
+	virtual void run(benchmark_state &state) = 0;
+
+private:
+	const char *name_;
+	benchmark_options options_;
+};
+
+// Runs benchmarks that return a value R (e.g., coroutines).
+// Suites that use such benchmarks specialize this template (see kernel-bench).
+template<typename R>
+struct benchmark_driver;
+
+// Benchmarks are plain functions or return a value that is handled by benchmark_driver.
+template<typename F>
+struct benchmark_case : abstract_benchmark {
+	benchmark_case(const char *name, F functor, benchmark_options options)
+	: abstract_benchmark{name, options}, functor_{std::move(functor)} { }
+
+	void run(benchmark_state &state) override {
+		using result_type = std::invoke_result_t<F &, benchmark_state &>;
+		if constexpr (std::is_same_v<result_type, void>) {
+			functor_(state);
+		}else{
+			benchmark_driver<result_type>::run(functor_(state));
+		}
+	}
+
+private:
+	F functor_;
+};
+
+// All benchmarks that are linked into the program, in registration order.
+std::vector<abstract_benchmark *> &benchmark_ptrs();
+
+// Returns true if the benchmark's name contains one of the filters (or if there are none).
+bool is_selected(const std::vector<std::string> &filters, abstract_benchmark *bp);
+
+struct benchmark_statistics {
+	size_t threads = 0;
+	uint64_t iterations = 0;
+	size_t samples = 0;
+	double mean = 0;
+	double stddev = 0;
+	uint64_t min = 0;
+	uint64_t p50 = 0;
+	uint64_t p99 = 0;
+	uint64_t p999 = 0;
+	uint64_t max = 0;
+	double ops_per_second = 0;
+};
+
+// Aggregates the samples of all threads that ran a benchmark.
+benchmark_statistics compute_statistics(const std::vector<benchmark_state *> &states);
+
+// Both suites print results in the same format such that they can be compared directly.
+void print_human(abstract_benchmark *bp, const benchmark_statistics &stats);
+void print_json(abstract_benchmark *bp, const benchmark_statistics &stats, bool first);
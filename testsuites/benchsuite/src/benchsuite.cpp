@@ -0,0 +1,110 @@
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include <benchsuite.hpp>
+
+std::vector<abstract_benchmark *> &benchmark_ptrs() {
+	static std::vector<abstract_benchmark *> singleton;
+	return singleton;
+}
+
+void abstract_benchmark::register_benchmark(abstract_benchmark *bp) {
+	benchmark_ptrs().push_back(bp);
+}
+
+bool is_selected(const std::vector<std::string> &filters, abstract_benchmark *bp) {
+	if(filters.empty())
+		return true;
+	for(auto &filter : filters) {
+		if(strstr(bp->name(), filter.c_str()))
+			return true;
+	}
+	return false;
+}
+
+namespace {
+
+// Nearest-rank percentile of a sorted sample vector.
+uint64_t percentile(const std::vector<uint64_t> &sorted, double q) {
+	auto rank = static_cast<size_t>(ceil(q * sorted.size()));
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+} // anonymous namespace
+
+benchmark_statistics compute_statistics(const std::vector<benchmark_state *> &states) {
+	benchmark_statistics stats;
+	stats.threads = states.size();
+
+	std::vector<uint64_t> all;
+	for(auto state : states) {
+		stats.iterations += state->iterations();
+		auto seconds = std::chrono::duration<double>(state->elapsed()).count();
+		if(seconds > 0)
+			stats.ops_per_second += state->iterations() / seconds;
+		all.insert(all.end(), state->samples().begin(), state->samples().end());
+	}
+	std::sort(all.begin(), all.end());
+	stats.samples = all.size();
+	if(all.empty())
+		return stats;
+
+	double sum = 0;
+	for(uint64_t n : all)
+		sum += n;
+	stats.mean = sum / all.size();
+
+	double var = 0;
+	for(uint64_t n : all)
+		var += (n - stats.mean) * (n - stats.mean);
+	stats.stddev = sqrt(var / all.size());
+
+	stats.min = all.front();
+	stats.p50 = percentile(all, 0.5);
+	stats.p99 = percentile(all, 0.99);
+	stats.p999 = percentile(all, 0.999);
+	stats.max = all.back();
+	return stats;
+}
+
+void print_human(abstract_benchmark *bp, const benchmark_statistics &stats) {
+	auto bytes = bp->options().bytes;
+
+	std::cout << bp->name();
+	if(stats.threads > 1)
+		std::cout << " (" << stats.threads << " threads)";
+	std::cout << "\n    " << static_cast<uint64_t>(stats.ops_per_second)
+			<< " iterations per second";
+	if(bytes)
+		std::cout << " (" << static_cast<uint64_t>(stats.ops_per_second * bytes / (1024 * 1024))
+				<< " MiB/s)";
+	std::cout << "\n    mean: " << static_cast<uint64_t>(stats.mean)
+			<< " ns, std: " << static_cast<uint64_t>(stats.stddev) << " ns\n"
+			<< "    min: " << stats.min << " ns, p50: " << stats.p50
+			<< " ns, p99: " << stats.p99 << " ns, p99.9: " << stats.p999
+			<< " ns, max: " << stats.max << " ns" << std::endl;
+}
+
+void print_json(abstract_benchmark *bp, const benchmark_statistics &stats, bool first) {
+	auto bytes = bp->options().bytes;
+
+	std::cout << (first ? "" : ",\n")
+			<< "  {\"name\": \"" << bp->name() << "\""
+			<< ", \"threads\": " << stats.threads
+			<< ", \"iterations\": " << stats.iterations
+			<< ", \"samples\": " << stats.samples
+			<< ", \"ops_per_second\": " << static_cast<uint64_t>(stats.ops_per_second);
+	if(bytes)
+		std::cout << ", \"bytes_per_second\": "
+				<< static_cast<uint64_t>(stats.ops_per_second * bytes);
+	std::cout << ", \"mean_ns\": " << static_cast<uint64_t>(stats.mean)
+			<< ", \"stddev_ns\": " << static_cast<uint64_t>(stats.stddev)
+			<< ", \"min_ns\": " << stats.min
+			<< ", \"p50_ns\": " << stats.p50
+			<< ", \"p99_ns\": " << stats.p99
+			<< ", \"p999_ns\": " << stats.p999
+			<< ", \"max_ns\": " << stats.max << "}" << std::flush;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <utility>
+
+#include <async/result.hpp>
+#include <benchsuite.hpp>
+#include <helix/ipc.hpp>
+
+// Coroutine benchmarks are driven by the dispatcher of the calling thread.
+template<>
+struct benchmark_driver<async::result<void>> {
+	static void run(async::result<void> result) {
+		async::run(std::move(result), helix::currentDispatcher);
+	}
+};
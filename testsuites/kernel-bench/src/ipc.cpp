@@ -0,0 +1,159 @@
+#include <assert.h>
+
+#include <vector>
+
+#include <async/algorithm.hpp>
+#include <async/oneshot-event.hpp>
+#include <async/result.hpp>
+#include <helix/ipc.hpp>
+
+#include "async-benchmark.hpp"
+
+namespace {
+
+async::result<void> doAsyncNop(benchmark_state &state) {
+	while(state.keep_running()) {
+		auto result = co_await helix_ng::asyncNop();
+		HEL_CHECK(result.error());
+	}
+}
+
+// Keeps a number of async nops in flight at the same time.
+// The samples are thus the inverse of the rate at which the queue delivers completions.
+auto doQueueThroughput(int inFlight) {
+	return [=] (benchmark_state &state) -> async::result<void> {
+		int pending = inFlight;
+		async::oneshot_event doneEvent;
+
+		auto worker = [&] () -> async::result<void> {
+			while(state.keep_running()) {
+				auto result = co_await helix_ng::asyncNop();
+				HEL_CHECK(result.error());
+			}
+			if(!--pending)
+				doneEvent.raise();
+		};
+
+		for(int i = 0; i < inFlight; ++i)
+			async::detach(worker());
+		co_await doneEvent.wait();
+	};
+}
+
+auto doSendRecvBuffer(size_t size) {
+	return [=] (benchmark_state &state) -> async::result<void> {
+		auto [lane1, lane2] = helix::createStream();
+		std::vector<std::byte> sBuf(size);
+		std::vector<std::byte> rBuf(size);
+
+		while(state.keep_running()) {
+			co_await async::when_all(
+				async::transform(
+					helix_ng::exchangeMsgs(lane1, helix_ng::sendBuffer(sBuf.data(), size)
+				), [&] (auto result) {
+					auto [send] = std::move(result);
+					HEL_CHECK(send.error());
+				}),
+				async::transform(
+					helix_ng::exchangeMsgs(lane2, helix_ng::recvBuffer(rBuf.data(), size)
+				), [&] (auto result) {
+					auto [recv] = std::move(result);
+					HEL_CHECK(recv.error());
+					assert(recv.actualLength() == size);
+				})
+			);
+		}
+	};
+}
+
+// Each iteration opens a conversation via offer/accept; closing it again is included.
+async::result<void> doOfferAccept(benchmark_state &state) {
+	auto [lane1, lane2] = helix::createStream();
+
+	while(state.keep_running()) {
+		co_await async::when_all(
+			async::transform(
+				helix_ng::exchangeMsgs(lane1, helix_ng::offer()),
+				[&] (auto result) {
+					auto [offer] = std::move(result);
+					HEL_CHECK(offer.error());
+				}),
+			async::transform(
+				helix_ng::exchangeMsgs(lane2, helix_ng::accept()),
+				[&] (auto result) {
+					auto [accept] = std::move(result);
+					HEL_CHECK(accept.error());
+				})
+		);
+	}
+}
+
+// Transfers a memory descriptor from one end of a stream to the other.
+async::result<void> doPushPullDescriptor(benchmark_state &state) {
+	auto [lane1, lane2] = helix::createStream();
+
+	HelHandle handle;
+	HEL_CHECK(helAllocateMemory(0x1000, 0, nullptr, &handle));
+	helix::UniqueDescriptor memory{handle};
+
+	while(state.keep_running()) {
+		co_await async::when_all(
+			async::transform(
+				helix_ng::exchangeMsgs(lane1, helix_ng::pushDescriptor(memory)),
+				[&] (auto result) {
+					auto [push] = std::move(result);
+					HEL_CHECK(push.error());
+				}),
+			async::transform(
+				helix_ng::exchangeMsgs(lane2, helix_ng::pullDescriptor()),
+				[&] (auto result) {
+					auto [pull] = std::move(result);
+					HEL_CHECK(pull.error());
+					pull.descriptor();
+				})
+		);
+	}
+}
+
+// There is no way to trigger a hardware IRQ from userspace without disturbing the driver
+// that owns the line. We raise a oneshot event instead; completions of IRQ and event
+// objects travel the same path from the kernel to the userspace queue.
+async::result<void> doEventLatency(benchmark_state &state) {
+	helix::UniqueDescriptor event;
+	while(state.keep_running()) {
+		// Oneshot events cannot be re-armed; replace the event outside of the timed region.
+		state.pause_timing();
+		HelHandle handle;
+		HEL_CHECK(helCreateOneshotEvent(&handle));
+		event = helix::UniqueDescriptor{handle};
+		state.resume_timing();
+
+		co_await async::when_all(
+			async::transform(
+				helix_ng::awaitEvent(event, 0),
+				[&] (auto result) {
+					HEL_CHECK(result.error());
+				}),
+			[&] () -> async::result<void> {
+				HEL_CHECK(helRaiseEvent(event.getHandle()));
+				co_return;
+			}()
+		);
+	}
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(async_nop, doAsyncNop, .batch = 100)
+DEFINE_BENCHMARK(async_nop_per_cpu, doAsyncNop, .threads = 0, .batch = 100)
+DEFINE_BENCHMARK(queue_throughput, doQueueThroughput(64), .batch = 64)
+DEFINE_BENCHMARK(send_recv_buffer_1, doSendRecvBuffer(1))
+DEFINE_BENCHMARK(send_recv_buffer_32, doSendRecvBuffer(32))
+DEFINE_BENCHMARK(send_recv_buffer_128, doSendRecvBuffer(128))
+DEFINE_BENCHMARK(send_recv_buffer_4k, doSendRecvBuffer(4096))
+DEFINE_BENCHMARK(send_recv_buffer_16k, doSendRecvBuffer(16 * 1024))
+DEFINE_BENCHMARK(send_recv_buffer_64k, doSendRecvBuffer(64 * 1024))
+DEFINE_BENCHMARK(send_recv_buffer_1m, doSendRecvBuffer(1024 * 1024))
+DEFINE_BENCHMARK(offer_accept, doOfferAccept)
+DEFINE_BENCHMARK(push_pull_descriptor, doPushPullDescriptor)
+DEFINE_BENCHMARK(event_latency, doEventLatency)
@@ -1,267 +1,147 @@
-#include <math.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
-#include <async/result.hpp>
-#include <async/algorithm.hpp>
 #include <helix/ipc.hpp>
 
-#include <vector>
+#include <benchsuite.hpp>
 
 namespace {
 
-struct IterationsPerSecondBenchmark {
-	using clock = std::chrono::high_resolution_clock;
-
-	void launchRepetition() {
-		ref_ = clock::now();
-	}
-
-	bool isRepetitionDone() {
-		auto elapsed = duration_cast<std::chrono::nanoseconds>(
-					std::chrono::high_resolution_clock::now() - ref_);
-		return elapsed.count() > 1'000'000'000;
-	}
+// Upper bound on the number of samples that each thread records.
+constexpr size_t maxSamples = 1 << 20;
 
-	void announceIterations(uint64_t iters) {
-		std::cout << "    " << iters << " iterations per second" << std::endl;
-		results_.push_back(iters);
-	}
-
-	void finalizeStatistics() {
-		double avg = 0;
-		for(uint64_t n : results_)
-			avg += n;
-		avg /= results_.size();
-
-		double var = 0;
-		for(uint64_t n : results_)
-			var += (n - avg) * (n - avg);
-		var /= results_.size();
-
-		std::cout << "    avg: " << static_cast<uint64_t>(avg)
-				<< ", std: " << static_cast<uint64_t>(sqrt(var)) << std::endl;
-	}
-
-private:
-	std::vector<double> results_;
-	std::chrono::time_point<clock> ref_;
+struct Config {
+	bool json = false;
+	bool pin = true;
+	std::vector<std::string> filters;
+	uint64_t warmupMs = 200;
+	uint64_t durationMs = 1000;
 };
 
-void doNopBenchmark() {
-	std::cout << "syscall ops" << std::endl;
-
-	IterationsPerSecondBenchmark bench;
-	for(int k = 0; k < 5; ++k) {
-		uint64_t n = 0;
-		bench.launchRepetition();
-		while(!bench.isRepetitionDone()) {
-			for(int i = 0; i < 100; ++i) {
-				HEL_CHECK(helNop());
-				++n;
-			}
-		}
-		bench.announceIterations(n);
-	}
-	bench.finalizeStatistics();
-}
-
-async::result<void> doAsyncNopBenchmark() {
-	std::cout << "ipc ops" << std::endl;
-
-	IterationsPerSecondBenchmark bench;
-	for(int k = 0; k < 5; ++k) {
-		uint64_t n = 0;
-		bench.launchRepetition();
-		while(!bench.isRepetitionDone()) {
-			for(int i = 0; i < 100; ++i) {
-				auto result = co_await helix_ng::asyncNop();
-				HEL_CHECK(result.error());
-				++n;
-			}
-		}
-		bench.announceIterations(n);
-	}
-	bench.finalizeStatistics();
+int countCpus() {
+	int n = 0;
+	HelCpuStats stats;
+	while(helQueryCpuStats(n, &stats) == kHelErrNone)
+		++n;
+	return n ? n : 1;
 }
 
-void doFutexBenchmark() {
-	std::cout << "futex waits" << std::endl;
-
-	IterationsPerSecondBenchmark bench;
-	for(int k = 0; k < 5; ++k) {
-		uint64_t n = 0;
-		bench.launchRepetition();
-		while(!bench.isRepetitionDone()) {
-			for(int i = 0; i < 100; ++i) {
-				int futex = 1;
-				HEL_CHECK(helFutexWait(&futex, 0, -1));
-				++n;
-			}
-		}
-		bench.announceIterations(n);
-	}
-	bench.finalizeStatistics();
+void pinToCpu(int cpu) {
+	std::vector<uint8_t> mask(cpu / 8 + 1);
+	mask[cpu / 8] |= 1 << (cpu % 8);
+	HEL_CHECK(helSetAffinity(kHelThisThread, mask.data(), mask.size()));
 }
 
-void doAllocateBenchmark(size_t size) {
-	std::cout << "allocate memory, size = " << (size / (1024 * 1024)) << " MiB" << std::endl;
+benchmark_statistics runBenchmark(const Config &config, int numCpus, abstract_benchmark *bp) {
+	auto &options = bp->options();
+	int numThreads = options.threads ? options.threads : numCpus;
 
-	IterationsPerSecondBenchmark bench;
-	for(int k = 0; k < 5; ++k) {
-		uint64_t n = 0;
-		bench.launchRepetition();
-		while(!bench.isRepetitionDone()) {
-			HelHandle handle;
-			HEL_CHECK(helAllocateMemory(size, 0, nullptr, &handle));
-			HEL_CHECK(helCloseDescriptor(kHelThisUniverse, handle));
-			++n;
-		}
-		bench.announceIterations(n);
+	std::vector<std::unique_ptr<benchmark_state>> states;
+	for(int i = 0; i < numThreads; ++i) {
+		int cpu = config.pin ? (i % numCpus) : -1;
+		states.push_back(std::make_unique<benchmark_state>(i, cpu, options.batch,
+				std::chrono::milliseconds{config.durationMs}, maxSamples));
 	}
-	bench.finalizeStatistics();
-}
 
-void doMapBenchmark(size_t size) {
-	std::cout << "memory mapping, size = " << (size / (1024 * 1024)) << " MiB" << std::endl;
+	// All threads finish their warm-up before any of them starts to measure.
+	std::atomic<int> arrived{0};
 
-	IterationsPerSecondBenchmark bench;
-	for(int k = 0; k < 5; ++k) {
-		uint64_t n = 0;
-		bench.launchRepetition();
-		while(!bench.isRepetitionDone()) {
-			HelHandle handle;
-			HEL_CHECK(helAllocateMemory(size, 0, nullptr, &handle));
-			void *window;
-			HEL_CHECK(helMapMemory(handle, kHelNullHandle, nullptr, 0, size,
-					kHelMapProtRead | kHelMapProtWrite, &window));
-			HEL_CHECK(helUnmapMemory(kHelNullHandle, window, size));
-			HEL_CHECK(helCloseDescriptor(kHelThisUniverse, handle));
-			++n;
-		}
-		bench.announceIterations(n);
-	}
-	bench.finalizeStatistics();
-}
-
-void doMapPopulatedBenchmark(size_t size) {
-	std::cout << "populated mapping, size = " << (size / (1024 * 1024)) << " MiB" << std::endl;
+	auto work = [&] (benchmark_state *state) {
+		if(state->cpu() >= 0)
+			pinToCpu(state->cpu());
 
-	HelHandle handle;
-	HEL_CHECK(helAllocateMemory(size, 0, nullptr, &handle));
-	void *window;
-	HEL_CHECK(helMapMemory(handle, kHelNullHandle, nullptr, 0, size,
-			kHelMapProtRead | kHelMapProtWrite, &window));
+		benchmark_state warmup{state->thread_index(), state->cpu(), options.batch,
+				std::chrono::milliseconds{config.warmupMs}, maxSamples};
+		bp->run(warmup);
 
-	// Touch all mapped pages.
-	auto p = reinterpret_cast<volatile std::byte *>(window);
-	for(size_t progress = 0; progress < size; progress += 0x1000)
-		p[progress] = static_cast<std::byte>(0);
+		arrived.fetch_add(1, std::memory_order_acq_rel);
+		while(arrived.load(std::memory_order_acquire) < numThreads)
+			HEL_CHECK(helYield());
 
-	HEL_CHECK(helUnmapMemory(kHelNullHandle, window, size));
+		bp->run(*state);
+	};
 
-	IterationsPerSecondBenchmark bench;
-	for(int k = 0; k < 5; ++k) {
-		uint64_t n = 0;
-		bench.launchRepetition();
-		while(!bench.isRepetitionDone()) {
-			void *window;
-			HEL_CHECK(helMapMemory(handle, kHelNullHandle, nullptr, 0, size,
-					kHelMapProtRead | kHelMapProtWrite, &window));
-			HEL_CHECK(helUnmapMemory(kHelNullHandle, window, size));
-			++n;
-		}
-		bench.announceIterations(n);
+	if(numThreads == 1) {
+		// Run on the main thread such that benchmarks can rely on its dispatcher.
+		work(states[0].get());
+	}else{
+		std::vector<std::thread> threads;
+		for(auto &state : states)
+			threads.emplace_back(work, state.get());
+		for(auto &thread : threads)
+			thread.join();
 	}
-	bench.finalizeStatistics();
 
-	HEL_CHECK(helCloseDescriptor(kHelThisUniverse, handle));
+	std::vector<benchmark_state *> statePtrs;
+	for(auto &state : states)
+		statePtrs.push_back(state.get());
+	return compute_statistics(statePtrs);
 }
 
-void doPageFaultBenchmark(size_t size) {
-	std::cout << "page faults (mapping size = " << (size / (1024 * 1024)) << " MiB)" << std::endl;
-
-	IterationsPerSecondBenchmark bench;
-	for(int k = 0; k < 5; ++k) {
-		uint64_t n = 0;
-		bench.launchRepetition();
-		while(!bench.isRepetitionDone()) {
-			HelHandle handle;
-			HEL_CHECK(helAllocateMemory(size, 0, nullptr, &handle));
-			void *window;
-			HEL_CHECK(helMapMemory(handle, kHelNullHandle, nullptr, 0, size,
-					kHelMapProtRead | kHelMapProtWrite, &window));
+void usage() {
+	std::cerr << "usage: kernel-bench [--json] [--list] [--no-pin]"
+			" [--warmup-ms N] [--duration-ms N] [FILTER...]\n"
+			"    Runs all benchmarks whose name contains one of the FILTERs."
+			<< std::endl;
+}
 
-			// Touch all mapped pages.
-			auto p = reinterpret_cast<volatile std::byte *>(window);
-			for(size_t progress = 0; progress < size; progress += 0x1000) {
-				p[progress] = static_cast<std::byte>(0);
-				++n;
-			}
+} // anonymous namespace
 
-			HEL_CHECK(helUnmapMemory(kHelNullHandle, window, size));
-			HEL_CHECK(helCloseDescriptor(kHelThisUniverse, handle));
+int main(int argc, char **argv) {
+	Config config;
+	bool list = false;
+
+	for(int i = 1; i < argc; ++i) {
+		std::string_view arg{argv[i]};
+		if(arg == "--json") {
+			config.json = true;
+		}else if(arg == "--list") {
+			list = true;
+		}else if(arg == "--no-pin") {
+			config.pin = false;
+		}else if(arg == "--warmup-ms" && i + 1 < argc) {
+			config.warmupMs = strtoull(argv[++i], nullptr, 10);
+		}else if(arg == "--duration-ms" && i + 1 < argc) {
+			config.durationMs = strtoull(argv[++i], nullptr, 10);
+		}else if(arg.size() && arg[0] == '-') {
+			usage();
+			return 1;
+		}else{
+			config.filters.emplace_back(arg);
 		}
-		bench.announceIterations(n);
 	}
-	bench.finalizeStatistics();
-}
 
-async::result<void> doSendRecvBufferBenchmark(size_t size) {
-	auto [lane1, lane2] = helix::createStream();
-	std::vector<std::byte> sBuf(size);
-	std::vector<std::byte> rBuf(size);
-
-	if(size < 1024) {
-		std::cout << "size = " << size << std::endl;
-	}else if(size < 1024 * 1024) {
-		std::cout << "size = " << (size / 1024) << " KiB" << std::endl;
-	}else{
-		std::cout << "size = " << (size / (1024 * 1024)) << " MiB" << std::endl;
+	if(list) {
+		for(auto bp : benchmark_ptrs())
+			std::cout << bp->name() << std::endl;
+		return 0;
 	}
 
-	IterationsPerSecondBenchmark bench;
-	for(int k = 0; k < 5; ++k) {
-		uint64_t n = 0;
-		bench.launchRepetition();
-		while(!bench.isRepetitionDone()) {
-			for(int i = 0; i < 100; ++i) {
-				co_await async::when_all(
-					async::transform(
-						helix_ng::exchangeMsgs(lane1, helix_ng::sendBuffer(sBuf.data(), size)
-					), [&] (auto result) {
-						auto [send] = std::move(result);
-						HEL_CHECK(send.error());
-					}),
-					async::transform(
-						helix_ng::exchangeMsgs(lane2, helix_ng::recvBuffer(rBuf.data(), size)
-					), [&] (auto result) {
-						auto [recv] = std::move(result);
-						HEL_CHECK(recv.error());
-						assert(recv.actualLength() == size);
-					})
-				);
-				++n;
-			}
+	int numCpus = countCpus();
+
+	if(config.json)
+		std::cout << "{\"cpus\": " << numCpus << ", \"benchmarks\": [\n" << std::flush;
+
+	bool first = true;
+	for(auto bp : benchmark_ptrs()) {
+		if(!is_selected(config.filters, bp))
+			continue;
+		auto stats = runBenchmark(config, numCpus, bp);
+		if(config.json) {
+			print_json(bp, stats, first);
+		}else{
+			print_human(bp, stats);
 		}
-		bench.announceIterations(n);
+		first = false;
 	}
-	bench.finalizeStatistics();
-}
-
-} // anonymous namespace
 
-int main() {
-	doNopBenchmark();
-	doFutexBenchmark();
-	async::run(doAsyncNopBenchmark(), helix::currentDispatcher);
-	doAllocateBenchmark(1 << 20);
-	doMapBenchmark(1 << 20);
-	doMapPopulatedBenchmark(1 << 20);
-	doPageFaultBenchmark(1 << 20);
-	async::run(doSendRecvBufferBenchmark(1), helix::currentDispatcher);
-	async::run(doSendRecvBufferBenchmark(32), helix::currentDispatcher);
-	async::run(doSendRecvBufferBenchmark(128), helix::currentDispatcher);
-	async::run(doSendRecvBufferBenchmark(4096), helix::currentDispatcher);
-	async::run(doSendRecvBufferBenchmark(16 * 1024), helix::currentDispatcher);
-	async::run(doSendRecvBufferBenchmark(64 * 1024), helix::currentDispatcher);
-	async::run(doSendRecvBufferBenchmark(1024 * 1024), helix::currentDispatcher);
+	if(config.json)
+		std::cout << "\n]}" << std::endl;
 }
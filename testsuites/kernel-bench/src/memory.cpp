@@ -0,0 +1,173 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <helix/ipc.hpp>
+
+#include <benchsuite.hpp>
+
+namespace {
+
+constexpr size_t pageSize = 0x1000;
+
+auto doAllocate(size_t size) {
+	return [=] (benchmark_state &state) {
+		while(state.keep_running()) {
+			HelHandle handle;
+			HEL_CHECK(helAllocateMemory(size, 0, nullptr, &handle));
+			HEL_CHECK(helCloseDescriptor(kHelThisUniverse, handle));
+		}
+	};
+}
+
+auto doMap(size_t size) {
+	return [=] (benchmark_state &state) {
+		while(state.keep_running()) {
+			HelHandle handle;
+			HEL_CHECK(helAllocateMemory(size, 0, nullptr, &handle));
+			void *window;
+			HEL_CHECK(helMapMemory(handle, kHelNullHandle, nullptr, 0, size,
+					kHelMapProtRead | kHelMapProtWrite, &window));
+			HEL_CHECK(helUnmapMemory(kHelNullHandle, window, size));
+			HEL_CHECK(helCloseDescriptor(kHelThisUniverse, handle));
+		}
+	};
+}
+
+auto doMapPopulated(size_t size) {
+	return [=] (benchmark_state &state) {
+		HelHandle handle;
+		HEL_CHECK(helAllocateMemory(size, 0, nullptr, &handle));
+		void *window;
+		HEL_CHECK(helMapMemory(handle, kHelNullHandle, nullptr, 0, size,
+				kHelMapProtRead | kHelMapProtWrite, &window));
+
+		// Touch all mapped pages.
+		auto p = reinterpret_cast<volatile std::byte *>(window);
+		for(size_t progress = 0; progress < size; progress += pageSize)
+			p[progress] = static_cast<std::byte>(0);
+
+		HEL_CHECK(helUnmapMemory(kHelNullHandle, window, size));
+
+		while(state.keep_running()) {
+			void *window;
+			HEL_CHECK(helMapMemory(handle, kHelNullHandle, nullptr, 0, size,
+					kHelMapProtRead | kHelMapProtWrite, &window));
+			HEL_CHECK(helUnmapMemory(kHelNullHandle, window, size));
+		}
+
+		HEL_CHECK(helCloseDescriptor(kHelThisUniverse, handle));
+	};
+}
+
+// Each iteration faults in a single page of fresh anonymous memory.
+// Setting up and tearing down the mapping is not timed.
+auto doPageFault(size_t size) {
+	return [=] (benchmark_state &state) {
+		HelHandle handle = kHelNullHandle;
+		void *window = nullptr;
+		size_t progress = size;
+
+		auto release = [&] {
+			if(!window)
+				return;
+			HEL_CHECK(helUnmapMemory(kHelNullHandle, window, size));
+			HEL_CHECK(helCloseDescriptor(kHelThisUniverse, handle));
+			window = nullptr;
+		};
+
+		while(state.keep_running()) {
+			if(progress == size) {
+				state.pause_timing();
+				release();
+				HEL_CHECK(helAllocateMemory(size, 0, nullptr, &handle));
+				HEL_CHECK(helMapMemory(handle, kHelNullHandle, nullptr, 0, size,
+						kHelMapProtRead | kHelMapProtWrite, &window));
+				progress = 0;
+				state.resume_timing();
+			}
+
+			auto p = reinterpret_cast<volatile std::byte *>(window);
+			p[progress] = static_cast<std::byte>(0);
+			progress += pageSize;
+		}
+		release();
+	};
+}
+
+// Each iteration writes to a single page of a copy-on-write mapping of populated memory,
+// such that the kernel has to copy the page.
+auto doCowFault(size_t size) {
+	return [=] (benchmark_state &state) {
+		HelHandle memory;
+		HEL_CHECK(helAllocateMemory(size, 0, nullptr, &memory));
+		void *source;
+		HEL_CHECK(helMapMemory(memory, kHelNullHandle, nullptr, 0, size,
+				kHelMapProtRead | kHelMapProtWrite, &source));
+		auto s = reinterpret_cast<volatile std::byte *>(source);
+		for(size_t progress = 0; progress < size; progress += pageSize)
+			s[progress] = static_cast<std::byte>(1);
+		HEL_CHECK(helUnmapMemory(kHelNullHandle, source, size));
+
+		HelHandle handle = kHelNullHandle;
+		void *window = nullptr;
+		size_t progress = size;
+
+		auto release = [&] {
+			if(!window)
+				return;
+			HEL_CHECK(helUnmapMemory(kHelNullHandle, window, size));
+			HEL_CHECK(helCloseDescriptor(kHelThisUniverse, handle));
+			window = nullptr;
+		};
+
+		while(state.keep_running()) {
+			if(progress == size) {
+				state.pause_timing();
+				release();
+				HEL_CHECK(helCopyOnWrite(memory, 0, size, &handle));
+				HEL_CHECK(helMapMemory(handle, kHelNullHandle, nullptr, 0, size,
+						kHelMapProtRead | kHelMapProtWrite, &window));
+				progress = 0;
+				state.resume_timing();
+			}
+
+			auto p = reinterpret_cast<volatile std::byte *>(window);
+			p[progress] = static_cast<std::byte>(0);
+			progress += pageSize;
+		}
+		release();
+
+		HEL_CHECK(helCloseDescriptor(kHelThisUniverse, memory));
+	};
+}
+
+// Forks a child that exits immediately and waits for it.
+void doFork(benchmark_state &state) {
+	while(state.keep_running()) {
+		pid_t pid = fork();
+		if(pid < 0) {
+			perror("kernel-bench: fork() failed");
+			abort();
+		}
+		if(!pid)
+			_exit(0);
+		int status;
+		if(waitpid(pid, &status, 0) != pid) {
+			perror("kernel-bench: waitpid() failed");
+			abort();
+		}
+	}
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(allocate_1m, doAllocate(1 << 20))
+DEFINE_BENCHMARK(map_1m, doMap(1 << 20))
+DEFINE_BENCHMARK(map_populated_1m, doMapPopulated(1 << 20))
+DEFINE_BENCHMARK(page_fault, doPageFault(1 << 20))
+DEFINE_BENCHMARK(page_fault_per_cpu, doPageFault(1 << 20), .threads = 0)
+DEFINE_BENCHMARK(cow_fault, doCowFault(1 << 20))
+DEFINE_BENCHMARK(fork, doFork)
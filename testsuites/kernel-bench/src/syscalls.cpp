@@ -0,0 +1,120 @@
+#include <assert.h>
+
+#include <thread>
+#include <vector>
+
+#include <async/result.hpp>
+#include <helix/ipc.hpp>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#include "async-benchmark.hpp"
+
+namespace {
+
+void doNop(benchmark_state &state) {
+	while(state.keep_running())
+		HEL_CHECK(helNop());
+}
+
+void doFutex(benchmark_state &state) {
+	while(state.keep_running()) {
+		// The value does not match, hence this returns immediately.
+		int futex = 1;
+		HEL_CHECK(helFutexWait(&futex, 0, -1));
+	}
+}
+
+// Two threads on the same CPU pass a token back and forth via futexes.
+// Each iteration thus performs two context switches.
+// If dirtySimd is set, both threads modify the vector registers before each switch,
+// such that the kernel has to save and restore the full SIMD state.
+auto doContextSwitch(bool dirtySimd) {
+	return [=] (benchmark_state &state) {
+#if defined(__x86_64__)
+		unsigned int eax, ebx, ecx, edx;
+		bool haveAvx = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 28));
+#endif
+
+		int cpu = state.cpu() >= 0 ? state.cpu() : 0;
+		auto pinToCpu = [&] {
+			std::vector<uint8_t> mask(cpu / 8 + 1);
+			mask[cpu / 8] |= 1 << (cpu % 8);
+			HEL_CHECK(helSetAffinity(kHelThisThread, mask.data(), mask.size()));
+		};
+
+		auto touchSimd = [&] {
+#if defined(__x86_64__)
+			if(haveAvx) {
+				asm volatile ("vpcmpeqd %%ymm0, %%ymm0, %%ymm0" : : : "xmm0");
+			}else{
+				asm volatile ("pcmpeqd %%xmm0, %%xmm0" : : : "xmm0");
+			}
+#endif
+		};
+
+		// Token values: 0 = ping's turn, 1 = pong's turn, -1 = stop.
+		int token = 0;
+
+		auto waitFor = [&] (int value) -> int {
+			while(true) {
+				auto current = __atomic_load_n(&token, __ATOMIC_ACQUIRE);
+				if(current == value || current == -1)
+					return current;
+				HEL_CHECK(helFutexWait(&token, current, -1));
+			}
+		};
+
+		auto passTo = [&] (int value) {
+			__atomic_store_n(&token, value, __ATOMIC_RELEASE);
+			HEL_CHECK(helFutexWake(&token));
+		};
+
+		std::thread pong{[&] {
+			pinToCpu();
+			while(waitFor(1) == 1) {
+				if(dirtySimd)
+					touchSimd();
+				passTo(0);
+			}
+		}};
+
+		pinToCpu();
+		while(state.keep_running()) {
+			if(dirtySimd)
+				touchSimd();
+			passTo(1);
+			waitFor(0);
+		}
+		passTo(-1);
+
+		pong.join();
+	};
+}
+
+// Arms a timer that does not expire during the benchmark and cancels it again.
+async::result<void> doTimerArmCancel(benchmark_state &state) {
+	while(state.keep_running()) {
+		uint64_t tick;
+		HEL_CHECK(helGetClock(&tick));
+
+		helix::AwaitClock await;
+		auto &&submit = helix::submitAwaitClock(&await, tick + 1'000'000'000,
+				helix::Dispatcher::global());
+		HEL_CHECK(helCancelAsync(helix::Dispatcher::global().acquire(),
+				await.asyncId()));
+		co_await submit.async_wait();
+		assert(await.error() == kHelErrCancelled);
+	}
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(nop, doNop, .batch = 100)
+DEFINE_BENCHMARK(nop_per_cpu, doNop, .threads = 0, .batch = 100)
+DEFINE_BENCHMARK(futex_wait, doFutex, .batch = 100)
+DEFINE_BENCHMARK(context_switch, doContextSwitch(false))
+DEFINE_BENCHMARK(context_switch_dirty_simd, doContextSwitch(true))
+DEFINE_BENCHMARK(timer_arm_cancel, doTimerArmCancel)
@@ -22,3 +22,19 @@ DEFINE_TEST(helGetCredentials_fault, ([] {
 	HelError ret = helGetCredentials(kHelThisThread, 0, static_cast<char *>(illegalPtr));
 	assert(ret == kHelErrFault);
 }))
+
+DEFINE_TEST(helSubmitBatch_fault, ([] {
+	size_t numSubmitted;
+	HelError ret = helSubmitBatch(kHelNullHandle, static_cast<HelBatchEntry *>(illegalPtr),
+			1, &numSubmitted);
+	assert(ret == kHelErrFault);
+	assert(!numSubmitted);
+}))
+
+DEFINE_TEST(helSubmitBatch_illegalOp, ([] {
+	HelBatchEntry entry{};
+	size_t numSubmitted;
+	HelError ret = helSubmitBatch(kHelNullHandle, &entry, 1, &numSubmitted);
+	assert(ret == kHelErrIllegalArgs);
+	assert(!numSubmitted);
+}))
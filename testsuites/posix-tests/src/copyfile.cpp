@@ -0,0 +1,159 @@
+#include <cassert>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+#include "testsuite.hpp"
+
+namespace {
+
+int makeTempFile() {
+	char path[] = "/tmp/posix-tests-XXXXXX";
+	int fd = mkstemp(path);
+	assert(fd != -1);
+	int e = unlink(path);
+	assert(!e);
+	return fd;
+}
+
+void fillPattern(char *buffer, size_t size) {
+	for(size_t i = 0; i < size; i++)
+		buffer[i] = 'a' + (i % 26);
+}
+
+} // anonymous namespace
+
+DEFINE_TEST(copy_file_range_basic, ([] {
+	// Span multiple pages to exercise partial windows.
+	constexpr size_t size = 0x3000 + 123;
+	static char data[size];
+	static char check[size];
+	fillPattern(data, size);
+
+	int in = makeTempFile();
+	int out = makeTempFile();
+	ssize_t n = write(in, data, size);
+	assert(n == size);
+
+	off_t inOffset = 100;
+	off_t outOffset = 0;
+	n = copy_file_range(in, &inOffset, out, &outOffset, size, 0);
+	assert(n == size - 100);
+	assert(inOffset == size);
+	assert(outOffset == size - 100);
+
+	n = pread(out, check, size, 0);
+	assert(n == size - 100);
+	assert(!memcmp(check, data + 100, size - 100));
+
+	// Copies at the end of the input file return zero.
+	n = copy_file_range(in, &inOffset, out, &outOffset, size, 0);
+	assert(!n);
+
+	close(in);
+	close(out);
+}))
+
+DEFINE_TEST(copy_file_range_file_offsets, ([] {
+	constexpr size_t size = 4096;
+	static char data[size];
+	static char check[size];
+	fillPattern(data, size);
+
+	int in = makeTempFile();
+	int out = makeTempFile();
+	ssize_t n = write(in, data, size);
+	assert(n == size);
+
+	// Without explicit offsets, both file offsets are used and advanced.
+	off_t off = lseek(in, 10, SEEK_SET);
+	assert(off == 10);
+	n = copy_file_range(in, nullptr, out, nullptr, 20, 0);
+	assert(n == 20);
+	assert(lseek(in, 0, SEEK_CUR) == 30);
+	assert(lseek(out, 0, SEEK_CUR) == 20);
+
+	n = pread(out, check, size, 0);
+	assert(n == 20);
+	assert(!memcmp(check, data + 10, 20));
+
+	close(in);
+	close(out);
+}))
+
+DEFINE_TEST(copy_file_range_access_mode, ([] {
+	char path[] = "/tmp/posix-tests-XXXXXX";
+	int fd = mkstemp(path);
+	assert(fd != -1);
+	ssize_t n = write(fd, "hello", 5);
+	assert(n == 5);
+	close(fd);
+
+	int writeOnly = open(path, O_WRONLY);
+	assert(writeOnly != -1);
+	int readOnly = open(path, O_RDONLY);
+	assert(readOnly != -1);
+	int out = makeTempFile();
+
+	// The input must be readable.
+	off_t inOffset = 0;
+	n = copy_file_range(writeOnly, &inOffset, out, nullptr, 5, 0);
+	assert(n == -1);
+	assert(errno == EBADF);
+
+	// The output must be writable.
+	n = copy_file_range(out, &inOffset, readOnly, nullptr, 5, 0);
+	assert(n == -1);
+	assert(errno == EBADF);
+
+	close(writeOnly);
+	close(readOnly);
+	close(out);
+	unlink(path);
+}))
+
+DEFINE_TEST(sendfile_basic, ([] {
+	constexpr size_t size = 0x2000;
+	static char data[size];
+	static char check[size];
+	fillPattern(data, size);
+
+	int in = makeTempFile();
+	int out = makeTempFile();
+	ssize_t n = write(in, data, size);
+	assert(n == size);
+
+	// With an explicit offset, the file offset of the input is not changed.
+	off_t inOffset = 0x1000;
+	n = sendfile(out, in, &inOffset, size);
+	assert(n == size - 0x1000);
+	assert(inOffset == size);
+	assert(lseek(in, 0, SEEK_CUR) == size);
+
+	n = pread(out, check, size, 0);
+	assert(n == size - 0x1000);
+	assert(!memcmp(check, data + 0x1000, size - 0x1000));
+
+	// The pipe is a valid output but not a valid input.
+	int fds[2];
+	int e = pipe(fds);
+	assert(!e);
+	inOffset = 0;
+	n = sendfile(fds[1], in, &inOffset, 16);
+	assert(n == 16);
+	n = read(fds[0], check, 16);
+	assert(n == 16);
+	assert(!memcmp(check, data, 16));
+
+	n = sendfile(out, fds[0], nullptr, 16);
+	assert(n == -1);
+	assert(errno == EINVAL);
+
+	close(fds[0]);
+	close(fds[1]);
+	close(in);
+	close(out);
+}))
@@ -0,0 +1,78 @@
+#include <cassert>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <benchsuite.hpp>
+
+namespace {
+
+// /tmp is a tmpfs while /root resides on the (ext2) root file system.
+constexpr const char *tmpfsDir = "/tmp";
+constexpr const char *ext2Dir = "/root";
+
+std::string create_bench_file(const char *dir) {
+	std::string path = std::string{dir} + "/posix-torture.bench";
+	int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	assert(fd >= 0);
+	close(fd);
+	return path;
+}
+
+auto do_open_close(const char *dir) {
+	return [=] (benchmark_state &state) {
+		auto path = create_bench_file(dir);
+		while(state.keep_running()) {
+			int fd = open(path.c_str(), O_RDONLY);
+			assert(fd >= 0);
+			close(fd);
+		}
+		unlink(path.c_str());
+	};
+}
+
+auto do_stat(const char *dir) {
+	return [=] (benchmark_state &state) {
+		auto path = create_bench_file(dir);
+		while(state.keep_running()) {
+			struct stat st;
+			[[maybe_unused]] int e = stat(path.c_str(), &st);
+			assert(!e);
+		}
+		unlink(path.c_str());
+	};
+}
+
+auto do_mmap_munmap(size_t size, bool touch) {
+	return [=] (benchmark_state &state) {
+		while(state.keep_running()) {
+			void *window = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+					MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			assert(window != MAP_FAILED);
+			if(touch) {
+				auto p = static_cast<volatile char *>(window);
+				for(size_t off = 0; off < size; off += 0x1000)
+					p[off] = 1;
+			}
+			munmap(window, size);
+		}
+	};
+}
+
+} // anonymous namespace
+
+// Use syscall() such that the C library cannot cache the result.
+DEFINE_BENCHMARK(getpid, ([] (benchmark_state &state) {
+	while(state.keep_running())
+		syscall(SYS_getpid);
+}), .batch = 100)
+
+DEFINE_BENCHMARK(open_close_tmpfs, do_open_close(tmpfsDir))
+DEFINE_BENCHMARK(open_close_ext2, do_open_close(ext2Dir))
+DEFINE_BENCHMARK(stat_tmpfs, do_stat(tmpfsDir))
+DEFINE_BENCHMARK(stat_ext2, do_stat(ext2Dir))
+DEFINE_BENCHMARK(mmap_munmap_4k, do_mmap_munmap(0x1000, false))
+DEFINE_BENCHMARK(mmap_touch_munmap_1m, do_mmap_munmap(1 << 20, true))
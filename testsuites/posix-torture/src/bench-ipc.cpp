@@ -0,0 +1,268 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include <benchsuite.hpp>
+
+namespace {
+
+constexpr size_t chunkSize = 64 * 1024;
+
+// Runs f() in a child process that exits once f() returns.
+// Benchmarks use this to set up the other end of a pipe or socket.
+template<typename F>
+pid_t fork_peer(F f) {
+	pid_t pid = fork();
+	assert(pid >= 0);
+	if(!pid) {
+		f();
+		_exit(0);
+	}
+	return pid;
+}
+
+void read_exactly(int fd, char *buffer, size_t size) {
+	size_t progress = 0;
+	while(progress < size) {
+		auto n = read(fd, buffer + progress, size - progress);
+		assert(n > 0);
+		progress += n;
+	}
+}
+
+// Echoes single bytes until the connection is closed.
+void run_echo(int rfd, int wfd) {
+	char c;
+	while(read(rfd, &c, 1) == 1) {
+		if(write(wfd, &c, 1) != 1)
+			break;
+	}
+}
+
+// Writes chunks until the reader goes away.
+void run_source(int wfd) {
+	signal(SIGPIPE, SIG_IGN);
+	std::vector<char> buffer(chunkSize);
+	while(write(wfd, buffer.data(), buffer.size()) > 0)
+		;
+}
+
+void reap(pid_t pid) {
+	int status;
+	[[maybe_unused]] auto res = waitpid(pid, &status, 0);
+	assert(res == pid);
+}
+
+void measure_latency(benchmark_state &state, int rfd, int wfd) {
+	char c = 0;
+	while(state.keep_running()) {
+		[[maybe_unused]] auto n = write(wfd, &c, 1);
+		assert(n == 1);
+		n = read(rfd, &c, 1);
+		assert(n == 1);
+	}
+}
+
+void measure_throughput(benchmark_state &state, int rfd) {
+	std::vector<char> buffer(chunkSize);
+	while(state.keep_running())
+		read_exactly(rfd, buffer.data(), buffer.size());
+}
+
+void pipe_latency(benchmark_state &state) {
+	int to_peer[2], from_peer[2];
+	[[maybe_unused]] int e = pipe(to_peer);
+	assert(!e);
+	e = pipe(from_peer);
+	assert(!e);
+
+	auto pid = fork_peer([&] {
+		close(to_peer[1]);
+		close(from_peer[0]);
+		run_echo(to_peer[0], from_peer[1]);
+	});
+	close(to_peer[0]);
+	close(from_peer[1]);
+
+	measure_latency(state, from_peer[0], to_peer[1]);
+
+	close(to_peer[1]);
+	close(from_peer[0]);
+	reap(pid);
+}
+
+void pipe_throughput(benchmark_state &state) {
+	int fds[2];
+	[[maybe_unused]] int e = pipe(fds);
+	assert(!e);
+
+	auto pid = fork_peer([&] {
+		close(fds[0]);
+		run_source(fds[1]);
+	});
+	close(fds[1]);
+
+	measure_throughput(state, fds[0]);
+
+	close(fds[0]);
+	reap(pid);
+}
+
+auto unix_latency(int type) {
+	return [=] (benchmark_state &state) {
+		int fds[2];
+		[[maybe_unused]] int e = socketpair(AF_UNIX, type, 0, fds);
+		assert(!e);
+
+		auto pid = fork_peer([&] {
+			close(fds[0]);
+			run_echo(fds[1], fds[1]);
+		});
+		close(fds[1]);
+
+		measure_latency(state, fds[0], fds[0]);
+
+		// Datagram sockets do not signal EOF on close; an empty datagram stops the echo.
+		if(type == SOCK_DGRAM)
+			send(fds[0], nullptr, 0, 0);
+		close(fds[0]);
+		reap(pid);
+	};
+}
+
+void unix_throughput(benchmark_state &state) {
+	int fds[2];
+	[[maybe_unused]] int e = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	assert(!e);
+
+	auto pid = fork_peer([&] {
+		close(fds[0]);
+		run_source(fds[1]);
+	});
+	close(fds[1]);
+
+	measure_throughput(state, fds[0]);
+
+	close(fds[0]);
+	reap(pid);
+}
+
+// Returns a connected TCP socket over loopback; the peer's end is passed to f().
+template<typename F>
+std::pair<int, pid_t> tcp_connect_peer(F f) {
+	int server = socket(AF_INET, SOCK_STREAM, 0);
+	assert(server >= 0);
+
+	struct sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	[[maybe_unused]] int e = bind(server, reinterpret_cast<struct sockaddr *>(&addr),
+			sizeof(addr));
+	assert(!e);
+	socklen_t len = sizeof(addr);
+	e = getsockname(server, reinterpret_cast<struct sockaddr *>(&addr), &len);
+	assert(!e);
+	e = listen(server, 1);
+	assert(!e);
+
+	auto pid = fork_peer([&] {
+		int conn = accept(server, nullptr, nullptr);
+		assert(conn >= 0);
+		close(server);
+		int one = 1;
+		setsockopt(conn, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		f(conn);
+	});
+	close(server);
+
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	assert(fd >= 0);
+	e = connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+	assert(!e);
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return {fd, pid};
+}
+
+void tcp_latency(benchmark_state &state) {
+	auto [fd, pid] = tcp_connect_peer([] (int conn) {
+		run_echo(conn, conn);
+	});
+
+	measure_latency(state, fd, fd);
+
+	close(fd);
+	reap(pid);
+}
+
+void tcp_throughput(benchmark_state &state) {
+	auto [fd, pid] = tcp_connect_peer([] (int conn) {
+		run_source(conn);
+	});
+
+	measure_throughput(state, fd);
+
+	close(fd);
+	reap(pid);
+}
+
+// Waits on an epoll instance that watches n pipes, exactly one of which is readable.
+// On an O(ready) implementation, the cost does not depend on n.
+auto epoll_wait_pipes(int n) {
+	return [=] (benchmark_state &state) {
+		int epfd = epoll_create1(0);
+		assert(epfd >= 0);
+
+		std::vector<int> fds;
+		for(int i = 0; i < n; i++) {
+			int p[2];
+			[[maybe_unused]] int e = pipe(p);
+			assert(!e);
+			fds.push_back(p[0]);
+			fds.push_back(p[1]);
+
+			struct epoll_event ev = {};
+			ev.events = EPOLLIN;
+			ev.data.fd = p[0];
+			e = epoll_ctl(epfd, EPOLL_CTL_ADD, p[0], &ev);
+			assert(!e);
+		}
+
+		// Make the last pipe readable; it stays readable as we never drain it.
+		char c = 0;
+		[[maybe_unused]] auto written = write(fds.back(), &c, 1);
+		assert(written == 1);
+
+		while(state.keep_running()) {
+			struct epoll_event events[16];
+			[[maybe_unused]] int k = epoll_wait(epfd, events, 16, 0);
+			assert(k == 1);
+		}
+
+		for(int fd : fds)
+			close(fd);
+		close(epfd);
+	};
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(pipe_latency, pipe_latency)
+DEFINE_BENCHMARK(pipe_throughput_64k, pipe_throughput, .bytes = chunkSize)
+DEFINE_BENCHMARK(unix_stream_latency, unix_latency(SOCK_STREAM))
+DEFINE_BENCHMARK(unix_dgram_latency, unix_latency(SOCK_DGRAM))
+DEFINE_BENCHMARK(unix_stream_throughput_64k, unix_throughput, .bytes = chunkSize)
+DEFINE_BENCHMARK(epoll_wait_1, epoll_wait_pipes(1))
+DEFINE_BENCHMARK(epoll_wait_16, epoll_wait_pipes(16))
+DEFINE_BENCHMARK(epoll_wait_256, epoll_wait_pipes(256))
+DEFINE_BENCHMARK(tcp_loopback_latency, tcp_latency)
+DEFINE_BENCHMARK(tcp_loopback_throughput_64k, tcp_throughput, .bytes = chunkSize)
@@ -0,0 +1,51 @@
+#include <cassert>
+#include <spawn.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <benchsuite.hpp>
+
+extern char **environ;
+
+DEFINE_BENCHMARK(fork_exit_waitpid, ([] (benchmark_state &state) {
+	while(state.keep_running()) {
+		int pid = fork();
+		assert(pid >= 0);
+		if(!pid)
+			_exit(0);
+		int status;
+		[[maybe_unused]] auto res = waitpid(pid, &status, 0);
+		assert(res > 0);
+	}
+}))
+
+DEFINE_BENCHMARK(fork_exec_waitpid, ([] (benchmark_state &state) {
+	while(state.keep_running()) {
+		int pid = fork();
+		assert(pid >= 0);
+		if(!pid) {
+			execl("/bin/true", "true", nullptr);
+			_exit(127);
+		}
+		int status;
+		[[maybe_unused]] auto res = waitpid(pid, &status, 0);
+		assert(res > 0);
+		assert(WIFEXITED(status) && !WEXITSTATUS(status));
+	}
+}))
+
+DEFINE_BENCHMARK(posix_spawn_waitpid, ([] (benchmark_state &state) {
+	char arg0[] = "true";
+	char *argv[] = {arg0, nullptr};
+	while(state.keep_running()) {
+		pid_t pid;
+		[[maybe_unused]] int e = posix_spawn(&pid, "/bin/true", nullptr, nullptr,
+				argv, environ);
+		assert(!e);
+		int status;
+		[[maybe_unused]] auto res = waitpid(pid, &status, 0);
+		assert(res > 0);
+		assert(WIFEXITED(status) && !WEXITSTATUS(status));
+	}
+}))
@@ -1,6 +1,11 @@
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#include <benchsuite.hpp>
 #include "testsuite.hpp"
 
 std::vector<abstract_test_case *> &test_case_ptrs() {
@@ -12,7 +17,87 @@ void abstract_test_case::register_case(abstract_test_case *tcp) {
 	test_case_ptrs().push_back(tcp);
 }
 
-int main() {
+namespace {
+
+// Upper bound on the number of samples that each benchmark records.
+constexpr size_t maxSamples = 1 << 20;
+
+struct bench_config {
+	bool json = false;
+	std::vector<std::string> filters;
+	uint64_t warmup_ms = 200;
+	uint64_t duration_ms = 1000;
+};
+
+// Returns false if nothing was printed.
+bool run_benchmark(const bench_config &config, abstract_benchmark *bp, bool first) {
+	auto &options = bp->options();
+
+	benchmark_state warmup{0, -1, options.batch,
+			std::chrono::milliseconds{config.warmup_ms}, maxSamples};
+	bp->run(warmup);
+
+	benchmark_state state{0, -1, options.batch,
+			std::chrono::milliseconds{config.duration_ms}, maxSamples};
+	bp->run(state);
+
+	auto stats = compute_statistics({&state});
+	if(!stats.samples) {
+		std::cerr << "posix-torture: " << bp->name() << " did not produce samples"
+				<< std::endl;
+		return false;
+	}
+
+	if(config.json) {
+		print_json(bp, stats, first);
+	}else{
+		print_human(bp, stats);
+	}
+	return true;
+}
+
+int run_benchmarks(int argc, char **argv) {
+	bench_config config;
+
+	for(int i = 2; i < argc; i++) {
+		std::string_view arg{argv[i]};
+		if(arg == "--json") {
+			config.json = true;
+		}else if(arg == "--warmup-ms" && i + 1 < argc) {
+			config.warmup_ms = strtoull(argv[++i], nullptr, 10);
+		}else if(arg == "--duration-ms" && i + 1 < argc) {
+			config.duration_ms = strtoull(argv[++i], nullptr, 10);
+		}else if(arg.size() && arg[0] == '-') {
+			std::cerr << "usage: posix-torture --bench [--json]"
+					" [--warmup-ms N] [--duration-ms N] [FILTER...]" << std::endl;
+			return 1;
+		}else{
+			config.filters.emplace_back(arg);
+		}
+	}
+
+	if(config.json)
+		std::cout << "{\"benchmarks\": [\n" << std::flush;
+
+	bool first = true;
+	for(abstract_benchmark *bp : benchmark_ptrs()) {
+		if(!is_selected(config.filters, bp))
+			continue;
+		if(run_benchmark(config, bp, first))
+			first = false;
+	}
+
+	if(config.json)
+		std::cout << "\n]}" << std::endl;
+	return 0;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+	if(argc > 1 && !strcmp(argv[1], "--bench"))
+		return run_benchmarks(argc, argv);
+
 	for(int s = 10; s < 24; s++) {
 		int n = 1 << s;
 		for(abstract_test_case *tcp : test_case_ptrs()) {
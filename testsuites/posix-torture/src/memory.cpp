@@ -9,3 +9,18 @@ DEFINE_TEST(map_unmap_anonymous, ([] {
 	assert(window != MAP_FAILED);
 	munmap(window, 0x1000);
 }))
+
+// Keeps multiple mappings alive at the same time, similar to malloc() growth.
+DEFINE_TEST(map_unmap_anonymous_batch, ([] {
+	constexpr int n = 16;
+	void *windows[n];
+	for(int i = 0; i < n; i++) {
+		size_t size = 0x1000 << (i % 4);
+		windows[i] = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		assert(windows[i] != MAP_FAILED);
+		*static_cast<volatile char *>(windows[i]) = 1;
+	}
+	for(int i = 0; i < n; i++)
+		munmap(windows[i], 0x1000 << (i % 4));
+}))
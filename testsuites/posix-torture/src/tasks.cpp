@@ -16,3 +16,17 @@ DEFINE_TEST(fork_exit_waitpid, ([] {
 		assert(res > 0);
 	}
 }))
+
+DEFINE_TEST(fork_exec_waitpid, ([] {
+	int pid = fork();
+	assert(pid >= 0);
+	if(!pid) {
+		execl("/bin/true", "true", nullptr);
+		_exit(127);
+	}else{
+		int status;
+		auto res = waitpid(pid, &status, 0);
+		assert(res > 0);
+		assert(WIFEXITED(status) && !WEXITSTATUS(status));
+	}
+}))
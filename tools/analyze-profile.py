@@ -12,32 +12,106 @@ parser.add_argument('--aggregate-by',
 	help="aggregate samples by source line of code or by symbol inside the binary")
 parser.add_argument('--line', action='store_true')
 parser.add_argument('--isn', action='store_true')
+parser.add_argument('--thor', type=str,
+	default='pkg-builds/managarm-kernel/kernel/thor/thor',
+	help="path to the kernel ELF")
+parser.add_argument('--elf', type=str, action='append', default=[],
+	metavar='PATH[@BASE]',
+	help="userspace ELF to resolve user addresses against (BASE is the load address in hex)")
+parser.add_argument('--folded', action='store_true',
+	help="emit folded stacks (as consumed by flamegraph.pl) instead of a flat profile")
+parser.add_argument('--thread', type=int,
+	help="only consider samples of the given thread (credentials ID)")
 
 args = parser.parse_args()
 
-profile = dict()
+# Must match struct ProfileSample in kernel/thor/generic/thor-internal/profile.hpp.
+sample_header = struct.Struct('<IIQQ')
+
+class Image:
+	def __init__(self, path, base):
+		self.path = path
+		self.base = base
+		self.addr2line = None
+
+		nm = subprocess.check_output(['nm', '-nC', '--defined-only', path], encoding='ascii')
+		self.sym_table = []
+		for line in nm.splitlines():
+			parts = line.split(' ', 2)
+			if len(parts) != 3:
+				continue
+			start, attr, symbol = parts
+			if attr not in 'tTwW':
+				continue
+			self.sym_table.append((int(start, 16) + base, symbol))
+		self.sym_index = [e[0] for e in self.sym_table]
+
+	def contains(self, ip):
+		return bool(self.sym_index) and self.sym_index[0] <= ip
+
+	def resolve(self, ip):
+		if args.aggregate_by == 'symbol':
+			idx = bisect.bisect_right(self.sym_index, ip)
+			if idx == 0:
+				return None
+			start, symbol = self.sym_table[idx - 1]
+			assert ip >= start
+			return (symbol, self.path)
+
+		if self.addr2line is None:
+			self.addr2line = subprocess.Popen(
+				[
+					'addr2line', '-sfC',
+					'-e', self.path
+				],
+				encoding='ascii',
+				stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+		self.addr2line.stdin.write(hex(ip - self.base) + '\n')
+		self.addr2line.stdin.flush()
+		func = self.addr2line.stdout.readline().rstrip()
+		line = self.addr2line.stdout.readline().rstrip()
+		if func == '??':
+			return None
+		if args.line:
+			return (func, line)
+		elif args.isn:
+			return (func, line.split(':')[0] + ':' + hex(ip))
+		else:
+			return (func, line.split(':')[0])
+
+kernel_image = Image(args.thor, 0)
+user_images = []
+for spec in args.elf:
+	path, _, base = spec.partition('@')
+	user_images.append(Image(path, int(base, 16) if base else 0))
+# Prefer the image with the highest base that is still below the IP.
+user_images.sort(key=lambda image: image.sym_index[0] if image.sym_index else 0, reverse=True)
+
+cache = dict()
+
+def resolve(ip):
+	if ip in cache:
+		return cache[ip]
+	loc = None
+	if ip >= (1 << 63):
+		loc = kernel_image.resolve(ip)
+	else:
+		for image in user_images:
+			if image.contains(ip):
+				loc = image.resolve(ip)
+				break
+	cache[ip] = loc
+	return loc
+
+def format_frame(ip, loc):
+	if loc is None:
+		return hex(ip)
+	if args.aggregate_by == 'symbol':
+		return loc[0]
+	return "{} ({})".format(loc[0], loc[1])
 
-if args.aggregate_by == 'symbol':
-	nm = subprocess.check_output(
-		[
-			'nm', '-nC',
-			'pkg-builds/managarm-kernel/kernel/thor/thor'
-		],
-		encoding='ascii');
-
-	sym_table = []
-	for line in nm.splitlines():
-		start, attr, symbol = line.split(' ', 2)
-		sym_table.append((int(start, 16), symbol))
-	sym_index = [e[0] for e in sym_table]
-else:
-	addr2line = subprocess.Popen(
-		[
-			'addr2line', '-sfC',
-			'-e', 'pkg-builds/managarm-kernel/kernel/thor/thor'
-		],
-		encoding='ascii',
-		stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+profile = dict()
+folded = dict()
 
 n_user = 0
 n_kernel = 0
@@ -45,47 +119,57 @@ n_resolved = 0
 
 with open(args.profile_path, 'rb') as f:
 	while True:
-		rec = f.read(8)
-		if not rec:
+		hdr = f.read(sample_header.size)
+		if not hdr:
+			break
+		if len(hdr) < sample_header.size:
+			print("Truncated sample header")
 			break
-		ip = struct.unpack('Q', rec)[0]
+		num_frames, cpu, space, thread = sample_header.unpack(hdr)
+		data = f.read(8 * num_frames)
+		if len(data) < 8 * num_frames:
+			print("Truncated sample")
+			break
+		frames = struct.unpack('<{}Q'.format(num_frames), data)
+
+		if args.thread is not None and thread != args.thread:
+			continue
+
+		ip = frames[0]
 		if ip < (1 << 63):
 			n_user += 1
-			continue
 		else:
 			n_kernel += 1
 
-		if args.aggregate_by == 'symbol':
-			idx = bisect.bisect_left(sym_index, ip)
-			if idx == 0:
-				continue
-			start, symbol = sym_table[idx - 1];
-			assert ip >= start
+		# Return addresses point behind the call instruction.
+		locs = [resolve(ip)] + [resolve(ret - 1) for ret in frames[1:]]
 
-			loc = symbol, 0
-		else:
-			addr2line.stdin.write(hex(ip) + '\n')
-			addr2line.stdin.flush()
-			func = addr2line.stdout.readline().rstrip()
-			line = addr2line.stdout.readline().rstrip()
-			if args.line:
-				loc = (func, line)
-			elif args.isn:
-				loc = (func, line.split(':')[0] + ':' + hex(ip))
-			else:
-				loc = (func, line.split(':')[0])
+		if locs[0] is not None:
+			profile[locs[0]] = profile.get(locs[0], 0) + 1
+			n_resolved += 1
 
-		if loc in profile:
-			profile[loc] += 1
-		else:
-			profile[loc] = 1
-		n_resolved += 1
+		if args.folded:
+			stack = ';'.join(format_frame(frames[i], locs[i])
+					for i in reversed(range(num_frames)))
+			if thread:
+				stack = 'thread-{};'.format(thread) + stack
+			else:
+				stack = 'kernel;' + stack
+			folded[stack] = folded.get(stack, 0) + 1
 
 n_all = n_user + n_kernel
+if not n_all:
+	print("No samples")
+	exit(0)
+
+if args.folded:
+	for stack, count in folded.items():
+		print("{} {}".format(stack, count))
+	exit(0)
 
 out = sorted(profile.keys(), key=lambda loc: profile[loc])
 for loc in out:
-	print("{:.2f}% ({} samples) in:".format(profile[loc]/n_kernel*100, profile[loc]))
+	print("{:.2f}% ({} samples) in:".format(profile[loc]/n_all*100, profile[loc]))
 	print("    {} in {}".format(loc[0], loc[1]))
-print("{} (= {:.2f}% of all samples) in the kernel".format(n_kernel, n_kernel/(n_user + n_kernel)*100))
-print("{:.2f}% of all kernel samples could be resolved".format(n_resolved/n_kernel*100))
+print("{} (= {:.2f}% of all samples) in the kernel".format(n_kernel, n_kernel/n_all*100))
+print("{:.2f}% of all samples could be resolved".format(n_resolved/n_all*100))
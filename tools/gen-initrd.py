@@ -11,6 +11,8 @@ parser = argparse.ArgumentParser(description = 'Generate a managarm initrd')
 parser.add_argument('-t', '--triple', dest = 'arch',
 		choices = ['x86_64-managarm', 'aarch64-managarm'], default = 'x86_64-managarm',
 		help = 'Target system triple (default: x86_64-managarm)')
+parser.add_argument('--no-page-align', dest = 'page_align', action = 'store_false',
+		help = 'Do not page-align file contents (thor has to copy unaligned files)')
 
 args = parser.parse_args()
 
@@ -96,7 +98,7 @@ for fname in os.listdir('system-root/usr/lib/managarm/server'):
 		continue
 	add_file('system-root/usr/lib/managarm/server', 'managarm/server', fname)
 
-# Copy (= hard link) the files to a temporary directory, run GNU cpio.
+# Copy (= hard link) the files to a temporary directory.
 
 tree_path = tempfile.mkdtemp(prefix='initrd-', dir='.')
 
@@ -112,14 +114,41 @@ for rel_path in file_list:
 	else:
 		os.link(entry.source, dest_path)
 
-proc = subprocess.Popen(['cpio', '--create', '--format=newc',
-			'-D', tree_path,
-			'--file', 'initrd.cpio',
-			'--quiet'],
-		stdin=subprocess.PIPE,
-		encoding='ascii')
-proc.communicate(input='\n'.join(file_list))
-if proc.returncode != 0:
-	sys.exit(1)
+# Write the archive in the "newc" cpio format.
+# Unless --no-page-align is given, we pad the file names with NUL bytes
+# such that the contents of each regular file start at a page boundary.
+# This allows thor to use the pages of the initrd module in place instead of copying them.
+# The padding is invisible to cpio implementations that treat names as C strings.
+
+page_size = 0x1000
+header_size = 110
+
+def align(n, a):
+	return (n + a - 1) & ~(a - 1)
+
+def write_entry(f, name, mode, data=b'', ino=0, mtime=0, nlink=1):
+	name_bytes = name.encode('ascii') + b'\0'
+	name_size = len(name_bytes)
+	if args.page_align and data:
+		name_size = align(f.tell() + header_size + name_size, page_size) - f.tell() - header_size
+	header = '070701' + ''.join(f'{v:08X}' for v in [
+		ino, mode, 0, 0, nlink, mtime, len(data),
+		0, 0, 0, 0, name_size, 0])
+	f.write(header.encode('ascii'))
+	f.write(name_bytes.ljust(name_size, b'\0'))
+	f.write(b'\0' * (align(f.tell(), 4) - f.tell()))
+	f.write(data)
+	f.write(b'\0' * (align(f.tell(), 4) - f.tell()))
+
+with open('initrd.cpio', 'wb') as f:
+	for (ino, rel_path) in enumerate(file_list, start=1):
+		st = os.stat(os.path.join(tree_path, rel_path))
+		if file_dict[rel_path].is_dir:
+			write_entry(f, rel_path, st.st_mode, ino=ino, mtime=int(st.st_mtime), nlink=2)
+		else:
+			with open(os.path.join(tree_path, rel_path), 'rb') as src:
+				data = src.read()
+			write_entry(f, rel_path, st.st_mode, data, ino=ino, mtime=int(st.st_mtime))
+	write_entry(f, 'TRAILER!!!', 0)
 
 shutil.rmtree(tree_path)
@@ -4,6 +4,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <iostream>
+#include <map>
+#include <unordered_map>
 
 #include <bragi/helpers-std.hpp>
 #include <CLI/App.hpp>
@@ -15,15 +17,149 @@
 enum class ExtractMode {
 	none,
 	eventOnly,
-	specificItem
+	specificItem,
+	chrome
 };
 
 
 std::unordered_map<std::string, ExtractMode> stringToExtractMode{
 	{"event-only", ExtractMode::eventOnly},
 	{"specific-item", ExtractMode::specificItem},
+	{"chrome", ExtractMode::chrome},
 };
 
+// A record that is emitted in chrome mode.
+struct TraceEvent {
+	uint64_t ts;
+	uint64_t id;
+	// Either the SpanPhase or zero for plain EventRecords.
+	uint32_t phase;
+	uint64_t span;
+	uint64_t parent;
+	uint64_t flow;
+	uint64_t ctx;
+	uint64_t thread;
+	std::vector<std::pair<uint64_t, int64_t>> ctrs;
+};
+
+std::string escapeJson(const std::string &in) {
+	std::string out;
+	for(char c : in) {
+		if(c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		}else if(static_cast<unsigned char>(c) < 0x20) {
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+			out += buf;
+		}else{
+			out += c;
+		}
+	}
+	return out;
+}
+
+// Emits the trace in the Chrome JSON trace format (which is also understood by Perfetto).
+// Kernel spans are strictly nested per CPU and become B/E events on a per-CPU thread of
+// the "thor" process. Userspace spans may interleave (due to coroutines) and become async
+// b/e events on the process that corresponds to their context. Flows are emitted as s/t/f.
+void emitChromeTrace(const std::vector<TraceEvent> &events,
+		const std::unordered_map<uint64_t, std::string> &eventNames,
+		const std::unordered_map<uint64_t, std::string> &itemNames,
+		const std::unordered_map<uint64_t, std::string> &contextNames) {
+	auto nameOf = [] (const std::unordered_map<uint64_t, std::string> &names, uint64_t id) {
+		auto it = names.find(id);
+		if(it == names.end())
+			return std::to_string(id);
+		return escapeJson(it->second);
+	};
+
+	// Chrome expects microseconds.
+	auto formatTs = [] (uint64_t ts) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "%lu.%03lu", ts / 1000, ts % 1000);
+		return std::string{buf};
+	};
+
+	// Count the number of events per flow such that we know where flows end.
+	std::map<uint64_t, size_t> flowSizes;
+	for(auto &ev : events) {
+		if(ev.flow)
+			flowSizes[ev.flow]++;
+	}
+
+	bool first = true;
+	auto emit = [&] (const std::string &json) {
+		std::cout << (first ? "" : ",\n") << json;
+		first = false;
+	};
+
+	std::cout << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+
+	emit("{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": 0,"
+			" \"args\": {\"name\": \"thor\"}}");
+	for(auto &[id, name] : contextNames)
+		emit("{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": "
+				+ std::to_string(id) + ", \"args\": {\"name\": \"" + escapeJson(name) + "\"}}");
+
+	std::map<uint64_t, size_t> flowProgress;
+	for(auto &ev : events) {
+		std::string common = "\"name\": \"" + nameOf(eventNames, ev.id) + "\""
+				+ ", \"cat\": \"ostrace\""
+				+ ", \"ts\": " + formatTs(ev.ts)
+				+ ", \"pid\": " + std::to_string(ev.ctx)
+				+ ", \"tid\": " + std::to_string(ev.thread);
+
+		std::string args = "\"args\": {";
+		for(size_t i = 0; i < ev.ctrs.size(); ++i)
+			args += (i ? ", \"" : "\"") + nameOf(itemNames, ev.ctrs[i].first)
+					+ "\": " + std::to_string(ev.ctrs[i].second);
+		if(ev.parent)
+			args += std::string{ev.ctrs.size() ? ", " : ""}
+					+ "\"parent\": " + std::to_string(ev.parent);
+		args += "}";
+
+		std::string ph;
+		std::string extra;
+		switch(ev.phase) {
+		case 0:
+			// Plain events do not carry a context; make them global instants.
+			ph = "i";
+			extra = ", \"s\": \"g\"";
+			break;
+		case static_cast<uint32_t>(managarm::ostrace::SpanPhase::BEGIN):
+			ph = ev.ctx ? "b" : "B";
+			break;
+		case static_cast<uint32_t>(managarm::ostrace::SpanPhase::END):
+			ph = ev.ctx ? "e" : "E";
+			break;
+		case static_cast<uint32_t>(managarm::ostrace::SpanPhase::INSTANT):
+			ph = "i";
+			extra = ", \"s\": \"t\"";
+			break;
+		default:
+			warnx("ignoring span record with unknown phase %u", ev.phase);
+			continue;
+		}
+		if(ev.ctx && ev.phase)
+			extra += ", \"id\": \"" + std::to_string(ev.span) + "\"";
+
+		emit("{\"ph\": \"" + ph + "\", " + common + extra + ", " + args + "}");
+
+		if(!ev.flow)
+			continue;
+		auto n = flowSizes[ev.flow];
+		auto k = flowProgress[ev.flow]++;
+		if(n < 2)
+			continue;
+		std::string flowPh = !k ? "s" : (k + 1 == n ? "f" : "t");
+		emit("{\"ph\": \"" + flowPh + "\", " + common
+				+ ", \"id\": \"" + std::to_string(ev.flow) + "\", \"bp\": \"e\"}");
+	}
+
+	std::cout << "\n]}" << std::endl;
+}
+
 int main(int argc, char **argv) {
 	ExtractMode mode{};
 	std::string path{"virtio-trace.bin"};
@@ -67,6 +203,11 @@ int main(int argc, char **argv) {
 	std::vector<uint64_t> ts;
 	std::vector<uint64_t> value;
 
+	std::vector<TraceEvent> traceEvents;
+	std::unordered_map<uint64_t, std::string> eventNames;
+	std::unordered_map<uint64_t, std::string> itemNames;
+	std::unordered_map<uint64_t, std::string> contextNames;
+
 	auto extractRecord = [&] () -> bool {
 		auto preamble = bragi::read_preamble(buffer);
 		if(preamble.error()) {
@@ -88,7 +229,14 @@ int main(int argc, char **argv) {
 			}
 			auto &record = maybeRecord.value();
 
-			if(record.id() == filteredEventId) {
+			if(mode == ExtractMode::chrome) {
+				TraceEvent ev{};
+				ev.ts = record.ts();
+				ev.id = record.id();
+				for(size_t i = 0; i < record.ctrs_size(); ++i)
+					ev.ctrs.emplace_back(record.ctrs(i).id(), record.ctrs(i).value());
+				traceEvents.push_back(std::move(ev));
+			}else if(record.id() == filteredEventId) {
 				if(mode == ExtractMode::eventOnly) {
 					ts.push_back(record.ts());
 				}else if(mode == ExtractMode::specificItem) {
@@ -107,6 +255,7 @@ int main(int argc, char **argv) {
 			assert(maybeRecord);
 			auto &record = maybeRecord.value();
 
+			eventNames[record.id()] = record.name();
 			if(record.name() == eventName)
 				filteredEventId = record.id();
 		} break;
@@ -116,9 +265,47 @@ int main(int argc, char **argv) {
 			assert(maybeRecord);
 			auto &record = maybeRecord.value();
 
+			itemNames[record.id()] = record.name();
 			if(record.name() == itemName)
 				desiredItemId = record.id();
 		} break;
+		case bragi::message_id<managarm::ostrace::SpanRecord>: {
+			auto maybeRecord = bragi::parse_head_tail<managarm::ostrace::SpanRecord>(
+					head_span, tail_span);
+			if(!maybeRecord) {
+				warnx("halting due to broken record");
+				return false;
+			}
+			auto &record = maybeRecord.value();
+
+			if(mode == ExtractMode::chrome) {
+				TraceEvent ev{};
+				ev.ts = record.ts();
+				ev.id = record.id();
+				ev.phase = record.phase();
+				ev.span = record.span();
+				ev.parent = record.parent();
+				ev.flow = record.flow();
+				ev.ctx = record.ctx();
+				ev.thread = record.thread();
+				for(size_t i = 0; i < record.ctrs_size(); ++i)
+					ev.ctrs.emplace_back(record.ctrs(i).id(), record.ctrs(i).value());
+				traceEvents.push_back(std::move(ev));
+			}else if(record.id() == filteredEventId
+					&& record.phase() != static_cast<uint32_t>(managarm::ostrace::SpanPhase::END)) {
+				// Treat the begin of a span like an event.
+				if(mode == ExtractMode::eventOnly)
+					ts.push_back(record.ts());
+			}
+		} break;
+		case bragi::message_id<managarm::ostrace::AnnounceContextRecord>: {
+			auto maybeRecord = bragi::parse_head_tail<managarm::ostrace::AnnounceContextRecord>(
+					head_span, tail_span);
+			assert(maybeRecord);
+			auto &record = maybeRecord.value();
+
+			contextNames[record.id()] = record.name();
+		} break;
 		default:
 			warnx("halting due to unexpected message ID %u", preamble.id());
 			return false;
@@ -135,6 +322,14 @@ int main(int argc, char **argv) {
 		++nRecords;
 	}
 
+	if(mode == ExtractMode::chrome) {
+		emitChromeTrace(traceEvents, eventNames, itemNames, contextNames);
+
+		std::cerr << "extracted " << nRecords << " records"
+				<< " (" << buffer.size() << " bytes remain)" << std::endl;
+		return 0;
+	}
+
 	std::cout << "{\n";
 	std::cout << "\"ts\": [";
 	for(size_t i = 0; i < ts.size(); ++i)